@@ -0,0 +1,53 @@
+# Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+# file Copyright.txt or https://cmake.org/licensing for details.
+
+#[=======================================================================[.rst:
+FindBrotli
+-----------
+
+Find the Brotli encoder library
+
+IMPORTED targets
+^^^^^^^^^^^^^^^^
+
+This module defines the following :prop_tgt:`IMPORTED` target:
+
+``Brotli::Encoder``
+
+Result variables
+^^^^^^^^^^^^^^^^
+
+This module will set the following variables if found:
+
+``Brotli_INCLUDE_DIRS``
+  where to find brotli/encode.h, etc.
+``Brotli_LIBRARIES``
+  the libraries to link against to use Brotli.
+``Brotli_FOUND``
+  TRUE if found
+
+#]=======================================================================]
+
+# Look for the necessary header
+find_path(Brotli_INCLUDE_DIR NAMES brotli/encode.h)
+mark_as_advanced(Brotli_INCLUDE_DIR)
+
+# Look for the necessary library
+find_library(Brotli_LIBRARY NAMES brotlienc)
+mark_as_advanced(Brotli_LIBRARY)
+
+include(${CMAKE_ROOT}/Modules/FindPackageHandleStandardArgs.cmake)
+find_package_handle_standard_args(Brotli
+        REQUIRED_VARS Brotli_INCLUDE_DIR Brotli_LIBRARY)
+
+# Create the imported target
+if(Brotli_FOUND)
+    set(Brotli_INCLUDE_DIRS ${Brotli_INCLUDE_DIR})
+    set(Brotli_LIBRARIES ${Brotli_LIBRARY})
+    if(NOT TARGET Brotli::Encoder)
+        add_library(Brotli::Encoder UNKNOWN IMPORTED)
+        set_target_properties(Brotli::Encoder PROPERTIES
+                IMPORTED_LOCATION             "${Brotli_LIBRARY}"
+                INTERFACE_INCLUDE_DIRECTORIES "${Brotli_INCLUDE_DIR}")
+    endif()
+endif()
@@ -49,6 +49,8 @@ if (NOT SUIL_INCLUDED)
         find_package(Zmq REQUIRED)
         find_package(Scc REQUIRED)
         find_package(Secp256k1 REQUIRED)
+        find_package(ZLIB REQUIRED)
+        find_package(Brotli)
         find_package(Suil)
 
         # Configure project version
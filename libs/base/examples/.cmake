@@ -7,4 +7,22 @@ if (ENABLE_EXAMPLES)
             RUNTIME_OUTPUT_NAME base-ex)
     target_link_libraries(Base-Example
             PRIVATE Suil::Base Threads::Threads)
+
+    # Benchmarks json::Object decoding with the available scanners
+    add_executable(Base-JsonBench
+            examples/json_bench.cpp)
+    set_target_properties(Base-JsonBench
+            PROPERTIES
+            RUNTIME_OUTPUT_NAME json-bench)
+    target_link_libraries(Base-JsonBench
+            PRIVATE Suil::Base Threads::Threads)
+
+    # Benchmarks the deflate configurations used by web socket permessage-deflate
+    add_executable(Base-DeflateBench
+            examples/deflate_bench.cpp)
+    set_target_properties(Base-DeflateBench
+            PROPERTIES
+            RUNTIME_OUTPUT_NAME deflate-bench)
+    target_link_libraries(Base-DeflateBench
+            PRIVATE Suil::Base Threads::Threads)
 endif()
\ No newline at end of file
@@ -0,0 +1,101 @@
+//
+// Created by Mpho Mbotho on 2021-07-10.
+//
+// Compares the compression ratio and throughput of the Deflater/Inflater
+// configurations negotiated by the web socket permessage-deflate extension,
+// using a stream of small and similar JSON messages like those exchanged by
+// chat or market data applications.
+//
+
+#include "suil/base/compress.hpp"
+
+#include <chrono>
+#include <vector>
+
+using suil::Buffer;
+using suil::String;
+
+static std::vector<String> messages(int count)
+{
+    std::vector<String> msgs;
+    msgs.reserve(count);
+    for (int i = 0; i < count; i++) {
+        Buffer ob{256};
+        ob << "{\"type\":\"trade\",\"symbol\":\"" << ((i % 3 == 0)? "BTC-USD" : "ETH-USD") << "\""
+           << ",\"id\":" << 1625900000000ll + i
+           << ",\"price\":" << 33000.25 + (i % 97) * 0.5
+           << ",\"size\":" << 0.001 * (i % 13 + 1)
+           << ",\"side\":\"" << ((i & 1)? "buy" : "sell") << "\""
+           << ",\"user\":{\"name\":\"user " << i % 50 << "\",\"verified\":false}}";
+        msgs.emplace_back(ob);
+    }
+    return msgs;
+}
+
+struct Result {
+    size_t raw{0};
+    size_t compressed{0};
+    double deflateMBs{0};
+    double inflateMBs{0};
+};
+
+static Result bench(const std::vector<String>& msgs, int windowBits, bool takeover, int rounds)
+{
+    Result res{};
+    suil::Deflater deflater{windowBits, takeover};
+    suil::Inflater inflater{windowBits, takeover};
+    std::vector<Buffer> frames;
+    frames.reserve(msgs.size());
+
+    std::chrono::duration<double> deflating{0}, inflating{0};
+    for (int r = 0; r < rounds; r++) {
+        frames.clear();
+        auto start = std::chrono::steady_clock::now();
+        for (auto& msg: msgs) {
+            auto& out = frames.emplace_back(0);
+            deflater.deflate(out, msg.data(), msg.size());
+        }
+        deflating += std::chrono::steady_clock::now() - start;
+
+        Buffer ob{1024};
+        start = std::chrono::steady_clock::now();
+        for (auto& frame: frames) {
+            ob.clear();
+            inflater.inflate(ob, frame.data(), frame.size());
+        }
+        inflating += std::chrono::steady_clock::now() - start;
+    }
+
+    for (int i = 0; i < msgs.size(); i++) {
+        res.raw += msgs[i].size();
+        res.compressed += frames[i].size();
+    }
+    auto total = double(res.raw) * rounds / (1024 * 1024);
+    res.deflateMBs = total / deflating.count();
+    res.inflateMBs = total / inflating.count();
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = (argc > 1)? atoi(argv[1]) : 10000;
+    int rounds = (argc > 2)? atoi(argv[2]) : 10;
+    auto msgs = messages(std::max(count, 1));
+
+    const std::tuple<int, bool, const char *> configs[] = {
+        {15, true,  "window 15, context takeover"},
+        {15, false, "window 15, no context takeover"},
+        {10, true,  "window 10, context takeover"},
+        {10, false, "window 10, no context takeover"}
+    };
+
+    printf("%zu messages, %d rounds\n", msgs.size(), rounds);
+    for (auto& [bits, takeover, name]: configs) {
+        auto res = bench(msgs, bits, takeover, rounds);
+        printf("  %-32s ratio %5.2f  deflate %8.2f MB/s  inflate %8.2f MB/s\n",
+               name, double(res.raw) / double(std::max(res.compressed, size_t(1))),
+               res.deflateMBs, res.inflateMBs);
+    }
+
+    return EXIT_SUCCESS;
+}
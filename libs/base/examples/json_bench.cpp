@@ -0,0 +1,121 @@
+//
+// Created by Mpho Mbotho on 2021-07-05.
+//
+// Compares the throughput of json::Object::decode with each of the scanners
+// supported by the CPU. Corpora can be given as paths to JSON files (e.g
+// twitter.json, citm_catalog.json, canada.json), by default synthetic
+// corpora of similar shape are used.
+//
+
+#include "suil/base/file.hpp"
+#include "suil/base/json.hpp"
+
+#include <chrono>
+
+using suil::Buffer;
+using suil::String;
+namespace json = suil::json;
+
+static String stringsCorpus()
+{
+    // twitter like, mostly long strings with a few escapes
+    Buffer ob{1024};
+    ob << "{\"statuses\":[";
+    for (int i = 0; i < 1000; i++) {
+        ob << (i? ",": "")
+           << "{\"id\":" << 505874924095815680ll + i
+           << ",\"text\":\"@aym0566x \\n\\nThe quick brown fox jumps over the lazy dog, "
+              "\\u3053\\u3093\\u306b\\u3061\\u306f again and again #" << i << "\""
+           << ",\"source\":\"<a href=\\\"http://twitter.com/download/iphone\\\" rel=\\\"nofollow\\\">"
+              "Twitter for iPhone</a>\""
+           << ",\"user\":{\"name\":\"user " << i << "\",\"screen_name\":\"user_" << i << "\""
+           << ",\"description\":\"Lorem ipsum dolor sit amet, consectetur adipiscing elit\""
+           << ",\"followers_count\":" << i * 7 << ",\"verified\":false}"
+           << ",\"retweeted\":false,\"lang\":\"en\"}";
+    }
+    ob << "]}";
+    return String{ob};
+}
+
+static String objectsCorpus()
+{
+    // citm_catalog like, pretty printed nested objects
+    Buffer ob{1024};
+    ob << "{\n  \"events\": {\n";
+    for (int i = 0; i < 1000; i++) {
+        ob << (i? ",\n": "")
+           << "    \"" << 138586341 + i << "\": {\n"
+           << "      \"description\": null,\n"
+           << "      \"id\": " << 138586341 + i << ",\n"
+           << "      \"name\": \"Event " << i << "\",\n"
+           << "      \"subTopicIds\": [\n        337184269,\n        337184283\n      ],\n"
+           << "      \"topicIds\": [\n        324846099,\n        107888604\n      ]\n"
+           << "    }";
+    }
+    ob << "\n  }\n}";
+    return String{ob};
+}
+
+static String numbersCorpus()
+{
+    // canada like, arrays of coordinates
+    Buffer ob{1024};
+    ob << "{\"type\":\"Polygon\",\"coordinates\":[";
+    for (int i = 0; i < 5000; i++) {
+        ob << (i? ",": "") << "[" << -65.613616999999977 + i * 0.0001
+           << "," << 43.420273000000009 - i * 0.0001 << "]";
+    }
+    ob << "]}";
+    return String{ob};
+}
+
+static double bench(const String& data, int iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        auto obj = json::Object::decode(data);
+        (void) obj;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double(data.size()) * iterations) / elapsed.count() / (1024 * 1024);
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::pair<String, String>> corpora;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            corpora.emplace_back(String{argv[i]}.dup(), suil::fs::readall(argv[i]));
+        }
+    }
+    else {
+        corpora.emplace_back("strings", stringsCorpus());
+        corpora.emplace_back("objects", objectsCorpus());
+        corpora.emplace_back("numbers", numbersCorpus());
+    }
+
+    const std::pair<json::Scanner, const char *> scanners[] = {
+        {json::Scanner::Scalar, "scalar"},
+        {json::Scanner::Sse2,   "sse2"},
+        {json::Scanner::Avx2,   "avx2"}
+    };
+
+    auto best = json::scanner();
+    for (auto& [name, data]: corpora) {
+        // aim for roughly 256 MB of input per scanner
+        int iterations = std::max(1, int((256 * 1024 * 1024) / std::max(data.size(), size_t(1))));
+        printf("%s (%zu bytes, %d iterations)\n", name(), data.size(), iterations);
+        for (auto& [sc, scName]: scanners) {
+            if (!json::scanner(sc)) {
+                printf("  %-8s not supported\n", scName);
+                continue;
+            }
+            // warm up
+            bench(data, std::max(1, iterations/10));
+            printf("  %-8s %10.2f MB/s\n", scName, bench(data, iterations));
+        }
+    }
+    json::scanner(best);
+
+    return EXIT_SUCCESS;
+}
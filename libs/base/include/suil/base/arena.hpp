@@ -0,0 +1,117 @@
+//
+// Created by Mpho Mbotho on 2021-07-03.
+//
+
+#ifndef SUIL_BASE_ARENA_HPP
+#define SUIL_BASE_ARENA_HPP
+
+#include "suil/base/string.hpp"
+
+#include <cstddef>
+
+#ifndef SUIL_ARENA_MAX_BLOCK
+#define SUIL_ARENA_MAX_BLOCK (1024*1024)
+#endif
+
+namespace suil {
+
+    /**
+     * A bump allocator, memory is handed out from large blocks and is only
+     * given back all at once when the arena is \a reset. This is meant for
+     * objects whose lifetime is bound to a cycle (e.g a request) and that would
+     * otherwise be allocated and freed piecemeal
+     */
+    class Arena {
+    public:
+        /**
+         * Creates a new arena, no memory is allocated until the first allocation
+         * @param blockSize the size of the blocks allocated by the arena
+         */
+        explicit Arena(size_t blockSize = 4096);
+
+        DISABLE_COPY(Arena);
+        DISABLE_MOVE(Arena);
+
+        ~Arena();
+
+        /**
+         * allocate memory from the arena
+         * @param size the number of bytes to allocate
+         * @param align the required alignment, must be a power of 2 not greater
+         * than alignof(std::max_align_t)
+         * @return pointer to the allocated memory, the memory is valid until
+         * the arena is reset
+         */
+        inline void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+            auto off = (Ego._offset + align - 1) & ~(align - 1);
+            if ((Ego._current != nullptr) and ((off + size) <= Ego._current->size)) {
+                Ego._offset = off + size;
+                Ego._used += size;
+                return &Ego._current->data()[off];
+            }
+            return Ego.grow(size, align);
+        }
+
+        /**
+         * copy the given string into the arena
+         * @param str the string to copy
+         * @param len the size of the string
+         * @return a null terminated string that references the memory in the arena
+         */
+        String dup(const char* str, size_t len);
+
+        inline String dup(const String& str) {
+            return Ego.dup(str.data(), str.size());
+        }
+
+        /**
+         * Gives back all the memory allocated from the arena. If the allocations
+         * didn't fit in a single block, the blocks are replaced by a single block
+         * large enough to hold them (up to SUIL_ARENA_MAX_BLOCK bytes)
+         */
+        void reset();
+
+        /**
+         * @return the number of bytes allocated since the last reset
+         */
+        inline size_t used() const {
+            return Ego._used;
+        }
+
+        /**
+         * @return the highest number of bytes allocated between resets
+         */
+        inline size_t peak() const {
+            return Ego._peak;
+        }
+
+        /**
+         * @return the number of blocks allocated during the lifetime
+         * of the arena
+         */
+        inline size_t blocks() const {
+            return Ego._blocks;
+        }
+
+    private suil_ut:
+        struct alignas(std::max_align_t) Block {
+            Block  *next{nullptr};
+            size_t  size{0};
+            inline char* data() {
+                return reinterpret_cast<char *>(this + 1);
+            }
+        };
+
+        void* grow(size_t size, size_t align);
+        void release();
+
+        Block  *_head{nullptr};
+        Block  *_current{nullptr};
+        size_t  _offset{0};
+        size_t  _blockSize{0};
+        size_t  _used{0};
+        size_t  _peak{0};
+        size_t  _blocks{0};
+    };
+}
+#endif //SUIL_BASE_ARENA_HPP
@@ -258,6 +258,15 @@ namespace suil {
             return appendnf(8, fmt, v);
         }
 
+        /**
+         * append the decimal representation of the given number into the buffer,
+         * this is a lot cheaper than the printf-style stream operators
+         * @param v the number to append
+         * @return the number of bytes copied into the buffer on success and
+         * -1 on failure
+         */
+        ssize_t decimal(uint64_t v);
+
         /**
          * append the given data into the buffer, formatting the buffer in
          * hex format
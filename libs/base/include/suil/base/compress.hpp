@@ -0,0 +1,169 @@
+//
+// Created by Mpho Mbotho on 2021-07-07.
+//
+
+#ifndef SUIL_BASE_COMPRESS_HPP
+#define SUIL_BASE_COMPRESS_HPP
+
+#include "suil/base/buffer.hpp"
+
+namespace suil {
+
+    /**
+     * The compression formats supported by the \a Compressor
+     */
+    enum class Codec : uint8 {
+        None,
+        Deflate,
+        Gzip,
+        Brotli
+    };
+
+    /**
+     * @return true if the given codec is available in the current build, brotli
+     * is only available if the library was found when building
+     */
+    bool supported(Codec codec);
+
+    /**
+     * A compression stream whose state is kept between messages. Creating the
+     * underlying zlib/brotli state is expensive, a compressor is meant to be created
+     * once and used to compress many messages
+     */
+    class Compressor {
+    public:
+        /**
+         * Creates a compressor, the underlying state is created on first use
+         * @param codec the format to compress to
+         * @param level the compression level, -1 uses the codec's default level
+         */
+        explicit Compressor(Codec codec = Codec::Gzip, int level = -1);
+
+        MOVE_CTOR(Compressor) noexcept;
+        MOVE_ASSIGN(Compressor) noexcept;
+
+        ~Compressor();
+
+        /**
+         * Compresses the given data as a single complete message, the state
+         * of the compressor is reset for the next message
+         * @param out the buffer to append the compressed data to
+         * @param data the data to compress
+         * @param len the size of the data
+         * @return true if the data was compressed, false otherwise
+         */
+        bool compress(Buffer& out, const void* data, size_t len);
+
+        inline bool compress(Buffer& out, const String& str) {
+            return Ego.compress(out, str.data(), str.size());
+        }
+
+        /**
+         * @return an upper bound on the size of \param len bytes once compressed
+         */
+        size_t bound(size_t len) const;
+
+        inline Codec codec() const {
+            return Ego._codec;
+        }
+
+    private suil_ut:
+        DISABLE_COPY(Compressor);
+        bool init();
+        void release();
+
+        Codec  _codec{Codec::Gzip};
+        int    _level{-1};
+        void  *_state{nullptr};
+    };
+
+    /**
+     * Compresses the given data using a compressor that is reused by the calling
+     * thread for the given codec
+     * @see Compressor::compress
+     */
+    bool compress(Buffer& out, Codec codec, const void* data, size_t len);
+
+    /**
+     * A raw deflate (RFC 1951) stream for message based protocols. Each message ends
+     * with a sync flush whose empty block trailer (0x00 0x00 0xff 0xff) is removed,
+     * as done by the web socket permessage-deflate extension (RFC 7692)
+     */
+    class Deflater {
+    public:
+        /**
+         * Creates a deflater, the underlying state is created on first use
+         * @param windowBits the base 2 logarithm of the window size (9 - 15)
+         * @param takeover true if the compression context is kept between messages
+         * @param level the compression level, -1 uses the default level
+         * @param memLevel the memory used by the compression state (1 - 9), the
+         *  state uses about (1 << (windowBits+2)) + (1 << (memLevel+9)) bytes
+         */
+        explicit Deflater(int windowBits = 15, bool takeover = true, int level = -1, int memLevel = 8);
+
+        MOVE_CTOR(Deflater) noexcept;
+        MOVE_ASSIGN(Deflater) noexcept;
+
+        ~Deflater();
+
+        /**
+         * Compresses a single message
+         * @param out the buffer to append the compressed message to
+         * @param data the message to compress
+         * @param len the size of the message
+         * @return true if the message was compressed, false otherwise
+         */
+        bool deflate(Buffer& out, const void* data, size_t len);
+
+    private suil_ut:
+        DISABLE_COPY(Deflater);
+        bool init();
+        void release();
+
+        int    _windowBits{15};
+        int    _level{-1};
+        int    _memLevel{8};
+        bool   _takeover{true};
+        void  *_state{nullptr};
+    };
+
+    /**
+     * Decompresses the messages produced by a  Deflater
+     */
+    class Inflater {
+    public:
+        /**
+         * Creates an inflater, the underlying state is created on first use
+         * @param windowBits the base 2 logarithm of the window size (9 - 15)
+         * @param takeover true if the compression context is kept between messages
+         * @param maxSize the maximum size of a decompressed message, 0 for no limit
+         */
+        explicit Inflater(int windowBits = 15, bool takeover = true, size_t maxSize = 0);
+
+        MOVE_CTOR(Inflater) noexcept;
+        MOVE_ASSIGN(Inflater) noexcept;
+
+        ~Inflater();
+
+        /**
+         * Decompresses a single message
+         * @param out the buffer to append the decompressed message to
+         * @param data the compressed message
+         * @param len the size of the compressed message
+         * @return true if the message was decompressed, false if the message is
+         * invalid or bigger than the maximum message size
+         */
+        bool inflate(Buffer& out, const void* data, size_t len);
+
+    private suil_ut:
+        DISABLE_COPY(Inflater);
+        bool init();
+        void release();
+
+        int    _windowBits{15};
+        bool   _takeover{true};
+        size_t _maxSize{0};
+        void  *_state{nullptr};
+    };
+}
+#endif //SUIL_BASE_COMPRESS_HPP
@@ -112,6 +112,8 @@ namespace suil {
 #define ENABLE_ROUTE            5
         MSG_DISABLE_ROUTE,
 #define DISABLE_ROUTE           6
+        MSG_GET_FILESERVER_STATS,
+#define GET_FILESERVER_STATS    7
         MSG_SYSTEM = 64
 #define SYSTEM                  64
     };
@@ -144,16 +146,27 @@ namespace suil {
             void release();
         };
 
-        void initialize(int n);
-
+        void initialize(int n, bool respawn = false, bool pin = true);
+
+        /**
+         * Initialize the IPC group
+         * @param opts options used to configure the group
+         *  - nworkers the number of worker processes to spawn (defaults to the number of CPU's)
+         *  - respawn when true, the parent restarts workers that crash (are killed by a
+         *    signal), workers that keep crashing are restarted with a backoff and given
+         *    up on after SUIL_IPC_RESPAWN_LIMIT crashes
+         *  - pinWorkers when true (default) each worker is pinned to a CPU
+         */
         template <typename ...Opts>
         inline void init(Opts... opts) {
             struct Args {
                 uint8 nworkers{NWORKERS_SYSTEM};
+                bool  respawn{false};
+                bool  pinWorkers{true};
             } args;
             applyConfig(args, std::forward<Opts>(opts)...);
 
-            return initialize(args.nworkers);
+            return initialize(args.nworkers, args.respawn, args.pinWorkers);
         }
 
         int spawn(Work, PostSpawnFunc ps = nullptr, PostSpawnFunc pps = nullptr);
@@ -35,6 +35,29 @@ namespace suil::json {
         JSON_OBJECT,
     };
 
+    /**
+     * The instruction set used by the decoder to scan over strings and white
+     * space, \a Scalar decodes the input one byte at a time
+     */
+    enum class Scanner : unsigned char {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    /**
+     * @return the scanner used by the decoder, defaults to the best scanner
+     * supported by the CPU
+     */
+    Scanner scanner();
+
+    /**
+     * Changes the scanner used by the decoder
+     * @param sc the scanner to use
+     * @return false if the scanner is not supported by the CPU
+     */
+    bool scanner(Scanner sc);
+
     struct JsonNode;
 
     template <typename T>
@@ -379,6 +379,14 @@ namespace suil {
             return Ego.m_cstr;
         }
 
+        /**
+         * @return true if the string owns the buffer it references, false
+         * if it's just a view into memory owned by something else
+         */
+        inline bool owns() const {
+            return Ego.m_own;
+        }
+
         inline Data release() {
             Data tmp{Ego.data(), Ego.size(), Ego.m_own};
             m_own = false;
@@ -52,4 +52,14 @@
     iod_define_symbol(nworkers)
 #endif
 
+#ifndef IOD_SYMBOL_respawn
+    #define IOD_SYMBOL_respawn
+    iod_define_symbol(respawn)
+#endif
+
+#ifndef IOD_SYMBOL_pinWorkers
+    #define IOD_SYMBOL_pinWorkers
+    iod_define_symbol(pinWorkers)
+#endif
+
 #endif //SUIL_BASE_SYMBOLS_HPP
@@ -5,6 +5,7 @@
 #ifndef INCLUDE_SUIL_BASE_URL_HPP
 #define INCLUDE_SUIL_BASE_URL_HPP
 
+#include <suil/base/arena.hpp>
 #include <suil/base/string.hpp>
 
 namespace suil::URL {
@@ -22,5 +23,16 @@ namespace suil::URL {
     inline String decode(const T& d) {
         return decode(d.data(), d.size());
     }
+
+    /**
+     * decode the given url encoded data into memory allocated from \param arena
+     * @return a string referencing the decoded data in the arena
+     */
+    String decode(const void* data, size_t len, Arena& arena);
+
+    template <DataBuf T>
+    inline String decode(const T& d, Arena& arena) {
+        return decode(d.data(), d.size(), arena);
+    }
 }
 #endif //INCLUDE_SUIL_BASE_URL_HPP
@@ -0,0 +1,129 @@
+//
+// Created by Mpho Mbotho on 2021-07-03.
+//
+
+#include "suil/base/arena.hpp"
+#include "suil/base/exception.hpp"
+
+#include <algorithm>
+
+namespace suil {
+
+    Arena::Arena(size_t blockSize)
+        : _blockSize{std::max(blockSize, sizeof(Block))}
+    {}
+
+    Arena::~Arena()
+    {
+        Ego.release();
+    }
+
+    void* Arena::grow(size_t size, size_t align)
+    {
+        auto blockSize = std::max(Ego._blockSize, size);
+        auto block = static_cast<Block *>(::malloc(sizeof(Block) + blockSize));
+        if (block == nullptr) {
+            throw MemoryAllocationFailure("Arena::grow allocating ", blockSize, " bytes failed: ", errno_s);
+        }
+        block->next = nullptr;
+        block->size = blockSize;
+        Ego._blocks++;
+
+        if (Ego._current == nullptr) {
+            Ego._head = block;
+        }
+        else {
+            Ego._current->next = block;
+        }
+        Ego._current = block;
+        Ego._offset = 0;
+        return Ego.allocate(size, align);
+    }
+
+    String Arena::dup(const char* str, size_t len)
+    {
+        auto out = static_cast<char *>(Ego.allocate(len+1, 1));
+        if (len) {
+            memcpy(out, str, len);
+        }
+        out[len] = '\0';
+        return String{out, len, false};
+    }
+
+    void Arena::reset()
+    {
+        Ego._peak = std::max(Ego._peak, Ego._used);
+        if ((Ego._head != nullptr) and (Ego._head->next != nullptr)) {
+            // allocations did not fit in a single block, next cycle will use
+            // a block large enough to hold them
+            Ego._blockSize = std::min(std::max(Ego._blockSize, Ego._used),
+                                      std::max(Ego._blockSize, size_t(SUIL_ARENA_MAX_BLOCK)));
+            Ego.release();
+        }
+        Ego._current = Ego._head;
+        Ego._offset = 0;
+        Ego._used = 0;
+    }
+
+    void Arena::release()
+    {
+        while (Ego._head != nullptr) {
+            auto next = Ego._head->next;
+            ::free(Ego._head);
+            Ego._head = next;
+        }
+        Ego._current = nullptr;
+        Ego._offset = 0;
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("suil::Arena tests", "[common][arena]")
+{
+    SECTION("Allocating from an arena") {
+        suil::Arena arena{256};
+        REQUIRE(arena._head == nullptr);
+        auto p1 = arena.allocate(10);
+        REQUIRE(p1 != nullptr);
+        REQUIRE(arena.blocks() == 1);
+        auto p2 = arena.allocate(8, 8);
+        REQUIRE((reinterpret_cast<uintptr_t>(p2) % 8) == 0);
+        REQUIRE(static_cast<char *>(p2) >= static_cast<char *>(p1) + 10);
+        REQUIRE(arena.used() == 18);
+
+        auto s = arena.dup("Hello World", 11);
+        REQUIRE(s == "Hello World");
+        REQUIRE_FALSE(s.owns());
+        REQUIRE(s.data()[11] == '\0');
+        REQUIRE(arena.blocks() == 1);
+    }
+
+    SECTION("Growing and resetting an arena") {
+        suil::Arena arena{128};
+        (void) arena.allocate(100);
+        (void) arena.allocate(100);
+        REQUIRE(arena.blocks() == 2);
+        (void) arena.allocate(1024);
+        REQUIRE(arena.blocks() == 3);
+        REQUIRE(arena.used() == 1224);
+
+        arena.reset();
+        REQUIRE(arena.used() == 0);
+        REQUIRE(arena.peak() == 1224);
+        REQUIRE(arena._head == nullptr);
+        // a block big enough for the previous cycle is used
+        (void) arena.allocate(100);
+        (void) arena.allocate(1024);
+        REQUIRE(arena.blocks() == 4);
+
+        arena.reset();
+        auto head = arena._head;
+        REQUIRE(head != nullptr);
+        (void) arena.allocate(10);
+        REQUIRE(arena._head == head);
+        REQUIRE(arena.blocks() == 4);
+    }
+}
+#endif
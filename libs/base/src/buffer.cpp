@@ -215,6 +215,35 @@ namespace suil {
         return *this;
     }
 
+    ssize_t Buffer::decimal(uint64_t v) {
+        static const char Digits[] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        // digits are written from the back, two at a time
+        char tmp[20];
+        char *p = tmp + sizeof(tmp);
+        while (v >= 100) {
+            auto i = (v % 100) << 1;
+            v /= 100;
+            *--p = Digits[i+1];
+            *--p = Digits[i];
+        }
+
+        if (v < 10) {
+            *--p = char('0' + v);
+        }
+        else {
+            auto i = v << 1;
+            *--p = Digits[i+1];
+            *--p = Digits[i];
+        }
+
+        return append(p, (tmp + sizeof(tmp)) - p);
+    }
+
     ssize_t Buffer::hex(const void *data, size_t size, bool caps) {
         reserve(size<<1);
 
@@ -401,6 +430,25 @@ TEST_CASE("sb::Buffer tests", "[common][buffer]")
         REQUIRE_THROWS(ob2.appendnf(8, "%s", "0123456789123456"));
     }
 
+    SECTION("Appending decimal numbers", "[decimal]") {
+        sb::Buffer ob(8);
+        auto checkDecimal = [&](uint64_t v) {
+            char expected[32];
+            ssize_t sz = snprintf(expected, sizeof(expected), "%lu", v);
+            ssize_t from{ob.m_offset};
+            REQUIRE(ob.decimal(v) == sz);
+            REQUIRE(Check(ob, from, expected, sz));
+        };
+
+        checkDecimal(0);
+        checkDecimal(7);
+        checkDecimal(10);
+        checkDecimal(99);
+        checkDecimal(100);
+        checkDecimal(1234567);
+        checkDecimal(UINT64_MAX);
+    }
+
     SECTION("Stream and add operators", "[stream][add]") {
         // test using stream operators on buffer
         sb::Buffer ob(128);
@@ -0,0 +1,447 @@
+//
+// Created by Mpho Mbotho on 2021-07-07.
+//
+
+#include "suil/base/compress.hpp"
+
+#include <algorithm>
+
+#include <zlib.h>
+#ifdef SUIL_HAS_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifndef SUIL_BROTLI_DEFAULT_QUALITY
+// the brotli default (11) is too slow to be used on the fly
+#define SUIL_BROTLI_DEFAULT_QUALITY 5
+#endif
+
+namespace suil {
+
+    bool supported(Codec codec)
+    {
+        switch (codec) {
+            case Codec::None:
+            case Codec::Deflate:
+            case Codec::Gzip:
+                return true;
+#ifdef SUIL_HAS_BROTLI
+            case Codec::Brotli:
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Compressor::Compressor(Codec codec, int level)
+        : _codec{codec},
+          _level{level}
+    {}
+
+    Compressor::Compressor(Compressor&& o) noexcept
+        : _codec{o._codec},
+          _level{o._level},
+          _state{std::exchange(o._state, nullptr)}
+    {}
+
+    Compressor& Compressor::operator=(Compressor&& o) noexcept
+    {
+        if (this != &o) {
+            Ego.release();
+            Ego._codec = o._codec;
+            Ego._level = o._level;
+            Ego._state = std::exchange(o._state, nullptr);
+        }
+        return Ego;
+    }
+
+    Compressor::~Compressor()
+    {
+        Ego.release();
+    }
+
+    bool Compressor::init()
+    {
+        if (Ego._state != nullptr) {
+            return true;
+        }
+
+        if (Ego._codec == Codec::Brotli) {
+            // brotli is compressed in one shot and doesn't need state
+            return supported(Ego._codec);
+        }
+
+        if (Ego._codec != Codec::Deflate and Ego._codec != Codec::Gzip) {
+            return false;
+        }
+
+        auto strm = new z_stream{};
+        // adding 16 to the window bits wraps the stream in a gzip header and trailer
+        int bits = (Ego._codec == Codec::Gzip)? 15 + 16 : 15;
+        int level = (Ego._level < 0)? Z_DEFAULT_COMPRESSION : Ego._level;
+        if (deflateInit2(strm, level, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete strm;
+            return false;
+        }
+        Ego._state = strm;
+        return true;
+    }
+
+    void Compressor::release()
+    {
+        if (Ego._state != nullptr) {
+            auto strm = static_cast<z_stream *>(Ego._state);
+            deflateEnd(strm);
+            delete strm;
+            Ego._state = nullptr;
+        }
+    }
+
+    size_t Compressor::bound(size_t len) const
+    {
+        switch (Ego._codec) {
+            case Codec::Deflate:
+                return compressBound(uLong(len));
+            case Codec::Gzip:
+                // the gzip header and trailer are 18 bytes
+                return compressBound(uLong(len)) + 18;
+#ifdef SUIL_HAS_BROTLI
+            case Codec::Brotli:
+                return BrotliEncoderMaxCompressedSize(len);
+#endif
+            default:
+                return len;
+        }
+    }
+
+    bool Compressor::compress(Buffer& out, const void* data, size_t len)
+    {
+        if (!Ego.init()) {
+            return false;
+        }
+
+        auto bound = Ego.bound(len);
+        out.reserve(bound);
+#ifdef SUIL_HAS_BROTLI
+        if (Ego._codec == Codec::Brotli) {
+            int quality = (Ego._level < 0)? SUIL_BROTLI_DEFAULT_QUALITY : Ego._level;
+            size_t written{out.capacity()};
+            auto ok = BrotliEncoderCompress(
+                    quality,
+                    BROTLI_DEFAULT_WINDOW,
+                    BROTLI_MODE_GENERIC,
+                    len,
+                    static_cast<const uint8_t *>(data),
+                    &written,
+                    reinterpret_cast<uint8_t *>(out.data() + out.size()));
+            if (ok == BROTLI_FALSE) {
+                return false;
+            }
+            out.seek(off_t(written));
+            return true;
+        }
+#endif
+
+        auto strm = static_cast<z_stream *>(Ego._state);
+        strm->next_in = static_cast<Bytef *>(const_cast<void *>(data));
+        strm->avail_in = uInt(len);
+        strm->next_out = reinterpret_cast<Bytef *>(out.data() + out.size());
+        strm->avail_out = uInt(out.capacity());
+        // the output buffer is large enough to finish in a single call
+        auto ret = deflate(strm, Z_FINISH);
+        auto written = strm->total_out;
+        deflateReset(strm);
+        if (ret != Z_STREAM_END) {
+            return false;
+        }
+        out.seek(off_t(written));
+        return true;
+    }
+
+    bool compress(Buffer& out, Codec codec, const void* data, size_t len)
+    {
+        static thread_local Compressor sCompressors[] = {
+            Compressor{Codec::None},
+            Compressor{Codec::Deflate},
+            Compressor{Codec::Gzip},
+            Compressor{Codec::Brotli}
+        };
+        return sCompressors[int(codec)].compress(out, data, len);
+    }
+
+    // the empty stored block produced by a sync flush
+    static const uint8 sSyncTrailer[] = {0x00, 0x00, 0xff, 0xff};
+
+    Deflater::Deflater(int windowBits, bool takeover, int level, int memLevel)
+        : _windowBits{std::clamp(windowBits, 9, 15)},
+          _level{level},
+          _memLevel{std::clamp(memLevel, 1, 9)},
+          _takeover{takeover}
+    {}
+
+    Deflater::Deflater(Deflater&& o) noexcept
+        : _windowBits{o._windowBits},
+          _level{o._level},
+          _memLevel{o._memLevel},
+          _takeover{o._takeover},
+          _state{std::exchange(o._state, nullptr)}
+    {}
+
+    Deflater& Deflater::operator=(Deflater&& o) noexcept
+    {
+        if (this != &o) {
+            Ego.release();
+            Ego._windowBits = o._windowBits;
+            Ego._level = o._level;
+            Ego._memLevel = o._memLevel;
+            Ego._takeover = o._takeover;
+            Ego._state = std::exchange(o._state, nullptr);
+        }
+        return Ego;
+    }
+
+    Deflater::~Deflater()
+    {
+        Ego.release();
+    }
+
+    bool Deflater::init()
+    {
+        if (Ego._state != nullptr) {
+            return true;
+        }
+
+        auto strm = new z_stream{};
+        int level = (Ego._level < 0)? Z_DEFAULT_COMPRESSION : Ego._level;
+        // negative window bits produce a raw deflate stream
+        if (deflateInit2(strm, level, Z_DEFLATED, -Ego._windowBits, Ego._memLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete strm;
+            return false;
+        }
+        Ego._state = strm;
+        return true;
+    }
+
+    void Deflater::release()
+    {
+        if (Ego._state != nullptr) {
+            auto strm = static_cast<z_stream *>(Ego._state);
+            deflateEnd(strm);
+            delete strm;
+            Ego._state = nullptr;
+        }
+    }
+
+    bool Deflater::deflate(Buffer& out, const void* data, size_t len)
+    {
+        if (!Ego.init()) {
+            return false;
+        }
+
+        auto strm = static_cast<z_stream *>(Ego._state);
+        auto start = out.size();
+        strm->next_in = static_cast<Bytef *>(const_cast<void *>(data));
+        strm->avail_in = uInt(len);
+        do {
+            out.reserve(std::max(len/2, size_t(64)));
+            strm->next_out = reinterpret_cast<Bytef *>(out.data() + out.size());
+            strm->avail_out = uInt(out.capacity());
+            auto ret = ::deflate(strm, Z_SYNC_FLUSH);
+            if (ret != Z_OK and ret != Z_BUF_ERROR) {
+                deflateReset(strm);
+                return false;
+            }
+            out.seek(off_t(out.capacity() - strm->avail_out));
+        } while (strm->avail_out == 0);
+
+        if (!Ego._takeover) {
+            deflateReset(strm);
+        }
+
+        if ((out.size() - start) >= sizeof(sSyncTrailer) and
+            memcmp(out.data() + out.size() - sizeof(sSyncTrailer), sSyncTrailer, sizeof(sSyncTrailer)) == 0)
+        {
+            out.seek(-off_t(sizeof(sSyncTrailer)));
+        }
+        return true;
+    }
+
+    Inflater::Inflater(int windowBits, bool takeover, size_t maxSize)
+        : _windowBits{std::clamp(windowBits, 9, 15)},
+          _takeover{takeover},
+          _maxSize{maxSize}
+    {}
+
+    Inflater::Inflater(Inflater&& o) noexcept
+        : _windowBits{o._windowBits},
+          _takeover{o._takeover},
+          _maxSize{o._maxSize},
+          _state{std::exchange(o._state, nullptr)}
+    {}
+
+    Inflater& Inflater::operator=(Inflater&& o) noexcept
+    {
+        if (this != &o) {
+            Ego.release();
+            Ego._windowBits = o._windowBits;
+            Ego._takeover = o._takeover;
+            Ego._maxSize = o._maxSize;
+            Ego._state = std::exchange(o._state, nullptr);
+        }
+        return Ego;
+    }
+
+    Inflater::~Inflater()
+    {
+        Ego.release();
+    }
+
+    bool Inflater::init()
+    {
+        if (Ego._state != nullptr) {
+            return true;
+        }
+
+        auto strm = new z_stream{};
+        if (inflateInit2(strm, -Ego._windowBits) != Z_OK) {
+            delete strm;
+            return false;
+        }
+        Ego._state = strm;
+        return true;
+    }
+
+    void Inflater::release()
+    {
+        if (Ego._state != nullptr) {
+            auto strm = static_cast<z_stream *>(Ego._state);
+            inflateEnd(strm);
+            delete strm;
+            Ego._state = nullptr;
+        }
+    }
+
+    bool Inflater::inflate(Buffer& out, const void* data, size_t len)
+    {
+        if (!Ego.init()) {
+            return false;
+        }
+
+        auto strm = static_cast<z_stream *>(Ego._state);
+        auto start = out.size();
+        // the message is followed by the trailer removed by the deflater
+        const std::pair<const void *, size_t> inputs[] = {{data, len}, {sSyncTrailer, sizeof(sSyncTrailer)}};
+        bool ok{true};
+        for (auto& [in, inLen]: inputs) {
+            strm->next_in = static_cast<Bytef *>(const_cast<void *>(in));
+            strm->avail_in = uInt(inLen);
+            do {
+                out.reserve(std::max(len * 2, size_t(256)));
+                strm->next_out = reinterpret_cast<Bytef *>(out.data() + out.size());
+                strm->avail_out = uInt(out.capacity());
+                auto ret = ::inflate(strm, Z_SYNC_FLUSH);
+                out.seek(off_t(out.capacity() - strm->avail_out));
+                if (ret == Z_STREAM_END) {
+                    // the final block was sent, the context cannot be reused
+                    inflateReset(strm);
+                    strm->avail_in = 0;
+                    break;
+                }
+
+                if (ret != Z_OK and ret != Z_BUF_ERROR) {
+                    ok = false;
+                    break;
+                }
+
+                if (Ego._maxSize and (out.size() - start) > Ego._maxSize) {
+                    // message too big
+                    ok = false;
+                    break;
+                }
+            } while (strm->avail_in > 0 or strm->avail_out == 0);
+
+            if (!ok) {
+                break;
+            }
+        }
+
+        if (!ok or !Ego._takeover) {
+            inflateReset(strm);
+        }
+        return ok;
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("suil::Compressor tests", "[common][compress]")
+{
+    std::string data;
+    for (int i = 0; i < 200; i++) {
+        data += "The quick brown fox jumps over the lazy dog. ";
+    }
+
+    SECTION("Compressing with zlib") {
+        suil::Compressor gzip{suil::Codec::Gzip};
+        suil::Buffer out;
+        REQUIRE(gzip.compress(out, data.data(), data.size()));
+        REQUIRE(out.size() < data.size()/10);
+        // gzip magic
+        REQUIRE(uint8_t(out.data()[0]) == 0x1f);
+        REQUIRE(uint8_t(out.data()[1]) == 0x8b);
+
+        std::string inflated(data.size(), '\0');
+        z_stream strm{};
+        REQUIRE(inflateInit2(&strm, 15 + 16) == Z_OK);
+        strm.next_in = reinterpret_cast<Bytef *>(out.data());
+        strm.avail_in = uInt(out.size());
+        strm.next_out = reinterpret_cast<Bytef *>(inflated.data());
+        strm.avail_out = uInt(inflated.size());
+        REQUIRE(inflate(&strm, Z_FINISH) == Z_STREAM_END);
+        inflateEnd(&strm);
+        REQUIRE(inflated == data);
+
+        // the compressor can be reused
+        suil::Buffer again;
+        REQUIRE(gzip.compress(again, data.data(), data.size()));
+        REQUIRE(again.size() == out.size());
+        REQUIRE(memcmp(again.data(), out.data(), out.size()) == 0);
+    }
+
+    SECTION("Deflating messages") {
+        suil::Deflater deflater{15, true};
+        suil::Inflater inflater{15, true, data.size()};
+        size_t first{0};
+        for (int i = 0; i < 3; i++) {
+            suil::Buffer out, in;
+            REQUIRE(deflater.deflate(out, data.data(), data.size()));
+            REQUIRE(inflater.inflate(in, out.data(), out.size()));
+            REQUIRE(std::string_view{in.data(), in.size()} == data);
+            if (i == 0) {
+                first = out.size();
+            }
+            else {
+                // the context is reused, repeated messages compress better
+                REQUIRE(out.size() < first);
+            }
+        }
+
+        suil::Deflater noTakeover{10, false};
+        suil::Inflater small{10, false, 128};
+        suil::Buffer out, in;
+        REQUIRE(noTakeover.deflate(out, data.data(), data.size()));
+        // the message is larger than the allowed size
+        REQUIRE_FALSE(small.inflate(in, out.data(), out.size()));
+    }
+
+    SECTION("Compressing with an unsupported codec") {
+        suil::Buffer out;
+        REQUIRE_FALSE(suil::compress(out, suil::Codec::None, data.data(), data.size()));
+        REQUIRE(out.empty());
+        REQUIRE(suil::compress(out, suil::Codec::Deflate, data.data(), data.size()));
+        REQUIRE_FALSE(out.empty());
+    }
+}
+#endif
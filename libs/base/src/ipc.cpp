@@ -8,6 +8,7 @@
  * @date 2022-11-08
  */
 
+#include <algorithm>
 #include <csignal>
 #include <utility>
 #include <sys/shm.h>
@@ -37,12 +38,35 @@
 #define IPC_MAX_NUMBER_OF_MESSAGES uint8((1<<8)-1)
 #endif
 
+// the number of times a worker that keeps crashing is replaced before giving up
+#ifndef SUIL_IPC_RESPAWN_LIMIT
+#define SUIL_IPC_RESPAWN_LIMIT      5
+#endif
+
+// the delay before replacing a worker that crashed again, doubled on each crash
+#ifndef SUIL_IPC_RESPAWN_BACKOFF
+#define SUIL_IPC_RESPAWN_BACKOFF    100
+#endif
+
+#ifndef SUIL_IPC_RESPAWN_MAX_BACKOFF
+#define SUIL_IPC_RESPAWN_MAX_BACKOFF 5000
+#endif
+
+// a worker that runs this long (in milliseconds) before crashing is considered healthy
+#ifndef SUIL_IPC_RESPAWN_WINDOW
+#define SUIL_IPC_RESPAWN_WINDOW     10000
+#endif
+
 namespace suil {
 
     uint8 workerProcessId = 0;
     const uint8& spid = workerProcessId;
     bool workerStarted = false;
     const bool& started = workerStarted;
+    // when set, the parent replaces workers that die abnormally
+    static bool respawnWorkers = false;
+    // when set, each worker is pinned to it's assigned CPU
+    static bool pinWorkers = true;
 
 #define SPID_PARENT 0
 
@@ -67,6 +91,17 @@ namespace suil {
     static IPCInfo   *IPC = nullptr;
     static int shmIpcId;
 
+    /**
+     * Tracks the crashes of a worker, only used by the parent process
+     */
+    struct RespawnInfo {
+        int64       started{0};
+        uint8       failures{0};
+        // time at which a dead worker should be forked again, -1 if none is pending
+        int64       due{-1};
+    };
+    static RespawnInfo respawnInfo[256]{};
+
     struct WorkerLog : public LOGGER(WORKER) { WorkerLog() noexcept = default; } workerLog;
     static decltype(workerLog)* WLOG = &workerLog;
 
@@ -157,13 +192,17 @@ namespace suil {
             return ETIMEDOUT;
         }
 
-        void waitForSignal()
+        void waitForSignal(int64 deadline = Deadline::Inf)
         {
             if (signalNotif[0] == -1)
                 return;
 
             do {
-                int ev = fdwait(signalNotif[0], FDW_IN | FDW_ERR, Deadline::Inf);
+                int ev = fdwait(signalNotif[0], FDW_IN | FDW_ERR, deadline);
+                if (ev == 0) {
+                    // deadline expired without a notification
+                    break;
+                }
                 if (ev & FDW_IN) {
                     // notification received
                     uint8 sig{0};
@@ -192,7 +231,7 @@ namespace suil {
             prctl(PR_SET_NAME, name);
 
             // set process affinity
-            if (spid != SPID_PARENT) {
+            if (spid != SPID_PARENT && pinWorkers) {
                 cpu_set_t mask;
                 CPU_ZERO(&mask);
                 CPU_SET(wrk.cpu, &mask);
@@ -214,7 +253,13 @@ namespace suil {
             // Setup pipe's
             for (uint8 w = 0; w <= IPC->nworkers; w++) {
                 Worker& tmp = IPC->workers[w];
-                if (w == spid) {
+                if (spid == SPID_PARENT && respawnWorkers) {
+                    // the parent keeps both ends open so that the pipes can be
+                    // inherited by workers that get respawned
+                    nonblocking(tmp.fd[0]);
+                    nonblocking(tmp.fd[1]);
+                }
+                else if (w == spid) {
                     // close the writing end for current process
                     close(tmp.fd[1]);
                     nonblocking(tmp.fd[0]);
@@ -247,7 +292,7 @@ namespace suil {
             workerStarted = true;
         }
 
-        void initialize(int n)
+        void initialize(int n, bool respawn, bool pin)
         {
             int status = 0;
 
@@ -286,6 +331,8 @@ namespace suil {
                 Lock::reset(IPC->locks[i], 256 + i);
 
             // initialize worker memory and pipe descriptors
+            respawnWorkers = respawn && (n != 0);
+            pinWorkers = pin;
             IPC->nworkers = n;
             IPC->nactive = 0;
 
@@ -318,6 +365,168 @@ namespace suil {
                 lcritical(WLOG, "ipc::init failed");
         }
 
+        static int runWorker(Work& work, PostSpawnFunc& ps, int n)
+        {
+            int quit = 0;
+            lnotice(WLOG, "worker/%hhu started", spid);
+            // if not parent handle work in continuous loop
+            if (ps) {
+                // start post spawn delegate
+                try {
+                    quit = ps(spid);
+                }
+                catch(...) {
+                    lerror(WLOG, "unhandled exception in post spawn delegate");
+                    quit  = 1;
+                }
+            }
+
+            while (sigReceived == 0 && !quit) {
+                try {
+                    quit = work();
+                }
+                catch (const std::exception &ex) {
+                    if (sigReceived == 0)
+                        lerror(WLOG, "unhandled error in work: %s", ex.what());
+                    break;
+                }
+            }
+
+
+            lnotice(WLOG, "worker/%hhu exit", spid, sigReceived);
+            __sync_fetch_and_sub(&IPC->nactive, 1);
+
+            // force worker to exit
+            workerStarted = false;
+            if (n != 0)
+                exit(quit);
+            return quit;
+        }
+
+        /**
+         * Decides whether a worker that exited is replaced
+         * @param info the crash history of the worker
+         * @param status the exit status of the worker
+         * @param now the current time in milliseconds
+         * @return the delay in milliseconds before replacing the worker, -1 if the
+         * worker should not be replaced
+         */
+        static int64 respawnDelay(RespawnInfo& info, int status, int64 now)
+        {
+            if (!WIFSIGNALED(status)) {
+                // workers exit on their own when done or when they fail to start
+                // (e.g listening failed), a replacement would fail the same way
+                return -1;
+            }
+
+            if (now - info.started >= SUIL_IPC_RESPAWN_WINDOW) {
+                // the worker was running fine for a while
+                info.failures = 0;
+            }
+
+            if (info.failures >= SUIL_IPC_RESPAWN_LIMIT) {
+                return -1;
+            }
+
+            // the first crash is replaced immediately
+            int64 delay = (info.failures == 0)? 0 :
+                          std::min<int64>(int64(SUIL_IPC_RESPAWN_BACKOFF) << (info.failures - 1),
+                                          SUIL_IPC_RESPAWN_MAX_BACKOFF);
+            info.failures++;
+            return delay;
+        }
+
+        static uint8 reap()
+        {
+            // reap all the workers that have exited, scheduling a respawn for those that died abnormally
+            uint8 exited{0};
+            int status{0};
+            pid_t pid;
+            while ((pid = waitpid(WAIT_ANY, &status, WNOHANG)) > 0) {
+                for (uint8 w = 1; w <= IPC->nworkers; w++) {
+                    Worker& wrk = IPC->workers[w];
+                    if (wrk.pid != pid) continue;
+
+                    wrk.active = false;
+                    if (WIFSIGNALED(status)) {
+                        // a worker killed by a signal does not get a chance to deregister itself
+                        __sync_fetch_and_sub(&IPC->nactive, 1);
+                    }
+
+                    auto& info = respawnInfo[wrk.id];
+                    auto delay = respawnDelay(info, status, mnow());
+                    if (delay < 0) {
+                        if (WIFSIGNALED(status)) {
+                            lerror(WLOG, "worker/%hhu crashed %hhu times, not respawning {status=%d}",
+                                   wrk.id, info.failures, status);
+                        }
+                        else {
+                            ldebug(WLOG, "worker/%hhu exited {status=%d}, not respawning", wrk.id, status);
+                        }
+                        exited++;
+                        break;
+                    }
+
+                    lwarn(WLOG, "worker/%hhu died {status=%d}, respawning in %ld ms", wrk.id, status, delay);
+                    info.due = mnow() + delay;
+                    break;
+                }
+            }
+
+            return exited;
+        }
+
+        static uint8 respawn(Work& work, PostSpawnFunc& ps, int64& next)
+        {
+            // fork the workers whose respawn deadline has passed, `next` receives the earliest pending deadline
+            uint8 exited{0};
+            next = Deadline::Inf;
+            auto now = mnow();
+            for (uint8 w = 1; w <= IPC->nworkers; w++) {
+                auto& info = respawnInfo[w];
+                if (info.due < 0) continue;
+                if (info.due > now) {
+                    if (next == Deadline::Inf || info.due < next) {
+                        next = info.due;
+                    }
+                    continue;
+                }
+
+                Worker& wrk = IPC->workers[w];
+                info.due = -1;
+                info.started = now;
+                pid_t child = mfork();
+                if (child < 0) {
+                    lerror(WLOG, "respawning worker/%hhu failed: %s", wrk.id, errno_s);
+                    exited++;
+                }
+                else if (child == 0) {
+                    // the parent's signal notification pipe is not needed by workers
+                    closepipe(signalNotif);
+                    signal(SIGCHLD, SIG_DFL);
+                    sigReceived = 0;
+                    prctl(PR_SET_PDEATHSIG, SIGHUP);
+                    init(wrk);
+                    runWorker(work, ps, IPC->nworkers);
+                }
+            }
+
+            return exited;
+        }
+
+        static uint8 cancelRespawns()
+        {
+            // drop pending respawns, the workers are accounted for as exited
+            uint8 cancelled{0};
+            for (uint8 w = 1; w <= IPC->nworkers; w++) {
+                if (respawnInfo[w].due >= 0) {
+                    respawnInfo[w].due = -1;
+                    cancelled++;
+                }
+            }
+            return cancelled;
+        }
+
         int spawn(Work work, PostSpawnFunc ps, PostSpawnFunc pps) {
             if (IPC == NULL) {
                 lcritical(WLOG, "IPC not initialized, call ipc::init() before spawning a worker");
@@ -340,6 +549,7 @@ namespace suil {
                     init(IPC->workers[w]);
                     break;
                 }
+                respawnInfo[w] = RespawnInfo{mnow(), 0};
             }
 
             sigReceived = 0;
@@ -347,38 +557,7 @@ namespace suil {
                 init(IPC->workers[SPID_PARENT]);
 
             if (n == 0 || spid != SPID_PARENT) {
-                lnotice(WLOG, "worker/%hhu started", spid);
-                // if not parent handle work in continuous loop
-                if (ps) {
-                    // start post spawn delegate
-                    try {
-                        quit = ps(spid);
-                    }
-                    catch(...) {
-                        lerror(WLOG, "unhandled exception in post spawn delegate");
-                        quit  = 1;
-                    }
-                }
-
-                while (sigReceived == 0 && !quit) {
-                    try {
-                        quit = work();
-                    }
-                    catch (const std::exception &ex) {
-                        if (sigReceived == 0)
-                            lerror(WLOG, "unhandled error in work: %s", ex.what());
-                        break;
-                    }
-                }
-
-
-                lnotice(WLOG, "worker/%hhu exit", spid, sigReceived);
-                __sync_fetch_and_sub(&IPC->nactive, 1);
-
-                // force worker to exit
-                workerStarted = false;
-                if (n != 0)
-                    exit(quit);
+                runWorker(work, ps, n);
             }
             else {
                 Worker& wrk = IPC->workers[SPID_PARENT];
@@ -398,10 +577,12 @@ namespace suil {
 
                 // loop until a termination signal is received from all workers exited
                 uint8_t done = 0;
+                int64 next{Deadline::Inf};
                 while (!quit) {
                     if (sigReceived) {
                         quit = sigReceived != SIGCHLD;
                         if (quit) {
+                            done += cancelRespawns();
                             for (uint8_t w = 1; w <= n; w++) {
                                 // pass signal through to worker processes
                                 Worker& tmp = IPC->workers[w];
@@ -426,21 +607,32 @@ namespace suil {
 
                             continue;
                         }
+                        else if (respawnWorkers) {
+                            sigReceived = 0;
+                            done += reap();
+                        }
                         else {
                             done++;
+                            sigReceived = 0;
                         }
-                        sigReceived = 0;
                     }
 
-                    if (done >= IPC->nworkers || workerWait(false) == ECHILD) {
+                    if (done >= IPC->nworkers || (!respawnWorkers && workerWait(false) == ECHILD)) {
                         ldebug(WLOG, "all child process exited %hhu/%hhu",
                                      done, IPC->nactive);
                         quit = true;
                         continue;
                     }
 
+                    if (respawnWorkers) {
+                        // fork workers whose respawn deadline has passed without blocking signal handling
+                        done += respawn(work, ps, next);
+                        if (done >= IPC->nworkers) {
+                            continue;
+                        }
+                    }
 
-                    waitForSignal();
+                    waitForSignal(next);
                 }
                 lnotice(WLOG, "parent exiting (%d)", sigReceived);
                 workerStarted = false;
@@ -985,4 +1177,41 @@ namespace suil {
             }
         }
     }
-}
\ No newline at end of file
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+TEST_CASE("IPC worker respawn policy", "[ipc]")
+{
+    using suil::RespawnInfo;
+    using suil::ipc::respawnDelay;
+    RespawnInfo info{1000, 0};
+
+    SECTION("Workers that exit on their own are not replaced") {
+        REQUIRE(respawnDelay(info, W_EXITCODE(EXIT_SUCCESS, 0), 1100) == -1);
+        // e.g the worker could not listen on its address
+        REQUIRE(respawnDelay(info, W_EXITCODE(EADDRINUSE, 0), 1100) == -1);
+        REQUIRE(info.failures == 0);
+    }
+
+    SECTION("Workers that keep crashing are replaced with a backoff") {
+        int64 now{1100};
+        REQUIRE(respawnDelay(info, W_EXITCODE(0, SIGSEGV), now) == 0);
+        for (int i = 1; i < SUIL_IPC_RESPAWN_LIMIT; i++) {
+            info.started = now;
+            now += 10;
+            REQUIRE(respawnDelay(info, W_EXITCODE(0, SIGSEGV), now) ==
+                    std::min<int64>(int64(SUIL_IPC_RESPAWN_BACKOFF) << (i - 1), SUIL_IPC_RESPAWN_MAX_BACKOFF));
+        }
+        // the worker is given up on
+        info.started = now;
+        REQUIRE(respawnDelay(info, W_EXITCODE(0, SIGSEGV), now + 10) == -1);
+        REQUIRE(respawnDelay(info, W_EXITCODE(0, SIGABRT), now + 20) == -1);
+
+        // a worker that ran for a while before crashing is replaced immediately
+        REQUIRE(respawnDelay(info, W_EXITCODE(0, SIGSEGV), now + SUIL_IPC_RESPAWN_WINDOW) == 0);
+        REQUIRE(info.failures == 1);
+    }
+}
+#endif
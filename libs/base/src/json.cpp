@@ -3,9 +3,11 @@
 //
 
 
+#include "suil/base/arena.hpp"
 #include "suil/base/file.hpp"
 #include "suil/base/json.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
@@ -13,6 +15,166 @@
 #include <cstring>
 #include <lua.hpp>
 
+#if defined(__x86_64__) || defined(__i386__)
+#define SUIL_JSON_X86 1
+#include <immintrin.h>
+#endif
+
+#ifndef SUIL_JSON_INDEX_THRESHOLD
+#define SUIL_JSON_INDEX_THRESHOLD 16
+#endif
+
+namespace suil::json {
+
+    /*
+     * Vectorized scanning of the input, used by the decoder to skip over runs
+     * of plain string characters and white space in bulk. A null scanner
+     * means the input is parsed one byte at a time
+     */
+    struct JsonScanner {
+        /* first byte that is a quote, an escape, a control or a non ASCII character */
+        const char *(*string)(const char *s, const char *end);
+        /* first byte that is not white space */
+        const char *(*space)(const char *s, const char *end);
+    };
+
+    static const char *scan_string_scalar(const char *s, const char *end) {
+        while (s < end) {
+            auto c = (unsigned char) *s;
+            if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+                break;
+            s++;
+        }
+        return s;
+    }
+
+    static const char *scan_space_scalar(const char *s, const char *end) {
+        while (s < end && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t'))
+            s++;
+        return s;
+    }
+
+#ifdef SUIL_JSON_X86
+    __attribute__((target("sse2")))
+    static const char *scan_string_sse2(const char *s, const char *end) {
+        const auto quote = _mm_set1_epi8('"');
+        const auto escape = _mm_set1_epi8('\\');
+        const auto ctrl = _mm_set1_epi8(0x20);
+        while ((end - s) >= 16) {
+            auto v = _mm_loadu_si128((const __m128i *) s);
+            /* signed comparison catches both control and non ASCII characters */
+            auto m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape)),
+                                  _mm_cmplt_epi8(v, ctrl));
+            auto mask = _mm_movemask_epi8(m);
+            if (mask != 0)
+                return s + __builtin_ctz(mask);
+            s += 16;
+        }
+        return scan_string_scalar(s, end);
+    }
+
+    __attribute__((target("sse2")))
+    static const char *scan_space_sse2(const char *s, const char *end) {
+        const auto sp = _mm_set1_epi8(' '), nl = _mm_set1_epi8('\n');
+        const auto cr = _mm_set1_epi8('\r'), tab = _mm_set1_epi8('\t');
+        while ((end - s) >= 16) {
+            auto v = _mm_loadu_si128((const __m128i *) s);
+            auto m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+            auto mask = ~_mm_movemask_epi8(m) & 0xFFFF;
+            if (mask != 0)
+                return s + __builtin_ctz(mask);
+            s += 16;
+        }
+        return scan_space_scalar(s, end);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *scan_string_avx2(const char *s, const char *end) {
+        const auto quote = _mm256_set1_epi8('"');
+        const auto escape = _mm256_set1_epi8('\\');
+        const auto ctrl = _mm256_set1_epi8(0x20);
+        while ((end - s) >= 32) {
+            auto v = _mm256_loadu_si256((const __m256i *) s);
+            auto m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, escape)),
+                                     _mm256_cmpgt_epi8(ctrl, v));
+            auto mask = (uint32_t) _mm256_movemask_epi8(m);
+            if (mask != 0)
+                return s + __builtin_ctz(mask);
+            s += 32;
+        }
+        return scan_string_sse2(s, end);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *scan_space_avx2(const char *s, const char *end) {
+        const auto sp = _mm256_set1_epi8(' '), nl = _mm256_set1_epi8('\n');
+        const auto cr = _mm256_set1_epi8('\r'), tab = _mm256_set1_epi8('\t');
+        while ((end - s) >= 32) {
+            auto v = _mm256_loadu_si256((const __m256i *) s);
+            auto m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, tab)));
+            auto mask = ~(uint32_t) _mm256_movemask_epi8(m);
+            if (mask != 0)
+                return s + __builtin_ctz(mask);
+            s += 32;
+        }
+        return scan_space_sse2(s, end);
+    }
+#endif
+
+    static bool scanner_supported(Scanner sc) {
+        switch (sc) {
+            case Scanner::Scalar:
+                return true;
+#ifdef SUIL_JSON_X86
+            case Scanner::Sse2:
+                return __builtin_cpu_supports("sse2");
+            case Scanner::Avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    static JsonScanner make_scanner(Scanner sc) {
+        switch (sc) {
+#ifdef SUIL_JSON_X86
+            case Scanner::Sse2:
+                return {scan_string_sse2, scan_space_sse2};
+            case Scanner::Avx2:
+                return {scan_string_avx2, scan_space_avx2};
+#endif
+            default:
+                return {nullptr, nullptr};
+        }
+    }
+
+    static Scanner best_scanner() {
+        if (scanner_supported(Scanner::Avx2))
+            return Scanner::Avx2;
+        if (scanner_supported(Scanner::Sse2))
+            return Scanner::Sse2;
+        return Scanner::Scalar;
+    }
+
+    static Scanner sScannerType{best_scanner()};
+    static JsonScanner sScanner{make_scanner(sScannerType)};
+
+    Scanner scanner() {
+        return sScannerType;
+    }
+
+    bool scanner(Scanner sc) {
+        if (!scanner_supported(sc))
+            return false;
+        sScannerType = sc;
+        sScanner = make_scanner(sc);
+        return true;
+    }
+}
+
 #pragma region EXTERNAL_SOURCE
 
 namespace suil::json {
@@ -64,6 +226,15 @@ namespace suil::json {
 
     static JsonNode *json_first_child(const JsonNode *node);
 
+    struct JsonIndex;
+
+    enum : uint32_t {
+        /* node, key and string are allocated from a document's arena */
+        JSON_POOLED   = 0x01,
+        /* root node of a document, owns the document's arena */
+        JSON_DOCUMENT = 0x02
+    };
+
     struct JsonNode {
         /* only if parent is an object or array (NULL otherwise) */
         JsonNode *parent;
@@ -73,6 +244,7 @@ namespace suil::json {
         char *key; /* Must be valid UTF-8. */
 
         Tag tag;
+        uint32_t flags;
         union {
             /* JSON_BOOL */
             bool bool_;
@@ -87,10 +259,49 @@ namespace suil::json {
             /* JSON_OBJECT */
             struct {
                 JsonNode *head, *tail;
+                /* JSON_OBJECT members index, built for large objects */
+                JsonIndex *index;
             } children;
         };
     };
 
+    /*
+     * A decoded document, all the nodes and strings of the document are
+     * allocated from the same arena and released at once with the root
+     */
+    struct JsonDoc {
+        explicit JsonDoc(size_t hint)
+            : root{},
+              arena{hint}
+        {}
+
+        JsonNode root;
+        Arena    arena;
+    };
+
+    static_assert(std::is_standard_layout_v<JsonDoc>, "JsonDoc::root must be at the beginning of JsonDoc");
+
+    static inline JsonDoc *json_document(JsonNode *root) {
+        return reinterpret_cast<JsonDoc *>(root);
+    }
+
+    /*
+     * Hash index of an object's members, open addressing with linear probing
+     */
+    struct JsonIndex {
+        struct Slot {
+            size_t    hash;
+            JsonNode *node;
+        };
+
+        uint32_t capacity;
+        uint32_t size;
+
+        inline Slot *slots() {
+            return reinterpret_cast<Slot *>(this + 1);
+        }
+    };
+
     /* String buffer */
     typedef struct {
         char *cur;
@@ -127,16 +338,54 @@ namespace suil::json {
         sb->end = sb->start + alloc;
     }
 
-    static char *sb_finish(SB *sb) {
-        *sb->cur = 0;
-        assert(sb->start <= sb->cur && strlen(sb->start) == (size_t) (sb->cur - sb->start));
-        return sb->start;
-    }
-
     static void sb_free(SB *sb) {
         free(sb->start);
     }
 
+    /*
+     * State of a document being decoded, strings are unescaped into a
+     * single scratch buffer before being copied into the document and
+     * object keys are interned, i.e keys that repeat (e.g the keys of
+     * objects in an array) are stored once
+     */
+    struct JsonParser {
+        JsonParser(JsonDoc *doc, const char *end)
+            : doc{doc},
+              end{end},
+              scan{sScanner}
+        {
+            sb_init(&sb);
+        }
+
+        DISABLE_COPY(JsonParser);
+        DISABLE_MOVE(JsonParser);
+
+        ~JsonParser() {
+            sb_free(&sb);
+        }
+
+        char *dup(size_t len, bool key) {
+            if (!key) {
+                return doc->arena.dup(sb.start, len).data();
+            }
+            String tmp{sb.start, len, false};
+            auto it = keys.find(tmp);
+            if (it != keys.end()) {
+                return it->second;
+            }
+            auto str = doc->arena.dup(sb.start, len);
+            keys.emplace(str.peek(), str.data());
+            return str.data();
+        }
+
+        JsonDoc     *doc;
+        /* end of the input, the scanner does not read beyond it */
+        const char  *end;
+        JsonScanner  scan;
+        SB           sb;
+        UnorderedMap<char *> keys{};
+    };
+
 /*
  * Unicode helper functions
  *
@@ -348,21 +597,21 @@ namespace suil::json {
 #define is_space(c) ((c) == '\t' || (c) == '\n' || (c) == '\r' || (c) == ' ')
 #define is_digit(c) ((c) >= '0' && (c) <= '9')
 
-    static bool parse_value(const char **sp, JsonNode **out);
+    static bool parse_value(const char **sp, JsonNode **out, JsonParser *p);
 
-    static bool parse_string(const char **sp, char **out);
+    static bool parse_string(const char **sp, char **out, JsonParser *p, bool key = false);
 
     static bool parse_number(const char **sp, double *out);
 
-    static bool parse_array(const char **sp, JsonNode **out);
+    static bool parse_array(const char **sp, JsonNode **out, JsonParser *p);
 
-    static bool parse_object(const char **sp, JsonNode **out);
+    static bool parse_object(const char **sp, JsonNode **out, JsonParser *p);
 
     static bool parse_hex16(const char **sp, uint16_t *out);
 
     static bool expect_literal(const char **sp, const char *str);
 
-    static void skip_space(const char **sp);
+    static void skip_space(const char **sp, JsonParser *p = nullptr);
 
     static void emit_value(iod::encode_stream &out, const JsonNode *node);
 
@@ -386,6 +635,8 @@ namespace suil::json {
 
     static JsonNode *mknode(Tag tag);
 
+    static JsonNode *mknode(JsonParser *p, Tag tag);
+
     static void append_node(JsonNode *parent, JsonNode *child);
 
     static void prepend_node(JsonNode *parent, JsonNode *child);
@@ -399,12 +650,37 @@ namespace suil::json {
 
     static void json_delete(JsonNode *node);
 
+    /*
+     * Parse the value at @sp into a new document, the size of the input
+     * is used to size the document's arena blocks
+     */
+    static JsonNode *json_parse(const char **sp, const char *end) {
+        size_t hint = end - *sp;
+        auto doc = new JsonDoc(std::clamp(hint * 4, size_t(4096), size_t(SUIL_ARENA_MAX_BLOCK)));
+        JsonParser p{doc, end};
+        JsonNode *ret;
+
+        if (!parse_value(sp, &ret, &p)) {
+            delete doc;
+            return nullptr;
+        }
+
+        /* the root node is embedded in the document */
+        doc->root = *ret;
+        doc->root.flags = JSON_DOCUMENT;
+        if (ret->tag == Tag::JSON_ARRAY || ret->tag == Tag::JSON_OBJECT) {
+            for (auto child = ret->children.head; child != nullptr; child = child->next)
+                child->parent = &doc->root;
+        }
+        return &doc->root;
+    }
+
     static JsonNode *json_decode(const char *json) {
         const char *s = json;
         JsonNode *ret;
 
         skip_space(&s);
-        if (!parse_value(&s, &ret))
+        if ((ret = json_parse(&s, json + strlen(json))) == nullptr)
             return nullptr;
 
         skip_space(&s);
@@ -422,7 +698,8 @@ namespace suil::json {
 
             switch (node->tag) {
                 case Tag::JSON_STRING:
-                    free(node->string_);
+                    if (!(node->flags & (JSON_POOLED | JSON_DOCUMENT)))
+                        free(node->string_);
                     break;
                 case Tag::JSON_ARRAY:
                 case Tag::JSON_OBJECT: {
@@ -431,11 +708,16 @@ namespace suil::json {
                         next = child->next;
                         json_delete(child);
                     }
+                    free(node->children.index);
                     break;
                 }
                 default:;
             }
-            free(node);
+
+            if (node->flags & JSON_DOCUMENT)
+                delete json_document(node);
+            else if (!(node->flags & JSON_POOLED))
+                free(node);
         }
     }
 
@@ -443,7 +725,7 @@ namespace suil::json {
         const char *s = json;
 
         skip_space(&s);
-        if (!parse_value(&s, nullptr))
+        if (!parse_value(&s, nullptr, nullptr))
             return false;
 
         skip_space(&s);
@@ -470,15 +752,60 @@ namespace suil::json {
     }
 
     JsonNode *json_find_member(JsonNode *object, const char *name) {
+        return json_find_member(object, name, strlen(name));
+    }
+
+    static inline size_t key_hash(const char *key, size_t len) {
+        return std::hash<std::string_view>{}(std::string_view{key, len});
+    }
+
+    static inline bool key_equals(const char *key, const char *other, size_t len) {
+        return (strncmp(key, other, len) == 0) && (key[len] == '\0');
+    }
+
+    static bool index_insert(JsonIndex *index, JsonNode *member) {
+        size_t len = strlen(member->key);
+        size_t hash = key_hash(member->key, len);
+        auto mask = index->capacity - 1;
+        auto slots = index->slots();
+        for (auto i = hash & mask;; i = (i + 1) & mask) {
+            if (slots[i].node == nullptr) {
+                if ((index->size + 1) * 4 > index->capacity * 3)
+                    /* index is full */
+                    return false;
+                slots[i] = {hash, member};
+                index->size++;
+                return true;
+            }
+            if (slots[i].hash == hash && key_equals(slots[i].node->key, member->key, len))
+                /* first member with a key wins */
+                return true;
+        }
+    }
+
+    static JsonIndex *index_build(JsonNode *object) {
         JsonNode *member;
+        size_t count{0};
+        json_foreach(member, object)
+            count++;
 
-        if (object == nullptr || object->tag != Tag::JSON_OBJECT)
-            return nullptr;
+        uint32_t capacity = 16;
+        while (capacity < count * 2)
+            capacity <<= 1;
 
-        json_foreach(member, object)if (strcmp(member->key, name) == 0)
-                return member;
+        auto index = (JsonIndex *) calloc(1, sizeof(JsonIndex) + capacity * sizeof(JsonIndex::Slot));
+        if (index == nullptr)
+            out_of_memory();
+        index->capacity = capacity;
 
-        return nullptr;
+        json_foreach(member, object)
+            index_insert(index, member);
+        return index;
+    }
+
+    static void index_drop(JsonNode *object) {
+        free(object->children.index);
+        object->children.index = nullptr;
     }
 
     JsonNode *json_find_member(JsonNode *object, const char *key, size_t keyLen) {
@@ -487,14 +814,30 @@ namespace suil::json {
         if (object == nullptr || object->tag != Tag::JSON_OBJECT)
             return nullptr;
 
-        json_foreach(member, object) {
-            auto len = strlen(member->key);
-            if ((len == keyLen) &&
-                strncmp(member->key, key, keyLen) == 0) {
-                return member;
+        if (object->children.index != nullptr) {
+            auto index = object->children.index;
+            auto hash = key_hash(key, keyLen);
+            auto mask = index->capacity - 1;
+            auto slots = index->slots();
+            for (auto i = hash & mask; slots[i].node != nullptr; i = (i + 1) & mask) {
+                if (slots[i].hash == hash && key_equals(slots[i].node->key, key, keyLen))
+                    return slots[i].node;
             }
+            return nullptr;
         }
-        return nullptr;
+
+        size_t count{0};
+        json_foreach(member, object) {
+            if (key_equals(member->key, key, keyLen))
+                break;
+            count++;
+        }
+
+        if (count > SUIL_JSON_INDEX_THRESHOLD) {
+            /* subsequent lookups on this object will not scan */
+            object->children.index = index_build(object);
+        }
+        return member;
     }
 
     JsonNode *json_first_child(const JsonNode *node) {
@@ -511,6 +854,14 @@ namespace suil::json {
         return ret;
     }
 
+    static JsonNode *mknode(JsonParser *p, Tag tag) {
+        auto ret = static_cast<JsonNode *>(p->doc->arena.allocate(sizeof(JsonNode), alignof(JsonNode)));
+        memset(ret, 0, sizeof(JsonNode));
+        ret->tag = tag;
+        ret->flags = JSON_POOLED;
+        return ret;
+    }
+
     JsonNode *json_mknull(void) {
         return mknode(Tag::JSON_NULL);
     }
@@ -576,6 +927,8 @@ namespace suil::json {
     static void append_member(JsonNode *object, char *key, JsonNode *value) {
         value->key = key;
         append_node(object, value);
+        if (object->children.index != nullptr && !index_insert(object->children.index, value))
+            index_drop(object);
     }
 
     void json_append_element(JsonNode *array, JsonNode *element) {
@@ -605,6 +958,8 @@ namespace suil::json {
 
         value->key = json_strdup(key);
         prepend_node(object, value);
+        /* a prepended member takes precedence over existing members */
+        index_drop(object);
     }
 
     void json_remove_from_parent(JsonNode *node) {
@@ -620,7 +975,10 @@ namespace suil::json {
             else
                 parent->children.tail = node->prev;
 
-            free(node->key);
+            if (parent->tag == Tag::JSON_OBJECT)
+                index_drop(parent);
+            if (!(node->flags & JSON_POOLED))
+                free(node->key);
 
             node->parent = nullptr;
             node->prev = node->next = nullptr;
@@ -628,14 +986,14 @@ namespace suil::json {
         }
     }
 
-    static bool parse_value(const char **sp, JsonNode **out) {
+    static bool parse_value(const char **sp, JsonNode **out, JsonParser *p) {
         const char *s = *sp;
 
         switch (*s) {
             case 'n':
                 if (expect_literal(&s, "null")) {
                     if (out)
-                        *out = json_mknull();
+                        *out = mknode(p, Tag::JSON_NULL);
                     *sp = s;
                     return true;
                 }
@@ -643,8 +1001,10 @@ namespace suil::json {
 
             case 'f':
                 if (expect_literal(&s, "false")) {
-                    if (out)
-                        *out = json_mkbool(false);
+                    if (out) {
+                        *out = mknode(p, Tag::JSON_BOOL);
+                        (*out)->bool_ = false;
+                    }
                     *sp = s;
                     return true;
                 }
@@ -652,8 +1012,10 @@ namespace suil::json {
 
             case 't':
                 if (expect_literal(&s, "true")) {
-                    if (out)
-                        *out = json_mkbool(true);
+                    if (out) {
+                        *out = mknode(p, Tag::JSON_BOOL);
+                        (*out)->bool_ = true;
+                    }
                     *sp = s;
                     return true;
                 }
@@ -661,9 +1023,11 @@ namespace suil::json {
 
             case '"': {
                 char *str;
-                if (parse_string(&s, out ? &str : nullptr)) {
-                    if (out)
-                        *out = mkstring(str);
+                if (parse_string(&s, out ? &str : nullptr, p)) {
+                    if (out) {
+                        *out = mknode(p, Tag::JSON_STRING);
+                        (*out)->string_ = str;
+                    }
                     *sp = s;
                     return true;
                 }
@@ -671,14 +1035,14 @@ namespace suil::json {
             }
 
             case '[':
-                if (parse_array(&s, out)) {
+                if (parse_array(&s, out, p)) {
                     *sp = s;
                     return true;
                 }
                 return false;
 
             case '{':
-                if (parse_object(&s, out)) {
+                if (parse_object(&s, out, p)) {
                     *sp = s;
                     return true;
                 }
@@ -687,8 +1051,10 @@ namespace suil::json {
             default: {
                 double num;
                 if (parse_number(&s, out ? &num : nullptr)) {
-                    if (out)
-                        *out = json_mknumber(num);
+                    if (out) {
+                        *out = mknode(p, Tag::JSON_NUMBER);
+                        (*out)->number_ = num;
+                    }
                     *sp = s;
                     return true;
                 }
@@ -697,14 +1063,18 @@ namespace suil::json {
         }
     }
 
-    static bool parse_array(const char **sp, JsonNode **out) {
+    /*
+     * Nodes are allocated from the document being parsed, on failure
+     * they are released with the document
+     */
+    static bool parse_array(const char **sp, JsonNode **out, JsonParser *p) {
         const char *s = *sp;
-        JsonNode *ret = out ? json_mkarray() : nullptr;
+        JsonNode *ret = out ? mknode(p, Tag::JSON_ARRAY) : nullptr;
         JsonNode *element;
 
         if (*s++ != '[')
             goto failure;
-        skip_space(&s);
+        skip_space(&s, p);
 
         if (*s == ']') {
             s++;
@@ -712,12 +1082,12 @@ namespace suil::json {
         }
 
         for (;;) {
-            if (!parse_value(&s, out ? &element : nullptr))
+            if (!parse_value(&s, out ? &element : nullptr, p))
                 goto failure;
-            skip_space(&s);
+            skip_space(&s, p);
 
             if (out)
-                json_append_element(ret, element);
+                append_node(ret, element);
 
             if (*s == ']') {
                 s++;
@@ -726,7 +1096,7 @@ namespace suil::json {
 
             if (*s++ != ',')
                 goto failure;
-            skip_space(&s);
+            skip_space(&s, p);
         }
 
         success:
@@ -736,19 +1106,18 @@ namespace suil::json {
         return true;
 
         failure:
-        json_delete(ret);
         return false;
     }
 
-    static bool parse_object(const char **sp, JsonNode **out) {
+    static bool parse_object(const char **sp, JsonNode **out, JsonParser *p) {
         const char *s = *sp;
-        JsonNode *ret = out ? json_mkobject() : nullptr;
+        JsonNode *ret = out ? mknode(p, Tag::JSON_OBJECT) : nullptr;
         char *key;
         JsonNode *value;
 
         if (*s++ != '{')
             goto failure;
-        skip_space(&s);
+        skip_space(&s, p);
 
         if (*s == '}') {
             s++;
@@ -756,17 +1125,17 @@ namespace suil::json {
         }
 
         for (;;) {
-            if (!parse_string(&s, out ? &key : nullptr))
+            if (!parse_string(&s, out ? &key : nullptr, p, true))
                 goto failure;
-            skip_space(&s);
+            skip_space(&s, p);
 
             if (*s++ != ':')
-                goto failure_free_key;
-            skip_space(&s);
+                goto failure;
+            skip_space(&s, p);
 
-            if (!parse_value(&s, out ? &value : nullptr))
-                goto failure_free_key;
-            skip_space(&s);
+            if (!parse_value(&s, out ? &value : nullptr, p))
+                goto failure;
+            skip_space(&s, p);
 
             if (out)
                 append_member(ret, key, value);
@@ -778,7 +1147,7 @@ namespace suil::json {
 
             if (*s++ != ',')
                 goto failure;
-            skip_space(&s);
+            skip_space(&s, p);
         }
 
         success:
@@ -787,17 +1156,13 @@ namespace suil::json {
             *out = ret;
         return true;
 
-        failure_free_key:
-        if (out)
-            free(key);
         failure:
-        json_delete(ret);
         return false;
     }
 
-    bool parse_string(const char **sp, char **out) {
+    bool parse_string(const char **sp, char **out, JsonParser *p, bool key) {
         const char *s = *sp;
-        SB sb;
+        SB *sb{nullptr};
         char throwaway_buffer[4];
         /* enough space for a UTF-8 character */
         char *b;
@@ -806,14 +1171,29 @@ namespace suil::json {
             return false;
 
         if (out) {
-            sb_init(&sb);
-            sb_need(&sb, 4);
-            b = sb.cur;
+            /* unescape into the parser's scratch buffer */
+            sb = &p->sb;
+            sb->cur = sb->start;
+            sb_need(sb, 4);
+            b = sb->cur;
         } else {
             b = throwaway_buffer;
         }
 
         while (*s != '"') {
+            if (p != nullptr && p->scan.string != nullptr) {
+                /* copy a run of plain characters at once */
+                const char *e = p->scan.string(s, p->end);
+                if (e != s) {
+                    sb_need(sb, (int) (e - s) + 4);
+                    memcpy(sb->cur, s, e - s);
+                    sb->cur += e - s;
+                    b = sb->cur;
+                    s = e;
+                    continue;
+                }
+            }
+
             unsigned char c = *s++;
 
             /* Parse next character, and write it to b. */
@@ -888,9 +1268,9 @@ namespace suil::json {
              * and set up b to write another character.
              */
             if (out) {
-                sb.cur = b;
-                sb_need(&sb, 4);
-                b = sb.cur;
+                sb->cur = b;
+                sb_need(sb, 4);
+                b = sb->cur;
             } else {
                 b = throwaway_buffer;
             }
@@ -898,13 +1278,11 @@ namespace suil::json {
         s++;
 
         if (out)
-            *out = sb_finish(&sb);
+            *out = p->dup(sb->cur - sb->start, key);
         *sp = s;
         return true;
 
         failed:
-        if (out)
-            sb_free(&sb);
         return false;
     }
 
@@ -965,8 +1343,11 @@ namespace suil::json {
         return true;
     }
 
-    static void skip_space(const char **sp) {
+    static void skip_space(const char **sp, JsonParser *p) {
         const char *s = *sp;
+        if (p != nullptr && p->scan.space != nullptr && s < p->end && is_space(*s)) {
+            s = p->scan.space(s, p->end);
+        }
         while (is_space(*s))
             s++;
         *sp = s;
@@ -1578,7 +1959,7 @@ namespace suil::json {
         JsonNode *ret;
         const char *s = str;
         skip_space(&s);
-        if (!parse_value(&s, &ret)) {
+        if ((ret = json_parse(&s, str + sz)) == nullptr) {
             /* parsing json string failed */
             throw UnsupportedOperation("json::Object::decode invalid json string at ", (s-str));
         }
@@ -2450,6 +2831,53 @@ TEST_CASE("suil::json::Object", "[json][Object]")
             REQUIRE(size == str.size());
         }
 
+        WHEN("decoding into a document") {
+            String big{R"([{"id":1,"name":"one"},{"id":2,"name":"two"}])"};
+            auto arr = json::Object::decode(big);
+            REQUIRE(arr.mNode->flags == json::JSON_DOCUMENT);
+            auto first = arr[0], second = arr[1];
+            REQUIRE(first.mNode->flags == json::JSON_POOLED);
+            // repeated keys are interned
+            REQUIRE(first.mNode->children.head->key == second.mNode->children.head->key);
+            REQUIRE(2 == (int) second["id"]);
+            // values created outside the document can be added to it
+            first.set("extra", "Cali");
+            REQUIRE(String{"Cali"} == (String) first["extra"]);
+
+            Buffer ob{256};
+            ob << '{';
+            for (int i = 0; i < 64; i++) {
+                ob << (i? ",": "") << "\"key" << i << "\":" << i;
+            }
+            ob << '}';
+            auto obj = json::Object::decode(ob);
+            REQUIRE(obj.mNode->children.index == nullptr);
+            REQUIRE(63 == (int) obj["key63"]);
+            // large objects are indexed after the first lookup
+            REQUIRE_FALSE(obj.mNode->children.index == nullptr);
+            REQUIRE(10 == (int) obj["key10"]);
+            REQUIRE(obj.get("key64", false).isNull());
+            obj.set("key64", 64);
+            REQUIRE(64 == (int) obj["key64"]);
+        }
+
+        WHEN("decoding with the different scanners") {
+            // strings long enough to be scanned in bulk, with escapes and non ASCII characters
+            String str3 = R"({"a long key that spans more than a vector": "line one\nline \"two\" \u00e9 é and the rest of it",)"
+                          R"(    "arr"   :   [ 1,  "short",)" "\n\t\t" R"( "another long enough string value"  ] })";
+            auto best = json::scanner();
+            REQUIRE(json::scanner(json::Scanner::Scalar));
+            auto expected = json::encode(json::Object::decode(str3));
+            for (auto sc: {json::Scanner::Sse2, json::Scanner::Avx2}) {
+                if (json::scanner(sc)) {
+                    REQUIRE(json::encode(json::Object::decode(str3)) == expected);
+                    // control characters are not allowed in strings
+                    REQUIRE_THROWS(json::Object::decode(String{"[\"a string with a control character \x01\"]"}));
+                }
+            }
+            REQUIRE(json::scanner(best));
+        }
+
         WHEN("encoding JSON object") {
             /*encoding with wrapper functions */
             json::Object obj(json::Obj, "one", 1, "bool", true, "str", "Cali", "obj",
@@ -111,6 +111,15 @@ namespace suil {
         (void)urlDecode(static_cast<const char*>(data), (int)len, out, size);
         return String{out, size, true};
     }
+
+    String URL::decode(const void* data, size_t len, Arena& arena)
+    {
+        auto out = static_cast<char *>(arena.allocate(len+1, 1));
+        size_t size{len};
+        (void)urlDecode(static_cast<const char*>(data), (int)len, out, size);
+        out[size] = '\0';
+        return String{out, size, false};
+    }
 }
 
 #ifdef SUIL_UNITTEST
@@ -28,4 +28,15 @@ if (ENABLE_EXAMPLES)
             PRIVATE Suil::Db)
     target_link_libraries(Db-RedisExample
             PRIVATE Suil::Db)
+
+    # Benchmarks the decoding of large redis replies
+    add_executable(Db-RespBench
+            examples/resp_bench.cpp)
+    set_target_properties(Db-RespBench
+            PROPERTIES
+            RUNTIME_OUTPUT_NAME resp-bench)
+    target_include_directories(Db-RespBench
+            PRIVATE ${CMAKE_BINARY_DIR}/scc/public)
+    target_link_libraries(Db-RespBench
+            PRIVATE Suil::Db)
 endif()
\ No newline at end of file
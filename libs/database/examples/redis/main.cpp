@@ -24,6 +24,13 @@ void _verify(bool val, Args... args)
 
 #define verify(op, ...) _verify((op), __FILE__, ":", __LINE__, " ", #op, " ",  ##__VA_ARGS__)
 
+static coroutine void setCounter(db::RedisDb& db, int i, int& done)
+{
+    scoped(conn, db.connect());
+    conn.set(suil::catstr("Counter", i), i);
+    done++;
+}
+
 void start()
 {
     {
@@ -40,6 +47,33 @@ void start()
             auto ttl = conn.ttl("Username");
             verify(!conn.exists("Username"), "Key should have expired");
         }
+        {
+            // explicit pipeline, all commands are sent with one write
+            scoped(conn, db1.connect());
+            auto resps = conn.pipeline()
+                    ("SET", "Pipelined", "Yes")
+                    ("EXISTS", "Pipelined")
+                    ("GET", "Pipelined").exec();
+            verify(resps.size() == 3, "pipeline should return 3 responses");
+            verify(resps[0].status(), "pipelined SET should succeed");
+            verify((int) resps[1] == 1, "key Pipelined must exist");
+            verify((static_cast<String>(resps[2]) == "Yes"), "read key must be Yes");
+        }
+    }
+    {
+        db::RedisDbConfig config{};
+        config.AutoPipeline = true;
+        db::RedisDb db2("redis", 6379, std::move(config));
+        // commands of concurrent coroutines are coalesced on the shared connection
+        int done{0};
+        for (int i = 0; i < 10; i++) {
+            go(setCounter(db2, i, done));
+        }
+        while (done < 10) {
+            msleep(suil::Deadline{10});
+        }
+        scoped(conn, db2.connect());
+        verify((conn.get<int>("Counter9") == 9), "read key must be 9");
     }
 }
 
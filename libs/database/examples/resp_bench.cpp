@@ -0,0 +1,134 @@
+//
+// Created by Mpho Mbotho on 2021-07-14.
+//
+// Benchmarks the decoding of large MGET, HGETALL and LRANGE replies. Without
+// arguments the replies are generated and decoded by the RespParser as if they
+// were received in SUIL_REDIS_RX_CHUNK reads. Given the address of a redis server
+// (e.g resp-bench redis 6379), HGETALL and LRANGE are also timed against the server.
+//
+
+#include "suil/db/redis.hpp"
+
+#include <chrono>
+
+namespace db = suil::db;
+using suil::Buffer;
+using suil::String;
+
+static void bulk(Buffer& ob, size_t size, int i)
+{
+    ob << '$' << size << "\r\n";
+    for (size_t j = 0; j < size; j++) {
+        ob << char('a' + (i + j) % 26);
+    }
+    ob << "\r\n";
+}
+
+static Buffer mget(int count, size_t size)
+{
+    Buffer ob{count * (size + 16)};
+    ob << '*' << count << "\r\n";
+    for (int i = 0; i < count; i++) {
+        bulk(ob, size, i);
+    }
+    return ob;
+}
+
+static Buffer hgetall(int count, bool resp3)
+{
+    Buffer ob{size_t(count) * 64};
+    ob << (resp3? '%' : '*') << (resp3? count : count * 2) << "\r\n";
+    for (int i = 0; i < count; i++) {
+        auto field = suil::catstr("field:", i);
+        ob << '$' << field.size() << "\r\n" << field << "\r\n";
+        bulk(ob, 24, i);
+    }
+    return ob;
+}
+
+static Buffer lrange(int count)
+{
+    Buffer ob{size_t(count) * 256};
+    ob << '*' << count << "\r\n";
+    for (int i = 0; i < count; i++) {
+        // list items of varying sizes, e.g serialized events
+        bulk(ob, 16 + (i * 37) % 480, i);
+    }
+    return ob;
+}
+
+static void decode(const char *name, const Buffer& reply, int rounds)
+{
+    db::RespParser parser;
+    size_t entries{0}, reads{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        parser.reset();
+        size_t len{0};
+        auto status = db::RespParser::Incomplete;
+        while (status == db::RespParser::Incomplete and len < reply.size()) {
+            len = std::min(reply.size(), len + SUIL_REDIS_RX_CHUNK);
+            status = parser.feed(reply.data(), len);
+            reads++;
+        }
+        if (status != db::RespParser::Complete) {
+            fprintf(stderr, "decoding %s reply failed\n", name);
+            exit(EXIT_FAILURE);
+        }
+        entries += parser.entries().size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    auto mbs = double(reply.size()) * rounds / (1024 * 1024) / elapsed.count();
+    printf("  %-24s %8zu bytes %7zu entries %4zu reads/reply  %9.2f MB/s  %8.2f us/reply\n",
+           name, reply.size(), entries / rounds, reads / rounds, mbs,
+           elapsed.count() * 1e6 / rounds);
+}
+
+static void live(const String& host, int port, int count, int rounds)
+{
+    db::RedisDb rdb(host, port, db::RedisDbConfig{});
+    scoped(conn, rdb.connect());
+
+    auto pipe = conn.pipeline();
+    for (int i = 0; i < count; i++) {
+        pipe("HSET", "resp-bench:hash", suil::catstr("field:", i), String{'y', 24});
+        pipe("RPUSH", "resp-bench:list", String{'z', size_t(16 + (i * 37) % 480)});
+    }
+    pipe.exec();
+
+    auto time = [&](const char *name, auto func) {
+        auto start = std::chrono::steady_clock::now();
+        size_t entries{0};
+        for (int r = 0; r < rounds; r++) {
+            entries += func().entries.size();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        printf("  %-24s %7zu entries  %8.2f us/command\n",
+               name, entries / rounds, elapsed.count() * 1e6 / rounds);
+    };
+
+    time("HGETALL", [&] { return conn.send("HGETALL", "resp-bench:hash"); });
+    time("LRANGE", [&] { return conn.send("LRANGE", "resp-bench:list", 0, -1); });
+
+    conn.send("DEL", "resp-bench:hash", "resp-bench:list");
+}
+
+int main(int argc, char *argv[])
+{
+    int count = (argc > 3)? atoi(argv[3]) : 10000;
+    int rounds = (argc > 4)? atoi(argv[4]) : 100;
+    count = std::max(count, 1);
+
+    printf("decoding replies with %d elements, %d rounds\n", count, rounds);
+    decode("MGET (128 bytes)", mget(count, 128), rounds);
+    decode("HGETALL", hgetall(count, false), rounds);
+    decode("HGETALL (RESP3 map)", hgetall(count, true), rounds);
+    decode("LRANGE", lrange(count), rounds);
+
+    if (argc > 2) {
+        printf("redis server %s:%s\n", argv[1], argv[2]);
+        live(argv[1], atoi(argv[2]), count, rounds);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -61,6 +61,10 @@ namespace suil::db {
         using IsAutoIncrementKey = HasSymbol<AutoIncrementKeys, typename Column::left_t>;
         template <typename T>
         static constexpr bool IsQueryColumn = IsUniqueKey<T>::value or IsPrimaryKey<T>::value or IsAutoIncrementKey<T>::value;
+        template <typename S>
+        static constexpr bool IsQuerySymbol = HasSymbol<UniqueKeys, S>::value or
+                                              HasSymbol<PrimaryKeys, S>::value or
+                                              HasSymbol<AutoIncrementKeys, S>::value;
 
         static_assert(!std::is_same_v<PrimaryKeys, void>, "ORM requires at least one member to be a primary key");
 
@@ -75,22 +79,35 @@ namespace suil::db {
         bool find(const Column& column, T& o)
         {
             Buffer qb(32);
-            qb << "SELECT ";
-            bool first{true};
-            iod::foreach(WithoutIgnore()) | [&](const auto& m) {
-                if (!first) {
-                    qb << ", ";
-                }
-                qb << m.symbol().name();
-                first = false;
-            };
-
-            qb << " FROM " << mTable << " WHERE " << column.left.name() << " = ";
-            Connection::params(qb, 1);
-
+            Ego.selectQuery(qb, column.left.name());
             return conn(qb)(column.right) >> o;
         }
 
+        /**
+         * Finds an object for each of the given keys, on async connections the
+         * queries are pipelined (see PgSqlStatement::executeMany)
+         * @param column the unique column to search, e.g var(id)
+         * @param keys the values of the column to search for
+         * @param objs receives the objects found, objs[i] is the object matching keys[i]
+         * @return true if an object was found for all the keys
+         */
+        template<typename Symbol, typename Key, typename T>
+            requires (IsQuerySymbol<Symbol> and iod::IsMetaType<T>)
+        bool findMany(const Symbol& column, const std::vector<Key>& keys, std::vector<T>& objs)
+        {
+            Buffer qb(32);
+            Ego.selectQuery(qb, column.name());
+            objs.resize(keys.size());
+            auto stmt = conn(qb);
+            return stmt.executeMany(keys.size(),
+                [&](size_t i, auto&& send) {
+                    send(keys[i]);
+                },
+                [&](size_t i, auto& res) {
+                    return res >> objs[i];
+                });
+        }
+
         template<typename Column>
             requires IsQueryColumn<Column>
         bool has(Column column)
@@ -205,44 +222,36 @@ namespace suil::db {
             requires iod::IsMetaType<T>
         bool update(const T& o)
         {
-            auto pk = iod::intersect(typename T::Schema(), PrimaryKeys());
-            static_assert(decltype(pk)::size() > 0, "Primary key required in object used to update");
-
             Buffer qb(32);
-            qb << "UPDATE " << mTable << " SET ";
-            bool first{true};
-            int index{1};
-            using WoIgnore = removeIgnoreFields<WithoutAutoIncrement>;
-            auto values = iod::foreach2(WoIgnore{}) | [&](const auto& m) {
-                if (!first) {
-                    qb << ", ";
-                }
-                first = false;
-                qb << m.symbol().name() << " = ";
-                Connection::params(qb, index++);
-
-                return m.symbol() = m.symbol().member_access(o);
-            };
-
-            qb << " WHERE ";
-            first = true;
-            auto pks = iod::foreach2(pk) | [&](const auto& m) {
-                if (!first) {
-                    qb << " AND ";
-                }
-                first = false;
-                qb << m.symbol().name() << " = ";
-                Connection::params(qb, index++);
-
-                return m.symbol() = m.symbol().member_access(o);
-            };
-
+            Ego.updateQuery<T>(qb);
             auto req = conn(qb);
-            iod::apply(values, pks, req);
+            Ego.updateParams(o, req);
 
             return req.status();
         }
 
+        /**
+         * Updates all the given objects, on async connections the updates are
+         * pipelined (see PgSqlStatement::executeMany)
+         * @param objs the objects to update
+         * @return true if all the updates succeeded
+         */
+        template<typename T>
+            requires iod::IsMetaType<T>
+        bool updateMany(const std::vector<T>& objs)
+        {
+            Buffer qb(32);
+            Ego.updateQuery<T>(qb);
+            auto stmt = conn(qb);
+            return stmt.executeMany(objs.size(),
+                [&](size_t i, auto&& send) {
+                    Ego.updateParams(objs[i], send);
+                },
+                [&](size_t, auto&) {
+                    return true;
+                });
+        }
+
         template <typename T>
             requires iod::IsMetaType<T>
         void remove(const T& o)
@@ -283,6 +292,69 @@ namespace suil::db {
         }
 
     private:
+        template <typename Name>
+        void selectQuery(Buffer& qb, const Name& column)
+        {
+            qb << "SELECT ";
+            bool first{true};
+            iod::foreach(WithoutIgnore()) | [&](const auto& m) {
+                if (!first) {
+                    qb << ", ";
+                }
+                qb << m.symbol().name();
+                first = false;
+            };
+
+            qb << " FROM " << mTable << " WHERE " << column << " = ";
+            Connection::params(qb, 1);
+        }
+
+        template <typename T>
+        void updateQuery(Buffer& qb)
+        {
+            auto pk = iod::intersect(typename T::Schema(), PrimaryKeys());
+            static_assert(decltype(pk)::size() > 0, "Primary key required in object used to update");
+
+            qb << "UPDATE " << mTable << " SET ";
+            bool first{true};
+            int index{1};
+            using WoIgnore = removeIgnoreFields<WithoutAutoIncrement>;
+            iod::foreach(WoIgnore{}) | [&](const auto& m) {
+                if (!first) {
+                    qb << ", ";
+                }
+                first = false;
+                qb << m.symbol().name() << " = ";
+                Connection::params(qb, index++);
+            };
+
+            qb << " WHERE ";
+            first = true;
+            iod::foreach(pk) | [&](const auto& m) {
+                if (!first) {
+                    qb << " AND ";
+                }
+                first = false;
+                qb << m.symbol().name() << " = ";
+                Connection::params(qb, index++);
+            };
+        }
+
+        template <typename T, typename Func>
+        void updateParams(const T& o, Func& func)
+        {
+            // parameters are bound in the order used by updateQuery
+            auto pk = iod::intersect(typename T::Schema(), PrimaryKeys());
+            using WoIgnore = removeIgnoreFields<WithoutAutoIncrement>;
+            auto values = iod::foreach2(WoIgnore{}) | [&](const auto& m) {
+                return m.symbol() = m.symbol().member_access(o);
+            };
+            auto pks = iod::foreach2(pk) | [&](const auto& m) {
+                return m.symbol() = m.symbol().member_access(o);
+            };
+            iod::apply(values, pks, func);
+        }
+
         String mTable{};
         Connection& conn;
     };
@@ -22,6 +22,7 @@
 #include <netinet/in.h>
 #include <deque>
 #include <memory>
+#include <unordered_map>
 
 namespace suil::db {
 
@@ -37,19 +38,33 @@ namespace suil::db {
         };
 
         enum pg_types_t {
+            BOOLOID  = 16,
             BYTEAOID = 17,
             CHAROID  = 18,
+            NAMEOID  = 19,
             INT8OID  = 20,
             INT2OID  = 21,
             INT4OID  = 23,
             TEXTOID  = 25,
+            OIDOID   = 26,
             JSONOID = 114,
+            XMLOID  = 142,
             FLOAT4OID = 700,
             FLOAT8OID = 701,
             INT2ARRAYOID   = 1005,
             INT4ARRAYOID   = 1007,
             TEXTARRAYOID   = 1009,
+            INT8ARRAYOID   = 1016,
             FLOAT4ARRAYOID = 1021,
+            FLOAT8ARRAYOID = 1022,
+            BPCHAROID      = 1042,
+            VARCHAROID     = 1043,
+            DATEOID        = 1082,
+            TIMEOID        = 1083,
+            TIMESTAMPOID   = 1114,
+            TIMESTAMPTZOID = 1184,
+            NUMERICOID     = 1700,
+            UUIDOID        = 2950,
             JSONBOID = 3802
 
         };
@@ -293,12 +308,155 @@ namespace suil::db {
             to.u32_1 = ntohl(from->u32_2);
             to.u32_2 = ntohl(from->u32_1);
         }
+
+        /**
+         * decode a number received in binary format
+         * @param buf the value as received from the server
+         * @param len the length of the value
+         * @param type the type of the column the value belongs to
+         * @param v the decoded value
+         * @return false if the column type is not a supported numeric type
+         */
+        template <typename Args>
+            requires std::is_arithmetic_v<Args>
+        static bool binary_to_vhod(const char *buf, int len, Oid type, Args& v) {
+            switch (type) {
+                case BOOLOID:
+                case CHAROID:
+                    if (len < 1) return false;
+                    v = Args(*buf);
+                    return true;
+                case INT2OID: {
+                    if (len < 2) return false;
+                    short int tmp;
+                    vnod_to_vhod(buf, tmp);
+                    v = Args(tmp);
+                    return true;
+                }
+                case INT4OID: {
+                    if (len < 4) return false;
+                    int tmp;
+                    vnod_to_vhod(buf, tmp);
+                    v = Args(tmp);
+                    return true;
+                }
+                case INT8OID: {
+                    if (len < 8) return false;
+                    long long tmp;
+                    vnod_to_vhod(buf, tmp);
+                    v = Args(tmp);
+                    return true;
+                }
+                case FLOAT4OID: {
+                    if (len < 4) return false;
+                    float tmp;
+                    vnod_to_vhod(buf, tmp);
+                    v = Args(tmp);
+                    return true;
+                }
+                case FLOAT8OID: {
+                    if (len < 8) return false;
+                    double tmp;
+                    vnod_to_vhod(buf, tmp);
+                    v = Args(tmp);
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * convert a value received in binary format to the text format the server
+         * would have sent
+         * @param out receives the text
+         * @return false if the binary format of the type is already it's text
+         * format (e.g text, varchar) or the type is not supported
+         */
+        bool binary_to_text(const char *buf, int len, Oid type, std::string& out);
+
+        /**
+         * @return true if values of the given type can be read when received
+         * in binary format
+         */
+        bool binary_decodable(Oid type);
+
+        template <typename Args>
+            requires std::is_arithmetic_v<Args>
+        static bool binary_array_value(const char *buf, int len, Oid type, Args& v) {
+            return binary_to_vhod(buf, len, type, v);
+        }
+
+        static inline bool binary_array_value(const char *buf, int len, Oid, String& v) {
+            v = String{buf, size_t(len), false}.dup();
+            return true;
+        }
+
+        /**
+         * decode a one dimensional array received in binary format
+         */
+        template <typename Args>
+        static bool parse_binary_array(std::vector<Args>& to, const char *from, int len) {
+            // ndim, has null, element type
+            if (len < 12) return false;
+            int ndim, hasNull, elemType;
+            vnod_to_vhod(from, ndim);
+            vnod_to_vhod(from + 4, hasNull);
+            vnod_to_vhod(from + 8, elemType);
+            if (ndim == 0) {
+                return true;
+            }
+            if ((ndim != 1) or (len < 20)) {
+                // only single dimension arrays are supported
+                return false;
+            }
+
+            int count;
+            vnod_to_vhod(from + 12, count);
+            const char *p = from + 20, *end = from + len;
+            to.reserve(to.size() + count);
+            for (int i = 0; i < count; i++) {
+                if ((p + 4) > end) return false;
+                int elen;
+                vnod_to_vhod(p, elen);
+                p += 4;
+                if (elen < 0) {
+                    // null element
+                    to.emplace_back();
+                    continue;
+                }
+                if ((p + elen) > end) return false;
+                Args e{};
+                if (!binary_array_value(p, elen, Oid(elemType), e)) {
+                    return false;
+                }
+                to.push_back(std::move(e));
+                p += elen;
+            }
+            return true;
+        }
     }
 
     class PgSqlStatement final : LOGGER(PGSQL_CONN) {
     public:
         using ErrorCallback = std::function<void(void)>;
-        PgSqlStatement(PGconn *conn, String stmt, bool async, std::int64_t timeout = -1);
+        // a statement prepared on a connection
+        struct Prepared {
+            // used to name the statement
+            std::size_t id{0};
+            // whether the results of the statement are received in binary format, decided
+            // from the types of its result columns when the statement is prepared
+            bool        binary{false};
+        };
+        // the statements prepared on a connection, the key is the text of the statement
+        // and the types of it's parameters
+        using PreparedMap = std::unordered_map<std::string, Prepared>;
+        PgSqlStatement(PGconn *conn,
+                       String stmt,
+                       bool async,
+                       std::int64_t timeout = -1,
+                       PreparedMap* prepared = nullptr,
+                       bool binary = false);
 
         template <typename... Args>
         auto& operator()(Args&&... args)
@@ -308,7 +466,7 @@ namespace suil::db {
             }
             catch (...) {
                 // reset connection on error and re-clear
-                PQreset(conn);
+                Ego.reset();
                 throw;
             }
         }
@@ -321,7 +479,7 @@ namespace suil::db {
             }
             catch (...) {
                 // reset connection on error
-                PQreset(conn);
+                Ego.reset();
 
                 if (ec != nullptr)
                     ec();
@@ -333,38 +491,16 @@ namespace suil::db {
         template <typename... Args>
         auto& execute(Args&&... args)
         {
-            const size_t size = sizeof...(Args)+1;
-            const char *values[size] = {nullptr};
-            int  lens[size]    = {0};
-            int  bins[size]    = {0};
-            Oid  oids[size]    = {InvalidOid};
-
-            // declare a buffer that will hold values transformed to network order
-            unsigned long long norder[size] = {0};
-            // collects all buffers that were needed to submit a transaction
-            // and frees them after the transaction
-            struct garbage_collector {
-                std::vector<void*> bag{};
-
-                ~garbage_collector() {
-                    for(auto b: bag)
-                        free(b);
-                }
-            } gc;
-
-            int i = 0;
-            iod::foreach(std::forward_as_tuple(args...)) |
-            [&](auto& m) {
-                void *tmp = this->bind(values[i], oids[i], lens[i], bins[i], norder[i], m);
-                if (tmp != nullptr) {
-                    /* add to garbage collector*/
-                    gc.bag.push_back(tmp);
-                }
-                i++;
-            };
+            params_t<sizeof...(Args)+1> p;
+            Ego.bindParams(p, args...);
 
             // Clear the results (important for reused statements)
             results.clear();
+            const int nParams = (int) sizeof...(Args);
+            // only prepared statements have their results described before they are
+            // executed, other statements receive their results in text format
+            int format{0};
+            char name[32] = {0};
             if (async) {
                 int sock = PQsocket(conn);
                 if (sock < 0) {
@@ -372,102 +508,36 @@ namespace suil::db {
                 }
                 fdclean(sock);
 
-                int status = PQsendQueryParams(
-                        conn,
-                        stmt.data(),
-                        (int) sizeof...(Args),
-                        oids,
-                        values,
-                        lens,
-                        bins,
-                        0);
+                int status{0};
+                if (prepared != nullptr) {
+                    Ego.prepare(sock, name, p.oids, nParams, format);
+                    status = PQsendQueryPrepared(conn, name, nParams, p.values, p.lens, p.bins, format);
+                }
+                else {
+                    status = PQsendQueryParams(conn, stmt.data(), nParams, p.oids, p.values, p.lens, p.bins, format);
+                }
                 if (!status) {
                     ierror("[%d] ASYNC QUERY: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
                     throw PgSqlException("[", sock, "] ASYNC QUERY: ", stmt(), " failed: ", PQerrorMessage(conn));
                 }
 
-                bool wait = true, err = false;
-                while (!err && PQflush(conn)) {
-                    itrace("[%d] ASYNC QUERY: %s wait write %ld", sock, stmt(), timeout);
-                    if (waitWrite(sock)) {
-                        ierror("[%d] ASYNC QUERY: % wait write failed: %s", sock, stmt(), errno_s);
-                        err  = true;
-                        continue;
-                    }
-                }
-
-                while (wait && !err) {
-                    if (PQisBusy(conn)) {
-                        itrace("ASYNC QUERY: %s wait read %ld", stmt.data(), timeout);
-                        if (waitRead(sock)) {
-                            ierror("ASYNC QUERY: %s wait read failed: %s", stmt.data(), errno_s);
-                            err = true;
-                            continue;
-                        }
-                    }
-
-                    // asynchronously wait for results
-                    if (!PQconsumeInput(conn)) {
-                        ierror("[%d] ASYNC QUERY: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
-                        err = true;
-                        continue;
-                    }
-
-                    PGresult *result = PQgetResult(conn);
-                    if (result == nullptr) {
-                        /* async query done */
-                        wait = false;
-                        continue;
-                    }
-
-                    switch (PQresultStatus(result)) {
-                        case PGRES_COPY_OUT:
-                        case PGRES_COPY_IN:
-                        case PGRES_COPY_BOTH:
-                        case PGRES_NONFATAL_ERROR:
-                            PQclear(result);
-                            break;
-                        case PGRES_COMMAND_OK:
-                            itrace("[%d] ASYNC QUERY: continue waiting for results", sock);
-                            PQclear(result);
-                            break;
-                        case PGRES_TUPLES_OK:
-#if PG_VERSION_NUM >= 90200
-                            case PGRES_SINGLE_TUPLE:
-#endif
-                            results.add(result);
-                            break;
-
-                        default:
-                            ierror("[%d] ASYNC QUERY: %s failed: %s",
-                                   sock, stmt(), PQerrorMessage(conn));
-                            PQclear(result);
-                            err = true;
-                    }
-                }
-
-                if (err) {
-                    /* error occurred and was reported in logs */
-                    fdclear(sock);
-                    auto msg = PQerrorMessage(conn);
-                    throw PgSqlException("[", sock, "] query failed: ",
-                                         (msg != nullptr && msg[0] != '\0')? msg: strerror(errno));
-                }
-
+                Ego.waitResults(sock);
                 itrace("[%d] ASYNC QUERY: received %d results", sock, results.results.size());
             }
             else {
                 int sock = PQsocket(conn);
 
-                PGresult *result = PQexecParams(
-                        conn,
-                        stmt.data(),
-                        (int) sizeof...(Args),
-                        oids,
-                        values,
-                        lens,
-                        bins,
-                        0);
+                PGresult *result{nullptr};
+                if (prepared != nullptr) {
+                    if (!Ego.prepare(sock, name, p.oids, nParams, format)) {
+                        results.fail();
+                        return *this;
+                    }
+                    result = PQexecPrepared(conn, name, nParams, p.values, p.lens, p.bins, format);
+                }
+                else {
+                    result = PQexecParams(conn, stmt.data(), nParams, p.oids, p.values, p.lens, p.bins, format);
+                }
                 ExecStatusType status = PQresultStatus(result);
 
                 if ((status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK)) {
@@ -490,6 +560,103 @@ namespace suil::db {
             return *this;
         }
 
+        /**
+         * Executes the statement once for each of \a count parameter sets. When libpq
+         * supports pipeline mode (LIBPQ_HAS_PIPELINING) and the connection is async,
+         * the executions are sent back to back and the results are collected in order
+         * afterwards, saving a round trip per execution, a failed execution aborts the
+         * executions sent after it. Otherwise the executions run one after the other
+         *
+         * @param count the number of times to execute the statement
+         * @param binder invoked as `binder(i, send)` for each execution, it must call
+         * `send(args...)` exactly once with the parameters of the i'th execution
+         * @param reader invoked as `reader(i, stmt)` once the results of the i'th
+         * execution are available and the execution succeeded, returns false if
+         * reading the results failed
+         * @return true if all the executions succeeded and were read successfully
+         */
+        template <typename Binder, typename Reader>
+        bool executeMany(size_t count, Binder binder, Reader reader)
+        {
+            try {
+                bool ok{true};
+#ifdef LIBPQ_HAS_PIPELINING
+                if (async and (count > 1)) {
+                    int sock = PQsocket(conn);
+                    if (sock < 0) {
+                        throw PgSqlException("invalid PGSQL socket");
+                    }
+                    fdclean(sock);
+
+                    results.clear();
+                    int format{0};
+                    char name[32] = {0};
+                    size_t sent{0};
+                    for (size_t i = 0; i < count; i++) {
+                        binder(i, [&](auto&&... args) {
+                            params_t<sizeof...(args)+1> p;
+                            Ego.bindParams(p, args...);
+                            const int nParams = (int) sizeof...(args);
+                            if (sent == 0) {
+                                // prepare() waits for the server's reply, which is only
+                                // possible before entering pipeline mode
+                                if (prepared != nullptr) {
+                                    Ego.prepare(sock, name, p.oids, nParams, format);
+                                }
+                                Ego.enterPipeline(sock);
+                            }
+
+                            int status{0};
+                            if (prepared != nullptr) {
+                                status = PQsendQueryPrepared(conn, name, nParams, p.values, p.lens, p.bins, format);
+                            }
+                            else {
+                                status = PQsendQueryParams(conn, stmt.data(), nParams, p.oids, p.values, p.lens, p.bins, format);
+                            }
+                            if (!status) {
+                                ierror("[%d] PIPELINE QUERY: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+                                throw PgSqlException("[", sock, "] PIPELINE QUERY: ", stmt(), " failed: ", PQerrorMessage(conn));
+                            }
+                            sent++;
+                        });
+                    }
+
+                    if (sent == 0) {
+                        return ok;
+                    }
+
+                    Ego.syncPipeline(sock);
+                    for (size_t i = 0; i < sent; i++) {
+                        if (Ego.pipelineResults(sock)) {
+                            results.reset();
+                            ok = reader(i, Ego) and ok;
+                        }
+                        else {
+                            ok = false;
+                        }
+                        results.clear();
+                    }
+                    Ego.exitPipeline(sock);
+                    itrace("[%d] PIPELINE QUERY: %s executed %zu times", sock, stmt(), sent);
+                    return ok;
+                }
+#endif
+                // blocking connections and libpq without pipeline mode execute one after the other
+                for (size_t i = 0; i < count; i++) {
+                    binder(i, [&](auto&&... args) {
+                        Ego.execute(args...);
+                    });
+                    ok = Ego.status() and reader(i, Ego) and ok;
+                }
+                return ok;
+            }
+            catch (...) {
+                // reset connection on error, this also leaves pipeline mode
+                Ego.reset();
+                throw;
+            }
+        }
+
         template <typename... O>
         inline bool operator>>(iod::sio<O...>& o)
         {
@@ -579,9 +746,50 @@ namespace suil::db {
             return results.empty();
         }
 
-    private:
+    private suil_ut:
         int waitRead(int sock);
         int waitWrite(int sock);
+        void waitResults(int sock);
+        bool prepare(int sock, char *name, const Oid *oids, int nParams, int& format);
+        bool describe(int sock, const char *name);
+        void reset();
+
+        void enterPipeline(int sock);
+        void syncPipeline(int sock);
+        bool pipelineResults(int sock);
+        void exitPipeline(int sock);
+
+        template <size_t N>
+        struct params_t {
+            const char *values[N] = {nullptr};
+            int  lens[N]    = {0};
+            int  bins[N]    = {0};
+            Oid  oids[N]    = {InvalidOid};
+            // holds values transformed to network order
+            unsigned long long norder[N] = {0};
+            // buffers that were needed to submit the query
+            std::vector<void*> bag{};
+
+            ~params_t() {
+                for (auto b: bag)
+                    free(b);
+            }
+        };
+
+        template <size_t N, typename... Args>
+        void bindParams(params_t<N>& p, Args&... args)
+        {
+            int i = 0;
+            iod::foreach(std::forward_as_tuple(args...)) |
+            [&](auto& m) {
+                void *tmp = this->bind(p.values[i], p.oids[i], p.lens[i], p.bins[i], p.norder[i], m);
+                if (tmp != nullptr) {
+                    /* add to garbage collector*/
+                    p.bag.push_back(tmp);
+                }
+                i++;
+            };
+        }
 
         template <typename T>
             requires iod::IsMetaType<T>
@@ -756,11 +964,35 @@ namespace suil::db {
                 return it != results.end();
             }
 
+            inline bool isBinary(int col) {
+                return PQfformat(*it, col) == 1;
+            }
+
+            /**
+             * get the textual representation of a value, values received in binary
+             * format are converted to their text format if necessary
+             */
+            strview text(char *data, int col) {
+                int len = PQgetlength(*it, row, col);
+                if (isBinary(col) and __internal::binary_to_text(data, len, PQftype(*it, col), scratch)) {
+                    return strview{scratch};
+                }
+                return strview{data, size_t(len)};
+            }
+
             template <typename __V, typename std::enable_if<std::is_arithmetic<__V>::value,void>::type* = nullptr>
             bool read(__V& v, int col) {
                 if (!empty()) {
                     char *data = PQgetvalue(*it, row, col);
                     if (data != nullptr) {
+                        if (isBinary(col)) {
+                            if (PQgetisnull(*it, row, col)) {
+                                // null values are not decoded
+                                return true;
+                            }
+                            return __internal::binary_to_vhod(
+                                    data, PQgetlength(*it, row, col), PQftype(*it, col), v);
+                        }
                         //__internal::vnod_to_vhod(data, v);
                         String tmp(data);
                         suil::cast(data, v);
@@ -776,6 +1008,10 @@ namespace suil::db {
                     char *data = PQgetvalue(*it, row, col);
                     if (data != nullptr) {
                         int len = PQgetlength(*it, row, col);
+                        if (isBinary(col)) {
+                            return PQgetisnull(*it, row, col) or
+                                   __internal::parse_binary_array(v, data, len);
+                        }
                         __internal::parse_array(v, data);
                         return true;
                     }
@@ -787,9 +1023,8 @@ namespace suil::db {
                 if (!empty()) {
                     char *data = PQgetvalue(*it, row, col);
                     if (data != nullptr) {
-                        int len = PQgetlength(*it, row, col);
-                        v.resize((size_t) len);
-                        memcpy(&v[0], data, (size_t) len);
+                        auto str = text(data, col);
+                        v.assign(str.data(), str.size());
                         return true;
                     }
                 }
@@ -800,8 +1035,7 @@ namespace suil::db {
                 if (!empty()) {
                     char *data = PQgetvalue(*it, row, col);
                     if (data != nullptr) {
-                        int len = PQgetlength(*it, row, col);
-                        v = strview{data, size_t(len)};
+                        v = text(data, col);
                         return true;
                     }
                 }
@@ -837,8 +1071,8 @@ namespace suil::db {
                 if (!empty()) {
                     char *data = PQgetvalue(*it, row, col);
                     if (data != nullptr) {
-                        int len = PQgetlength(*it, row, col);
-                        v = std::move(String(data, len, false).dup());
+                        auto str = text(data, col);
+                        v = std::move(String(str.data(), str.size(), false).dup());
                         return true;
                     }
                 }
@@ -853,6 +1087,8 @@ namespace suil::db {
                     results.erase(tmp);
                     tmp = results.begin();
                 }
+                // a statement is reused for many executions
+                failure = false;
                 reset();
             }
 
@@ -882,6 +1118,9 @@ namespace suil::db {
             bool failed() const {
                 return failure;
             }
+
+            // holds values converted from binary to text
+            std::string scratch{};
         };
 
     private:
@@ -889,6 +1128,8 @@ namespace suil::db {
         String       stmt{};
         bool         async{false};
         std::int64_t timeout{-1};
+        PreparedMap  *prepared{nullptr};
+        bool         binary{false};
         pgsql_result results{};
 
     };
@@ -899,7 +1140,17 @@ namespace suil::db {
         using StmtMapPtr = std::shared_ptr<StmtMap>;
         using FreeConnFunc = std::function<void(PgSqlConnection*)>;
     public:
-        PgSqlConnection(PGconn *conn, String dbname, bool async, std::int64_t timeout, FreeConnFunc freeConn);
+        // statements prepared on the server outlive the connection object, they
+        // belong to the underlying PGconn handle which is cached
+        using PreparedMapPtr = std::shared_ptr<PgSqlStatement::PreparedMap>;
+
+        PgSqlConnection(PGconn *conn,
+                        String dbname,
+                        bool async,
+                        std::int64_t timeout,
+                        FreeConnFunc freeConn,
+                        PreparedMapPtr prepared = nullptr,
+                        bool binary = false);
         PgSqlConnection() = default;
 
         DISABLE_COPY(PgSqlConnection);
@@ -998,6 +1249,8 @@ namespace suil::db {
         friend struct PgSqlDb;
         PGconn        *conn{nullptr};
         StmtMap       stmtCache;
+        PreparedMapPtr prepared{nullptr};
+        bool          binary{false};
         bool          async{false};
         std::int64_t  timeout{-1};
         FreeConnFunc  freeConn{nullptr};
@@ -1076,6 +1329,8 @@ namespace suil::db {
             async      = opts.get(var(ASYNC), false);
             timeout    = opts.get(var(TIMEOUT), -1);
             keepAlive  = opts.get(var(EXPIRES), -1);
+            prepared   = opts.get(var(PREPARED), false);
+            binary     = opts.get(var(BINARY), false);
             dbname     = String{opts.get(var(name), "public")}.dup();
 
             if (keepAlive > 0 && keepAlive < 3000) {
@@ -1102,6 +1357,7 @@ namespace suil::db {
         struct conn_handle_t {
             PGconn  *conn;
             int64_t alive;
+            Connection::PreparedMapPtr prepared{nullptr};
             inline void cleanup() {
                 if (conn) {
                     PQfinish(conn);
@@ -1114,6 +1370,8 @@ namespace suil::db {
         struct UseCount {int acquire{0}, release{0}; uint32 user{0}; };
         std::map<int, UseCount> useCount;
         bool             async{false};
+        bool             prepared{false};
+        bool             binary{false};
         int64_t          keepAlive{-1};
         int64_t          timeout{-1};
         Channel<uint8_t> notify{1};
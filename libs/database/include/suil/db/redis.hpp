@@ -9,17 +9,96 @@
 
 #include <deque>
 #include <list>
+#include <map>
 #include <suil/base/channel.hpp>
 #include <suil/base/blob.hpp>
 #include <suil/base/exception.hpp>
 #include <suil/net/socket.hpp>
 
+#ifndef SUIL_REDIS_RX_CHUNK
+#define SUIL_REDIS_RX_CHUNK    16384
+#endif
+
 namespace suil::db {
 
     define_log_tag(REDIS_DB);
     DECLARE_EXCEPTION(RedisDbError);
 
+    struct RedisPipeline;
+
+    /**
+     * An incremental RESP2/RESP3 reply decoder. The decoder does not copy the elements
+     * of a reply, it records where each element is in the received bytes. When a reply
+     * is split across reads, decoding resumes from the first incomplete element.
+     *
+     * Aggregates (arrays, maps, sets, pushes and attributes) are flattened, an aggregate
+     * is followed by its elements (maps have 2 elements per entry)
+     */
+    class RespParser {
+    public:
+        enum Status : uint8 {
+            Incomplete,
+            Complete,
+            Invalid
+        };
+
+        struct Entry {
+            // the type of the element, i.e it's RESP prefix
+            char   prefix{'-'};
+            // the offset of the element's data from the first byte of the reply
+            size_t offset{0};
+            // the size of the element's data, the number of elements for aggregates
+            // and -1 for null
+            int64  size{0};
+        };
+
+        /**
+         * Decode the reply at the start of the given bytes
+         * @param data the bytes received so far, starting with the first byte of the
+         * reply. When \a Incomplete is returned, this must be invoked again with the same
+         * bytes followed by the bytes received next
+         * @param len the number of bytes received so far
+         * @return \a Complete if the whole reply was decoded, \a Incomplete if more
+         * bytes are needed and \a Invalid if the bytes are not a RESP reply
+         */
+        Status feed(const char* data, size_t len);
+
+        /**
+         * @return the size of the decoded reply in bytes
+         */
+        inline size_t consumed() const {
+            return Ego._pos;
+        }
+
+        /**
+         * @return the number of bytes needed to complete the element being decoded if
+         * known (i.e when receiving a bulk string), 0 otherwise
+         */
+        inline size_t needed() const {
+            return Ego._needed;
+        }
+
+        inline const std::vector<Entry>& entries() const {
+            return Ego._entries;
+        }
+
+        /**
+         * Prepare the parser for decoding the next reply
+         */
+        void reset();
+
+    private suil_ut:
+        bool completed();
+
+        std::vector<Entry> _entries{};
+        // the number of elements left in each of the aggregates being decoded
+        std::vector<int64> _left{};
+        size_t _pos{0};
+        size_t _needed{0};
+    };
+
     class RedisClient final : LOGGER(REDIS_DB) {
+    private suil_ut:
         static constexpr const char* REDIS_CRLF                 = "\r\n";
         static constexpr const char* StatusOk            = "OK";
         static constexpr char PrefixError         = '-';
@@ -220,6 +299,20 @@ namespace suil::db {
             return send(cd, std::forward<Args>(args)...);
         }
 
+        /**
+         * Creates a pipeline of commands which are sent with a single write and
+         * whose responses are read in order. Unlike a transaction (MULTI/EXEC), the
+         * commands are not executed atomically
+         *
+         * @code
+         *   auto resps = cli.pipeline()
+         *       ("SET", "a", 1)
+         *       ("EXPIRE", "a", 60)
+         *       ("GET", "b").exec();
+         * @endcode
+         */
+        RedisPipeline pipeline();
+
         inline void flush() {
             reset();
         }
@@ -397,24 +490,80 @@ namespace suil::db {
 
         ~RedisClient();
 
-    private:
+    private suil_ut:
+        friend struct RedisPipeline;
+        friend struct RedisTransaction;
+        // a command waiting for its response on an auto-pipelined client
+        struct Pending {
+            Pending(Command& cmd, size_t nreply)
+                : cmd{cmd},
+                  nreply{nreply}
+            {}
+
+            Command& cmd;
+            size_t   nreply{1};
+            Response resp{};
+            Channel<uint8_t, 1> done{uint8_t(0)};
+        };
+
         Response dosend(Command& cmd, size_t nreply);
+        std::vector<Response> exec(std::deque<Command>& cmds);
+        void enqueue(Pending& pending);
+        String transmit(const Command* const* cmds, size_t count);
+        bool receive(Response& resp, size_t nreply);
+        static coroutine void pump(RedisClient& cli);
         void reset();
         void batch(Command& cmd);
         void batch(std::vector<Command>& cmds);
-        bool receiveResponse(Buffer& out, std::vector<Reply>& staging);
-        bool readLine(Buffer& out);
-        bool readLen(std::int64_t& len);
+        bool receiveReply(Buffer& out, std::vector<RespParser::Entry>& staging);
+        bool fill();
+        static Reply toReply(Buffer& buf, const RespParser::Entry& entry);
         String commit(Response& resp);
         net::Socket& adaptor();
 
-    private:
+    private suil_ut:
         friend class RedisDb;
         net::Socket::UPtr sock{nullptr};
         CacheId      cacheId{nullptr};
         RedisDbConfig& config;
         CloseFunc onClose{nullptr};
         std::vector<Command*> batched;
+        // commands queued by coroutines sharing an auto-pipelined client
+        std::deque<Pending*> queued;
+        bool isShared{false};
+        bool pumping{false};
+        // set while the broken connection of a shared client is being replaced
+        bool reconnecting{false};
+        // bytes received from the server, replies are decoded from rxpos
+        Buffer rxb{0};
+        size_t rxpos{0};
+        RespParser parser{};
+    };
+
+    struct RedisPipeline : LOGGER(REDIS_DB) {
+        template <typename... Params>
+        RedisPipeline& operator()(const String& cmd, const Params&... params) {
+            cmds.emplace_back(cmd, params...);
+            return Ego;
+        }
+
+        /**
+         * Sends all the commands in the pipeline
+         * @return the responses of the commands, in the order the commands
+         * were added
+         */
+        std::vector<RedisClient::Response> exec();
+
+        inline size_t size() const {
+            return cmds.size();
+        }
+
+        RedisPipeline(RedisClient& client);
+
+    private:
+        RedisClient& client;
+        // commands are not moved once added, their buffers are sent as is
+        std::deque<RedisClient::Command> cmds;
     };
 
     struct RedisTransaction : LOGGER(REDIS_DB) {
@@ -475,19 +624,30 @@ namespace suil::db {
             }
         }
 
-        RedisClient& connect(int db = 0);
+        /**
+         * Get a connection to the given database
+         * @param db the database to select on the connection
+         * @param exclusive when auto pipelining is enabled, connections are shared
+         * between coroutines. An exclusive connection must be used for transactions
+         * and blocking commands (e.g BLPOP)
+         */
+        RedisClient& connect(int db = 0, bool exclusive = false);
 
         const RedisClient::ServerInfo& getServerInfo();
 
-    private:
+    private suil_ut:
         typename Clients::iterator fromCache(int db);
         typename Clients::iterator newConnection();
+        typename Clients::iterator sharedConnection(int db);
+        RedisClient& shared(int db);
         void returnConnection(typename Clients::iterator it, bool dctor);
         static coroutine void cleanup(RedisDb& db);
         bool isValid(typename Clients::iterator& it);
     private:
         Clients  clients;
         ClientsCache cache;
+        // auto pipelined connections, one per database
+        std::map<int, typename Clients::iterator> sharedClients;
         ipaddr  addr;
         RedisDbConfig config;
         RedisClient::ServerInfo serverInfo;
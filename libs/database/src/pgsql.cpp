@@ -6,13 +6,535 @@
 
 namespace suil::db {
 
-    PgSqlStatement::PgSqlStatement(PGconn *conn, String stmt, bool async, std::int64_t timeout)
+    namespace __internal {
+
+        // dates and times are sent relative to 2000-01-01 00:00:00 UTC
+        static constexpr int64_t PgEpochSecs{946684800};
+
+        static void formatDate(std::string& out, int64_t secs)
+        {
+            time_t t = time_t(secs);
+            struct tm tm{};
+            gmtime_r(&t, &tm);
+            char buf[32];
+            auto n = strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+            out.append(buf, n);
+        }
+
+        static void formatTime(std::string& out, int64_t usecs)
+        {
+            // usecs since midnight, fractions without trailing zeros like the server
+            char buf[32];
+            auto secs = usecs / 1000000;
+            auto n = snprintf(buf, sizeof(buf), "%02d:%02d:%02d",
+                              int(secs / 3600), int((secs / 60) % 60), int(secs % 60));
+            if (auto frac = usecs % 1000000) {
+                n += snprintf(&buf[n], sizeof(buf) - n, ".%06d", int(frac));
+                while (buf[n-1] == '0') {
+                    n--;
+                }
+            }
+            out.append(buf, n);
+        }
+
+        static void formatNumeric(std::string& out, const char *buf, int len)
+        {
+            // ndigits, weight, sign and display scale followed by base 10000 digits
+            int16_t ndigits, weight, dscale;
+            uint16_t sign;
+            vnod_to_vhod(buf, ndigits);
+            vnod_to_vhod(buf + 2, weight);
+            vnod_to_vhod(buf + 4, sign);
+            vnod_to_vhod(buf + 6, dscale);
+            if (sign == 0xC000) {
+                out = "NaN";
+                return;
+            }
+            if (sign == 0xD000 or sign == 0xF000) {
+                out = (sign == 0xF000)? "-Infinity" : "Infinity";
+                return;
+            }
+
+            ndigits = std::min<int16_t>(ndigits, int16_t((len - 8) / 2));
+            auto digit = [&](int i) -> int {
+                if (i < 0 or i >= ndigits) {
+                    return 0;
+                }
+                int16_t d;
+                vnod_to_vhod(buf + 8 + (i * 2), d);
+                return d;
+            };
+
+            char tmp[8];
+            if (sign == 0x4000) {
+                out += '-';
+            }
+            if (weight < 0) {
+                out += '0';
+            }
+            for (int i = 0; i <= weight; i++) {
+                auto n = snprintf(tmp, sizeof(tmp), (i == 0)? "%d" : "%04d", digit(i));
+                out.append(tmp, n);
+            }
+            if (dscale > 0) {
+                out += '.';
+                auto start = out.size();
+                for (int i = weight + 1; (out.size() - start) < size_t(dscale); i++) {
+                    auto n = snprintf(tmp, sizeof(tmp), "%04d", digit(i));
+                    out.append(tmp, n);
+                }
+                out.resize(start + dscale);
+            }
+        }
+
+        bool binary_to_text(const char *buf, int len, Oid type, std::string& out)
+        {
+            out.clear();
+            char tmp[64];
+            switch (type) {
+                case JSONBOID:
+                    // binary jsonb is prefixed with a version number
+                    if (len > 0) {
+                        out.assign(buf + 1, len - 1);
+                    }
+                    return true;
+                case BOOLOID:
+                    out = (len > 0 and *buf)? "t" : "f";
+                    return true;
+                case INT2OID:
+                case INT4OID:
+                case INT8OID: {
+                    long long num{0};
+                    binary_to_vhod(buf, len, type, num);
+                    out.append(tmp, snprintf(tmp, sizeof(tmp), "%lld", num));
+                    return true;
+                }
+                case OIDOID: {
+                    unsigned int num{0};
+                    if (len >= 4) {
+                        vnod_to_vhod(buf, num);
+                    }
+                    out.append(tmp, snprintf(tmp, sizeof(tmp), "%u", num));
+                    return true;
+                }
+                case FLOAT4OID:
+                case FLOAT8OID: {
+                    double num{0};
+                    binary_to_vhod(buf, len, type, num);
+                    out.append(tmp, snprintf(tmp, sizeof(tmp), "%.17g", num));
+                    return true;
+                }
+                case NUMERICOID:
+                    if (len >= 8) {
+                        formatNumeric(out, buf, len);
+                    }
+                    return true;
+                case UUIDOID: {
+                    auto u = reinterpret_cast<const uint8_t *>(buf);
+                    for (int i = 0; i < std::min(len, 16); i++) {
+                        if (i == 4 or i == 6 or i == 8 or i == 10) {
+                            out += '-';
+                        }
+                        out.append(tmp, snprintf(tmp, sizeof(tmp), "%02x", u[i]));
+                    }
+                    return true;
+                }
+                case DATEOID: {
+                    if (len < 4) {
+                        return true;
+                    }
+                    int days;
+                    vnod_to_vhod(buf, days);
+                    if (days == INT32_MAX or days == INT32_MIN) {
+                        out = (days == INT32_MAX)? "infinity" : "-infinity";
+                        return true;
+                    }
+                    formatDate(out, PgEpochSecs + int64_t(days) * 86400);
+                    return true;
+                }
+                case TIMEOID: {
+                    if (len < 8) {
+                        return true;
+                    }
+                    long long usecs;
+                    vnod_to_vhod(buf, usecs);
+                    formatTime(out, usecs);
+                    return true;
+                }
+                case TIMESTAMPOID:
+                case TIMESTAMPTZOID: {
+                    if (len < 8) {
+                        return true;
+                    }
+                    long long usecs;
+                    vnod_to_vhod(buf, usecs);
+                    if (usecs == INT64_MAX or usecs == INT64_MIN) {
+                        out = (usecs == INT64_MAX)? "infinity" : "-infinity";
+                        return true;
+                    }
+                    // split into whole days and the time of the day
+                    auto days = usecs / 86400000000ll;
+                    auto rem = usecs % 86400000000ll;
+                    if (rem < 0) {
+                        days--;
+                        rem += 86400000000ll;
+                    }
+                    formatDate(out, PgEpochSecs + days * 86400);
+                    out += ' ';
+                    formatTime(out, rem);
+                    if (type == TIMESTAMPTZOID) {
+                        // sent in UTC
+                        out += "+00";
+                    }
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        bool binary_decodable(Oid type)
+        {
+            switch (type) {
+                case BOOLOID: case BYTEAOID: case CHAROID: case NAMEOID:
+                case INT8OID: case INT2OID: case INT4OID: case TEXTOID:
+                case OIDOID: case JSONOID: case XMLOID: case FLOAT4OID:
+                case FLOAT8OID: case INT2ARRAYOID: case INT4ARRAYOID:
+                case TEXTARRAYOID: case INT8ARRAYOID: case FLOAT4ARRAYOID:
+                case FLOAT8ARRAYOID: case BPCHAROID: case VARCHAROID:
+                case DATEOID: case TIMEOID: case TIMESTAMPOID:
+                case TIMESTAMPTZOID: case NUMERICOID: case UUIDOID:
+                case JSONBOID:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    PgSqlStatement::PgSqlStatement(
+            PGconn *conn,
+            String stmt,
+            bool async,
+            std::int64_t timeout,
+            PreparedMap* prepared,
+            bool binary)
         : conn{conn},
           stmt{std::move(stmt)},
           async{async},
-          timeout{timeout}
+          timeout{timeout},
+          prepared{prepared},
+          binary{binary}
     {}
 
+    void PgSqlStatement::reset()
+    {
+        PQreset(conn);
+        if (prepared != nullptr) {
+            // prepared statements do not survive a connection reset
+            prepared->clear();
+        }
+    }
+
+    bool PgSqlStatement::prepare(int sock, char *name, const Oid *oids, int nParams, int& format)
+    {
+        // a statement is identified by its text and the types of its parameters
+        std::string key{stmt.data(), stmt.size()};
+        key.append(reinterpret_cast<const char *>(oids), sizeof(Oid) * nParams);
+        auto it = prepared->find(key);
+        if (it != prepared->end()) {
+            snprintf(name, 32, "suil_%zu", it->second.id);
+            format = it->second.binary? 1 : 0;
+            return true;
+        }
+
+        auto id = prepared->size();
+        snprintf(name, 32, "suil_%zu", id);
+
+        itrace("[%d] PREPARE %s: %s", sock, name, stmt());
+        if (async) {
+            if (!PQsendPrepare(conn, name, stmt.data(), nParams, oids)) {
+                ierror("[%d] ASYNC PREPARE: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+                throw PgSqlException("[", sock, "] ASYNC PREPARE: ", stmt(), " failed: ", PQerrorMessage(conn));
+            }
+            Ego.waitResults(sock);
+        }
+        else {
+            PGresult *result = PQprepare(conn, name, stmt.data(), nParams, oids);
+            auto status = PQresultStatus(result);
+            PQclear(result);
+            if (status != PGRES_COMMAND_OK) {
+                ierror("[%d] PREPARE: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+                return false;
+            }
+        }
+
+        // the result format is settled once, statements are never executed again
+        // because their results could not be decoded
+        bool bin = binary and Ego.describe(sock, name);
+        if (binary and !bin) {
+            idebug("[%d] PREPARE %s: %s has columns without binary decoding, using text results",
+                   sock, name, stmt());
+        }
+        prepared->emplace(std::move(key), Prepared{id, bin});
+        format = bin? 1 : 0;
+        return true;
+    }
+
+    bool PgSqlStatement::describe(int sock, const char *name)
+    {
+        // the types of the result columns tell whether the results can be decoded from binary
+        PGresult *result{nullptr};
+        if (async) {
+            if (!PQsendDescribePrepared(conn, name)) {
+                ierror("[%d] ASYNC DESCRIBE: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+                throw PgSqlException("[", sock, "] ASYNC DESCRIBE: ", stmt(), " failed: ", PQerrorMessage(conn));
+            }
+
+            int status{0};
+            while ((status = PQflush(conn)) > 0) {
+                if (waitWrite(sock)) {
+                    status = -1;
+                    break;
+                }
+            }
+
+            while (status == 0) {
+                while (PQisBusy(conn)) {
+                    if (waitRead(sock) or !PQconsumeInput(conn)) {
+                        status = -1;
+                        break;
+                    }
+                }
+                if (status < 0) {
+                    break;
+                }
+
+                PGresult *tmp = PQgetResult(conn);
+                if (tmp == nullptr) {
+                    break;
+                }
+                if (result == nullptr) {
+                    result = tmp;
+                }
+                else {
+                    PQclear(tmp);
+                }
+            }
+
+            if (status < 0) {
+                PQclear(result);
+                fdclear(sock);
+                auto msg = PQerrorMessage(conn);
+                throw PgSqlException("[", sock, "] describing statement failed: ",
+                                     (msg != nullptr && msg[0] != '\0')? msg: strerror(errno));
+            }
+        }
+        else {
+            result = PQdescribePrepared(conn, name);
+        }
+
+        bool decodable{PQresultStatus(result) == PGRES_COMMAND_OK};
+        for (int col = 0; decodable and col < PQnfields(result); col++) {
+            decodable = __internal::binary_decodable(PQftype(result, col));
+        }
+        PQclear(result);
+        return decodable;
+    }
+
+    void PgSqlStatement::waitResults(int sock)
+    {
+        bool wait = true, err = false;
+        while (!err && PQflush(conn)) {
+            itrace("[%d] ASYNC QUERY: %s wait write %ld", sock, stmt(), timeout);
+            if (waitWrite(sock)) {
+                ierror("[%d] ASYNC QUERY: % wait write failed: %s", sock, stmt(), errno_s);
+                err  = true;
+                continue;
+            }
+        }
+
+        while (wait && !err) {
+            if (PQisBusy(conn)) {
+                itrace("ASYNC QUERY: %s wait read %ld", stmt.data(), timeout);
+                if (waitRead(sock)) {
+                    ierror("ASYNC QUERY: %s wait read failed: %s", stmt.data(), errno_s);
+                    err = true;
+                    continue;
+                }
+            }
+
+            // asynchronously wait for results
+            if (!PQconsumeInput(conn)) {
+                ierror("[%d] ASYNC QUERY: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+                err = true;
+                continue;
+            }
+
+            PGresult *result = PQgetResult(conn);
+            if (result == nullptr) {
+                /* async query done */
+                wait = false;
+                continue;
+            }
+
+            switch (PQresultStatus(result)) {
+                case PGRES_COPY_OUT:
+                case PGRES_COPY_IN:
+                case PGRES_COPY_BOTH:
+                case PGRES_NONFATAL_ERROR:
+                    PQclear(result);
+                    break;
+                case PGRES_COMMAND_OK:
+                    itrace("[%d] ASYNC QUERY: continue waiting for results", sock);
+                    PQclear(result);
+                    break;
+                case PGRES_TUPLES_OK:
+#if PG_VERSION_NUM >= 90200
+                case PGRES_SINGLE_TUPLE:
+#endif
+                    results.add(result);
+                    break;
+
+                default:
+                    ierror("[%d] ASYNC QUERY: %s failed: %s",
+                           sock, stmt(), PQerrorMessage(conn));
+                    PQclear(result);
+                    err = true;
+            }
+        }
+
+        if (err) {
+            /* error occurred and was reported in logs */
+            fdclear(sock);
+            auto msg = PQerrorMessage(conn);
+            throw PgSqlException("[", sock, "] query failed: ",
+                                 (msg != nullptr && msg[0] != '\0')? msg: strerror(errno));
+        }
+    }
+
+#ifdef LIBPQ_HAS_PIPELINING
+    void PgSqlStatement::enterPipeline(int sock)
+    {
+        if (!PQenterPipelineMode(conn)) {
+            ierror("[%d] PIPELINE: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+            throw PgSqlException("[", sock, "] PIPELINE: ", stmt(), " failed: ", PQerrorMessage(conn));
+        }
+    }
+
+    void PgSqlStatement::syncPipeline(int sock)
+    {
+        if (!PQpipelineSync(conn)) {
+            ierror("[%d] PIPELINE SYNC: %s failed: %s", sock, stmt(), PQerrorMessage(conn));
+            throw PgSqlException("[", sock, "] PIPELINE SYNC: ", stmt(), " failed: ", PQerrorMessage(conn));
+        }
+
+        int status{0};
+        while ((status = PQflush(conn)) > 0) {
+            // the server might block writing results while we are still sending
+            // queries, so keep reading whatever it sends us
+            int events = fdwait(sock, FDW_IN|FDW_OUT, Deadline{timeout});
+            if (events&FDW_ERR) {
+                status = -1;
+                break;
+            }
+            if (events == 0) {
+                errno = ETIMEDOUT;
+                status = -1;
+                break;
+            }
+            if ((events&FDW_IN) and !PQconsumeInput(conn)) {
+                status = -1;
+                break;
+            }
+        }
+
+        if (status < 0) {
+            fdclear(sock);
+            ierror("[%d] PIPELINE SYNC: %s flush failed: %s", sock, stmt(), errno_s);
+            throw PgSqlException("[", sock, "] PIPELINE SYNC: ", stmt(), " flush failed: ", errno_s);
+        }
+    }
+
+    bool PgSqlStatement::pipelineResults(int sock)
+    {
+        bool ok{true};
+        while (true) {
+            while (PQisBusy(conn)) {
+                if (waitRead(sock) or !PQconsumeInput(conn)) {
+                    fdclear(sock);
+                    auto msg = PQerrorMessage(conn);
+                    throw PgSqlException("[", sock, "] pipeline query failed: ",
+                                         (msg != nullptr && msg[0] != '\0')? msg: strerror(errno));
+                }
+            }
+
+            PGresult *result = PQgetResult(conn);
+            if (result == nullptr) {
+                /* all results of the current query received */
+                break;
+            }
+
+            switch (PQresultStatus(result)) {
+                case PGRES_TUPLES_OK:
+                case PGRES_SINGLE_TUPLE:
+                    if (PQntuples(result) > 0) {
+                        results.add(result);
+                    }
+                    else {
+                        PQclear(result);
+                    }
+                    break;
+                case PGRES_COMMAND_OK:
+                    PQclear(result);
+                    break;
+                case PGRES_PIPELINE_ABORTED:
+                    // an earlier query in the pipeline failed
+                    idebug("[%d] PIPELINE QUERY: %s aborted", sock, stmt());
+                    PQclear(result);
+                    ok = false;
+                    break;
+                default:
+                    ierror("[%d] PIPELINE QUERY: %s failed: %s",
+                           sock, stmt(), PQresultErrorMessage(result));
+                    PQclear(result);
+                    ok = false;
+                    break;
+            }
+        }
+
+        return ok;
+    }
+
+    void PgSqlStatement::exitPipeline(int sock)
+    {
+        // consume the result of the sync point
+        while (true) {
+            while (PQisBusy(conn)) {
+                if (waitRead(sock) or !PQconsumeInput(conn)) {
+                    fdclear(sock);
+                    throw PgSqlException("[", sock, "] waiting for pipeline sync failed: ", PQerrorMessage(conn));
+                }
+            }
+            PGresult *result = PQgetResult(conn);
+            if (result == nullptr) {
+                // all queries results were consumed, the sync point should be next
+                throw PgSqlException("[", sock, "] PIPELINE: ", stmt(), " missing sync point");
+            }
+            auto status = PQresultStatus(result);
+            PQclear(result);
+            if (status == PGRES_PIPELINE_SYNC) {
+                break;
+            }
+        }
+
+        if (!PQexitPipelineMode(conn)) {
+            ierror("[%d] PIPELINE: %s exit failed: %s", sock, stmt(), PQerrorMessage(conn));
+            throw PgSqlException("[", sock, "] PIPELINE: ", stmt(), " exit failed: ", PQerrorMessage(conn));
+        }
+    }
+#endif
+
     int PgSqlStatement::waitRead(int sock)
     {
         int events = fdwait(sock, FDW_IN, Deadline{timeout});
@@ -38,8 +560,17 @@ namespace suil::db {
         return ETIMEDOUT;
     }
 
-    PgSqlConnection::PgSqlConnection(PGconn *conn, String dbname, bool async, std::int64_t timeout, FreeConnFunc freeConn)
+    PgSqlConnection::PgSqlConnection(
+            PGconn *conn,
+            String dbname,
+            bool async,
+            std::int64_t timeout,
+            FreeConnFunc freeConn,
+            PreparedMapPtr prepared,
+            bool binary)
         : conn{conn},
+          prepared{std::move(prepared)},
+          binary{binary},
           async{async},
           timeout{timeout},
           freeConn{std::move(freeConn)},
@@ -76,7 +607,9 @@ namespace suil::db {
         /* the key will be copied to statement so it won't be delete
          * when the statement is deleted */
         auto ret = stmtCache.insert(it,
-                                     std::make_pair(std::move(req), PgSqlStatement(conn, std::move(tmp), async, timeout)));
+                                     std::make_pair(std::move(req),
+                                                    PgSqlStatement(conn, std::move(tmp), async, timeout,
+                                                                   prepared.get(), binary)));
 
         return ret->second;
     }
@@ -200,6 +733,7 @@ namespace suil::db {
     PgSqlDb::Connection& PgSqlDb::connection(bool cached)
     {
         PGconn *conn{nullptr};
+        Connection::PreparedMapPtr preparedSet{nullptr};
         if (!cached || conns.empty()) {
             /* open a new Connection */
             int y{2};
@@ -218,6 +752,7 @@ namespace suil::db {
                 /* cancel Connection expiry */
                 h.alive = -1;
                 conn = h.conn;
+                preparedSet = std::move(h.prepared);
                 conns.pop_back();
             }
             else {
@@ -226,11 +761,17 @@ namespace suil::db {
             }
         }
 
+        if (prepared and (preparedSet == nullptr)) {
+            // new connection, nothing prepared yet
+            preparedSet = std::make_shared<PgSqlStatement::PreparedMap>();
+        }
+
         auto *c = new Connection(
                 conn, dbname.peek(), async, timeout,
                 [&, cached = cached](Connection* _conn) {
                     free(_conn, cached);
-                });
+                },
+                std::move(preparedSet), binary);
         return *c;
     }
 
@@ -306,7 +847,7 @@ namespace suil::db {
     }
 
     void PgSqlDb::free(Connection* conn, bool cached) {
-        conn_handle_t h {conn->conn, -1};
+        conn_handle_t h {conn->conn, -1, std::move(conn->prepared)};
 
         if (cached && keepAlive != 0) {
             /* set connections keep alive */
@@ -324,4 +865,523 @@ namespace suil::db {
             PQfinish(h.conn);
         }
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+namespace db = suil::db;
+namespace pgi = suil::db::__internal;
+
+namespace {
+
+    template <typename T>
+    void putBE(std::string& out, T v)
+    {
+        // values are sent in network byte order
+        for (int i = sizeof(T) - 1; i >= 0; i--) {
+            out += char((uint64_t(v) >> (i * 8)) & 0xFF);
+        }
+    }
+
+    std::string toText(const std::string& bin, Oid type)
+    {
+        std::string out;
+        REQUIRE(pgi::binary_to_text(bin.data(), int(bin.size()), type, out));
+        return out;
+    }
+
+    std::string numeric(int16_t weight, uint16_t sign, int16_t dscale, std::initializer_list<int16_t> digits)
+    {
+        std::string bin;
+        putBE(bin, int16_t(digits.size()));
+        putBE(bin, weight);
+        putBE(bin, sign);
+        putBE(bin, dscale);
+        for (auto d: digits) {
+            putBE(bin, d);
+        }
+        return bin;
+    }
+
+    /**
+     * A server speaking just enough of the PostgreSQL protocol to serve a single
+     * client. Every statement returns the first parameter of an execution as a
+     * single column of the given type, an execution whose first parameter is
+     * "fail" fails. The server runs on its own thread and must only be inspected
+     * after it was joined
+     */
+    struct FakePgServer {
+        explicit FakePgServer(Oid columnType)
+            : columnType{columnType}
+        {
+            listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+            int on{1};
+            ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            struct sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(9309);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            REQUIRE(::bind(listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+            REQUIRE(::listen(listenFd, 1) == 0);
+            thread = std::thread([this] { serve(); });
+        }
+
+        ~FakePgServer() {
+            join();
+            ::close(listenFd);
+        }
+
+        PGconn *connect(bool async) {
+            auto conn = PQconnectdb("host=127.0.0.1 port=9309 user=suil dbname=suil "
+                                    "sslmode=disable gssencmode=disable");
+            REQUIRE(PQstatus(conn) == CONNECTION_OK);
+            if (async) {
+                REQUIRE(PQsetnonblocking(conn, 1) == 0);
+            }
+            return conn;
+        }
+
+        void join() {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+
+        Oid columnType{pgi::TEXTOID};
+        // the first parameter and the result format of each execution
+        std::vector<std::string> executed{};
+        std::vector<int> formats{};
+        int prepares{0};
+        int describes{0};
+
+    private:
+        static bool readAll(int fd, void *buf, size_t len) {
+            auto p = static_cast<char *>(buf);
+            while (len > 0) {
+                auto n = ::read(fd, p, len);
+                if (n <= 0) {
+                    return false;
+                }
+                p += n;
+                len -= size_t(n);
+            }
+            return true;
+        }
+
+        template <typename T>
+        static T getBE(const char *p) {
+            T v{0};
+            for (size_t i = 0; i < sizeof(T); i++) {
+                v = T((uint64_t(v) << 8) | uint8_t(p[i]));
+            }
+            return v;
+        }
+
+        static std::string fields(std::initializer_list<const char *> strs) {
+            // each field is a null terminated string
+            std::string out;
+            for (auto str: strs) {
+                out.append(str, strlen(str) + 1);
+            }
+            return out;
+        }
+
+        static void message(std::string& out, char type, const std::string& body) {
+            out += type;
+            putBE(out, int32_t(body.size() + 4));
+            out += body;
+        }
+
+        void rowDescription(std::string& out, int16_t format) {
+            std::string body;
+            putBE(body, int16_t(1));
+            body.append("value", 6);
+            putBE(body, int32_t(0));
+            putBE(body, int16_t(0));
+            putBE(body, int32_t(columnType));
+            putBE(body, int16_t(-1));
+            putBE(body, int32_t(-1));
+            putBE(body, format);
+            message(out, 'T', body);
+        }
+
+        void serve() {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+
+            // the startup message is accepted whatever it contains
+            char hdr[4];
+            std::string body, out;
+            if (readAll(fd, hdr, sizeof(hdr))) {
+                body.resize(size_t(getBE<int32_t>(hdr) - 4));
+                readAll(fd, body.data(), body.size());
+            }
+            message(out, 'R', std::string(4, '\0'));
+            message(out, 'S', fields({"server_version", "15.0"}));
+            message(out, 'S', fields({"client_encoding", "UTF8"}));
+            message(out, 'S', fields({"standard_conforming_strings", "on"}));
+            message(out, 'S', fields({"integer_datetimes", "on"}));
+            message(out, 'K', std::string(8, '\1'));
+            message(out, 'Z', "I");
+            ::write(fd, out.data(), out.size());
+            out.clear();
+
+            std::string param;
+            int16_t format{0};
+            bool failed{false};
+            while (true) {
+                char type;
+                if (!readAll(fd, &type, 1) or !readAll(fd, hdr, sizeof(hdr))) {
+                    break;
+                }
+                body.resize(size_t(getBE<int32_t>(hdr) - 4));
+                if (!readAll(fd, body.data(), body.size()) or (type == 'X')) {
+                    break;
+                }
+                if (failed and (type != 'S')) {
+                    // messages are discarded until the next sync after an error
+                    continue;
+                }
+
+                switch (type) {
+                    case 'P':
+                        prepares += (body[0] != '\0');
+                        message(out, '1', "");
+                        break;
+                    case 'B': {
+                        // portal and statement names, parameter formats, parameters, result formats
+                        const char *p = body.data();
+                        p += strlen(p) + 1;
+                        p += strlen(p) + 1;
+                        p += 2 + (2 * getBE<int16_t>(p));
+                        auto nparams = getBE<int16_t>(p);
+                        p += 2;
+                        param.clear();
+                        for (int i = 0; i < nparams; i++) {
+                            auto len = getBE<int32_t>(p);
+                            p += 4;
+                            if (len > 0) {
+                                if (i == 0) {
+                                    param.assign(p, size_t(len));
+                                }
+                                p += len;
+                            }
+                        }
+                        format = (getBE<int16_t>(p) > 0)? getBE<int16_t>(p + 2) : 0;
+                        message(out, '2', "");
+                        break;
+                    }
+                    case 'D':
+                        if (body[0] == 'S') {
+                            describes++;
+                            std::string params;
+                            putBE(params, int16_t(1));
+                            putBE(params, int32_t(pgi::TEXTOID));
+                            message(out, 't', params);
+                            rowDescription(out, 0);
+                        }
+                        else {
+                            rowDescription(out, format);
+                        }
+                        break;
+                    case 'E': {
+                        if (param == "fail") {
+                            message(out, 'E', fields({"SERROR", "CXX000", "Mexecution failed", ""}));
+                            failed = true;
+                            break;
+                        }
+                        executed.push_back(param);
+                        formats.push_back(format);
+                        std::string row;
+                        putBE(row, int16_t(1));
+                        putBE(row, int32_t(param.size()));
+                        row += param;
+                        message(out, 'D', row);
+                        message(out, 'C', fields({"SELECT 1"}));
+                        break;
+                    }
+                    case 'S':
+                        failed = false;
+                        message(out, 'Z', "I");
+                        break;
+                    default:
+                        break;
+                }
+
+                // replies are sent when the client syncs or flushes
+                if ((type == 'S') or (type == 'H')) {
+                    ::write(fd, out.data(), out.size());
+                    out.clear();
+                }
+            }
+            ::close(fd);
+        }
+
+        int listenFd{-1};
+        std::thread thread;
+    };
+}
+
+TEST_CASE("PgSql binary results", "[db][pgsql][binary]")
+{
+    SECTION("Numbers are converted to text") {
+        std::string bin;
+        putBE(bin, int32_t(-42));
+        REQUIRE(toText(bin, pgi::INT4OID) == "-42");
+        bin.clear();
+        putBE(bin, int64_t(1) << 40);
+        REQUIRE(toText(bin, pgi::INT8OID) == "1099511627776");
+        bin.clear();
+        putBE(bin, uint32_t(4000000000u));
+        REQUIRE(toText(bin, pgi::OIDOID) == "4000000000");
+        REQUIRE(toText(std::string(1, '\1'), pgi::BOOLOID) == "t");
+        REQUIRE(toText(std::string(1, '\1') + R"({"a":1})", pgi::JSONBOID) == R"({"a":1})");
+    }
+
+    SECTION("Numerics are converted to text") {
+        // 12345.678 is {1, 2345, 6780} with weight 1
+        REQUIRE(toText(numeric(1, 0, 3, {1, 2345, 6780}), pgi::NUMERICOID) == "12345.678");
+        REQUIRE(toText(numeric(1, 0x4000, 0, {1, 2345}), pgi::NUMERICOID) == "-12345");
+        // 0.00012 is {1, 2000} with weight -1 and 0.000012 is {1200} with weight -2
+        REQUIRE(toText(numeric(-1, 0, 5, {1, 2000}), pgi::NUMERICOID) == "0.00012");
+        REQUIRE(toText(numeric(-2, 0, 6, {1200}), pgi::NUMERICOID) == "0.000012");
+        // 20000 is {2} with weight 1, trailing zero groups are not sent
+        REQUIRE(toText(numeric(1, 0, 2, {2}), pgi::NUMERICOID) == "20000.00");
+        REQUIRE(toText(numeric(0, 0, 0, {}), pgi::NUMERICOID) == "0");
+        REQUIRE(toText(numeric(0, 0xC000, 0, {}), pgi::NUMERICOID) == "NaN");
+    }
+
+    SECTION("Dates and times are converted to text") {
+        std::string bin;
+        putBE(bin, int32_t(0));
+        REQUIRE(toText(bin, pgi::DATEOID) == "2000-01-01");
+        bin.clear();
+        putBE(bin, int32_t(-1));
+        REQUIRE(toText(bin, pgi::DATEOID) == "1999-12-31");
+
+        // 2021-06-04 13:45:30.25
+        bin.clear();
+        putBE(bin, int64_t(676129530250000ll));
+        REQUIRE(toText(bin, pgi::TIMESTAMPOID) == "2021-06-04 13:45:30.25");
+        REQUIRE(toText(bin, pgi::TIMESTAMPTZOID) == "2021-06-04 13:45:30.25+00");
+
+        // before the epoch
+        bin.clear();
+        putBE(bin, int64_t(-1000000));
+        REQUIRE(toText(bin, pgi::TIMESTAMPOID) == "1999-12-31 23:59:59");
+
+        bin.clear();
+        putBE(bin, int64_t(INT64_MAX));
+        REQUIRE(toText(bin, pgi::TIMESTAMPOID) == "infinity");
+
+        bin.clear();
+        putBE(bin, int64_t(3723000001ll));
+        REQUIRE(toText(bin, pgi::TIMEOID) == "01:02:03.000001");
+    }
+
+    SECTION("Uuids are converted to text") {
+        std::string bin;
+        for (int i = 0; i < 16; i++) {
+            bin += char(i * 17);
+        }
+        REQUIRE(toText(bin, pgi::UUIDOID) == "00112233-4455-6677-8899-aabbccddeeff");
+    }
+
+    SECTION("Types sent as text or not supported are not converted") {
+        std::string out;
+        REQUIRE_FALSE(pgi::binary_to_text("abc", 3, pgi::TEXTOID, out));
+        REQUIRE_FALSE(pgi::binary_to_text("abc", 3, Oid(1186), out));
+        REQUIRE(pgi::binary_decodable(pgi::TEXTOID));
+        REQUIRE(pgi::binary_decodable(pgi::NUMERICOID));
+        REQUIRE(pgi::binary_decodable(pgi::UUIDOID));
+        // e.g interval, inet
+        REQUIRE_FALSE(pgi::binary_decodable(Oid(1186)));
+        REQUIRE_FALSE(pgi::binary_decodable(Oid(869)));
+    }
+
+    SECTION("Binary arrays are decoded") {
+        std::string bin;
+        putBE(bin, int32_t(1));
+        putBE(bin, int32_t(0));
+        putBE(bin, int32_t(pgi::INT4OID));
+        putBE(bin, int32_t(3));
+        putBE(bin, int32_t(1));
+        for (int32_t v: {7, -8, 9}) {
+            putBE(bin, int32_t(4));
+            putBE(bin, v);
+        }
+        std::vector<int> values;
+        REQUIRE(pgi::parse_binary_array(values, bin.data(), int(bin.size())));
+        REQUIRE(values == std::vector<int>{7, -8, 9});
+    }
+}
+
+TEST_CASE("PgSql prepared statements", "[db][pgsql][prepare]")
+{
+    db::PgSqlStatement::PreparedMap prepared;
+    const Oid oids[] = {pgi::INT4OID};
+    char name[32] = {0};
+
+    int format{-1};
+
+    db::PgSqlStatement select(nullptr, suil::String{"SELECT * FROM t WHERE id = $1"}, false, -1, &prepared);
+    prepared.emplace(std::string{"SELECT * FROM t WHERE id = $1"} +
+                     std::string{reinterpret_cast<const char *>(oids), sizeof(oids)},
+                     db::PgSqlStatement::Prepared{5, true});
+    // statements are found by their text and parameter types
+    REQUIRE(select.prepare(-1, name, oids, 1, format));
+    REQUIRE(strcmp(name, "suil_5") == 0);
+    // with the result format chosen when they were prepared
+    REQUIRE(format == 1);
+
+    // another statement is never mistaken for a prepared one
+    db::PgSqlStatement other(nullptr, suil::String{"DELETE FROM t WHERE id = $1"}, false, -1, &prepared);
+    REQUIRE_FALSE(other.prepare(-1, name, oids, 1, format));
+    REQUIRE(strcmp(name, "suil_1") == 0);
+    REQUIRE(prepared.size() == 1);
+
+    const Oid text[] = {pgi::TEXTOID};
+    REQUIRE_FALSE(select.prepare(-1, name, text, 1, format));
+    REQUIRE(prepared.size() == 1);
+}
+
+TEST_CASE("PgSql result formats", "[db][pgsql][binary]")
+{
+    db::PgSqlStatement::PreparedMap prepared;
+    auto query = [&](FakePgServer& server, bool async) {
+        auto conn = server.connect(async);
+        db::PgSqlStatement stmt(conn, suil::String{"SELECT $1"}, async, -1, &prepared, true);
+        for (auto v: {"first", "second"}) {
+            suil::String value;
+            REQUIRE(stmt(suil::String{v}).status());
+            REQUIRE(stmt >> value);
+            REQUIRE(value == suil::String{v});
+        }
+        PQfinish(conn);
+        server.join();
+    };
+
+    SECTION("Decodable columns are received in binary format") {
+        FakePgServer server{pgi::TEXTOID};
+        query(server, false);
+        REQUIRE(server.prepares == 1);
+        REQUIRE(server.describes == 1);
+        REQUIRE(server.executed == std::vector<std::string>{"first", "second"});
+        REQUIRE(server.formats == std::vector<int>{1, 1});
+        REQUIRE(prepared.begin()->second.binary);
+    }
+
+    SECTION("Other columns are received in text format") {
+        // e.g interval, statements are never executed twice to switch formats
+        FakePgServer server{Oid(1186)};
+        query(server, false);
+        REQUIRE(server.describes == 1);
+        REQUIRE(server.executed == std::vector<std::string>{"first", "second"});
+        REQUIRE(server.formats == std::vector<int>{0, 0});
+        REQUIRE_FALSE(prepared.begin()->second.binary);
+    }
+
+    SECTION("Async statements are described when prepared") {
+        FakePgServer server{Oid(1186)};
+        query(server, true);
+        REQUIRE(server.prepares == 1);
+        REQUIRE(server.describes == 1);
+        REQUIRE(server.executed == std::vector<std::string>{"first", "second"});
+        REQUIRE(server.formats == std::vector<int>{0, 0});
+    }
+}
+
+TEST_CASE("PgSql batched executions", "[db][pgsql][batch]")
+{
+    db::PgSqlStatement::PreparedMap prepared;
+    std::vector<size_t> bound;
+    std::vector<std::string> read;
+    auto batch = [&](FakePgServer& server, bool async, std::vector<std::string> params) {
+        auto conn = server.connect(async);
+        db::PgSqlStatement stmt(conn, suil::String{"SELECT $1"}, async, -1, &prepared, true);
+        auto ok = stmt.executeMany(params.size(),
+            [&](size_t i, auto&& send) {
+                bound.push_back(i);
+                send(suil::String{params[i]});
+            },
+            [&](size_t i, auto& st) {
+                suil::String value;
+                if (!(st >> value)) {
+                    return false;
+                }
+                read.push_back(std::to_string(i) + ":" + std::string{value.data(), value.size()});
+                return true;
+            });
+        auto status = stmt.status();
+        PQfinish(conn);
+        server.join();
+        return std::make_pair(ok, status);
+    };
+
+    SECTION("Executions run one after the other on blocking connections") {
+        FakePgServer server{pgi::TEXTOID};
+        auto [ok, status] = batch(server, false, {"a", "b", "c"});
+        REQUIRE(ok);
+        REQUIRE(status);
+        REQUIRE(bound == std::vector<size_t>{0, 1, 2});
+        REQUIRE(read == std::vector<std::string>{"0:a", "1:b", "2:c"});
+        REQUIRE(server.executed == std::vector<std::string>{"a", "b", "c"});
+        REQUIRE(server.formats == std::vector<int>{1, 1, 1});
+    }
+
+    SECTION("A failed execution does not fail the ones after it") {
+        FakePgServer server{pgi::TEXTOID};
+        auto [ok, status] = batch(server, false, {"a", "fail", "c"});
+        REQUIRE_FALSE(ok);
+        // the last execution succeeded
+        REQUIRE(status);
+        REQUIRE(bound == std::vector<size_t>{0, 1, 2});
+        // results are only read for executions that succeeded
+        REQUIRE(read == std::vector<std::string>{"0:a", "2:c"});
+        REQUIRE(server.executed == std::vector<std::string>{"a", "c"});
+    }
+
+#ifdef LIBPQ_HAS_PIPELINING
+    SECTION("Executions are pipelined on async connections") {
+        FakePgServer server{pgi::TEXTOID};
+        auto [ok, status] = batch(server, true, {"a", "b", "c", "d"});
+        REQUIRE(ok);
+        REQUIRE(read == std::vector<std::string>{"0:a", "1:b", "2:c", "3:d"});
+        // the statement is prepared and described once, before the pipeline
+        REQUIRE(server.prepares == 1);
+        REQUIRE(server.describes == 1);
+        REQUIRE(server.executed == std::vector<std::string>{"a", "b", "c", "d"});
+        REQUIRE(server.formats == std::vector<int>{1, 1, 1, 1});
+    }
+
+    SECTION("A failed pipelined execution aborts the ones after it") {
+        FakePgServer server{Oid(1186)};
+        auto [ok, status] = batch(server, true, {"a", "fail", "c"});
+        REQUIRE_FALSE(ok);
+        REQUIRE(bound == std::vector<size_t>{0, 1, 2});
+        REQUIRE(read == std::vector<std::string>{"0:a"});
+        REQUIRE(server.executed == std::vector<std::string>{"a"});
+        REQUIRE(server.formats == std::vector<int>{0});
+    }
+#endif
+
+    SECTION("Nothing is executed for an empty batch") {
+        FakePgServer server{pgi::TEXTOID};
+        auto [ok, status] = batch(server, true, {});
+        REQUIRE(ok);
+        REQUIRE(bound.empty());
+        REQUIRE(read.empty());
+        REQUIRE(server.prepares == 0);
+        REQUIRE(server.executed.empty());
+    }
+}
+#endif
@@ -32,6 +32,118 @@ namespace suil::db {
         buffer << REDIS_CRLF;
     }
 
+    static bool respnum(const char *data, size_t len, int64& out)
+    {
+        size_t i = (len > 0 and data[0] == '-')? 1 : 0;
+        if (i == len) {
+            return false;
+        }
+
+        int64 val{0};
+        for (; i < len; i++) {
+            if (data[i] < '0' or data[i] > '9') {
+                return false;
+            }
+            val = (val * 10) + (data[i] - '0');
+        }
+        out = (data[0] == '-')? -val : val;
+        return true;
+    }
+
+    RespParser::Status RespParser::feed(const char* data, size_t len)
+    {
+        Ego._needed = 0;
+        while (Ego._pos < len) {
+            auto cr = static_cast<const char *>(memchr(&data[Ego._pos], '\r', len - Ego._pos));
+            if (cr == nullptr or (cr + 1) == &data[len]) {
+                // the header line is incomplete
+                return Incomplete;
+            }
+            if (cr[1] != '\n') {
+                return Invalid;
+            }
+
+            auto prefix = data[Ego._pos];
+            size_t start{Ego._pos + 1}, eol = cr - data, next{eol + 2};
+            switch (prefix) {
+                case '+': case '-': case ':': case ',': case '(': case '#': case '_': {
+                    // the data is the rest of the line
+                    Ego._entries.push_back({prefix, start, int64(eol - start)});
+                    Ego._pos = next;
+                    break;
+                }
+                case '$': case '!': case '=': {
+                    int64 size{0};
+                    if (!respnum(&data[start], eol - start, size)) {
+                        return Invalid;
+                    }
+                    if (size < 0) {
+                        Ego._entries.push_back({prefix, next, -1});
+                        Ego._pos = next;
+                        break;
+                    }
+
+                    size_t end = next + size_t(size) + 2;
+                    if (end > len) {
+                        Ego._needed = end - len;
+                        return Incomplete;
+                    }
+                    if (data[end - 2] != '\r' or data[end - 1] != '\n') {
+                        return Invalid;
+                    }
+                    Ego._entries.push_back({prefix, next, size});
+                    Ego._pos = end;
+                    break;
+                }
+                case '*': case '%': case '~': case '>': case '|': {
+                    int64 count{0};
+                    if (!respnum(&data[start], eol - start, count)) {
+                        return Invalid;
+                    }
+                    Ego._entries.push_back({prefix, start, count});
+                    Ego._pos = next;
+
+                    // maps have 2 elements per entry and attributes are followed
+                    // by the element they describe
+                    auto left = (prefix == '%' or prefix == '|')? (count * 2) : count;
+                    left += (prefix == '|')? 1 : 0;
+                    if (left > 0) {
+                        Ego._left.push_back(left);
+                        continue;
+                    }
+                    break;
+                }
+                default:
+                    return Invalid;
+            }
+
+            if (Ego.completed()) {
+                return Complete;
+            }
+        }
+        return Incomplete;
+    }
+
+    bool RespParser::completed()
+    {
+        // an element was decoded, so are the aggregates that it was the last element of
+        while (!Ego._left.empty()) {
+            if (--Ego._left.back() > 0) {
+                return false;
+            }
+            Ego._left.pop_back();
+        }
+        return true;
+    }
+
+    void RespParser::reset()
+    {
+        Ego._entries.clear();
+        Ego._left.clear();
+        Ego._pos = 0;
+        Ego._needed = 0;
+    }
+
     RedisClient::Reply::Reply(char prefix, String data)
         : prefix{prefix},
           data{std::move(data)}
@@ -139,6 +251,21 @@ namespace suil::db {
     RedisTransaction::RedisTransaction(RedisClient &client)
     : client(client) {}
 
+    RedisPipeline::RedisPipeline(RedisClient& client)
+        : client(client)
+    {}
+
+    std::vector<RedisClient::Response> RedisPipeline::exec()
+    {
+        if (cmds.empty()) {
+            return {};
+        }
+
+        auto resps = client.exec(cmds);
+        cmds.clear();
+        return resps;
+    }
+
     RedisClient::Response& RedisTransaction::exec()
     {
         // send MULTI command
@@ -183,6 +310,12 @@ namespace suil::db {
             return false;
         }
 
+        if (client.isShared) {
+            // commands from other coroutines would end up in the transaction
+            ierror("MULTI requires an exclusive connection, see RedisDb::connect");
+            return false;
+        }
+
         // send EXEC command
         cachedResp = client.send("MULTI");
         if (!cachedResp) {
@@ -216,7 +349,12 @@ namespace suil::db {
           cacheId{std::move(other.cacheId)},
           config{other.config},
           onClose{std::move(other.onClose)},
-          batched{std::move(other.batched)}
+          batched{std::move(other.batched)},
+          queued{std::move(other.queued)},
+          isShared{std::exchange(other.isShared, false)},
+          rxb{std::move(other.rxb)},
+          rxpos{std::exchange(other.rxpos, 0)},
+          parser{std::move(other.parser)}
     {
         other.cacheId = CacheId{nullptr};
     }
@@ -228,6 +366,11 @@ namespace suil::db {
         config = other.config;
         onClose = std::move(other.onClose);
         batched = std::move(other.batched);
+        queued = std::move(other.queued);
+        isShared = std::exchange(other.isShared, false);
+        rxb = std::move(other.rxb);
+        rxpos = std::exchange(other.rxpos, 0);
+        parser = std::move(other.parser);
 
         other.cacheId = CacheId{nullptr};
         other.onClose = nullptr;
@@ -237,6 +380,13 @@ namespace suil::db {
 
     RedisClient::Response RedisClient::dosend(Command &cmd, size_t nrps)
     {
+        if (Ego.isShared) {
+            // coalesce with the commands of other coroutines
+            Pending pending{cmd, nrps};
+            Ego.enqueue(pending);
+            return std::move(pending.resp);
+        }
+
         // send the command to the server
         String data = cmd.prepared();
         size_t size = adaptor().send(data.data(), data.size(), config.Timeout);
@@ -247,21 +397,155 @@ namespace suil::db {
         adaptor().flush(config.Timeout);
 
         Response resp;
-        std::vector<Reply> stage;
+        if (!Ego.receive(resp, nrps)) {
+            // receiving data failed
+            return Response{Reply('-',
+                                  suil::catstr("receiving Response failed: ", errno_s))};
+        }
+        return std::move(resp);
+    }
+
+    RedisPipeline RedisClient::pipeline()
+    {
+        return RedisPipeline{Ego};
+    }
+
+    std::vector<RedisClient::Response> RedisClient::exec(std::deque<Command>& cmds)
+    {
+        std::vector<Response> resps;
+        resps.reserve(cmds.size());
+        if (Ego.isShared) {
+            // queue all the commands before waiting, they will be sent together
+            std::deque<Pending> pending;
+            for (auto& cmd: cmds) {
+                auto& p = pending.emplace_back(cmd, 1);
+                Ego.queued.push_back(&p);
+            }
+            if (!Ego.pumping) {
+                Ego.pumping = true;
+                go(pump(Ego));
+            }
+            for (auto& p: pending) {
+                uint8_t status{0};
+                p.done >> status;
+                resps.push_back(std::move(p.resp));
+            }
+            return resps;
+        }
+
+        std::vector<const Command*> all;
+        all.reserve(cmds.size());
+        for (auto& cmd: cmds) {
+            all.push_back(&cmd);
+        }
+
+        auto err = Ego.transmit(all.data(), all.size());
+        for (size_t i = 0; i < cmds.size(); i++) {
+            auto& resp = resps.emplace_back();
+            if (err.empty() and !Ego.receive(resp, 1)) {
+                err = suil::catstr("receiving Response failed: ", errno_s);
+            }
+            if (!err.empty()) {
+                resp = Response{Reply('-', err.dup())};
+            }
+        }
+        return resps;
+    }
+
+    void RedisClient::enqueue(Pending& pending)
+    {
+        Ego.queued.push_back(&pending);
+        if (!Ego.pumping) {
+            Ego.pumping = true;
+            go(pump(Ego));
+        }
+
+        uint8_t status{0};
+        pending.done >> status;
+    }
+
+    void RedisClient::pump(RedisClient& cli)
+    {
+        // let the other coroutines that are ready queue their commands
+        yield();
+
+        std::vector<Pending*> inflight;
+        std::vector<const Command*> cmds;
+        while (!cli.queued.empty()) {
+            inflight.assign(cli.queued.begin(), cli.queued.end());
+            cli.queued.clear();
+            cmds.clear();
+            for (auto p: inflight) {
+                cmds.push_back(&p->cmd);
+            }
+
+            ltrace(&cli, "pipelining %zu commands", inflight.size());
+            auto err = cli.transmit(cmds.data(), cmds.size());
+            for (auto p: inflight) {
+                if (err.empty() and !cli.receive(p->resp, p->nreply)) {
+                    err = suil::catstr("receiving Response failed: ", errno_s);
+                    // the replies of the remaining commands cannot be matched anymore
+                    cli.sock->close();
+                }
+                if (!err.empty()) {
+                    p->resp = Response{Reply('-', err.dup())};
+                }
+                p->done << uint8_t(1);
+            }
+        }
+        cli.pumping = false;
+    }
+
+    String RedisClient::transmit(const Command* const* cmds, size_t count)
+    {
+        // send all the commands with a single write
+        std::vector<iovec> iov(count);
+        size_t total{0};
+        for (size_t i = 0; i < count; i++) {
+            auto data = cmds[i]->prepared();
+            iov[i].iov_base = (void *) data.data();
+            iov[i].iov_len = data.size();
+            total += data.size();
+        }
+
+        auto size = adaptor().sendv(iov.data(), int(count), config.Timeout);
+        if (size != total) {
+            auto err = suil::catstr("sending failed: ", errno_s);
+            sock->close();
+            return err;
+        }
+        adaptor().flush(config.Timeout);
+        return {};
+    }
+
+    bool RedisClient::receive(Response& resp, size_t nreply)
+    {
+        std::vector<RespParser::Entry> staging;
         do {
-            if (!receiveResponse(resp.buffer, stage)) {
-                // receiving data failed
-                return Response{Reply('-',
-                                      suil::catstr("receiving Response failed: ", errno_s))};
+            if (!Ego.receiveReply(resp.buffer, staging)) {
+                // the bytes received so far cannot be matched to a reply
+                Ego.rxb.bseek(0);
+                Ego.rxpos = 0;
+                return false;
             }
-        } while (--nrps > 0);
+        } while (--nreply > 0);
 
-        resp.entries = std::move(stage);
-        return std::move(resp);
+        // the buffer might be reallocated while receiving, replies refer to
+        // it's final location
+        resp.entries.reserve(staging.size());
+        for (auto& entry: staging) {
+            resp.entries.push_back(toReply(resp.buffer, entry));
+        }
+        return true;
     }
 
     String RedisClient::commit(Response& resp)
     {
+        if (Ego.isShared) {
+            // the replies would be mixed up with those of the commands sent by the pump
+            return String{"batched commands require an exclusive connection"};
+        }
+
         // send all the commands at once and read all the responses in one go
         auto last = batched.back();
         batched.pop_back();
@@ -283,115 +567,128 @@ namespace suil::db {
         return String{nullptr};
     }
 
-    bool RedisClient::receiveResponse(Buffer& out, std::vector<Reply>& staging)
+    bool RedisClient::receiveReply(Buffer& out, std::vector<RespParser::Entry>& staging)
     {
-        std::size_t rxd{1}, offset{out.size()};
-        char prefix;
-        if (!adaptor().read(&prefix, rxd, config.Timeout)) {
-            return false;
+        Ego.parser.reset();
+        while (true) {
+            auto status = Ego.parser.feed(&Ego.rxb.data()[Ego.rxpos], Ego.rxb.size() - Ego.rxpos);
+            if (status == RespParser::Complete) {
+                break;
+            }
+            if (status == RespParser::Invalid) {
+                ierror("received an invalid reply from redis server");
+                errno = EPROTO;
+                return false;
+            }
+            if (!Ego.fill()) {
+                return false;
+            }
         }
 
-        switch (prefix) {
-            case PrefixError:
-            case PrefixInteger:
-            case PrefixValue: {
-                if (!readLine(out)) {
-                    return false;
-                }
-                String tmp{(char *) &out[offset], out.size() - offset, false};
-                out << '\0';
-                staging.emplace_back(Reply(prefix, std::move(tmp)));
-                return true;
-            }
-            case PrefixString: {
-                std::int64_t len{0};
-                if (!readLen(len)) {
-                    return false;
-                }
+        auto size = Ego.parser.consumed();
+        auto base = out.size();
+        if (base == 0 and Ego.rxpos == 0 and size == Ego.rxb.size() and size >= (SUIL_REDIS_RX_CHUNK >> 2)) {
+            // a large reply which is alone in the receive buffer, take the buffer instead of copying it
+            out = std::move(Ego.rxb);
+        }
+        else {
+            out.append(&Ego.rxb.data()[Ego.rxpos], size);
+        }
 
-                String tmp{};
-                if (len >= 0) {
-                    size_t size = (size_t) len + 2;
-                    out.reserve((size_t) size + 2);
-                    if (!adaptor().read(&out[offset], size, config.Timeout)) {
-                        idebug("receiving string '%lu' failed: %s", errno_s);
-                        return false;
-                    }
-                    // only interested in actual string
-                    if (len) {
-                        out.seek(len);
-                        tmp = String{(char *) &out[offset], (size_t) len, false};
-                        // terminate string
-                        out << '\0';
-                    }
-                }
-                staging.emplace_back(Reply(PrefixString, std::move(tmp)));
-                return true;
-            }
+        Ego.rxpos += size;
+        if (Ego.rxpos >= Ego.rxb.size()) {
+            Ego.rxb.bseek(0);
+            Ego.rxpos = 0;
+        }
 
-            case PrefixArray: {
-                int64_t len{0};
-                if (!readLen(len)) {
-                    return false;
-                }
-                staging.emplace_back(Reply(PrefixArray, ""));
-                if (len > 0) {
-                    int i = 0;
-                    for (i; i < len; i++) {
-                        if (!receiveResponse(out, staging)) {
-                            return false;
-                        }
-                    }
-                }
+        for (auto& entry: Ego.parser.entries()) {
+            staging.push_back({entry.prefix, base + entry.offset, entry.size});
+        }
+        return true;
+    }
 
-                return true;
-            }
+    bool RedisClient::fill()
+    {
+        if (Ego.rxpos > 0) {
+            // discard the replies that were already decoded
+            auto left = Ego.rxb.size() - Ego.rxpos;
+            memmove(Ego.rxb.data(), &Ego.rxb.data()[Ego.rxpos], left);
+            Ego.rxb.bseek(off_t(left));
+            Ego.rxpos = 0;
+        }
 
-            default: {
-                ierror("received Response with unsupported type: %c", out[0]);
-                return false;
+        size_t len{0};
+        bool ok{false};
+        if (Ego.config.UseSsl) {
+            // TLS reads wait for the requested number of bytes, only request
+            // the bytes that are known to be part of the reply
+            len = Ego.parser.needed();
+            Ego.rxb.reserve(std::max(len, size_t(256)));
+            if (len != 0) {
+                ok = adaptor().receive(&Ego.rxb.data()[Ego.rxb.size()], len, config.Timeout);
+            }
+            else {
+                len = Ego.rxb.capacity();
+                ok = adaptor().receiveUntil(&Ego.rxb.data()[Ego.rxb.size()], len, "\n", 1, config.Timeout) or
+                     (errno == ENOBUFS);
             }
         }
-    }
+        else {
+            // read whatever is available, up to the size of the buffer
+            Ego.rxb.reserve(std::max(Ego.parser.needed(), size_t(SUIL_REDIS_RX_CHUNK)));
+            len = Ego.rxb.capacity();
+            ok = adaptor().read(&Ego.rxb.data()[Ego.rxb.size()], len, config.Timeout);
+        }
 
-    bool RedisClient::readLen(int64_t &len)
-    {
-        Buffer out{16};
-        if (!readLine(out)) {
+        if (!ok) {
+            idebug("receiving reply failed: %s", errno_s);
             return false;
         }
-        String tmp{(char *) &out[0], out.size(), false};
-        tmp.data()[tmp.size()] = '\0';
-        suil::cast(tmp, len);
+        Ego.rxb.seek(off_t(len));
         return true;
     }
 
-    bool RedisClient::readLine(Buffer &out) {
-        out.reserve(255);
-        size_t cap{out.capacity()};
-        do {
-            size_t ndelims{1};
-            if (!adaptor().receiveUntil(&out[out.size()], cap, "\r", ndelims, config.Timeout)) {
-                if (errno == ENOBUFS) {
-                    // reserve buffers
-                    out.seek(cap);
-                    out.reserve(512);
-                    continue;
-                }
-                return false;
-            }
+    RedisClient::Reply RedisClient::toReply(Buffer& buf, const RespParser::Entry& entry)
+    {
+        auto data = &buf.data()[entry.offset];
+        switch (entry.prefix) {
+            case '*': case '%': case '~': case '>': case '|':
+                // aggregates are flattened, maps are returned as arrays of key-value pairs like in RESP2
+                return Reply(PrefixArray, "");
+            case '_':
+                return Reply(PrefixString, String{});
+            case '#':
+                return Reply(PrefixInteger, (data[0] == 't')? "1" : "0");
+            default:
+                break;
+        }
 
-            out.seek(cap - 1);
-            uint8_t tmp[2];
-            cap = sizeof(tmp);
-            if (!adaptor().receiveUntil(tmp, cap, "\n", ndelims, config.Timeout)) {
-                // this should be impossible
-                return false;
-            }
-            break;
-        } while (true);
+        if (entry.size < 0) {
+            // null bulk string
+            return Reply(PrefixString, String{});
+        }
 
-        return true;
+        // the data is followed by \r\n, terminate it in place
+        auto size = size_t(entry.size);
+        data[size] = '\0';
+        switch (entry.prefix) {
+            case '$':
+                return Reply(PrefixString, size? String{data, size, false} : String{});
+            case '!':
+                return Reply(PrefixError, String{data, size, false});
+            case '=':
+                // verbatim strings start with their format, e.g txt:
+                if (size >= 4) {
+                    return Reply(PrefixString, String{&data[4], size - 4, false});
+                }
+                return Reply(PrefixString, String{data, size, false});
+            case ',':
+            case '(':
+                // doubles and big numbers
+                return Reply(PrefixInteger, String{data, size, false});
+            default:
+                return Reply(entry.prefix, String{data, size, false});
+        }
     }
 
     bool RedisClient::info(ServerInfo &out)
@@ -622,6 +919,11 @@ namespace suil::db {
 
     void RedisClient::close()
     {
+        if (isShared) {
+            // shared connections stay open for the other coroutines
+            return;
+        }
+
         if ((onClose != nullptr) and (cacheId != CacheId{nullptr})) {
             onClose(cacheId, true);
         }
@@ -652,8 +954,12 @@ namespace suil::db {
         }
         return serverInfo;
     }
-    RedisClient& RedisDb::connect(int db)
+    RedisClient& RedisDb::connect(int db, bool exclusive)
     {
+        if (config.AutoPipeline and !exclusive) {
+            return Ego.shared(db);
+        }
+
         auto it = fromCache(db);
         bool isFromCache{true};
         if (it == Ego.clients.end()) {
@@ -679,6 +985,65 @@ namespace suil::db {
         return cli;
     }
 
+    RedisClient& RedisDb::shared(int db)
+    {
+        auto it = Ego.sharedClients.find(db);
+        if (it == Ego.sharedClients.end()) {
+            auto cit = Ego.sharedConnection(db);
+            // another coroutine might have connected while this one was connecting
+            auto [sit, added] = Ego.sharedClients.emplace(db, cit);
+            if (!added) {
+                cit->onClose = nullptr;
+                Ego.clients.erase(cit);
+            }
+            return *sit->second;
+        }
+
+        auto& cli = *it->second;
+        if ((cli.sock != nullptr and cli.sock->isOpen()) or cli.pumping or cli.reconnecting) {
+            return cli;
+        }
+
+        // the connection was closed after an error. Other coroutines might still be
+        // holding the client, so the client is kept and only it's socket is replaced
+        idebug("reconnecting broken shared connection to database %d", db);
+        cli.reconnecting = true;
+        try {
+            auto cit = Ego.sharedConnection(db);
+            std::swap(cli.sock, cit->sock);
+            // whatever was received on the broken connection is stale
+            cli.rxb.bseek(0);
+            cli.rxpos = 0;
+            // closes the broken socket
+            cit->onClose = nullptr;
+            Ego.clients.erase(cit);
+        }
+        catch (...) {
+            cli.reconnecting = false;
+            throw;
+        }
+        cli.reconnecting = false;
+        return cli;
+    }
+
+    typename RedisDb::Clients::iterator RedisDb::sharedConnection(int db)
+    {
+        auto cit = newConnection();
+        if (db != 0) {
+            itrace("changing database to %d", db);
+            auto resp = (*cit)("SELECT", db);
+            if (!resp) {
+                cit->onClose = nullptr;
+                Ego.clients.erase(cit);
+                throw RedisDbError(
+                        "redis - changing to selected database '", db, "' failed: ", resp.error());
+            }
+        }
+        // commands are only pipelined once the database is selected
+        cit->isShared = true;
+        return cit;
+    }
+
     typename RedisDb::Clients::iterator RedisDb::fromCache(int db)
     {
         if (!Ego.cache.empty()) {
@@ -802,4 +1167,196 @@ namespace suil::db {
     {
         return (it != Clients::iterator{nullptr}) and (it != clients.end());
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace db = suil::db;
+
+TEST_CASE("RESP reply decoding", "[db][redis][resp]")
+{
+    db::RespParser parser;
+
+    SECTION("Replies split across reads are resumed") {
+        const std::string reply{"*3\r\n$3\r\nfoo\r\n$-1\r\n%1\r\n+key\r\n:42\r\n+OK\r\n"};
+        const size_t size{reply.size() - 5};
+        for (size_t len = 0; len < size; len++) {
+            REQUIRE(parser.feed(reply.data(), len) == db::RespParser::Incomplete);
+        }
+        REQUIRE(parser.feed(reply.data(), reply.size()) == db::RespParser::Complete);
+        REQUIRE(parser.consumed() == size);
+
+        auto& entries = parser.entries();
+        REQUIRE(entries.size() == 6);
+        REQUIRE(entries[0].prefix == '*');
+        REQUIRE(entries[0].size == 3);
+        REQUIRE(entries[1].prefix == '$');
+        REQUIRE(reply.compare(entries[1].offset, entries[1].size, "foo") == 0);
+        REQUIRE(entries[2].size == -1);
+        REQUIRE(entries[3].prefix == '%');
+        REQUIRE(reply.compare(entries[4].offset, entries[4].size, "key") == 0);
+        REQUIRE(reply.compare(entries[5].offset, entries[5].size, "42") == 0);
+    }
+
+    SECTION("The size of incomplete bulk strings is known") {
+        const std::string reply{"$10\r\n0123"};
+        REQUIRE(parser.feed(reply.data(), reply.size()) == db::RespParser::Incomplete);
+        REQUIRE(parser.needed() == 8);
+    }
+
+    SECTION("Invalid replies are rejected") {
+        const std::string reply{"$3\r\nfooo\r\n"};
+        REQUIRE(parser.feed(reply.data(), reply.size()) == db::RespParser::Invalid);
+        parser.reset();
+        REQUIRE(parser.feed("?1\r\n", 4) == db::RespParser::Invalid);
+    }
+}
+
+using suil::net::Socket;
+using suil::net::TcpServerSock;
+
+static coroutine void fakeRedisConnection(Socket::UPtr sock)
+{
+    // replies to GET with the key, to PING with PONG, to everything else with OK and
+    // closes the connection on QUIT
+    suil::Buffer rxb{1024};
+    size_t pos{0};
+    db::RespParser parser;
+    while (sock->isOpen()) {
+        rxb.reserve(1024);
+        size_t len = rxb.capacity();
+        if (!sock->read(&rxb.data()[rxb.size()], len, 5000) or len == 0) {
+            break;
+        }
+        rxb.seek(off_t(len));
+
+        suil::Buffer ob{256};
+        while (pos < rxb.size()) {
+            parser.reset();
+            if (parser.feed(&rxb.data()[pos], rxb.size() - pos) != db::RespParser::Complete) {
+                break;
+            }
+            auto& entries = parser.entries();
+            auto arg = [&](size_t i) {
+                return std::string{&rxb.data()[pos + entries[i].offset], size_t(entries[i].size)};
+            };
+
+            auto cmd = arg(1);
+            if (cmd == "GET") {
+                auto key = arg(2);
+                ob << '$' << key.size() << "\r\n" << key << "\r\n";
+            }
+            else if (cmd == "PING") {
+                ob << "+PONG\r\n";
+            }
+            else if (cmd == "QUIT") {
+                sock->close();
+                return;
+            }
+            else {
+                ob << "+OK\r\n";
+            }
+            pos += parser.consumed();
+        }
+
+        if (!ob.empty()) {
+            sock->send(ob.data(), ob.size(), 5000);
+        }
+    }
+}
+
+static coroutine void fakeRedisServer(TcpServerSock::Ptr& server)
+{
+    auto s = server;
+    while (s->isRunning()) {
+        if (auto sock = s->accept()) {
+            go(fakeRedisConnection(std::move(sock)));
+        }
+    }
+}
+
+static coroutine void redisGet(db::RedisClient& cli, int i, suil::String& out, suil::Channel<int>& done)
+{
+    auto resp = cli.send("GET", suil::catstr("key:", i));
+    out = resp? resp.get<suil::String>(0) : suil::String{resp.error()}.dup();
+    done << i;
+}
+
+static coroutine void redisPipeline(db::RedisClient& cli, int i, std::vector<suil::String>& out, suil::Channel<int>& done)
+{
+    auto resps = cli.pipeline()
+            ("GET", suil::catstr("pipe:", i, ":a"))
+            ("GET", suil::catstr("pipe:", i, ":b")).exec();
+    for (auto& resp: resps) {
+        out.push_back(resp? resp.get<suil::String>(0) : suil::String{resp.error()}.dup());
+    }
+    done << i;
+}
+
+TEST_CASE("Auto pipelined redis connections", "[db][redis][pipeline]")
+{
+    auto addr = iplocal("127.0.0.1", 6399, 0);
+    TcpServerSock::Ptr server{new TcpServerSock};
+    REQUIRE(server->listen(addr, 16));
+    go(fakeRedisServer(server));
+
+    db::RedisDbConfig config;
+    config.Timeout = 2000;
+    config.AutoPipeline = true;
+
+    {
+        db::RedisDb rdb("127.0.0.1", 6399, config);
+        auto& cli = rdb.connect();
+        REQUIRE(cli.isShared);
+
+        SECTION("Replies are matched to the commands in the order they were sent") {
+            constexpr int count{32};
+            std::vector<suil::String> got(count);
+            std::vector<std::vector<suil::String>> piped(count);
+            suil::Channel<int> done{-1};
+            for (int i = 0; i < count; i++) {
+                // plain commands and pipelines of different coroutines are interleaved
+                go(redisGet(cli, i, got[i], done));
+                go(redisPipeline(cli, i, piped[i], done));
+            }
+            for (int i = 0; i < count * 2; i++) {
+                int id{-1};
+                done >> id;
+            }
+
+            for (int i = 0; i < count; i++) {
+                REQUIRE(got[i] == suil::catstr("key:", i));
+                REQUIRE(piped[i].size() == 2);
+                REQUIRE(piped[i][0] == suil::catstr("pipe:", i, ":a"));
+                REQUIRE(piped[i][1] == suil::catstr("pipe:", i, ":b"));
+            }
+        }
+
+        SECTION("A broken shared connection is replaced in place") {
+            REQUIRE(cli.ping());
+            // the server closes the connection, the command fails
+            REQUIRE_FALSE(cli.send("QUIT"));
+            REQUIRE_FALSE(cli.sock->isOpen());
+
+            // the client held by other coroutines remains usable
+            auto& again = rdb.connect();
+            REQUIRE(&again == &cli);
+            REQUIRE(cli.sock->isOpen());
+            REQUIRE(cli.get<suil::String>("after") == "after");
+        }
+
+        SECTION("Transactions and batches require an exclusive connection") {
+            db::RedisTransaction txn(cli);
+            REQUIRE_FALSE(txn.multi());
+
+            db::RedisClient::Command cmd("GET", "a");
+            cli.batch(cmd);
+            db::RedisClient::Response resp;
+            REQUIRE_FALSE(cli.commit(resp).empty());
+            cli.reset();
+        }
+    }
+
+    server->close();
+}
+#endif
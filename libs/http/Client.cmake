@@ -6,9 +6,11 @@ set(SUIL_HTTP_CLIENT_SOURCES
         src/offload.cpp
         src/parser.cpp
         src/passwd.cpp
+        src/client/batch.cpp
         src/client/fileoffload.cpp
         src/client/form.cpp
         src/client/memoffload.cpp
+        src/client/pool.cpp
         src/client/request.cpp
         src/client/response.cpp
         src/client/session.cpp
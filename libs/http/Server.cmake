@@ -7,6 +7,7 @@ set(SUIL_HTTP_SERVER_SOURCES
         src/parser.cpp
         src/passwd.cpp
         src/server/admin.cpp
+        src/server/compressmw.cpp
         src/server/connection.cpp
         src/server/cors.cpp
         src/server/endpoint.cpp
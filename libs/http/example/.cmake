@@ -22,6 +22,17 @@ if (ENABLE_EXAMPLES)
     configure_file(${CMAKE_CURRENT_SOURCE_DIR}/example/server/www/index.html
                    ${CMAKE_CURRENT_BINARY_DIR}/www/index.html @ONLY)
 
+    # Benchmarks looking up routes with and without the compiled matcher
+    add_executable(HttpServer-RoutesBench
+            ${CMAKE_CURRENT_SOURCE_DIR}/example/routes/main.cpp)
+    set_target_properties(HttpServer-RoutesBench
+        PROPERTIES
+            RUNTIME_OUTPUT_NAME http-routes-bench)
+    target_link_libraries(HttpServer-RoutesBench
+            PRIVATE Suil::HttpServer)
+    target_include_directories(HttpServer-RoutesBench
+            PRIVATE ${CMAKE_BINARY_DIR}/scc/public)
+
     add_executable(HttpClient-Example
             ${CMAKE_CURRENT_SOURCE_DIR}/example/client/main.cpp)
     set_target_properties(HttpClient-Example
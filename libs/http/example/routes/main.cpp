@@ -0,0 +1,97 @@
+//
+// Created by Mpho Mbotho on 2021-07-06.
+//
+// Measures the time it takes to look up a route in a router with 520 routes,
+// using the recursive trie search and the compiled matcher.
+//
+
+#include <suil/http/server/trie.hpp>
+
+#include <chrono>
+
+using suil::String;
+using suil::http::server::RoutesTrie;
+namespace crow = suil::http::crow;
+
+static const char* Resources[] = {
+    "users", "groups", "roles", "orders", "items", "carts", "payments", "invoices",
+    "products", "reviews", "ratings", "tags", "categories", "brands", "stores", "addresses",
+    "shipments", "returns", "refunds", "coupons", "campaigns", "emails", "messages", "threads",
+    "posts", "comments", "likes", "files", "folders", "shares", "devices", "sessions",
+    "tokens", "keys", "webhooks", "events", "logs", "metrics", "alerts", "reports"
+};
+
+static const char* Patterns[] = {
+    "/api/v1/%s",
+    "/api/v1/%s/{int}",
+    "/api/v1/%s/{int}/history",
+    "/api/v1/%s/{int}/owner",
+    "/api/v1/%s/{int}/tags/{string}",
+    "/api/v1/%s/search/{string}",
+    "/api/v1/%s/export",
+    "/api/v1/%s/import",
+    "/api/v1/%s/count",
+    "/api/v2/%s",
+    "/api/v2/%s/{uint}",
+    "/api/v2/%s/{uint}/audit/{float}",
+    "/static/%s/{path}"
+};
+
+static double bench(const RoutesTrie& trie, const std::vector<String>& urls, int iterations)
+{
+    crow::detail::routing_params params;
+    unsigned sum{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (auto& url: urls) {
+            sum += trie.match(url, params);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) {
+        printf("no route matched\n");
+    }
+    return elapsed.count() / (double(iterations) * urls.size());
+}
+
+int main(int argc, char *argv[])
+{
+    RoutesTrie recursive, compiled;
+    std::vector<String> urls;
+    unsigned index{1};
+    char route[128], url[128];
+    for (auto res: Resources) {
+        for (auto pattern: Patterns) {
+            snprintf(route, sizeof(route), pattern, res);
+            recursive.add(route, index);
+            compiled.add(route, index++);
+        }
+        snprintf(url, sizeof(url), "/api/v1/%s", res);
+        urls.emplace_back(String{url}.dup());
+        snprintf(url, sizeof(url), "/api/v1/%s/1024/tags/blue", res);
+        urls.emplace_back(String{url}.dup());
+        snprintf(url, sizeof(url), "/api/v1/%s/count", res);
+        urls.emplace_back(String{url}.dup());
+        snprintf(url, sizeof(url), "/api/v2/%s/77/audit/1.5", res);
+        urls.emplace_back(String{url}.dup());
+        snprintf(url, sizeof(url), "/static/%s/css/main.css", res);
+        urls.emplace_back(String{url}.dup());
+        snprintf(url, sizeof(url), "/api/v1/%s/unknown/route", res);
+        urls.emplace_back(String{url}.dup());
+    }
+    compiled.validate();
+    if (!compiled.compiled()) {
+        printf("routes could not be compiled\n");
+        return EXIT_FAILURE;
+    }
+
+    int iterations = argc > 1? atoi(argv[1]) : 2000;
+    printf("%u routes, %zu urls, %d iterations\n", index-1, urls.size(), iterations);
+    // warm up
+    bench(recursive, urls, std::max(1, iterations/10));
+    printf("  %-10s %8.1f ns/lookup\n", "recursive", bench(recursive, urls, iterations));
+    bench(compiled, urls, std::max(1, iterations/10));
+    printf("  %-10s %8.1f ns/lookup\n", "compiled", bench(compiled, urls, iterations));
+
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@
 #include <suil/http/common.hpp>
 
 #include "suil/http/server/endpoint.hpp"
+#include "suil/http/server/compressmw.hpp"
 #include "suil/http/server/sysattrs.hpp"
 #include "suil/http/server/cors.hpp"
 #include "suil/http/server/admin.hpp"
@@ -35,9 +36,10 @@ const suil::UnorderedMap<User> users = {
 int main(int argc, char *argv[])
 {
     suil::setup(opt(verbose, 0));
-    ipc::init(/*opt(nworkers, 2)*/);
+    ipc::init(/*opt(nworkers, 2), opt(respawn, true)*/);
 
     using Server = hs::Endpoint<
+                        hs::Compression,        // Compress response bodies
                         hs::Initializer,        // Block all routes until application is initialized
                         hs::SystemAttrs,        // System level attributes
                         hs::Cors,               // CORS
@@ -0,0 +1,151 @@
+//
+// Created by Mpho Mbotho on 2021-07-12.
+//
+
+#ifndef SUIL_HTTP_CLIENT_BATCH_HPP
+#define SUIL_HTTP_CLIENT_BATCH_HPP
+
+#include <suil/http/client/session.hpp>
+
+namespace suil::http::cli {
+
+    /**
+     * A request executed as part of a \a Batch, along with its result
+     */
+    struct Call {
+        Call(Method m,
+             String resource,
+             Request::Builder builder = nullptr,
+             Response::Writer writer = nullptr,
+             int64 timeout = -1);
+
+        MOVE_CTOR(Call) = default;
+        MOVE_ASSIGN(Call) = default;
+
+        /**
+         * @return true if a response was received for the request, the response
+         * status still needs to be checked
+         */
+        inline bool ok() const {
+            return error.empty();
+        }
+
+        Method method{Method::Get};
+        String resource{};
+        Request::Builder builder{nullptr};
+        // e.g the writer of a MemoryOffload or a FileOffload
+        Response::Writer writer{nullptr};
+        // the deadline of the whole request, -1 to use the session's timeout
+        int64 timeout{-1};
+
+        Response resp{};
+        // set when sending the request or receiving the response failed
+        String error{};
+
+    private:
+        DISABLE_COPY(Call);
+        friend class Batch;
+        friend class Session;
+        void fail();
+        Deadline deadline{};
+    };
+
+    /**
+     * Executes many requests to the same site concurrently from a single coroutine.
+     * The requests are either fanned out across pooled connections, with each request
+     * running in its own coroutine, or pipelined on keep-alive connections
+     *
+     * @code
+     *   cli::Batch batch(session);
+     *   for (auto& id: ids) {
+     *       batch.get(suil::catstr("/accounts/", id), nullptr, 500);
+     *   }
+     *   batch.fanout(16);
+     *   for (auto& call: batch) {
+     *       if (call.ok() and call.resp) { ... }
+     *   }
+     * @endcode
+     */
+    class Batch: LOGGER(HTTP_CLIENT) {
+    public:
+        using iterator = std::vector<Call>::iterator;
+
+        explicit Batch(Session& sess);
+
+        DISABLE_COPY(Batch);
+        DISABLE_MOVE(Batch);
+
+        /**
+         * Add a request to the batch
+         * @param timeout the deadline of the request in milliseconds, measured
+         * from the start of \a fanout or \a pipeline
+         * @return the index of the added call, calls are stored contiguously and
+         * references to them are invalidated by adding calls
+         */
+        size_t add(
+                Method m,
+                String resource,
+                Request::Builder builder = nullptr,
+                Response::Writer writer = nullptr,
+                int64 timeout = -1);
+
+        inline size_t get(String resource, Request::Builder builder = nullptr, int64 timeout = -1) {
+            return Ego.add(Method::Get, std::move(resource), std::move(builder), nullptr, timeout);
+        }
+
+        template <typename T>
+        inline size_t get(T& off, String resource, Request::Builder builder = nullptr, int64 timeout = -1) {
+            return Ego.add(Method::Get, std::move(resource), std::move(builder), off(), timeout);
+        }
+
+        inline size_t post(String resource, Request::Builder builder = nullptr, int64 timeout = -1) {
+            return Ego.add(Method::Post, std::move(resource), std::move(builder), nullptr, timeout);
+        }
+
+        /**
+         * Execute all the requests concurrently, each on its own connection from
+         * the session's pool. Returns when all the requests are done or their
+         * deadline expired
+         * @param concurrency the maximum number of requests in flight, 0 for no limit
+         */
+        void fanout(size_t concurrency = 0);
+
+        /**
+         * Pipeline the requests on keep-alive connections, i.e requests are sent
+         * without waiting for the responses of previous requests. The requests are
+         * split into consecutive groups, one per connection. Only idempotent requests
+         * (GET, HEAD, OPTIONS, DELETE) can be pipelined
+         * @param connections the number of connections to spread the requests across
+         */
+        void pipeline(size_t connections = 1);
+
+        inline Call& operator[](size_t index) {
+            return Ego._calls[index];
+        }
+
+        inline size_t size() const {
+            return Ego._calls.size();
+        }
+
+        inline iterator begin() {
+            return Ego._calls.begin();
+        }
+
+        inline iterator end() {
+            return Ego._calls.end();
+        }
+
+        inline void clear() {
+            Ego._calls.clear();
+        }
+
+    private suil_ut:
+        void start();
+        static coroutine void performOne(Batch& batch, size_t index, Channel<int>& done);
+        static coroutine void pipelineGroup(Batch& batch, size_t from, size_t to, Channel<int>& done);
+
+        std::reference_wrapper<Session> _session;
+        std::vector<Call> _calls{};
+    };
+}
+#endif //SUIL_HTTP_CLIENT_BATCH_HPP
@@ -0,0 +1,126 @@
+//
+// Created by Mpho Mbotho on 2021-07-11.
+//
+
+#ifndef SUIL_HTTP_CLIENT_POOL_HPP
+#define SUIL_HTTP_CLIENT_POOL_HPP
+
+#include <suil/http/client/request.hpp>
+#include <suil/http/client.scc.hpp>
+
+#include <suil/base/channel.hpp>
+
+#include <deque>
+
+#ifndef SUIL_HTTP_POOL_MAX_IDLE
+#define SUIL_HTTP_POOL_MAX_IDLE       8
+#endif
+
+#ifndef SUIL_HTTP_POOL_MAX_PER_HOST
+#define SUIL_HTTP_POOL_MAX_PER_HOST   64
+#endif
+
+#ifndef SUIL_HTTP_POOL_IDLE_TIMEOUT
+#define SUIL_HTTP_POOL_IDLE_TIMEOUT   30000
+#endif
+
+namespace suil::http::cli {
+
+    /**
+     * Keeps the connections opened by client sessions alive so that they can be
+     * reused by subsequent requests to the same host. Connections are grouped by
+     * their protocol, host and port (e.g https://example.com:443), a group has at
+     * most `maxPerHost` open connections (idle or in use) and keeps at most `maxIdle`
+     * of them idle for `idleTimeout` milliseconds. A coroutine acquiring a connection
+     * from an exhausted group waits until a connection is released.
+     *
+     * @note pools are not thread safe, \a shared returns the calling thread's pool
+     */
+    class ConnectionPool: LOGGER(HTTP_CLIENT) {
+    public:
+        ConnectionPool() = default;
+
+        DISABLE_COPY(ConnectionPool);
+        DISABLE_MOVE(ConnectionPool);
+
+        ~ConnectionPool();
+
+        template<typename T>
+        void configure(T& opts) {
+            Ego._maxIdle = opts.get(sym(maxIdle), Ego._maxIdle);
+            Ego._maxPerHost = opts.get(sym(maxPerHost), Ego._maxPerHost);
+            Ego._idleTimeout = opts.get(sym(idleTimeout), Ego._idleTimeout);
+        }
+
+        template <typename... Opts>
+        void setup(Opts... args) {
+            auto opts = iod::D(args...);
+            configure(opts);
+        }
+
+        /**
+         * Acquire a connection to the given host, the returned socket is either an
+         * idle connection that is still alive or a new (not connected) socket
+         * @param key the key of the host, see \a key
+         * @param ssl true if the connection to the host uses TLS
+         * @param timeout the maximum amount of time to wait for a connection when
+         * the host already has \a maxPerHost open connections
+         * @return a socket that can be used to send requests to the host
+         * @throws HttpException if no connection is released before timeout
+         */
+        net::Socket::UPtr acquire(const String& key, bool ssl, int64 timeout = -1);
+
+        /**
+         * Return a connection acquired with \a acquire to the pool
+         * @param key the key of the host the connection was acquired for
+         * @param sock the connection to return
+         * @param reuse true if the connection can be used for another request
+         */
+        void release(const String& key, net::Socket::UPtr sock, bool reuse);
+
+        /**
+         * @return the number of idle connections to the given host
+         */
+        size_t idle(const String& key) const;
+
+        /**
+         * @return the number of open connections (idle or in use) to the given host
+         */
+        size_t open(const String& key) const;
+
+        /**
+         * @return the key of a host in a pool
+         */
+        static String key(const String& proto, const String& host, int port);
+
+        /**
+         * @return the pool used by sessions of the calling thread by default
+         */
+        static ConnectionPool& shared();
+
+    private suil_ut:
+        struct Idle {
+            net::Socket::UPtr sock{nullptr};
+            int64 expires{0};
+        };
+
+        struct Host {
+            // most recently used connections are at the back
+            std::deque<Idle> idle{};
+            Conditional waiters{};
+            uint32 open{0};
+        };
+
+        Host& host(const String& key);
+        static bool isAlive(net::Socket& sock);
+        static coroutine void cleanup(ConnectionPool& pool);
+
+        UnorderedMap<std::unique_ptr<Host>> _hosts{};
+        uint32 _maxIdle{SUIL_HTTP_POOL_MAX_IDLE};
+        uint32 _maxPerHost{SUIL_HTTP_POOL_MAX_PER_HOST};
+        int64  _idleTimeout{SUIL_HTTP_POOL_IDLE_TIMEOUT};
+        Channel<uint8_t> _notify{1};
+        bool   _cleaning{false};
+    };
+}
+#endif //SUIL_HTTP_CLIENT_POOL_HPP
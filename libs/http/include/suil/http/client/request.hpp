@@ -83,7 +83,7 @@ namespace suil::http::cli {
         void encodeArgs(Buffer& dst) const;
         void encodeHeaders(Buffer& dst) const;
         size_t buildBody();
-        void submit(int64 timeout = -1);
+        void submit(const Deadline& dd = Deadline::infinite());
 
         friend class Session;
         net::Socket::UPtr _sock{nullptr};
@@ -29,7 +29,7 @@ namespace suil::http::cli {
 
         const String& header(const String& name) const;
 
-        inline const UnorderedMap<String,CaseInsensitive>& headers() const {
+        inline const HeaderTable& headers() const {
             return _headers;
         }
 
@@ -41,6 +41,14 @@ namespace suil::http::cli {
             return status() == http::Ok;
         }
 
+        /**
+         * @return true if the connection the response was received on can be
+         * used for another request
+         */
+        inline bool keepAlive() const {
+            return _bodyRead and (llhttp_should_keep_alive(this) != 0);
+        }
+
         const String& contentType() const {
             return header("Content-Type");
         }
@@ -60,9 +68,13 @@ namespace suil::http::cli {
 
     private:
         DISABLE_COPY(Response);
-        void receive(net::Socket& sock, int64 timeout = -1);
+        void receive(net::Socket& sock, const Deadline& dd, Buffer* pending = nullptr);
         friend class Session;
         bool _bodyRead{false};
+        // set for responses to HEAD requests, which have no body
+        bool _noBody{false};
+        // the number of bytes of the response received so far
+        size_t _received{0};
         Writer _writer{nullptr};
     };
 }
@@ -5,16 +5,21 @@
 #ifndef SUIL_HTTP_CLIENT_SESSION_HPP
 #define SUIL_HTTP_CLIENT_SESSION_HPP
 
+#include <suil/http/client/pool.hpp>
 #include <suil/http/client/request.hpp>
 #include <suil/http/client/response.hpp>
 #include <suil/http/client.scc.hpp>
 
+#include <span>
+
 #ifndef SUIL_HTTP_USER_AGENT
 #define SUIL_HTTP_USER_AGENT SUIL_SOFTWARE_NAME "/" SUIL_VERSION_STRING
 #endif
 
 namespace suil::http::cli {
 
+    struct Call;
+
     class Session: LOGGER(HTTP_CLIENT) {
     public:
         class Handle {
@@ -26,6 +31,8 @@ namespace suil::http::cli {
 
             DISABLE_COPY(Handle);
 
+            ~Handle();
+
             inline operator bool() const {
                 return req._sock->isOpen();
             }
@@ -36,6 +43,14 @@ namespace suil::http::cli {
 
             std::reference_wrapper<Session> _session;
             Request req;
+
+        private:
+            friend class Session;
+            void release();
+            // the pool the connection is returned to when the handle is destroyed
+            ConnectionPool* _pool{nullptr};
+            // true if the last response allows reusing the connection
+            bool _reuse{false};
         };
 
         MOVE_CTOR(Session) = default;
@@ -93,6 +108,17 @@ namespace suil::http::cli {
         DISABLE_COPY(Session);
         Session(String proto, String host, int port);
 
+        friend class Batch;
+        Handle handle(const Deadline& dd);
+        Response perform(
+                Handle& h,
+                Method m,
+                String resource,
+                const Request::Builder& builder,
+                Response::Writer writer,
+                const Deadline& dd);
+        void pipeline(Handle& h, std::span<Call> calls);
+
         static Session doLoad(const String& url, int port, String path);
 
         template<typename... Options>
@@ -100,11 +126,14 @@ namespace suil::http::cli {
             // @TODO read session from path
             auto opts = iod::D(std::forward<Options>(options)...);
             _timeout = opts.get(sym(timeout), _timeout);
+            // connections are pooled by default, use opt(pool, (ConnectionPool *)nullptr) to disable
+            _pool = opts.get(sym(pool), &ConnectionPool::shared());
 
             if (_port == 0) {
                 // choose port base on standard ports
                 _port = isHttps()? 443 : 80;
             }
+            _poolKey = ConnectionPool::key(_proto, _host, _port);
             _addr = ipremote(_host.data(), _port, 0, Deadline{_timeout});
             if (errno != 0) {
                 throw HttpException("resolving address '", _host, ':', _port, "' failed: ", errno_s);
@@ -124,6 +153,8 @@ namespace suil::http::cli {
         int64 _timeout{20_sec};
         ipaddr _addr{};
         String _proto{"http"};
+        ConnectionPool* _pool{nullptr};
+        String _poolKey{};
     };
 
     template <typename... Options>
@@ -5,6 +5,7 @@
 #ifndef SUIL_HTTP_SERVER_COMMON_HPP
 #define SUIL_HTTP_SERVER_COMMON_HPP
 
+#include <suil/base/compress.hpp>
 #include <suil/base/string.hpp>
 #include <suil/base/exception.hpp>
 
@@ -86,6 +87,21 @@ namespace suil::http {
 
     Method fromString(const String& name);
 
+    /**
+     * Chooses the content coding of a response from the value of the request's
+     * Accept-Encoding header, honouring the quality values given by the client. When
+     * the client weighs codings equally, brotli is preferred over gzip over deflate
+     * @param header the value of the Accept-Encoding header
+     * @param allowed a mask (1 << Codec) of the codings the server is willing to use
+     * @return the coding to use, Codec::None if the response should not be encoded
+     */
+    Codec acceptEncoding(const String& header, uint32 allowed);
+
+    /**
+     * @return the name of the given coding as used in the Content-Encoding header
+     */
+    const char* contentEncoding(Codec codec);
+
 }
 
 #endif //SUIL_HTTP_SERVER_COMMON_HPP
@@ -7,10 +7,78 @@
 
 #include <suil/http/llhttp.h>
 
+#include <suil/base/arena.hpp>
 #include <suil/base/buffer.hpp>
 
 namespace suil::http {
 
+    /**
+     * A flat table of HTTP headers keyed by pre-hashed (case insensitive) names. The
+     * table keeps its capacity across \a clear() calls, so a table reused across
+     * requests on the same connection stops allocating once it has seen the largest
+     * header set. Header names and values can either be owned or views into memory
+     * owned by the parser's user (see \a HttpParser::intern)
+     */
+    class HeaderTable {
+    public:
+        using Header = std::pair<String, String>;
+        using const_iterator = std::vector<Header>::const_iterator;
+
+        HeaderTable() = default;
+
+        /**
+         * add the given header to the table, if a header with the same name already
+         * exists, the table is not modified
+         * @param name the name of the header
+         * @param value the value of the header
+         * @return true if the header was added, false otherwise
+         */
+        bool emplace(String name, String value);
+
+        /**
+         * find the header with the given name (case insensitive)
+         * @param name the name of the header to find
+         * @return an iterator to the found header or \a end() if the header
+         * is not in the table
+         */
+        const_iterator find(const String& name) const;
+
+        inline bool contains(const String& name) const {
+            return Ego.find(name) != Ego.end();
+        }
+
+        inline const_iterator begin() const {
+            return Ego._headers.begin();
+        }
+
+        inline const_iterator end() const {
+            return Ego._headers.end();
+        }
+
+        inline size_t size() const {
+            return Ego._headers.size();
+        }
+
+        inline bool empty() const {
+            return Ego._headers.empty();
+        }
+
+        void clear();
+
+        /**
+         * duplicates all header names and values that are views into memory
+         * not owned by the table
+         * @param arena if provided, the copies will be allocated from the arena
+         */
+        void intern(Arena* arena = nullptr);
+
+    private:
+        std::vector<size_t> _hashes{};
+        std::vector<Header> _headers{};
+        // headers before this index have already been interned
+        size_t _interned{0};
+    };
+
     class HttpParser : protected llhttp_t {
     protected:
         HttpParser(llhttp_type type = HTTP_REQUEST);
@@ -29,6 +97,13 @@ namespace suil::http {
             return feed(nullptr, 0);
         }
 
+        /**
+         * Makes the parser's state independent of the data that was fed to it. Must
+         * be invoked before the memory backing data that was fed to a parser in
+         * \a _viewHeaders mode is modified
+         */
+        virtual void intern();
+
         virtual int onHeadersComplete() { return HPE_OK; }
         virtual int onBodyPart(const String& part);
         virtual int onMessageComplete() { return HPE_OK; }
@@ -40,14 +115,28 @@ namespace suil::http {
         struct {
             uint8_t _headersComplete : 1 = 0;
             uint8_t _bodyComplete    : 1 = 0;
-            uint8_t _u6 : 6              = 0;
+            // when set, the parser stops at the end of each message, leaving
+            // any pipelined data for the next call to feed
+            uint8_t _pipelined       : 1 = 0;
+            // when set, the url, header names and values will be views into the
+            // data given to feed instead of copies (see intern)
+            uint8_t _viewHeaders     : 1 = 0;
+            uint8_t _u4 : 4              = 0;
         } __attribute__((packed));
 
-        UnorderedMap<String, CaseInsensitive> _headers{};
+        HeaderTable _headers{};
         Buffer      _stage{0};
         String      _follow;
+        // view of the url, header name or value currently being parsed
+        String      _mark;
+        // when set, views are interned into this arena instead of the heap
+        Arena      *_arena{nullptr};
+        // the number of bytes consumed by the last call to feed
+        size_t      _parsed{0};
 
     private:
+        void track(const char *at, size_t len);
+        String take();
         static int on_headers_complete(llhttp_t *);
         static int on_chunk_header(llhttp_t *);
         static int on_chunk_complete(llhttp_t *);
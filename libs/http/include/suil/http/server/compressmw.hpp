@@ -0,0 +1,70 @@
+//
+// Created by Mpho Mbotho on 2021-07-08.
+//
+
+#ifndef SUIL_HTTP_SERVER_COMPRESSMW_HPP
+#define SUIL_HTTP_SERVER_COMPRESSMW_HPP
+
+#include <suil/http/server.scc.hpp>
+#include <suil/http/common.hpp>
+#include <suil/base/compress.hpp>
+#include <suil/base/sio.hpp>
+
+namespace suil::http::server {
+
+    class Request;
+    class Response;
+
+    /**
+     * Compresses response bodies using the best coding accepted by the client
+     * (brotli, gzip or deflate). Only responses with a compressible content type
+     * and that are at least `compressMin` bytes are compressed. Compression can
+     * be disabled on a route with the `Compress` attribute, i.e
+     *   .attrs(opt(Compress, false))
+     *
+     * @note the middleware should be the first middleware of the endpoint, so that
+     * it sees the body produced by all the other middlewares
+     */
+    class Compression {
+    public:
+        struct Context{
+        };
+
+        void before(Request&, Response&, Context&);
+
+        void after(Request& req, Response& resp, Context&);
+
+        template<typename T>
+        void configure(T& opts) {
+            Ego._minSize = opts.get(sym(compressMin), Ego._minSize);
+            auto level = opts.get(sym(compressLevel), Ego._level);
+            if (level != Ego._level) {
+                Ego._level = level;
+                for (int i = 0; i < Count; i++) {
+                    Ego._compressors[i] = Compressor{Codec(i + int(Codec::Deflate)), Ego._level};
+                }
+            }
+        }
+
+        template <typename... Opts>
+        void setup(Opts... args) {
+            auto opts = iod::D(args...);
+            configure(opts);
+        }
+
+    private suil_ut:
+        static constexpr int Count{3};
+        static bool compressible(const String& contentType);
+        bool compress(Response& resp, Codec codec);
+
+        size_t _minSize{1_Kib};
+        int    _level{-1};
+        // compressors are reused across responses, indexed by codec - Codec::Deflate
+        Compressor _compressors[Count]{
+            Compressor{Codec::Deflate},
+            Compressor{Codec::Gzip},
+            Compressor{Codec::Brotli}
+        };
+    };
+}
+#endif //SUIL_HTTP_SERVER_COMPRESSMW_HPP
@@ -208,12 +208,62 @@ namespace server {
 
     define_log_tag(HTTP_CONN);
 
+    /**
+     * Per endpoint block of the headers that are common to all responses. The
+     * block is only rebuilt when the date changes (once a second) or when the
+     * configuration it is built from changes
+     */
+    class HeaderCache {
+    public:
+        enum Segment : uint8 {
+            KeepAlive = 0,
+            Hsts,
+            Server,
+            Date,
+            ContentType,
+            Count
+        };
+
+        explicit HeaderCache(const HttpServerConfig& config);
+
+        DISABLE_COPY(HeaderCache);
+        DISABLE_MOVE(HeaderCache);
+
+        /**
+         * rebuild the cached block if it is stale
+         */
+        void update();
+
+        /**
+         * copy the cached segments [from, to) into the given buffer
+         * @param out the buffer to append the segments to
+         * @param from the first segment to copy
+         * @param to the segment to stop at (not copied)
+         */
+        inline void append(Buffer& out, Segment from, Segment to) const {
+            if (from < to) {
+                out.append(&Ego._block.data()[Ego._offsets[from]], Ego._offsets[to] - Ego._offsets[from]);
+            }
+        }
+
+    private:
+        void rebuild(int64 now);
+        const HttpServerConfig& _config;
+        Buffer _block{256};
+        uint32 _offsets[Count+1]{0};
+        int64  _updated{0};
+        uint64 _keepAliveTime{0};
+        uint64 _hstsEnable{0};
+        String _serverName{};
+    };
+
     class ConnectionImpl : LOGGER(HTTP_CONN) {
     public:
         ConnectionImpl(net::Socket& sock,
                        HttpServerConfig& config,
                        Router& handler,
-                       HttpServerStats& stats);
+                       HttpServerStats& stats,
+                       HeaderCache& headers);
 
         void start();
 
@@ -229,14 +279,13 @@ namespace server {
 
         void sendResponse(Request& req, Response& resp, bool err = false);
 
-        bool writeResponse(const SendBuffer& buf);
-
-        static const char* getCachedDate();
+        bool writeResponse(const SendBuffer& buf, bool flush = true);
 
         HttpServerConfig& _config;
         HttpServerStats& _stats;
         net::Socket& _sock;
         Router& _handler;
+        HeaderCache& _headerCache;
         Buffer _stage{};
         bool _close{false};
     };
@@ -250,8 +299,9 @@ namespace server {
                    HttpServerConfig& config,
                    Router& handler,
                    Middlewares* mws,
-                   HttpServerStats& stats)
-                : ConnectionImpl(sock, config, handler, stats),
+                   HttpServerStats& stats,
+                   HeaderCache& headers)
+                : ConnectionImpl(sock, config, handler, stats, headers),
                   _mws{mws} {}
 
     protected:
@@ -542,6 +542,10 @@ namespace suil::http::crow {
                 }
 
                 params_container<_T> &operator=(params_container<_T> &&pc) {
+                    if (this == &pc) {
+                        return *this;
+                    }
+                    clear();
                     params = pc.params;
                     pc.params = nullptr;
                     size = pc.size;
@@ -583,10 +587,24 @@ namespace suil::http::crow {
                 }
 
                 inline void clear() {
+                    reset();
                     if (params) {
                         free(params);
                         params = nullptr;
                     }
+                    size = 0;
+                }
+
+                /**
+                 * Drops all the parameters but keeps the memory for reuse
+                 */
+                inline void reset() {
+                    if constexpr (std::is_same_v<strparams, _T>) {
+                        while (back > 0) {
+                            params[--back].~strparams();
+                        }
+                    }
+                    back = 0;
                 }
 
             private:
@@ -646,6 +664,13 @@ namespace suil::http::crow {
                 string_params.clear();
             }
 
+            inline void reset() {
+                int_params.reset();
+                uint_params.reset();
+                double_params.reset();
+                string_params.reset();
+            }
+
             ~routing_params() {
                 clear();
             }
@@ -37,6 +37,7 @@ namespace suil::http::server {
 
         HttpServerConfig _config{};
         HttpServerStats  _stats{};
+        HeaderCache      _headerCache{_config};
         Router           _router;
         std::tuple<Mws...> _mws{};
 
@@ -52,7 +53,7 @@ namespace suil::http::server {
         struct ConnectionHandler {
             void operator()(net::Socket& sock, std::shared_ptr<Context> ctx)
             {
-                Connection<Mws...> conn{sock, ctx->_config, ctx->_router, &ctx->_mws, ctx->_stats};
+                Connection<Mws...> conn{sock, ctx->_config, ctx->_router, &ctx->_mws, ctx->_stats, ctx->_headerCache};
                 conn.start();
             }
         };
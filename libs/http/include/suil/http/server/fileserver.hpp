@@ -11,6 +11,7 @@
 
 #include <suil/base/channel.hpp>
 #include <suil/base/exception.hpp>
+#include <suil/base/ipc.hpp>
 
 #include <list>
 #include <unistd.h>
@@ -20,6 +21,20 @@ namespace suil::http::server {
     define_log_tag(FILE_SERVER);
 
     struct CachedFile {
+        /**
+         * A compressed representation of the cached file, either loaded from a
+         * precompressed sibling on disk (e.g index.html.gz) or compressed on demand
+         */
+        struct Encoded {
+            void   *data{nullptr};
+            size_t  len{0};
+            int     fd{-1};
+            bool    probed{false};
+            bool    incompressible{false};
+            // being compressed in the background
+            bool    compressing{false};
+        };
+
         CachedFile();
         MOVE_CTOR(CachedFile) noexcept;
         MOVE_ASSIGN(CachedFile) noexcept;
@@ -29,6 +44,8 @@ namespace suil::http::server {
         bool isGarbage{false};
         bool isReloading{false};
         int64 inFlight{0};
+        // the key of the file in the cache
+        String key{};
         String path{};
         void *data{nullptr};
         size_t len{0};
@@ -41,11 +58,29 @@ namespace suil::http::server {
             struct {
                 uint8 useFd: 1;
                 uint8 isMapped: 1;
-                uint8 _u6: 6;
+                // not admitted into the memory cache, served from the file descriptor
+                uint8 isRejected: 1;
+                uint8 _u5: 5;
             } __attribute__((packed));
             uint8 flags;
         };
         Conditional reloadCond{};
+        // indexed by FileServer::encodedIndex
+        Encoded encoded[2]{};
+
+        /**
+         * @return the number of bytes held in memory by the compressed representations
+         */
+        size_t encodedSize() const;
+
+        /**
+         * @return the number of bytes charged to the cache for this file, i.e the
+         * file contents (unless served from the file descriptor) and the compressed
+         * representations
+         */
+        inline size_t memSize() const {
+            return (useFd? 0 : len) + encodedSize();
+        }
     private:
         DISABLE_COPY(CachedFile);
     };
@@ -72,6 +107,26 @@ namespace suil::http::server {
                 handleRequest(req, resp);
             });
 
+            ipc::registerGetHandler(GET_FILESERVER_STATS, [this](void *token, int src) {
+                auto stats = Ego.stats();
+                ipc::sendGetResponse(token, src, &stats, sizeof(stats));
+            });
+
+            ep("/_admin/fileserver/stats")
+            ("GET"_method, "OPTIONS"_method)
+            .attrs(opt(Authorize, Auth{"System-Admin"}))
+            ([this] {
+                std::vector<FileServerStats> stats{};
+                stats.push_back(Ego.stats());
+                auto all = ipc::gather(GET_FILESERVER_STATS);
+                for (auto& proc: all) {
+                    stats.emplace_back();
+                    memcpy(&stats.back(), proc.data, sizeof(FileServerStats));
+                }
+                ipc::release(all);
+                return stats;
+            });
+
             inotice("attached file server to http endpoint");
         }
 
@@ -117,6 +172,11 @@ namespace suil::http::server {
 
         void alias(const String& from, const String& to);
 
+        /**
+         * @return the cache statistics of the file server in the current process
+         */
+        FileServerStats stats() const;
+
     private suil_ut:
         struct MimeType {
             String mime;
@@ -126,11 +186,31 @@ namespace suil::http::server {
             bool allowRange{true};
             bool allowSendFile{true};
         };
-        using CachedFileIt = typename UnorderedMap<CachedFile>::iterator;
+        /**
+         * A TinyLFU style frequency sketch, a count-min sketch of 4-bit counters
+         * that are halved periodically so that the popularity of files ages
+         */
+        struct Sketch {
+            void resize(size_t entries);
+            void increment(const String& key);
+            uint8 frequency(const String& key) const;
+
+        private suil_ut:
+            size_t index(size_t hash, int i) const;
+            std::vector<uint64> _table{};
+            size_t _additions{0};
+            size_t _sampleSize{0};
+            size_t _mask{0};
+        };
+
+        // cached files are kept in LRU order, most recently used first. Files are
+        // never moved in memory as chunks in flight reference them
+        using CachedFiles = std::list<CachedFile>;
+        using CachedFileIt = typename CachedFiles::iterator;
 
         void init();
         void handleRequest(const Request& req, Response& resp);
-        void get(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm);
+        void get(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm, Codec codec);
         void head(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm);
         String aliased(const String& path);
         CachedFileIt loadFile(const String& path, const MimeType& mt);
@@ -138,7 +218,13 @@ namespace suil::http::server {
         bool readFile(CachedFile& cf, const struct stat& st);
         bool reloadCachedFile(CachedFileIt& it, const struct stat& st);
         void cacheControl(const Request& req, Response& resp, const CachedFile& cf, const MimeType& mt);
-        void prepareResponse(const Request& req, Response& resp, CachedFile& cf, const MimeType& mt);
+        void prepareResponse(const Request& req, Response& resp, CachedFile& cf, const MimeType& mt, Codec codec);
+        bool encodedResponse(Response& resp, CachedFile& cf, const MimeType& mt, Codec codec);
+        bool loadEncoded(CachedFile& cf, CachedFile::Encoded& enc, const MimeType& mt, Codec codec);
+        bool compressFile(CachedFile& cf, CachedFile::Encoded& enc, Codec codec);
+        static void compressor(FileServer& S, CachedFile& cf, Codec codec);
+        void addEncodedChunk(Response& resp, CachedFile& cf, CachedFile::Encoded& enc);
+        static int encodedIndex(Codec codec);
         void buildRangeResponse(
                     const Request& req,
                     Response& resp,
@@ -151,19 +237,23 @@ namespace suil::http::server {
                 CachedFile& cf,
                 const MimeType& mt);
 
-        CachedFileIt addCachedFile(CachedFile&& cf);
+        CachedFileIt addCachedFile(const String& key, CachedFile&& cf);
+        bool admit(const String& key, size_t len, const CachedFile* keep = nullptr);
+        void evict(size_t len, size_t count, const CachedFile* keep);
         void markCachedFileForRemoval(CachedFileIt it);
         void derefCachedFileChunk(CachedFile& cf);
         void addCachedFileChunk(Response& resp, CachedFile& cf, size_t len, off_t offset);
-        String relativePath(const CachedFile& cf);
         static void garbageCollector(FileServer& S);
         size_t _totalMemCachedSize{};
         String _wwwDir{};
         FileServerConfig _config{};
         UnorderedMap<String> _redirects{};
         UnorderedMap<MimeType> _mimeTypes{};
-        UnorderedMap<CachedFile> _cachedFiles{};
-        std::list<CachedFile> _garbageCache{};
+        UnorderedMap<CachedFileIt> _cachedFiles{};
+        CachedFiles _lru{};
+        CachedFiles _garbageCache{};
+        Sketch _sketch{};
+        FileServerStats _stats{};
         bool _isCollectingGarbage{false};
         Conditional _gcCond;
     };
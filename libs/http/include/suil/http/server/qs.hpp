@@ -5,6 +5,7 @@
 #ifndef SUIL_HTTP_SERVER_QS_HPP
 #define SUIL_HTTP_SERVER_QS_HPP
 
+#include <suil/base/arena.hpp>
 #include <suil/base/string.hpp>
 #include <suil/base/exception.hpp>
 
@@ -18,6 +19,14 @@ namespace suil::http::server {
         MOVE_CTOR(QueryString);
         MOVE_ASSIGN(QueryString);
 
+        /**
+         * parse the given query string, replacing the current parameters. The
+         * parameters vector retains its capacity between calls
+         * @param sv the query string to parse
+         * @param arena if provided, the copy of the query string will be
+         * allocated from the arena instead of the heap
+         */
+        void parse(const String& sv, Arena* arena = nullptr);
         void clear();
         String get(const String& name) const;
         std::vector<String> getAll(const String& name) const;
@@ -37,6 +46,7 @@ namespace suil::http::server {
 
     private:
         char *_url{nullptr};
+        bool  _own{false};
         std::vector<char *> _params;
     };
 }
@@ -40,7 +40,7 @@ namespace suil::http::server {
 
         const String& cookie(const String& name) const;
 
-        inline const UnorderedMap<String, CaseInsensitive>& headers() const {
+        inline const HeaderTable& headers() const {
             return Ego._headers;
         }
 
@@ -89,11 +89,28 @@ namespace suil::http::server {
             return Method(Ego.method);
         }
 
+        /**
+         * @return an arena which can be used for allocations that only need to
+         * live until the request is done. The arena is reset after each request
+         */
+        inline Arena& arena() {
+            return Ego._pool;
+        }
+
+        /**
+         * @return true if the receive buffer holds data that was pipelined
+         * by the client after the current request
+         */
+        inline bool isPipelined() const {
+            return Ego._rxOffset < Ego._rx.size();
+        }
+
         void clear(bool internal = false) override;
 
         void *middlewareContent{nullptr};
 
     protected:
+        void intern() override;
         int onBodyPart(const String &part) override;
         int onUrl(String &&url) override;
         int onHeadersComplete() override;
@@ -107,6 +124,8 @@ namespace suil::http::server {
         bool parseMultipartForm(const String& boundary);
         Status receiveHeaders(HttpServerStats& stats);
         Status receiveBody(HttpServerStats& stats);
+        bool receiveSome(HttpServerStats& stats);
+        bool parseSome();
         Data readBody();
         template <typename...Args>
         bool anyMethod(Method m, Args... args) {
@@ -129,6 +148,13 @@ namespace suil::http::server {
 
         static uint64 sOffloadIndex;
         uint32 _bodyOffset{0};
+        // per connection receive buffer, survives clear() because it might
+        // contain requests pipelined after the current one. The url and headers
+        // of the current request are views into this buffer
+        Buffer _rx{0};
+        uint32 _rxOffset{0};
+        // per connection arena, reset after each request
+        Arena  _pool;
         Status _status{http::Ok};
         Form   _form{};
         FileOffload _offload;
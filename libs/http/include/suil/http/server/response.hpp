@@ -204,6 +204,7 @@ namespace server {
         inline ProtocolUpgrade& operator()() { return Ego._upgrade; }
         void flushCookies();
         friend class ConnectionImpl;
+        friend class Compression;
         std::vector<net::Chunk> _chunks{};
         std::size_t _chunksSize{0};
         UnorderedMap<String, CaseInsensitive> _headers{};
@@ -7,6 +7,18 @@
 
 #include <suil/http/server/rules.hpp>
 
+#ifndef SUIL_ROUTER_MAX_PARAMS
+#define SUIL_ROUTER_MAX_PARAMS 16
+#endif
+
+#ifndef SUIL_ROUTER_MATCH_STACK
+#define SUIL_ROUTER_MATCH_STACK 64
+#endif
+
+#ifndef SUIL_ROUTER_DISPATCH_MIN
+#define SUIL_ROUTER_DISPATCH_MIN 8
+#endif
+
 namespace suil::http::server {
 
     class RoutesTrie {
@@ -27,9 +39,32 @@ namespace suil::http::server {
         void validate();
 
         inline RouterParams find(const String& reqUrl) {
+            if (Ego.compiled()) {
+                RouterParams ret{0, {}};
+                ret.first = Ego.match(reqUrl, ret.second);
+                return ret;
+            }
             return Ego.find(reqUrl, head(), 0, nullptr);
         }
 
+        /**
+         * Find the route matching the given url. The routes compiled when the trie
+         * was optimized are used, the lookup itself does not allocate memory and
+         * the parameters are only decoded once the matching route is known
+         * @param reqUrl the url to match
+         * @param params cleared and populated with the parameters of the matched route,
+         * memory held by the container is reused
+         * @return the index of the matched route, 0 if there is no matching route
+         */
+        unsigned match(const String& reqUrl, crow::detail::routing_params& params) const;
+
+        /**
+         * @return true if the routes have been compiled into a flat matcher
+         */
+        inline bool compiled() const {
+            return !Ego._flat.empty();
+        }
+
         void add(const String& url, unsigned index);
         inline void debug(std::ostream& os) {
             Ego.debug(os, head(), 0);
@@ -55,12 +90,41 @@ namespace suil::http::server {
             return &Ego._nodes.front();
         }
 
+        void compile();
+        void compileEdges(unsigned node, const std::vector<std::pair<String, unsigned>>& items);
+        unsigned compileBound(unsigned node, unsigned& params);
+
         unsigned createNode() {
             Ego._nodes.emplace_back(Node{});
             return Ego._nodes.size()-1;
         }
 
+        /**
+         * A node of the compiled matcher, static children are stored contiguously
+         * in \a _edges sorted by their fragment, which start with distinct bytes
+         */
+        struct Flat {
+            unsigned _index{0};
+            unsigned _minIndex{0};
+            unsigned _edges{0};
+            uint16_t _nedges{0};
+            uint8_t  _paramMask{0};
+            unsigned _dispatch{0};
+            std::array<unsigned, int(crow::detail::ParamType::MAX)> _params{};
+        };
+
+        struct Edge {
+            unsigned _fragment{0};
+            unsigned _len{0};
+            unsigned _child{0};
+            unsigned char _first{0};
+        };
+
         std::vector<Node> _nodes;
+        std::vector<Flat> _flat;
+        std::vector<Edge> _edges;
+        std::vector<uint16_t> _dispatch;
+        std::vector<char> _fragments;
     };
 }
 #endif //SUIL_HTTP_SERVER_TRIE_HPP
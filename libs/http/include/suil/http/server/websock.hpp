@@ -9,17 +9,44 @@
 #include <suil/http/server/response.hpp>
 
 #include <suil/base/channel.hpp>
+#include <suil/base/compress.hpp>
 #include <suil/base/signal.hpp>
 
 #include <libmill/libmill.hpp>
 
+#include <deque>
+
+#ifndef SUIL_WSOCK_MAX_QUEUED
+#define SUIL_WSOCK_MAX_QUEUED 256
+#endif
+
 namespace suil::http {
 
     class WebSock;
 
+    /**
+     * An encoded web socket frame (header and payload). Frames are immutable and
+     * shared by all the web sockets they are sent to
+     */
+    using WsFrame = std::shared_ptr<const Buffer>;
+
     class WebSockApi {
     public:
-        WebSockApi(int64 timeout, bool blockingBroadcast = true);
+        /**
+         * What to do with a web socket whose send queue is full
+         */
+        enum SlowConsumer : uint8 {
+            // drop the frames that do not fit in the queue
+            Drop,
+            // close the web socket
+            Disconnect
+        };
+
+        WebSockApi(
+            int64 timeout,
+            bool blockingBroadcast = true,
+            size_t maxQueued = SUIL_WSOCK_MAX_QUEUED,
+            SlowConsumer slowConsumer = Disconnect);
 
         using ConnectHandler    = Signal<void(WebSock&)>;
         using CloseHandler      = Signal<void(WebSock&)>;
@@ -33,9 +60,16 @@ namespace suil::http {
 
         std::shared_ptr<WebSock> find(const String& uuid);
 
+        /**
+         * Configures the permessage-deflate extension, the extension is negotiated
+         * with clients that offer it when \a config.enabled is true
+         */
+        void perMessageDeflate(server::WebSockDeflate config);
+
     private:
         friend class WebSock;
-        void broadcast(WebSock* src, const void *data, size_t size);
+        void broadcast(WebSock* src, const WsFrame& frame);
+        static void registerIpc();
         static coroutine void   send(chan ch, WebSock& ws, const void *data, size_t sz, uint8 op);
         using WebSockMap = UnorderedMap<std::shared_ptr<WebSock>>;
         using WebSockSnapshot = std::vector<std::weak_ptr<WebSock>>;
@@ -46,6 +80,9 @@ namespace suil::http {
         int64  _timeout{-1};
         mill::Mutex _mutex{};
         bool _blockingBroadcast{true};
+        size_t _maxQueued{SUIL_WSOCK_MAX_QUEUED};
+        SlowConsumer _slowConsumer{Disconnect};
+        server::WebSockDeflate _deflate{};
     };
 
     struct WsockBcastMsg {
@@ -54,8 +91,8 @@ namespace suil::http {
         uint8_t         payload[0];
     } __attribute((packed));
 
-#define IPC_WSOCK_BCAST ipc_msg(1)
-#define IPC_WSOCK_CONN  ipc_msg(2)
+#define IPC_WSOCK_BCAST IPC_MSG(1)
+#define IPC_WSOCK_CONN  IPC_MSG(2)
 
     /**
      * The web socket Connection message. This message is sent to other
@@ -94,6 +131,14 @@ namespace suil::http {
             return send(b.data(), b.size(), op);
         }
 
+        /**
+         * Sends the given message to all the other web sockets of the API, including
+         * those connected to other workers. The message is framed once and the frame
+         * is queued on each web socket
+         * @param data the message to send
+         * @param sz the size of the message
+         * @param op the message op code
+         */
         void broadcast(const void *data, size_t sz, WsOp op);
 
         inline void broadcast(const String& zc, WsOp op = WsOp::Text) {
@@ -104,6 +149,15 @@ namespace suil::http {
             broadcast(b.data(), b.size(), op);
         }
 
+        /**
+         * Encodes a web socket frame that can be queued on multiple web sockets
+         * @param data the frame payload
+         * @param sz the size of the payload
+         * @param op the frame op code
+         * @return the encoded frame
+         */
+        static WsFrame frame(const void *data, size_t sz, WsOp op);
+
         void close();
 
         ~WebSock();
@@ -120,7 +174,7 @@ namespace suil::http {
                 size_t,
                 WebSockCreated onSockCreated);
 
-    protected:
+    protected suil_ut:
         WebSock(net::Socket& sock, WebSockApi& api, size_t size = 0);
 
         template <typename ...Mws>
@@ -161,12 +215,19 @@ namespace suil::http {
         void              *_data{nullptr};
         String             _uuid{};
         mill::Mutex _mutex{};
-    private:
+    private suil_ut:
         friend struct WebSockApi;
         void handle();
-        bool broadcastSend(const void *data, size_t len);
-        static coroutine void broadcast(
-                std::shared_ptr<WebSock> ws, WebSockApi& api, void *data, size_t size);
+        static uint8 encodeHeader(uint8 (&hbuf)[14], size_t size, uint8 op, bool rsv1 = false);
+        bool enqueue(const WsFrame& frame);
+        bool broadcastSend();
+        static coroutine void drain(std::shared_ptr<WebSock> ws);
+        std::deque<WsFrame> _queue{};
+        bool _draining{false};
+        // set when permessage-deflate was negotiated
+        std::unique_ptr<Deflater> _deflater{nullptr};
+        std::unique_ptr<Inflater> _inflater{nullptr};
+        Buffer _inflated{0};
     };
 
     namespace ws {
@@ -192,7 +253,9 @@ namespace suil::http {
 
             WebSockApi api{
                     opts.get(sym(timeout), int64{-1}),
-                    opts.get(sym(blockingBroadcast), false)
+                    opts.get(sym(blockingBroadcast), false),
+                    opts.get(sym(maxQueued), size_t{SUIL_WSOCK_MAX_QUEUED}),
+                    opts.get(sym(slowConsumer), WebSockApi::Disconnect)
             };
 
             if (opts.has(sym(onConnect))) {
@@ -211,6 +274,10 @@ namespace suil::http {
                 api.onDisconnect += std::move(opts.get(sym(onDisconnect), nullptr));
             }
 
+            if (opts.has(sym(perMessageDeflate))) {
+                api.perMessageDeflate(opts.get(sym(perMessageDeflate), server::WebSockDeflate{}));
+            }
+
             return std::move(api);
         }
     }
@@ -0,0 +1,292 @@
+//
+// Created by Mpho Mbotho on 2021-07-12.
+//
+
+#include "suil/http/client/batch.hpp"
+
+#include <algorithm>
+
+namespace suil::http::cli {
+
+    Call::Call(Method m, String resource, Request::Builder builder, Response::Writer writer, int64 timeout)
+        : method{m},
+          resource{std::move(resource)},
+          builder{std::move(builder)},
+          writer{std::move(writer)},
+          timeout{timeout}
+    {}
+
+    void Call::fail()
+    {
+        auto ex = Exception::fromCurrent();
+        error = String{ex.what()}.dup();
+    }
+
+    Batch::Batch(Session& sess)
+        : _session{sess}
+    {}
+
+    size_t Batch::add(
+            Method m,
+            String resource,
+            Request::Builder builder,
+            Response::Writer writer,
+            int64 timeout)
+    {
+        Ego._calls.emplace_back(m, std::move(resource), std::move(builder), std::move(writer), timeout);
+        return Ego._calls.size() - 1;
+    }
+
+    void Batch::start()
+    {
+        auto& sess = Ego._session.get();
+        for (auto& call: Ego._calls) {
+            // deadlines are measured from the start of the batch
+            call.deadline = Deadline{(call.timeout < 0)? sess._timeout : call.timeout};
+            call.error = {};
+            call.resp = Response{};
+        }
+    }
+
+    void Batch::fanout(size_t concurrency)
+    {
+        if (Ego._calls.empty()) {
+            return;
+        }
+
+        Ego.start();
+        auto total = Ego._calls.size();
+        if (concurrency == 0 or concurrency > total) {
+            concurrency = total;
+        }
+
+        Channel<int> done{-1};
+        size_t next{0}, running{0};
+        while (next < concurrency) {
+            running++;
+            go(performOne(Ego, next++, done));
+        }
+
+        while (running) {
+            int index{-1};
+            done >> index;
+            running--;
+            if (next < total) {
+                // keep the number of requests in flight constant
+                running++;
+                go(performOne(Ego, next++, done));
+            }
+        }
+        itrace("fanned out %zu requests with %zu in flight", total, concurrency);
+    }
+
+    void Batch::pipeline(size_t connections)
+    {
+        if (Ego._calls.empty()) {
+            return;
+        }
+
+        for (auto& call: Ego._calls) {
+            if (!suil::matchany(call.method, Method::Get, Method::Head, Method::Options, Method::Delete)) {
+                throw HttpException("cannot pipeline non-idempotent request ",
+                                    http::toString(call.method), " ", call.resource);
+            }
+        }
+
+        Ego.start();
+        auto total = Ego._calls.size();
+        connections = std::clamp(connections, size_t(1), total);
+        // spread the requests evenly, the first groups take the remainder
+        auto per = total / connections, extra = total % connections;
+        Channel<int> done{-1};
+        size_t from{0};
+        for (size_t i = 0; i < connections; i++) {
+            auto to = from + per + ((i < extra)? 1 : 0);
+            go(pipelineGroup(Ego, from, to, done));
+            from = to;
+        }
+
+        int index{-1};
+        for (size_t i = 0; i < connections; i++) {
+            done >> index;
+        }
+    }
+
+    void Batch::performOne(Batch& batch, size_t index, Channel<int>& done)
+    {
+        auto& call = batch._calls[index];
+        auto& sess = batch._session.get();
+        try {
+            auto h = sess.handle(call.deadline);
+            call.resp = sess.perform(
+                    h, call.method, call.resource.peek(), call.builder, call.writer, call.deadline);
+        }
+        catch (...) {
+            call.fail();
+            ldebug(&batch, "request %s %s failed: %s",
+                   http::toString(call.method)(), call.resource(), call.error());
+        }
+        done << int(index);
+    }
+
+    void Batch::pipelineGroup(Batch& batch, size_t from, size_t to, Channel<int>& done)
+    {
+        auto& sess = batch._session.get();
+        std::span<Call> calls{&batch._calls[from], to - from};
+        try {
+            // the connection is acquired within the deadline of the group's first request
+            auto h = sess.handle(calls.front().deadline);
+            sess.pipeline(h, calls);
+        }
+        catch (...) {
+            // failed to acquire or connect the connection
+            for (auto& call: calls) {
+                if (call.ok()) {
+                    call.fail();
+                }
+            }
+        }
+        done << int(from);
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/net/tcp.hpp>
+
+namespace cli = suil::http::cli;
+
+namespace {
+
+    struct BatchServer {
+        suil::net::TcpServerSock server;
+        int inFlight{0};
+        int maxInFlight{0};
+        std::vector<int> requests{};
+        suil::Channel<int> done{-1};
+    };
+
+    coroutine void batchConnection(BatchServer& bs, suil::net::Socket::UPtr sock, int id)
+    {
+        std::string data{};
+        char buf[1024];
+        while (true) {
+            size_t len{sizeof(buf)};
+            if (!sock->read(buf, len, 2000)) {
+                // the client closed the connection
+                break;
+            }
+            data.append(buf, len);
+
+            // pipelined requests can arrive with a single read, they have no body
+            size_t end{0};
+            while ((end = data.find("\r\n\r\n")) != std::string::npos) {
+                auto from = data.find(' ') + 1;
+                auto path = data.substr(from, data.find(' ', from) - from);
+                data.erase(0, end + 4);
+
+                bs.requests[id]++;
+                bs.maxInFlight = std::max(++bs.inFlight, bs.maxInFlight);
+                msleep(mnow() + 10);
+                bs.inFlight--;
+                auto resp = suil::catstr("HTTP/1.1 200 OK\r\nContent-Length: ", path.size(), "\r\n\r\n", path);
+                sock->send(resp.data(), resp.size(), 2000);
+                sock->flush(2000);
+            }
+        }
+        sock->close();
+        bs.done << id;
+    }
+
+    coroutine void batchServer(BatchServer& bs, int connections)
+    {
+        for (int id = 0; id < connections; id++) {
+            auto sock = bs.server.accept(2000);
+            if (sock == nullptr) {
+                // unblock the test waiting for the remaining connections
+                for (; id < connections; id++) {
+                    bs.done << id;
+                }
+                break;
+            }
+            bs.requests.push_back(0);
+            go(batchConnection(bs, std::move(sock), id));
+        }
+    }
+
+    void batchWait(BatchServer& bs, int connections)
+    {
+        for (int i = 0; i < connections; i++) {
+            int id{-1};
+            bs.done >> id;
+        }
+    }
+}
+
+TEST_CASE("Client request batches", "[http][client][batch]")
+{
+    BatchServer bs;
+    REQUIRE(bs.server.listen(iplocal("127.0.0.1", 9307, 0), 8));
+    auto sess = cli::loadSession("127.0.0.1", 9307, "",
+                                 opt(timeout, 2000),
+                                 opt(pool, (cli::ConnectionPool *) nullptr));
+    cli::Batch batch(sess);
+
+    SECTION("Calls added to a batch are addressed by index") {
+        auto first = batch.get("/a");
+        auto second = batch.post("/b");
+        REQUIRE(first == 0);
+        REQUIRE(second == 1);
+        for (int i = 0; i < 64; i++) {
+            batch.get(suil::catstr("/", i));
+        }
+        REQUIRE(batch.size() == 66);
+        REQUIRE(batch[first].resource == "/a");
+        REQUIRE(batch[second].method == suil::http::Method::Post);
+    }
+
+    SECTION("Fanned out requests run concurrently up to the given limit") {
+        for (int i = 0; i < 6; i++) {
+            batch.get(suil::catstr("/fanout/", i));
+        }
+        // each request has it's own connection when pooling is disabled
+        go(batchServer(bs, 6));
+        batch.fanout(2);
+        batchWait(bs, 6);
+
+        REQUIRE(bs.maxInFlight == 2);
+        for (auto& call: batch) {
+            REQUIRE(call.ok());
+            REQUIRE(call.resp.status() == suil::http::Ok);
+            REQUIRE(call.resp.str() == call.resource);
+        }
+    }
+
+    SECTION("Pipelined requests share connections") {
+        for (int i = 0; i < 5; i++) {
+            batch.get(suil::catstr("/pipeline/", i));
+        }
+        go(batchServer(bs, 2));
+        batch.pipeline(2);
+        batchWait(bs, 2);
+
+        // the requests are split in consecutive groups, one per connection
+        REQUIRE(bs.requests.size() == 2);
+        std::sort(bs.requests.begin(), bs.requests.end());
+        REQUIRE(bs.requests[0] == 2);
+        REQUIRE(bs.requests[1] == 3);
+        for (auto& call: batch) {
+            REQUIRE(call.ok());
+            REQUIRE(call.resp.str() == call.resource);
+        }
+    }
+
+    SECTION("Requests that are not idempotent cannot be pipelined") {
+        batch.get("/a");
+        batch.post("/b");
+        REQUIRE_THROWS(batch.pipeline(1));
+    }
+
+    bs.server.close();
+}
+#endif
@@ -0,0 +1,214 @@
+//
+// Created by Mpho Mbotho on 2021-07-11.
+//
+
+#include "suil/http/client/pool.hpp"
+
+#include <suil/net/ssl.hpp>
+#include <suil/net/tcp.hpp>
+
+namespace suil::http::cli {
+
+    ConnectionPool::~ConnectionPool()
+    {
+        if (Ego._cleaning) {
+            // stop the cleanup coroutine and let it exit before the pool is gone
+            Ego._notify << uint8_t(1);
+            yield();
+        }
+        Ego._hosts.clear();
+    }
+
+    ConnectionPool& ConnectionPool::shared()
+    {
+        static thread_local ConnectionPool sPool{};
+        return sPool;
+    }
+
+    String ConnectionPool::key(const String& proto, const String& host, int port)
+    {
+        return suil::catstr(proto, "://", host, ':', port);
+    }
+
+    ConnectionPool::Host& ConnectionPool::host(const String& key)
+    {
+        auto it = Ego._hosts.find(key);
+        if (it == Ego._hosts.end()) {
+            it = Ego._hosts.emplace(key.dup(), std::make_unique<Host>()).first;
+        }
+        return *it->second;
+    }
+
+    net::Socket::UPtr ConnectionPool::acquire(const String& key, bool ssl, int64 timeout)
+    {
+        // hosts are never removed and are heap allocated, the reference survives waiting
+        auto& h = Ego.host(key);
+        Deadline dd{timeout};
+        while (true) {
+            while (!h.idle.empty()) {
+                // the most recently used connection is the most likely to still be alive
+                auto sock = std::move(h.idle.back().sock);
+                h.idle.pop_back();
+                if (isAlive(*sock)) {
+                    itrace("reusing connection to %s", key());
+                    return sock;
+                }
+                itrace("dropping stale connection to %s", key());
+                h.open--;
+            }
+
+            if (h.open < Ego._maxPerHost) {
+                h.open++;
+                if (ssl) {
+                    return std::make_unique<net::SslSock>();
+                }
+                return std::make_unique<net::TcpSock>();
+            }
+
+            int64 left{-1};
+            if (timeout >= 0) {
+                left = int64(dd) - mnow();
+                if (left <= 0) {
+                    break;
+                }
+            }
+
+            // wait for a connection to be released
+            itrace("waiting for one of %u connections to %s", h.open, key());
+            Sync sync;
+            if (!h.waiters.wait(sync, left)) {
+                break;
+            }
+        }
+
+        throw HttpException("timed out waiting for a connection to '", key, "'");
+    }
+
+    void ConnectionPool::release(const String& key, net::Socket::UPtr sock, bool reuse)
+    {
+        auto& h = Ego.host(key);
+        if (reuse and sock != nullptr and sock->isOpen() and
+            Ego._idleTimeout != 0 and h.idle.size() < Ego._maxIdle)
+        {
+            h.idle.push_back(Idle{std::move(sock), mnow() + Ego._idleTimeout});
+            if (!Ego._cleaning) {
+                // schedule cleanup routine
+                go(cleanup(Ego));
+            }
+        }
+        else {
+            // closes the connection
+            sock = nullptr;
+            if (h.open) {
+                h.open--;
+            }
+        }
+
+        // either a connection is idle or a new one can be opened
+        h.waiters.notifyOne();
+    }
+
+    size_t ConnectionPool::idle(const String& key) const
+    {
+        auto it = Ego._hosts.find(key);
+        return (it == Ego._hosts.end())? 0 : it->second->idle.size();
+    }
+
+    size_t ConnectionPool::open(const String& key) const
+    {
+        auto it = Ego._hosts.find(key);
+        return (it == Ego._hosts.end())? 0 : it->second->open;
+    }
+
+    bool ConnectionPool::isAlive(net::Socket& sock)
+    {
+        if (!sock.isOpen()) {
+            return false;
+        }
+
+        // an idle connection should not be readable, reading something means
+        // that the server either closed the connection or sent unsolicited data
+        char c;
+        size_t len{1};
+        if (sock.receive(&c, len, Deadline{0})) {
+            return false;
+        }
+        return errno == ETIMEDOUT;
+    }
+
+    void ConnectionPool::cleanup(ConnectionPool& pool)
+    {
+        int64_t expires = pool._idleTimeout + 300;
+        pool._cleaning = true;
+        while (true) {
+            uint8_t status{0};
+            if (pool._notify[expires] >> status) {
+                // pool is being destroyed
+                if (status == 1) return;
+            }
+
+            // close connections that expired or will expire in the next 500 ms
+            auto t = mnow() + 500;
+            size_t pruned{0}, remaining{0};
+            int64 next{INT64_MAX};
+            for (auto& [_, h]: pool._hosts) {
+                // the oldest connections are at the front
+                while (!h->idle.empty() and h->idle.front().expires <= t) {
+                    h->idle.pop_front();
+                    h->open--;
+                    h->waiters.notifyOne();
+                    pruned++;
+                }
+                if (!h->idle.empty()) {
+                    next = std::min(next, h->idle.front().expires);
+                    remaining += h->idle.size();
+                }
+            }
+            ltrace(&pool, "pruned %zu idle connections, %zu remaining", pruned, remaining);
+
+            if (remaining == 0) {
+                break;
+            }
+            // avoid waking up too often
+            expires = std::max(next - t, int64(1000));
+        }
+        pool._cleaning = false;
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace cli = suil::http::cli;
+
+TEST_CASE("Client connection pool", "[http][client][pool]")
+{
+    cli::ConnectionPool pool;
+    pool.setup(opt(maxPerHost, 2u), opt(maxIdle, 1u));
+    auto key = cli::ConnectionPool::key("http", "localhost", 8080);
+    REQUIRE(key == "http://localhost:8080");
+
+    SECTION("Connections are limited per host") {
+        auto s1 = pool.acquire(key, false, 10);
+        auto s2 = pool.acquire(key, false, 10);
+        REQUIRE(pool.open(key) == 2);
+        REQUIRE_THROWS(pool.acquire(key, false, 10));
+        // other hosts are not affected
+        auto other = cli::ConnectionPool::key("https", "localhost", 8443);
+        auto s3 = pool.acquire(other, true, 10);
+        REQUIRE(pool.open(other) == 1);
+
+        // sockets that are not connected cannot be reused
+        pool.release(key, std::move(s1), true);
+        REQUIRE(pool.open(key) == 1);
+        REQUIRE(pool.idle(key) == 0);
+        auto s4 = pool.acquire(key, false, 10);
+        REQUIRE(pool.open(key) == 2);
+        pool.release(key, std::move(s2), false);
+        pool.release(key, std::move(s4), false);
+        pool.release(other, std::move(s3), false);
+        REQUIRE(pool.open(key) == 0);
+        REQUIRE(pool.open(other) == 0);
+    }
+}
+#endif
@@ -146,7 +146,7 @@ namespace suil::http::cli {
         return _body.size();
     }
 
-    void Request::submit(int64 timeout)
+    void Request::submit(const Deadline& dd)
     {
         Buffer head{2048};
         auto contentLength = buildBody();
@@ -165,7 +165,7 @@ namespace suil::http::cli {
         head << CRLF;
 
         // send headers
-        auto writen = _sock->send(head.data(), head.size(), timeout);
+        auto writen = _sock->send(head.data(), head.size(), dd);
         if (writen != head.size()) {
             // sending headers failed
             throw HttpException("Sending request headers failed: ", errno_s);
@@ -173,14 +173,14 @@ namespace suil::http::cli {
 
         if (contentLength == 0) {
             // nothing to send
-            _sock->flush(timeout);
+            _sock->flush(dd);
             return;
         }
 
         if (Ego._bodyFd.valid()) {
             // send body as file
             auto fd = Ego._bodyFd.raw();
-            writen = _sock->sendfile(fd, 0, contentLength, timeout);
+            writen = _sock->sendfile(fd, 0, contentLength, dd);
             if (writen != contentLength) {
                 // sending file failed
                 throw HttpException("sending request body-fd file failed: ", errno_s);
@@ -190,7 +190,7 @@ namespace suil::http::cli {
 
         if (!_body.empty()) {
             // send body
-            writen = _sock->send(_body.data(), _body.size(), timeout);
+            writen = _sock->send(_body.data(), _body.size(), dd);
             if (writen != _body.size()) {
                 // sending body buffer failed
                 throw HttpException("sending request body failed: ", errno_s);
@@ -201,14 +201,14 @@ namespace suil::http::cli {
             // submit uploaded files
             for (auto& up: _form._uploads) {
                 auto fd = up.open();
-                writen = _sock->send(up.getHead().data(), up.getHead().size(), timeout);
+                writen = _sock->send(up.getHead().data(), up.getHead().size(), dd);
                 if (writen != up.getHead().size()) {
                     // sending upload head failed
                     throw HttpException("sending request upload failed: ", errno_s);
                 }
                 size_t totalWritten{0};
                 do {
-                    writen = _sock->sendfile(fd, totalWritten, up.size()-totalWritten, timeout);
+                    writen = _sock->sendfile(fd, totalWritten, up.size()-totalWritten, dd);
                     if (errno) {
                         // sending upload file failed
                         throw HttpException("sending request upload failed: ", errno_s);
@@ -216,7 +216,7 @@ namespace suil::http::cli {
                     totalWritten += writen;
                 } while (totalWritten != up.size());
 
-                if (_sock->send(CRLF, sizeofcstr(CRLF), timeout) != sizeofcstr(CRLF)) {
+                if (_sock->send(CRLF, sizeofcstr(CRLF), dd) != sizeofcstr(CRLF)) {
                     throw HttpException("send CRLF after upload failed: ", errno_s);
                 }
 
@@ -228,13 +228,13 @@ namespace suil::http::cli {
             head << "--" << _form._boundary << "--"
                  << CRLF;
 
-            writen = _sock->send(head.data(), head.size(), timeout);
+            writen = _sock->send(head.data(), head.size(), dd);
             if (writen != head.size()) {
                 // sending terminal boundary failed
                 throw HttpException("Sending terminal boundary failed: ", errno_s);
             }
         }
 
-        _sock->flush(timeout);
+        _sock->flush(dd);
     }
 }
\ No newline at end of file
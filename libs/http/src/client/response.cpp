@@ -13,6 +13,8 @@ namespace suil::http::cli {
     Response::Response(Response&& o)
         : HttpParser(std::move(o)),
           _bodyRead{std::exchange(o._bodyRead, false)},
+          _noBody{std::exchange(o._noBody, false)},
+          _received{std::exchange(o._received, 0)},
           _writer{std::exchange(o._writer, nullptr)}
     {}
 
@@ -24,6 +26,8 @@ namespace suil::http::cli {
 
         HttpParser::operator=(std::move(o));
         _bodyRead = std::exchange(o._bodyRead, false);
+        _noBody = std::exchange(o._noBody, false);
+        _received = std::exchange(o._received, 0);
         _writer = std::exchange(o._writer, nullptr);
 
         return Ego;
@@ -58,25 +62,54 @@ namespace suil::http::cli {
         return Data{_stage.data(), _stage.size(), false};
     }
 
-    void Response::receive(net::Socket& sock, int64 timeout)
+    void Response::receive(net::Socket& sock, const Deadline& dd, Buffer* pending)
     {
+        if (pending != nullptr) {
+            // pipelined responses, stop at the end of this response and keep
+            // the data of the following responses in pending
+            _pipelined = 1;
+            if (!pending->empty()) {
+                Buffer data = std::move(*pending);
+                _received += data.size();
+                if (!feed(data.data(), data.size())) {
+                    throw HttpException("parsing response failed: ",
+                                llhttp_get_error_reason(this));
+                }
+                if (_bodyComplete == 1) {
+                    pending->append(data.data() + _parsed, data.size() - _parsed);
+                    return;
+                }
+            }
+        }
+
         char buffer[8192];
+        size_t nread{0};
         // receive headers
         do {
-            auto nread = sizeof(buffer);
-            if (!sock.read(buffer, nread, timeout)) {
+            nread = sizeof(buffer);
+            if (!sock.read(buffer, nread, dd)) {
                 throw HttpException("Receiving response failed: ", errno_s);
             }
+            _received += nread;
 
             if (!feed(buffer, nread)) {
                 throw HttpException("parsing response failed: ",
                             llhttp_get_error_reason(this));
             }
         } while (_bodyComplete != 1);
+
+        if (pending != nullptr and _parsed < nread) {
+            pending->append(&buffer[_parsed], nread - _parsed);
+        }
     }
 
     int Response::onHeadersComplete()
     {
+        if (_noBody) {
+            // tell the parser that the response has no body
+            return 1;
+        }
+
         if (_writer == nullptr) {
             // no custom writer configured, save data in _staging area
             if (content_length) {
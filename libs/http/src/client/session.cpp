@@ -3,6 +3,7 @@
 //
 
 #include "suil/http/client/session.hpp"
+#include "suil/http/client/batch.hpp"
 
 #include <suil/net/ssl.hpp>
 #include <suil/net/tcp.hpp>
@@ -16,7 +17,9 @@ namespace suil::http::cli {
 
     Session::Handle::Handle(Handle&& o)
         : _session{o._session},
-          req{std::move(o.req)}
+          req{std::move(o.req)},
+          _pool{std::exchange(o._pool, nullptr)},
+          _reuse{std::exchange(o._reuse, false)}
     {}
 
     Session::Handle& Session::Handle::operator=(Handle&& o)
@@ -24,12 +27,30 @@ namespace suil::http::cli {
         if (this == &o) {
             return Ego;
         }
+        release();
         _session = o._session;
         req = std::move(o.req);
+        _pool = std::exchange(o._pool, nullptr);
+        _reuse = std::exchange(o._reuse, false);
 
         return Ego;
     }
 
+    Session::Handle::~Handle()
+    {
+        release();
+    }
+
+    void Session::Handle::release()
+    {
+        if (_pool != nullptr and req._sock != nullptr) {
+            // give the connection back to the pool
+            _pool->release(_session.get()._poolKey, std::move(req._sock), _reuse);
+        }
+        _pool = nullptr;
+        _reuse = false;
+    }
+
     Session::Session(String proto, String host, int port)
         : _proto{std::move(proto)},
           _host{std::move(host)},
@@ -43,6 +64,18 @@ namespace suil::http::cli {
 
     Session::Handle Session::handle()
     {
+        return handle(Deadline{Ego._timeout});
+    }
+
+    Session::Handle Session::handle(const Deadline& dd)
+    {
+        if (Ego._pool != nullptr) {
+            int64 timeout = (dd == Deadline::infinite())? -1 : std::max(int64(dd) - mnow(), int64(0));
+            Handle h{Ego, Ego._pool->acquire(Ego._poolKey, isHttps(), timeout)};
+            h._pool = Ego._pool;
+            return h;
+        }
+
         net::Socket::UPtr sock{nullptr};
         if (isHttps()) {
             sock = std::make_unique<net::SslSock>();
@@ -105,9 +138,21 @@ namespace suil::http::cli {
                 String resource,
                 Request::Builder builder,
                 Response::Writer writer)
+    {
+        return perform(h, m, std::move(resource), builder, std::move(writer), Deadline{_timeout});
+    }
+
+    Response Session::perform(
+            Handle& h,
+            Method m,
+            String resource,
+            const Request::Builder& builder,
+            Response::Writer writer,
+            const Deadline& dd)
     {
         auto& req = h.req;
         Response resp;
+        h._reuse = false;
         req.reset(m, std::move(resource), false);
         for (auto& hdr : _headers) {
             req.header(hdr.first.peek(), hdr.second.peek());
@@ -120,19 +165,118 @@ namespace suil::http::cli {
             }
         }
 
-        if (unlikely(!req._sock->isOpen())) {
-            // Open connection, very unlikely
-            if (!req._sock->connect(_addr, _timeout)) {
+        // a pooled connection might have been closed by the server while idle
+        bool reused = req._sock->isOpen();
+        if (!reused) {
+            // Open connection
+            if (!req._sock->connect(_addr, dd)) {
+                throw HttpException("Socket connection to '", _host, ':', _port, "' failed: ", errno_s);
+            }
+        }
+
+        resp._writer = writer;
+        resp._noBody = (m == Method::Head);
+        try {
+            req.submit(dd);
+            resp.receive(*req._sock, dd);
+        }
+        catch (HttpException&) {
+            // only a reused connection that was closed before the server sent anything
+            // is retried, the writer has not seen any data of the response then
+            if (!reused or resp._received != 0 or
+                !suil::matchany(m, Method::Get, Method::Head, Method::Options, Method::Delete))
+            {
+                throw;
+            }
+            // retry idempotent requests once on a new connection
+            idebug("request on reused connection to %s failed, retrying: %s", _poolKey(), errno_s);
+            req._sock->close();
+            if (!req._sock->connect(_addr, dd)) {
                 throw HttpException("Socket connection to '", _host, ':', _port, "' failed: ", errno_s);
             }
+            resp = Response{};
+            resp._writer = std::move(writer);
+            resp._noBody = (m == Method::Head);
+            req.submit(dd);
+            resp.receive(*req._sock, dd);
         }
 
-        req.submit(_timeout);
-        resp._writer = std::move(writer);
-        resp.receive(*req._sock, _timeout);
+        auto conn = req._headers.find("Connection");
+        h._reuse = (m != Method::Connect) and resp.keepAlive() and
+                   ((conn == req._headers.end()) or (conn->second.compare("Close", true) != 0));
         return std::move(resp);
     }
 
+    void Session::pipeline(Handle& h, std::span<Call> calls)
+    {
+        auto& req = h.req;
+        h._reuse = false;
+        if (!req._sock->isOpen()) {
+            if (!req._sock->connect(_addr, Deadline{_timeout})) {
+                throw HttpException("Socket connection to '", _host, ':', _port, "' failed: ", errno_s);
+            }
+        }
+
+        // send all the requests before reading any response
+        size_t sent{0};
+        bool close{false};
+        for (auto& call: calls) {
+            try {
+                req.reset(call.method, call.resource.peek(), true);
+                for (auto& hdr : _headers) {
+                    req.header(hdr.first.peek(), hdr.second.peek());
+                }
+                if (call.builder != nullptr and !call.builder(req)) {
+                    throw HttpException("Building request for resource failed failed");
+                }
+                auto conn = req._headers.find("Connection");
+                close = (conn != req._headers.end()) and (conn->second.compare("Close", true) == 0);
+                req.submit(call.deadline);
+                sent++;
+            }
+            catch (...) {
+                call.fail();
+                break;
+            }
+            if (close) {
+                // the server closes the connection after this request
+                break;
+            }
+        }
+        req.cleanup();
+
+        // responses are received in the order the requests were sent
+        Buffer pending{0};
+        size_t received{0};
+        for (; received < sent; received++) {
+            auto& call = calls[received];
+            try {
+                call.resp._writer = call.writer;
+                call.resp._noBody = (call.method == Method::Head);
+                call.resp.receive(*req._sock, call.deadline, &pending);
+                if (!call.resp.keepAlive()) {
+                    // the server will not handle the remaining requests
+                    received++;
+                    break;
+                }
+            }
+            catch (...) {
+                call.fail();
+                received++;
+                break;
+            }
+        }
+
+        for (auto i = received; i < calls.size(); i++) {
+            if (calls[i].ok()) {
+                calls[i].error = String{"request not handled on pipelined connection"}.dup();
+            }
+        }
+
+        h._reuse = !calls.empty() and (received == calls.size()) and calls.back().ok() and
+                   calls.back().resp.keepAlive() and pending.empty() and !close;
+    }
+
     Response Session::perform(Handle& h, Method m, String resource)
     {
         Request::Builder builder{nullptr};
@@ -157,4 +301,111 @@ namespace suil::http::cli {
         // @TODO load session for given path
         return Session{std::move(proto), std::move(host), port};
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace cli = suil::http::cli;
+
+namespace {
+
+    enum class FakeReply { Full, Close, Partial };
+
+    coroutine void fakeHttpServer(
+            suil::net::TcpServerSock& server,
+            std::vector<FakeReply> replies,
+            int& requests)
+    {
+        size_t next{0};
+        while (next < replies.size()) {
+            auto sock = server.accept(2000);
+            if (sock == nullptr) {
+                break;
+            }
+
+            while (next < replies.size()) {
+                // the requests sent by the tests have no body
+                std::string req{};
+                char buf[1024];
+                while (req.find("\r\n\r\n") == std::string::npos) {
+                    size_t len{sizeof(buf)};
+                    if (!sock->read(buf, len, 2000)) {
+                        break;
+                    }
+                    req.append(buf, len);
+                }
+                if (req.find("\r\n\r\n") == std::string::npos) {
+                    break;
+                }
+
+                requests++;
+                auto reply = replies[next++];
+                if (reply == FakeReply::Full) {
+                    static const char Ok[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+                    sock->send(Ok, sizeof(Ok) - 1, 2000);
+                    sock->flush(2000);
+                    continue;
+                }
+                if (reply == FakeReply::Partial) {
+                    static const char Partial[] = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhello";
+                    sock->send(Partial, sizeof(Partial) - 1, 2000);
+                    sock->flush(2000);
+                }
+                // close the connection without completing the response
+                break;
+            }
+            sock->close();
+        }
+    }
+}
+
+TEST_CASE("Session requests on reused connections", "[http][client][session]")
+{
+    suil::net::TcpServerSock server;
+    REQUIRE(server.listen(iplocal("127.0.0.1", 9306, 0), 4));
+    auto sess = cli::loadSession("127.0.0.1", 9306, "",
+                                 opt(timeout, 2000),
+                                 opt(pool, (cli::ConnectionPool *) nullptr));
+    int requests{0};
+
+    SECTION("Requests that failed before any response byte was received are retried") {
+        std::vector<FakeReply> replies{FakeReply::Full, FakeReply::Close, FakeReply::Full};
+        go(fakeHttpServer(server, replies, requests));
+        auto h = sess.handle();
+        auto resp = cli::get(h, "/");
+        REQUIRE(resp.status() == suil::http::Ok);
+        resp = cli::get(h, "/");
+        REQUIRE(resp.status() == suil::http::Ok);
+        REQUIRE(requests == 3);
+    }
+
+    SECTION("Partially received responses are not retried") {
+        std::vector<FakeReply> replies{FakeReply::Full, FakeReply::Partial};
+        go(fakeHttpServer(server, replies, requests));
+        auto h = sess.handle();
+        REQUIRE(cli::get(h, "/").status() == suil::http::Ok);
+        size_t written{0};
+        REQUIRE_THROWS(sess.perform(suil::http::Method::Get, h, "/", nullptr,
+            [&written](const char* data, size_t len) {
+                if (data != nullptr) {
+                    written += len;
+                }
+                return true;
+            }));
+        // the writer has seen part of the response
+        REQUIRE(written == 5);
+        REQUIRE(requests == 2);
+    }
+
+    SECTION("Requests that are not idempotent are not retried") {
+        std::vector<FakeReply> replies{FakeReply::Full, FakeReply::Close};
+        go(fakeHttpServer(server, replies, requests));
+        auto h = sess.handle();
+        REQUIRE(cli::get(h, "/").status() == suil::http::Ok);
+        REQUIRE_THROWS(cli::post(h, "/"));
+        REQUIRE(requests == 2);
+    }
+
+    server.close();
+}
+#endif
@@ -4,6 +4,8 @@
 
 #include "suil/http/common.hpp"
 
+#include <algorithm>
+
 namespace suil::http {
 
     String toString(Status status)
@@ -187,4 +189,106 @@ namespace suil::http {
                 return Method::Unknown;
         }
     }
-}
\ No newline at end of file
+
+    Codec acceptEncoding(const String& header, uint32 allowed)
+    {
+        static const Codec Preferred[] = {Codec::Brotli, Codec::Gzip, Codec::Deflate};
+        // quality value of each coding in thousandths, -1 if not listed
+        int quality[4] = {-1, -1, -1, -1};
+        int wildcard{-1};
+
+        auto p = header.data(), end = header.data() + header.size();
+        while (p < end) {
+            while (p < end and (*p == ' ' or *p == '\t' or *p == ',')) p++;
+            auto name = p;
+            while (p < end and *p != ',' and *p != ';' and *p != ' ' and *p != '\t') p++;
+            String coding{name, size_t(p - name), false};
+
+            int q{1000};
+            while (p < end and *p != ',') {
+                if (*p++ != ';') {
+                    continue;
+                }
+                while (p < end and *p == ' ') p++;
+                if ((end - p) > 2 and ::tolower(p[0]) == 'q' and p[1] == '=') {
+                    // qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] )
+                    p += 2;
+                    q = (p < end and *p == '1')? 1000 : 0;
+                    if (++p < end and *p == '.') {
+                        int scale{100};
+                        for (p++; p < end and scale > 0 and ::isdigit(*p); p++, scale /= 10) {
+                            q += (*p - '0') * scale;
+                        }
+                    }
+                    q = std::min(q, 1000);
+                }
+            }
+
+            if (coding == "*") {
+                wildcard = q;
+            }
+            else if (coding.compare("br", true) == 0) {
+                quality[int(Codec::Brotli)] = q;
+            }
+            else if (coding.compare("gzip", true) == 0 or coding.compare("x-gzip", true) == 0) {
+                quality[int(Codec::Gzip)] = q;
+            }
+            else if (coding.compare("deflate", true) == 0) {
+                quality[int(Codec::Deflate)] = q;
+            }
+        }
+
+        Codec chosen{Codec::None};
+        int best{0};
+        for (auto codec: Preferred) {
+            if ((allowed & (1u << uint32(codec))) == 0 or !supported(codec)) {
+                continue;
+            }
+            auto q = quality[int(codec)] < 0? wildcard : quality[int(codec)];
+            if (q > best) {
+                best = q;
+                chosen = codec;
+            }
+        }
+        return chosen;
+    }
+
+    const char* contentEncoding(Codec codec)
+    {
+        switch (codec) {
+            case Codec::Deflate:
+                return "deflate";
+            case Codec::Gzip:
+                return "gzip";
+            case Codec::Brotli:
+                return "br";
+            default:
+                return "identity";
+        }
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+using suil::Codec;
+namespace http = suil::http;
+
+TEST_CASE("Negotiating the content coding", "[http][common]")
+{
+    const uint32_t all = (1u << uint32_t(Codec::Deflate)) | (1u << uint32_t(Codec::Gzip)) | (1u << uint32_t(Codec::Brotli));
+    const uint32_t gzip = (1u << uint32_t(Codec::Gzip));
+    REQUIRE(http::acceptEncoding("", all) == Codec::None);
+    REQUIRE(http::acceptEncoding("gzip, deflate", all) == Codec::Gzip);
+    REQUIRE(http::acceptEncoding("deflate", all) == Codec::Deflate);
+    REQUIRE(http::acceptEncoding("gzip;q=0.5, deflate;q=0.8", all) == Codec::Deflate);
+    REQUIRE(http::acceptEncoding("GZIP;q=1.0, identity; q=0.5, *;q=0", all) == Codec::Gzip);
+    REQUIRE(http::acceptEncoding("gzip;q=0, deflate;q=0", all) == Codec::None);
+    REQUIRE(http::acceptEncoding("*", gzip) == Codec::Gzip);
+    REQUIRE(http::acceptEncoding("br", gzip) == Codec::None);
+    if (suil::supported(Codec::Brotli)) {
+        REQUIRE(http::acceptEncoding("gzip, deflate, br", all) == Codec::Brotli);
+        REQUIRE(http::acceptEncoding("gzip, br;q=0.9", all) == Codec::Gzip);
+    }
+}
+#endif
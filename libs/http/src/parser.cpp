@@ -6,6 +6,53 @@
 
 namespace suil::http {
 
+    bool HeaderTable::emplace(String name, String value)
+    {
+        auto hash = CaseInsensitiveHash{}(name);
+        for (size_t i = 0; i < Ego._hashes.size(); i++) {
+            if (Ego._hashes[i] == hash and Ego._headers[i].first.compare(name, true) == 0) {
+                // header already exists
+                return false;
+            }
+        }
+        Ego._hashes.push_back(hash);
+        Ego._headers.emplace_back(std::move(name), std::move(value));
+        return true;
+    }
+
+    HeaderTable::const_iterator HeaderTable::find(const String& name) const
+    {
+        auto hash = CaseInsensitiveHash{}(name);
+        for (size_t i = 0; i < Ego._hashes.size(); i++) {
+            if (Ego._hashes[i] == hash and Ego._headers[i].first.compare(name, true) == 0) {
+                return Ego._headers.begin() + i;
+            }
+        }
+        return Ego._headers.end();
+    }
+
+    void HeaderTable::clear()
+    {
+        // clear retains the capacity of the vectors
+        Ego._hashes.clear();
+        Ego._headers.clear();
+        Ego._interned = 0;
+    }
+
+    void HeaderTable::intern(Arena* arena)
+    {
+        for (auto i = Ego._interned; i < Ego._headers.size(); i++) {
+            auto& [name, value] = Ego._headers[i];
+            if (!name.owns()) {
+                name = arena? arena->dup(name) : name.dup();
+            }
+            if (!value.owns()) {
+                value = arena? arena->dup(value) : value.dup();
+            }
+        }
+        Ego._interned = Ego._headers.size();
+    }
+
     int HttpParser::on_message_begin(llhttp_t* p)
     {
         auto hp = static_cast<HttpParser *>(p);
@@ -13,43 +60,89 @@ namespace suil::http {
         return HPE_OK;
     }
 
+    void HttpParser::track(const char *at, size_t len)
+    {
+        if (Ego._viewHeaders and Ego._stage.size() == 0) {
+            if (Ego._mark.empty()) {
+                Ego._mark = String{at, len, false};
+                return;
+            }
+
+            if ((Ego._mark.data() + Ego._mark.size()) == at) {
+                // continuation of the current token
+                Ego._mark = String{Ego._mark.data(), Ego._mark.size() + len, false};
+                return;
+            }
+
+            // token not contiguous in memory, fallback to copying
+            Ego._stage.append(Ego._mark.data(), Ego._mark.size());
+            Ego._mark = {};
+        }
+        Ego._stage.append(at, len);
+    }
+
+    String HttpParser::take()
+    {
+        if (Ego._viewHeaders and Ego._stage.size() == 0) {
+            return std::exchange(Ego._mark, String{});
+        }
+        return String{Ego._stage};
+    }
+
+    void HttpParser::intern()
+    {
+        if (!Ego._mark.empty()) {
+            // token currently being parsed
+            Ego._stage.append(Ego._mark.data(), Ego._mark.size());
+            Ego._mark = {};
+        }
+
+        if (!Ego._follow.owns()) {
+            Ego._follow = Ego._arena? Ego._arena->dup(Ego._follow) : Ego._follow.dup();
+        }
+        Ego._headers.intern(Ego._arena);
+    }
+
     int HttpParser::on_url(llhttp_t *p, const char *at, size_t len)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_stage.append(at, len);
+        hp->track(at, len);
         return HPE_OK;
     }
 
     int HttpParser::on_url_complete(llhttp_t *p)
     {
         auto hp = static_cast<HttpParser *>(p);
-        return hp->onUrl(String{hp->_stage});
+        return hp->onUrl(hp->take());
     }
 
     int HttpParser::on_status(llhttp_t *p, const char *at, size_t len)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_stage.append(at, len);
+        hp->track(at, len);
         return HPE_OK;
     }
 
     int HttpParser::on_status_complete(llhttp_t *p)
     {
         auto hp = static_cast<HttpParser *>(p);
-        return hp->onStatus(String{hp->_stage});
+        return hp->onStatus(hp->take());
     }
 
     int HttpParser::on_header_field(llhttp_t *p, const char* at, size_t len)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_stage.append(at, len);
+        hp->track(at, len);
 #if 1 // @TODO hack see https://github.com/nodejs/llhttp/pull/81
-        if (String{hp->_stage, false}.compare("Connection", true) == 0) {
-            hp->_follow = String{hp->_stage};
-        }
-
-        if (p->type == HTTP_RESPONSE and String{hp->_stage, false}.compare("Content-Length", true) == 0) {
-            hp->_follow = String{hp->_stage};
+        auto size = hp->_stage.size() + hp->_mark.size();
+        if (size == sizeofcstr("Connection") or
+           (p->type == HTTP_RESPONSE and size == sizeofcstr("Content-Length")))
+        {
+            // only compare fields whose size matches
+            auto field = hp->_stage.size()? String{hp->_stage, false} : hp->_mark.peek();
+            if (field.compare("Connection", true) == 0 or field.compare("Content-Length", true) == 0) {
+                hp->_follow = hp->take();
+            }
         }
 #endif
         return HPE_OK;
@@ -58,21 +151,24 @@ namespace suil::http {
     int HttpParser::on_header_field_complete(llhttp_t *p)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_follow = String{hp->_stage};
+        if (hp->_stage.size() or hp->_mark.size()) {
+            // could have been taken by the hack in on_header_field
+            hp->_follow = hp->take();
+        }
         return HPE_OK;
     }
 
     int HttpParser::on_header_value(llhttp_t *p, const char *at, size_t len)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_stage.append(at, len);
+        hp->track(at, len);
         return HPE_OK;
     }
 
     int HttpParser::on_header_value_complete(llhttp_t *p)
     {
         auto hp = static_cast<HttpParser *>(p);
-        hp->_headers.emplace(std::move(hp->_follow), String{hp->_stage});
+        hp->_headers.emplace(std::move(hp->_follow), hp->take());
         return HPE_OK;
     }
 
@@ -80,7 +176,7 @@ namespace suil::http {
     {
         auto hp = static_cast<HttpParser *>(p);
         if (hp->_follow) {
-            hp->_headers.emplace(String{hp->_follow}, String{hp->_stage});
+            hp->_headers.emplace(std::move(hp->_follow), hp->take());
         }
         hp->_headersComplete = 1;
         return hp->onHeadersComplete();
@@ -96,7 +192,12 @@ namespace suil::http {
     {
         auto hp = static_cast<HttpParser *>(p);
         hp->_bodyComplete = 1;
-        return hp->onMessageComplete();
+        auto status = hp->onMessageComplete();
+        if (status == HPE_OK and hp->_pipelined) {
+            // pause the parser, the remaining data belongs to the next message
+            return HPE_PAUSED;
+        }
+        return status;
     }
 
     int HttpParser::on_chunk_header(llhttp_t *p)
@@ -135,11 +236,18 @@ namespace suil::http {
     bool HttpParser::feed(const char* data, size_t len)
     {
         auto err = llhttp_execute(this, data, len);
+        Ego._parsed = len;
         if (err != HPE_OK) {
             if (err == HPE_PAUSED_UPGRADE) {
                 llhttp_resume_after_upgrade(this);
                 return true;
             }
+            if (err == HPE_PAUSED) {
+                // paused at the end of a message
+                Ego._parsed = llhttp_get_error_pos(this) - data;
+                llhttp_resume(this);
+                return true;
+            }
             return false;
         }
 
@@ -149,6 +257,7 @@ namespace suil::http {
     void HttpParser::clear(bool intern)
     {
         _follow = {};
+        _mark = {};
         if (!intern) {
             _stage.clear();
         }
@@ -162,4 +271,81 @@ namespace suil::http {
         Ego._stage << part;
         return HPE_OK;
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+using suil::http::HttpParser;
+using suil::http::HeaderTable;
+using suil::String;
+
+namespace {
+    struct TestParser : HttpParser {
+        TestParser() : HttpParser(HTTP_REQUEST) {
+            _viewHeaders = 1;
+        }
+        int onUrl(String&& url) override {
+            Url = std::move(url);
+            return HPE_OK;
+        }
+        using HttpParser::feed;
+        using HttpParser::intern;
+        using HttpParser::_headers;
+        using HttpParser::_headersComplete;
+        String Url;
+    };
+}
+
+TEST_CASE("HttpParser header views", "[http][parser]")
+{
+    SECTION("Header table lookups") {
+        HeaderTable table;
+        REQUIRE(table.emplace("Content-Type", "text/plain"));
+        REQUIRE(table.emplace("Host", "localhost"));
+        REQUIRE_FALSE(table.emplace("content-type", "application/json"));
+        REQUIRE(table.size() == 2);
+        REQUIRE(table.contains("HOST"));
+        REQUIRE(table.find("content-type")->second == "text/plain");
+        REQUIRE(table.find("Content-Length") == table.end());
+        table.clear();
+        REQUIRE(table.empty());
+    }
+
+    SECTION("Headers reference the fed buffer") {
+        char data[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nX-Test: value\r\n\r\n";
+        TestParser parser;
+        REQUIRE(parser.feed(data, sizeof(data)-1));
+        REQUIRE(parser._headersComplete);
+        REQUIRE(parser.Url == "/index.html");
+        REQUIRE_FALSE(parser.Url.owns());
+        auto it = parser._headers.find("x-test");
+        REQUIRE(it != parser._headers.end());
+        REQUIRE(it->second == "value");
+        REQUIRE_FALSE(it->second.owns());
+        REQUIRE(it->second.data() >= data);
+        REQUIRE(it->second.data() < &data[sizeof(data)]);
+
+        parser.intern();
+        REQUIRE(it->first.owns());
+        REQUIRE(it->second.owns());
+        REQUIRE(it->second == "value");
+    }
+
+    SECTION("Headers split across non contiguous feeds") {
+        const char first[]  = "GET / HTTP/1.1\r\nX-Te";
+        const char second[] = "st: val";
+        const char third[]  = "ue\r\n\r\n";
+        TestParser parser;
+        REQUIRE(parser.feed(first, sizeof(first)-1));
+        parser.intern();
+        REQUIRE(parser.feed(second, sizeof(second)-1));
+        REQUIRE(parser.feed(third, sizeof(third)-1));
+        REQUIRE(parser._headersComplete);
+        auto it = parser._headers.find("X-Test");
+        REQUIRE(it != parser._headers.end());
+        REQUIRE(it->first.owns());
+        REQUIRE(it->second == "value");
+        REQUIRE(it->second.owns());
+    }
+}
+#endif
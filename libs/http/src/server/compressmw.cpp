@@ -0,0 +1,206 @@
+//
+// Created by Mpho Mbotho on 2021-07-08.
+//
+
+#include "suil/http/server/compressmw.hpp"
+#include "suil/http/server/response.hpp"
+#include "suil/http/server/request.hpp"
+
+namespace suil::http::server {
+
+    // the codings used for dynamic responses
+    static constexpr uint32 Encodable{
+        (1u << uint32(Codec::Deflate)) | (1u << uint32(Codec::Gzip)) | (1u << uint32(Codec::Brotli))};
+
+    void Compression::before(Request&, Response&, Context&)
+    {}
+
+    void Compression::after(Request& req, Response& resp, Context&)
+    {
+        if (!req.attrs().Compress or resp.size() < Ego._minSize) {
+            // compression disabled on route or not worth it
+            return;
+        }
+
+        if (req.attrs().Static) {
+            // the file server picks the encoding of static resources, honouring its
+            // own configuration and the files it found to be incompressible
+            return;
+        }
+
+        if (req.getMethod() == Method::Head or
+            resp.status() == http::NoContent or
+            resp.status() == http::NotModified or
+            resp.status() == http::SwitchingProtocols)
+        {
+            // responses without a body
+            return;
+        }
+
+        if (resp.status() == http::PartialContent or !resp.header("Content-Range").empty()) {
+            // the byte ranges refer to the identity body
+            return;
+        }
+
+        if (!resp.header("Content-Encoding").empty()) {
+            // already encoded, e.g by the file server
+            return;
+        }
+
+        const auto& type = resp.contentType().empty()? req.attrs().ReplyType : resp.contentType();
+        if (!compressible(type)) {
+            return;
+        }
+
+        // the body sent depends on the Accept-Encoding header
+        resp.header("Vary", "Accept-Encoding");
+        auto codec = http::acceptEncoding(req.header("Accept-Encoding"), Encodable);
+        if (codec != Codec::None and Ego.compress(resp, codec)) {
+            resp.header("Content-Encoding", http::contentEncoding(codec));
+        }
+    }
+
+    bool Compression::compress(Response& resp, Codec codec)
+    {
+        auto& compressor = Ego._compressors[int(codec) - int(Codec::Deflate)];
+        auto size = resp.size();
+        Buffer out{};
+        if (resp._chunks.empty()) {
+            if (!compressor.compress(out, resp._body.data(), resp._body.size())) {
+                return false;
+            }
+        }
+        else {
+            // chunks are sent before the body
+            Buffer raw{size};
+            for (auto& ch: resp._chunks) {
+                if (ch.usesFd()) {
+                    // file chunks are sent as is
+                    return false;
+                }
+                raw.append(ch.ptr(), ch.size());
+            }
+            raw.append(resp._body.data(), resp._body.size());
+            if (!compressor.compress(out, raw.data(), raw.size())) {
+                return false;
+            }
+        }
+
+        if (out.size() >= size) {
+            // incompressible content
+            return false;
+        }
+
+        resp._chunks.clear();
+        resp._chunksSize = 0;
+        resp._body = std::move(out);
+        return true;
+    }
+
+    bool Compression::compressible(const String& contentType)
+    {
+        // ignore the parameters, e.g text/plain; charset=utf-8
+        auto pos = contentType.find(';');
+        String type{contentType.data(), (pos == String::npos)? contentType.size() : pos, false};
+        while (!type.empty() and isspace(type.data()[type.size()-1])) {
+            type = String{type.data(), type.size()-1, false};
+        }
+
+        if (type.startsWith("text/", true)) {
+            return true;
+        }
+
+        auto endsWith = [&type](const char *suffix, size_t len) {
+            return (type.size() > len) and
+                   (strncasecmp(&type.data()[type.size() - len], suffix, len) == 0);
+        };
+
+        if (endsWith("+json", 5) or endsWith("+xml", 4)) {
+            // e.g application/problem+json, image/svg+xml
+            return true;
+        }
+
+        return (type.compare("application/json", true) == 0) or
+               (type.compare("application/javascript", true) == 0) or
+               (type.compare("application/xml", true) == 0);
+    }
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/net/tcp.hpp>
+
+namespace hs = suil::http::server;
+
+TEST_CASE("Compression middleware", "[http][server][compress]")
+{
+    SECTION("Compressible content types") {
+        REQUIRE(hs::Compression::compressible("text/html"));
+        REQUIRE(hs::Compression::compressible("Text/Plain; charset=utf-8"));
+        REQUIRE(hs::Compression::compressible("application/json"));
+        REQUIRE(hs::Compression::compressible("application/problem+json"));
+        REQUIRE(hs::Compression::compressible("image/svg+xml"));
+        REQUIRE_FALSE(hs::Compression::compressible("image/png"));
+        REQUIRE_FALSE(hs::Compression::compressible("application/octet-stream"));
+        REQUIRE_FALSE(hs::Compression::compressible(""));
+    }
+
+    suil::net::TcpSock sock;
+    hs::HttpServerConfig config;
+    hs::Request req{sock, config};
+    hs::RouteAttributes attrs;
+    req._params.attrs = &attrs;
+    req.method = uint8(suil::http::Method::Get);
+    req.header("Accept-Encoding", "gzip");
+    hs::Compression mw;
+    hs::Compression::Context ctx;
+    const std::string text(4096, 'a');
+
+    SECTION("Compressible responses are compressed") {
+        hs::Response resp{suil::http::Ok};
+        resp.setContentType("text/plain");
+        resp.append(text);
+        mw.after(req, resp, ctx);
+        REQUIRE(resp.header("Content-Encoding") == "gzip");
+        REQUIRE(resp.header("Vary") == "Accept-Encoding");
+        REQUIRE(resp.size() < text.size());
+    }
+
+    SECTION("Partial content is sent as is") {
+        hs::Response resp{suil::http::PartialContent};
+        resp.setContentType("text/plain");
+        resp.append(text);
+        mw.after(req, resp, ctx);
+        REQUIRE(resp.header("Content-Encoding").empty());
+        REQUIRE(resp.size() == text.size());
+
+        hs::Response ranged{suil::http::Ok};
+        ranged.setContentType("text/plain");
+        ranged.header("Content-Range", "bytes 0-4095/8192");
+        ranged.append(text);
+        mw.after(req, ranged, ctx);
+        REQUIRE(ranged.header("Content-Encoding").empty());
+        REQUIRE(ranged.size() == text.size());
+    }
+
+    SECTION("Encoded responses are sent as is") {
+        hs::Response resp{suil::http::Ok};
+        resp.setContentType("text/plain");
+        resp.header("Content-Encoding", "br");
+        resp.append(text);
+        mw.after(req, resp, ctx);
+        REQUIRE(resp.header("Content-Encoding") == "br");
+        REQUIRE(resp.size() == text.size());
+    }
+
+    SECTION("Static resources are left to the file server") {
+        attrs.Static = true;
+        hs::Response resp{suil::http::Ok};
+        resp.setContentType("text/plain");
+        resp.append(text);
+        mw.after(req, resp, ctx);
+        REQUIRE(resp.header("Content-Encoding").empty());
+        REQUIRE(resp.size() == text.size());
+    }
+}
+#endif
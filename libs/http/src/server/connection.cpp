@@ -6,17 +6,104 @@
 
 #include <suil/base/datetime.hpp>
 
+#ifndef HTTP_SEND_MAX_IOV
+#define HTTP_SEND_MAX_IOV 16
+#endif
+
 namespace suil::http::server {
 
+    HeaderCache::HeaderCache(const HttpServerConfig& config)
+        : _config{config}
+    {}
+
+    void HeaderCache::update()
+    {
+        auto now = mnow();
+        if (((now - Ego._updated) > 1000) or
+            (Ego._keepAliveTime != Ego._config.keepAliveTime) or
+            (Ego._hstsEnable != Ego._config.hstsEnable) or
+            (Ego._serverName != Ego._config.serverName))
+        {
+            Ego.rebuild(now);
+        }
+    }
+
+    void HeaderCache::rebuild(int64 now)
+    {
+        Ego._updated = now;
+        Ego._keepAliveTime = Ego._config.keepAliveTime;
+        Ego._hstsEnable = Ego._config.hstsEnable;
+        Ego._serverName = Ego._config.serverName.dup();
+
+        Ego._block.reset(256, true);
+        Ego._offsets[KeepAlive] = 0;
+        if (Ego._keepAliveTime) {
+            Ego._block.append("Connection: Keep-Alive\r\nKeepAlive: ",
+                              sizeofcstr("Connection: Keep-Alive\r\nKeepAlive: "));
+            Ego._block.decimal(Ego._keepAliveTime);
+            Ego._block.append("\r\n", 2);
+        }
+
+        Ego._offsets[Hsts] = Ego._block.size();
+        if (Ego._hstsEnable) {
+            Ego._block.append("Strict-Transport-Security: max-age ",
+                              sizeofcstr("Strict-Transport-Security: max-age "));
+            Ego._block.decimal(Ego._hstsEnable);
+            Ego._block.append("; includeSubdomains\r\n", sizeofcstr("; includeSubdomains\r\n"));
+        }
+
+        Ego._offsets[Server] = Ego._block.size();
+        Ego._block.append("Server: ", sizeofcstr("Server: "));
+        Ego._block << Ego._serverName;
+        Ego._block.append("\r\n", 2);
+
+        Ego._offsets[Date] = Ego._block.size();
+        char date[64] = {0};
+        Datetime{}(date, sizeof(date), Datetime::HTTP_FMT);
+        Ego._block.append("Date: ", sizeofcstr("Date: "));
+        Ego._block.append(date);
+        Ego._block.append("\r\n", 2);
+
+        Ego._offsets[ContentType] = Ego._block.size();
+        Ego._block.append("Content-Type: text/plain\r\n", sizeofcstr("Content-Type: text/plain\r\n"));
+        Ego._offsets[Count] = Ego._block.size();
+    }
+
+    enum : uint8 {
+        HasServer        = 0x01,
+        HasDate          = 0x02,
+        HasContentLength = 0x04,
+        HasContentType   = 0x08
+    };
+
+    static inline uint8 defaultHeader(const String& name)
+    {
+        // only headers whose length match are compared
+        switch (name.size()) {
+            case sizeofcstr("Date"):
+                return name.compare("Date", true) == 0? HasDate : 0;
+            case sizeofcstr("Server"):
+                return name.compare("Server", true) == 0? HasServer : 0;
+            case sizeofcstr("Content-Type"):
+                return name.compare("Content-Type", true) == 0? HasContentType : 0;
+            case sizeofcstr("Content-Length"):
+                return name.compare("Content-Length", true) == 0? HasContentLength : 0;
+            default:
+                return 0;
+        }
+    }
+
     ConnectionImpl::ConnectionImpl(
             net::Socket& sock,
             HttpServerConfig& config,
             Router& handler,
-            HttpServerStats& stats)
+            HttpServerStats& stats,
+            HeaderCache& headers)
         : _config{config},
           _stats{stats},
           _sock{sock},
-          _handler{handler}
+          _handler{handler},
+          _headerCache{headers}
     {
         Ego._stats.totalRequests++;
         Ego._stats.openRequests++;
@@ -31,6 +118,8 @@ namespace suil::http::server {
     {
         Status status = http::Ok;
         Request req(Ego._sock, Ego._config);
+        // reused across requests so that the body buffer is only allocated once
+        Response resp{http::Ok};
 
         itrace("%s - starting connection handler", Ego._sock.id());
         do {
@@ -39,7 +128,7 @@ namespace suil::http::server {
             if (status != http::Ok) {
                 if (status != http::RequestTimeout) {
                     // receiving failed, send back failure
-                    Response resp{status};
+                    resp._status = status;
                     sendResponse(req, resp, true);
                 }
                 else {
@@ -54,7 +143,7 @@ namespace suil::http::server {
             if (status != http::Ok) {
                 if (status != http::RequestTimeout) {
                     // receiving failed, send back failure
-                    Response resp{status};
+                    resp._status = status;
                     sendResponse(req, resp, true);
                 }
                 else {
@@ -67,7 +156,6 @@ namespace suil::http::server {
             // handle received request
             bool err{false};
             int64_t start = mnow();
-            Response resp{http::Ok};
             try {
                 handleRequest(req, resp);
             }
@@ -93,9 +181,12 @@ namespace suil::http::server {
                 Ego._close = true;
             }
 
-            itrace("\"%s " PRIs " HTTP/%u.%u\" %u - %lu ms",
+            auto arenaUsed = req._pool.used();
+            Ego._stats.arenaBytes += arenaUsed;
+            Ego._stats.arenaPeak = std::max(Ego._stats.arenaPeak, uint64(arenaUsed));
+            itrace("\"%s " PRIs " HTTP/%u.%u\" %u - %lu ms, %zu arena bytes",
                    http::toString(Method(req.method))(), _PRIs(req.url()),
-                   req.http_major, req.http_minor, resp._status, (mnow()-start));
+                   req.http_major, req.http_minor, resp._status, (mnow()-start), arenaUsed);
 
             req.clear();
             resp.clear();
@@ -118,6 +209,7 @@ namespace suil::http::server {
         auto status = http::toString(resp._status);
         Ego._stage << status;
         Ego._stage.append("\r\n", 2);
+        Ego._headerCache.update();
 
         if (!err) {
             const auto& conn = req.header("Connection");
@@ -126,18 +218,11 @@ namespace suil::http::server {
                 Ego._close = true;
             }
 
-            if (Ego._config.keepAliveTime and !Ego._close) {
-                // set keep alive time
-                constexpr strview keepAlive{"Connection: Keep-Alive\r\n"};
-                Ego._stage.append(keepAlive);
-                Ego._stage.appendnf(30, "KeepAlive: %lu\r\n", Ego._config.keepAliveTime);
-            }
-
-            if (Ego._config.hstsEnable) {
-                Ego._stage.reserve(48);
-                Ego._stage << "Strict-Transport-Security: max-age "
-                           << Ego._config.hstsEnable << "; includeSubdomains\r\n";
-            }
+            // keep alive and HSTS headers (if enabled) come straight from the cache
+            bool keepAlive = Ego._config.keepAliveTime and !Ego._close;
+            Ego._headerCache.append(Ego._stage,
+                                    keepAlive? HeaderCache::KeepAlive : HeaderCache::Hsts,
+                                    HeaderCache::Server);
         }
         else {
             // force connection close on error
@@ -149,42 +234,36 @@ namespace suil::http::server {
         }
 
         resp.flushCookies();
+        uint8 has{0};
         for (const auto& [k, v]: resp._headers) {
             Ego._stage.append(k.data(), k.size());
             Ego._stage.append(": ", sizeofcstr(": "));
             Ego._stage.append(v.data(), v.size());
             Ego._stage.append("\r\n", 2);
+            has |= defaultHeader(k);
         }
 
-        if (!resp._headers.contains("Server")) {
-            Ego._stage.append("Server: ", sizeofcstr("Server: "));
-            Ego._stage << Ego._config.serverName;
-            Ego._stage.append("\r\n", 2);
-        }
+        // Server and Date headers are adjacent in the cache
+        Ego._headerCache.append(Ego._stage,
+                                (has & HasServer)? HeaderCache::Date : HeaderCache::Server,
+                                (has & HasDate)? HeaderCache::Date : HeaderCache::ContentType);
 
-        if (!resp._headers.contains("Date")) {
-            Ego._stage.append("Date: ", sizeofcstr("Date: "));
-            Ego._stage.append(getCachedDate());
-            Ego._stage.append("\r\n", 2);
-        }
-
-        if (!resp._headers.contains("Content-Length")) {
+        if (!(has & HasContentLength)) {
             Ego._stage.append("Content-Length: ", sizeofcstr("Content-Length: "));
-            auto tmp = std::to_string(resp.size());
-            Ego._stage.append(tmp.data(), tmp.size());
+            Ego._stage.decimal(resp.size());
             Ego._stage.append("\r\n", 2);
         }
 
-        if (!resp._headers.contains("Content-Type")) {
-            Ego._stage.append("Content-Type: ", sizeofcstr("Content-Type: "));
+        if (!(has & HasContentType)) {
             if (req._params.attrs and req.attrs().ReplyType) {
+                Ego._stage.append("Content-Type: ", sizeofcstr("Content-Type: "));
                 Ego._stage << req.attrs().ReplyType;
+                Ego._stage.append("\r\n", 2);
             }
             else {
                 // default content type "text/plain"
-                Ego._stage.append("text/plain", sizeofcstr("text/plain"));
+                Ego._headerCache.append(Ego._stage, HeaderCache::ContentType, HeaderCache::Count);
             }
-            Ego._stage.append("\r\n", 2);
         }
 
         Ego._stage.append("\r\n", 2);
@@ -200,7 +279,12 @@ namespace suil::http::server {
             sb.emplace_back(resp._body.data(), resp._body.size());
         }
 
-        if (!Ego.writeResponse(sb)) {
+        // responses to pipelined requests are batched, they get flushed once all the
+        // requests already received have been handled
+        bool flush = Ego._close or
+                     !req.isPipelined() or
+                     (resp._status == http::SwitchingProtocols);
+        if (!Ego.writeResponse(sb, flush)) {
             iwarn("%s sending data to socket failed: %s", Ego._sock.id(), errno_s);
             Ego._close = true;
             resp.clear();
@@ -208,16 +292,67 @@ namespace suil::http::server {
         sb.clear();
     }
 
-    bool ConnectionImpl::writeResponse(const SendBuffer& buf)
+    bool ConnectionImpl::writeResponse(const SendBuffer& buf, bool flush)
     {
-        size_t rc{0};
+        bool usesFd = std::any_of(buf.begin(), buf.end(), [](const net::Chunk& b) {
+            return b.usesFd();
+        });
+
+        if (!flush and !usesFd) {
+            // response to a pipelined request, copy into the socket's send buffer
+            // so that it goes out in the same write as the responses that follow
+            for (auto& b: buf) {
+                size_t sent{0};
+                auto data = static_cast<const char*>(b.ptr());
+                while (sent < b.size()) {
+                    auto chunk = std::min(Ego._config.sendChunk, b.size()-sent);
+                    auto rc = Ego._sock.send(&data[sent], chunk, Ego._config.connectionTimeout);
+                    if (rc == 0 || rc != chunk) {
+                        itrace("%s sending failed: %s", Ego._sock.id(), errno_s);
+                        return false;
+                    }
+                    sent += chunk;
+                }
+                Ego._stats.txBytes += b.size();
+            }
+            return true;
+        }
+
+        // memory chunks are gathered into a single vectored send, file
+        // descriptors still go out with sendfile
+        struct iovec iov[HTTP_SEND_MAX_IOV];
+        int iovcnt{0};
+        size_t pending{0};
+        auto sendPending = [&]() {
+            if (iovcnt == 0) {
+                return true;
+            }
+            auto rc = Ego._sock.sendv(iov, iovcnt, Ego._config.connectionTimeout);
+            if (rc != pending) {
+                itrace("%s sending failed: %s", Ego._sock.id(), errno_s);
+                return false;
+            }
+            Ego._stats.txBytes += pending;
+            iovcnt = 0;
+            pending = 0;
+            return true;
+        };
+
         for (auto& b: buf) {
+            if (b.empty()) {
+                continue;
+            }
+
             if (b.usesFd()) {
+                if (!sendPending()) {
+                    return false;
+                }
+
                 // send file descriptor
                 size_t sent{0};
                 do {
                     auto chunk = std::min(Ego._config.sendChunk, b.size() - sent);
-                    rc = Ego._sock.sendfile(
+                    auto rc = Ego._sock.sendfile(
                             b.fd(),
                             (b.offset() + sent),
                             chunk,
@@ -229,40 +364,22 @@ namespace suil::http::server {
 
                     sent += chunk;
                 } while (sent < b.size());
+                Ego._stats.txBytes += b.size();
             }
             else {
-                // send buffer
-                size_t sent{0};
-                auto data = static_cast<const char*>(b.ptr());
-                do {
-                    auto chunk = std::min(Ego._config.sendChunk, b.size()-sent);
-                    rc = Ego._sock.send(&data[sent], chunk, Ego._config.connectionTimeout);
-                    if (rc == 0 || rc != chunk) {
-                        itrace("%s sending failed: %s", Ego._sock.id(), errno_s);
-                        return false;
-                    }
-
-                    sent += chunk;
-                } while (sent < b.size());
+                if ((iovcnt == HTTP_SEND_MAX_IOV) and !sendPending()) {
+                    return false;
+                }
+                iov[iovcnt++] = {const_cast<void *>(b.ptr()), b.size()};
+                pending += b.size();
             }
-            Ego._stats.txBytes += b.size();
         }
 
-        return Ego._sock.flush(Ego._config.connectionTimeout);
-    }
-
-    const char* ConnectionImpl::getCachedDate()
-    {
-        static uint64 rec{0};
-        auto point = mnow();
-        static char buf[64] = {0};
-        if ((point - rec) > 1000) {
-            // update timestamp after every second
-            rec = point;
-            Datetime{}(buf, sizeof(buf), Datetime::HTTP_FMT);
+        if (!sendPending()) {
+            return false;
         }
 
-        return buf;
+        return !flush or Ego._sock.flush(Ego._config.connectionTimeout);
     }
 
 }
\ No newline at end of file
@@ -7,12 +7,16 @@
 #include <suil/base/datetime.hpp>
 #include <suil/base/file.hpp>
 
+#include <algorithm>
 #include <climits>
 
 #include <sys/mman.h>
 
 namespace suil::http::server {
 
+    // the codings the file server can send
+    static constexpr uint32 Encodable{(1u << uint32(Codec::Gzip)) | (1u << uint32(Codec::Brotli))};
+
     CachedFile::CachedFile()
     {
         flags = 0;
@@ -22,6 +26,7 @@ namespace suil::http::server {
         : isGarbage{std::exchange(o.isGarbage, false)},
           isReloading{std::exchange(o.isReloading, false)},
           inFlight{std::exchange(o.inFlight, 0)},
+          key{std::move(o.key)},
           path{std::move(o.path)},
           data{std::exchange(o.data, nullptr)},
           len{std::exchange(o.len, 0)},
@@ -33,6 +38,9 @@ namespace suil::http::server {
           reloadCond{std::move(o.reloadCond)}
     {
         flags = std::exchange(o.flags, 0);
+        for (int i = 0; i < 2; i++) {
+            encoded[i] = std::exchange(o.encoded[i], {});
+        }
     }
 
     CachedFile& CachedFile::operator=(CachedFile&& o) noexcept
@@ -44,6 +52,7 @@ namespace suil::http::server {
         isGarbage = std::exchange(o.isGarbage, false);
         isReloading = std::exchange(o.isReloading, false);
         inFlight = std::exchange(o.inFlight, 0);
+        key = std::move(o.key);
         path = std::move(o.path);
         data = std::exchange(o.data, nullptr);
         len = std::exchange(o.len, 0);
@@ -54,6 +63,9 @@ namespace suil::http::server {
         fd = std::exchange(o.fd, -1);
         reloadCond = std::move(o.reloadCond);
         flags = std::exchange(o.flags, 0);
+        for (int i = 0; i < 2; i++) {
+            encoded[i] = std::exchange(o.encoded[i], {});
+        }
 
         return Ego;
     }
@@ -75,6 +87,17 @@ namespace suil::http::server {
             data = nullptr;
         }
 
+        for (auto& enc: encoded) {
+            if (enc.data) {
+                ::free(enc.data);
+            }
+            if (enc.fd != -1) {
+                fdclear(enc.fd);
+                ::close(enc.fd);
+            }
+            enc = {};
+        }
+
         if (fd != -1) {
             auto tmp = fd;
             fd = -1;
@@ -90,17 +113,34 @@ namespace suil::http::server {
         lastModified = lastAccessed = 0;
     }
 
+    size_t CachedFile::encodedSize() const
+    {
+        size_t total{0};
+        for (auto& enc: encoded) {
+            if (enc.data) {
+                total += enc.len;
+            }
+        }
+        return total;
+    }
+
     void FileServer::init()
     {
         // add text mime types
         mime(".html", "text/html",
              opt(allowCaching, false),
-             opt(allowSendFile, false));
-        mime(".css", "text/css");
-        mime(".csv", "text/csv");
-        mime(".txt", "text/plain");
-        mime(".sgml","text/sgml");
-        mime(".tsv", "text/tab-separated-values");
+             opt(allowSendFile, false),
+             opt(allowCompress, true));
+        mime(".css", "text/css",
+             opt(allowCompress, true));
+        mime(".csv", "text/csv",
+             opt(allowCompress, true));
+        mime(".txt", "text/plain",
+             opt(allowCompress, true));
+        mime(".sgml","text/sgml",
+             opt(allowCompress, true));
+        mime(".tsv", "text/tab-separated-values",
+             opt(allowCompress, true));
 
         // add compressed mime types
         mime(".bz", "application/x-bzip",
@@ -122,7 +162,8 @@ namespace suil::http::server {
         // add image mime types
         mime(".jpg", "image/jpeg");
         mime(".png", "image/png");
-        mime(".svg", "image/svg+xml");
+        mime(".svg", "image/svg+xml",
+             opt(allowCompress, true));
         mime(".gif", "image/gif");
         mime(".bmp", "image/bmp");
         mime(".tiff","image/tiff");
@@ -145,12 +186,18 @@ namespace suil::http::server {
         mime(".wav", "audio/wav, audio/x-wav");
 
         // Other common mime types
-        mime(".json",  "application/json");
-        mime(".map",   "application/json");
-        mime(".js",    "application/javascript");
-        mime(".ttf",   "font/ttf");
-        mime(".xhtml", "application/xhtml+xml");
-        mime(".xml",   "application/xml");
+        mime(".json",  "application/json",
+             opt(allowCompress, true));
+        mime(".map",   "application/json",
+             opt(allowCompress, true));
+        mime(".js",    "application/javascript",
+             opt(allowCompress, true));
+        mime(".ttf",   "font/ttf",
+             opt(allowCompress, true));
+        mime(".xhtml", "application/xhtml+xml",
+             opt(allowCompress, true));
+        mime(".xml",   "application/xml",
+             opt(allowCompress, true));
 
         char base[PATH_MAX];
         realpath(_config.root.data(), base);
@@ -168,6 +215,7 @@ namespace suil::http::server {
 
         // this will dup over the base
         _wwwDir = String{base}.dup();
+        _sketch.resize(_config.maxCachedFiles);
         _config.route = "/" SUIL_FILE_SERVER_ROUTE;
         // add some basic redirects
         alias("/", "index.html");
@@ -223,13 +271,13 @@ namespace suil::http::server {
 
         auto& mm = it->second;
         auto sf = loadFile(path, mm);
-        if (sf == _cachedFiles.end()) {
+        if (sf == _lru.end()) {
             itrace("requested static resource (" PRIs ") does not exist", _PRIs(path));
             // static file not found;
             throw HttpError(http::NotFound);
         }
 
-        auto& cf = sf->second;
+        auto& cf = *sf;
         if (mm.allowCaching) {
             // if file supports cache headers employ cache headers
             auto cc = req.header("If-Modified-Since");
@@ -245,13 +293,23 @@ namespace suil::http::server {
             cacheControl(req, resp, cf, mm);
         }
 
+        Codec codec{Codec::None};
+        if (_config.enableCompression and mm.allowCompress) {
+            // the representation sent depends on the Accept-Encoding header
+            resp.header("Vary", "Accept-Encoding");
+            if (req.header("Range").empty()) {
+                // ranges are always served from the identity representation
+                codec = http::acceptEncoding(req.header("Accept-Encoding"), Encodable);
+            }
+        }
+
         if (req.getMethod() == Method::Head) {
             head(req, resp, cf, mm);
         }
 
         // get path from extension
         try {
-            get(req, resp, cf, mm);
+            get(req, resp, cf, mm, codec);
         } catch (...) {
             auto ex = Exception::fromCurrent();
             ierror("'" PRIs "': %s", _PRIs(path), ex.message().c_str());
@@ -259,13 +317,13 @@ namespace suil::http::server {
         }
     }
 
-    void FileServer::get(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm)
+    void FileServer::get(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm, Codec codec)
     {
         // set content type as configured on  mime
         resp.setContentType(mm.mime.peek());
 
         // prepare response
-        prepareResponse(req, resp, cf, mm);
+        prepareResponse(req, resp, cf, mm, codec);
     }
 
     void FileServer::head(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm)
@@ -280,8 +338,20 @@ namespace suil::http::server {
         }
     }
 
-    void FileServer::prepareResponse(const Request& req, Response& resp, CachedFile& cf, const MimeType& mm)
+    void FileServer::prepareResponse(
+                const Request& req,
+                Response& resp,
+                CachedFile& cf,
+                const MimeType& mm,
+                Codec codec)
     {
+        if (codec != Codec::None and encodedResponse(resp, cf, mm, codec)) {
+            // the compressed representation is always sent whole
+            resp.header("Accept-Ranges", "none");
+            resp.end(Status::Ok);
+            return;
+        }
+
         if (mm.allowRange) {
             // let clients know that the server accepts ranges for current mime type
             resp.header("Accept-Ranges", "bytes");
@@ -307,6 +377,142 @@ namespace suil::http::server {
         }
     }
 
+    int FileServer::encodedIndex(Codec codec)
+    {
+        return (codec == Codec::Brotli)? 1 : 0;
+    }
+
+    bool FileServer::encodedResponse(Response& resp, CachedFile& cf, const MimeType& mt, Codec codec)
+    {
+        auto& enc = cf.encoded[encodedIndex(codec)];
+        if (enc.data == nullptr and enc.fd == -1 and !loadEncoded(cf, enc, mt, codec)) {
+            return false;
+        }
+
+        resp.header("Content-Encoding", contentEncoding(codec));
+        addEncodedChunk(resp, cf, enc);
+        return true;
+    }
+
+    bool FileServer::loadEncoded(CachedFile& cf, CachedFile::Encoded& enc, const MimeType& mt, Codec codec)
+    {
+        if (!enc.probed) {
+            // look for a precompressed sibling only once per (re)load of the file
+            enc.probed = true;
+            auto path = suil::catstr(cf.path, (codec == Codec::Brotli)? ".br" : ".gz");
+            struct stat st{};
+            if (::stat(path(), &st) == 0 and S_ISREG(st.st_mode) and
+                time_t(st.st_mtim.tv_sec) >= cf.lastModified)
+            {
+                if (_config.enableSendFile and mt.allowSendFile) {
+                    enc.fd = ::open(path(), O_RDONLY);
+                    if (enc.fd >= 0) {
+                        enc.len = size_t(st.st_size);
+                        itrace("serving %s from precompressed file %s", cf.path(), path());
+                        return true;
+                    }
+                    iwarn("opening precompressed resource %s failed: %s", path(), errno_s);
+                }
+                else if (admit(cf.key, size_t(st.st_size), &cf)) {
+                    try {
+                        Buffer b{size_t(st.st_size)};
+                        fs::readall(b, path());
+                        enc.len = b.size();
+                        enc.data = b.release();
+                        // the file might have changed since it was admitted
+                        _totalMemCachedSize = _totalMemCachedSize + enc.len - size_t(st.st_size);
+                        itrace("serving %s from precompressed file %s", cf.path(), path());
+                        return true;
+                    }
+                    catch (...) {
+                        auto ex = Exception::fromCurrent();
+                        _totalMemCachedSize -= size_t(st.st_size);
+                        iwarn("reading precompressed resource %s failed: %s", path(), ex.what());
+                    }
+                }
+                else {
+                    // not popular enough, probe again next time
+                    enc.probed = false;
+                    return false;
+                }
+            }
+        }
+
+        if (enc.incompressible or enc.compressing or cf.len < _config.compressMin) {
+            return false;
+        }
+
+        // the current request is answered with the uncompressed file without waiting
+        // for the compression, the compressed copy is served to subsequent requests.
+        // The compression itself runs to completion on this worker
+        enc.compressing = true;
+        cf.inFlight++;
+        go(compressor(Ego, cf, codec));
+        return false;
+    }
+
+    void FileServer::compressor(FileServer& S, CachedFile& cf, Codec codec)
+    {
+        // let the request that scheduled the compression complete first
+        yield();
+        auto& enc = cf.encoded[encodedIndex(codec)];
+        if (!cf.isGarbage) {
+            S.compressFile(cf, enc, codec);
+        }
+        enc.compressing = false;
+        S.derefCachedFileChunk(cf);
+    }
+
+    bool FileServer::compressFile(CachedFile& cf, CachedFile::Encoded& enc, Codec codec)
+    {
+        Buffer raw{};
+        const void *src{cf.data};
+        if (cf.useFd or src == nullptr) {
+            raw.reserve(cf.len);
+            auto nread = ::pread(cf.fd, raw.data(), cf.len, 0);
+            if (nread != ssize_t(cf.len)) {
+                iwarn("reading static resource %s for compression failed: %s", cf.path(), errno_s);
+                return false;
+            }
+            raw.seek(nread);
+            src = raw.data();
+        }
+
+        Buffer out{};
+        if (!suil::compress(out, codec, src, cf.len) or out.size() >= cf.len) {
+            itrace("static resource %s not compressed with %s", cf.path(), contentEncoding(codec));
+            enc.incompressible = true;
+            return false;
+        }
+
+        if (!admit(cf.key, out.size(), &cf)) {
+            // no room in the cache for the compressed copy
+            itrace("compressed copy of %s not admitted into the cache", cf.path());
+            return false;
+        }
+
+        enc.len = out.size();
+        enc.data = out.release();
+        itrace("compressed static resource %s with %s {%zu -> %zu}",
+               cf.path(), contentEncoding(codec), cf.len, enc.len);
+        return true;
+    }
+
+    void FileServer::addEncodedChunk(Response& resp, CachedFile& cf, CachedFile::Encoded& enc)
+    {
+        cf.inFlight++;
+        if (enc.fd != -1) {
+            resp.chunk(net::Chunk{enc.fd, enc.len, 0, [this, cfp = &cf](int) {
+                derefCachedFileChunk(*cfp);
+            }});
+        }
+        else {
+            resp.chunk(net::Chunk{enc.data, enc.len, 0, [this, cfp = &cf](void *) {
+                derefCachedFileChunk(*cfp);
+            }});
+        }
+    }
+
     void FileServer::cacheControl(
                 const Request& req,
                 Response& resp,
@@ -383,12 +589,15 @@ namespace suil::http::server {
 
     bool FileServer::reloadCachedFile(CachedFileIt& it, const struct stat& st)
     {
-        auto& cf = it->second;
+        auto& cf = *it;
         if (!readFile(cf, st)) {
-            // reading file failure
+            // reading file failure, coroutines waiting for the reload hold the file in flight
+            auto waiting = cf.inFlight > 0;
             auto cff = &cf;
             markCachedFileForRemoval(it);
-            cff->reloadCond.notify();
+            if (waiting) {
+                cff->reloadCond.notify();
+            }
             return false;
         }
 
@@ -422,18 +631,15 @@ namespace suil::http::server {
         return tmp.dup();
     }
 
-    String FileServer::relativePath(const CachedFile& cf)
-    {
-        return cf.path.substr(_wwwDir.size());
-    }
-
     FileServer::CachedFileIt FileServer::loadFile(const String& rel, const MimeType& mt)
     {
-        auto it = _cachedFiles.find(rel);
-        if (it == _cachedFiles.end()) {
+        _sketch.increment(rel);
+        auto mit = _cachedFiles.find(rel);
+        if (mit == _cachedFiles.end()) {
+            _stats.misses++;
             auto path = fileAbsolutePath(rel);
             if (!path) {
-                return it;
+                return _lru.end();
             }
 
             CachedFile cf;
@@ -442,85 +648,121 @@ namespace suil::http::server {
             cf.fd = ::open(path.data(), O_RDONLY);
             if (cf.fd < 0) {
                 iwarn("opening static resource %s failed: %s", path(), errno_s);
-                return it;
+                return _lru.end();
             }
 
             cf.path         = std::move(path);
             cf.lastModified = time_t(st.st_mtim.tv_sec);
             cf.lastAccessed = time_t(st.st_atim.tv_sec);
             cf.len          = size_t(st.st_size);
-            it  = addCachedFile(std::move(cf));
-
             if (_config.enableSendFile and mt.allowSendFile) {
                 // Only enable sending if allowed for current file mime type
-                it->second.useFd  = 1;
+                cf.useFd = 1;
+            }
+            else if (!admit(rel, cf.len)) {
+                // not popular enough to take the place of cached files
+                itrace("static resource %s not admitted into the cache", cf.path());
+                cf.useFd = 1;
+                cf.isRejected = 1;
+                _stats.rejections++;
             }
-            else if(!reloadCachedFile(it, st)) {
-                itrace("reading cached resource '%s' failed: %s", it->second.path());
-                ::close(it->second.fd);
-                return _cachedFiles.end();
+
+            auto it = addCachedFile(rel, std::move(cf));
+            if (!it->useFd and !reloadCachedFile(it, st)) {
+                itrace("reading cached resource '" PRIs "' failed", _PRIs(rel));
+                return _lru.end();
             }
 
             return it;
         }
-        else {
-            auto& cf = it->second;
-            if (unlikely(cf.isReloading)) {
-                // need to wait reload to be complete
-                auto cfp = &cf;
-                cfp->inFlight++;
-                Sync sync;
-                cfp->reloadCond.wait(sync);
-                cfp->inFlight--;
-
-                if (cfp->isGarbage) {
-                    // at this point file was marked for removal so loading failed
-                    return _cachedFiles.end();
-                }
 
-                // file was successfully reloaded
-                return it;
+        _stats.hits++;
+        auto it = mit->second;
+        auto& cf = *it;
+        // most recently used files are kept in front
+        _lru.splice(_lru.begin(), _lru, it);
+        if (unlikely(cf.isReloading)) {
+            // need to wait reload to be complete
+            auto cfp = &cf;
+            cfp->inFlight++;
+            Sync sync;
+            cfp->reloadCond.wait(sync);
+            derefCachedFileChunk(*cfp);
+
+            if (cfp->isGarbage) {
+                // at this point file was marked for removal so loading failed
+                return _lru.end();
             }
 
-            struct  stat st{};
-            if (::stat(cf.path(), &st) < 0) {
-                // file might not exist anymore
-                idebug("reloading static resource  %s failed: %s", cf.path(), errno_s);
-                markCachedFileForRemoval(it);
-                return _cachedFiles.end();
-            }
+            // file was successfully reloaded
+            return it;
+        }
+
+        struct  stat st{};
+        if (::stat(cf.path(), &st) < 0) {
+            // file might not exist anymore
+            idebug("reloading static resource  %s failed: %s", cf.path(), errno_s);
+            markCachedFileForRemoval(it);
+            return _lru.end();
+        }
 
-            if (cf.lastModified == time_t(st.st_mtim.tv_sec)) {
-                cf.lastAccessed = time_t(st.st_atim.tv_sec);
-                // file not modified, no need to reload
-                return it;
+        if (cf.lastModified == time_t(st.st_mtim.tv_sec)) {
+            cf.lastAccessed = time_t(st.st_atim.tv_sec);
+            if (cf.isRejected and admit(rel, cf.len, &cf)) {
+                // file became popular enough to be served from memory
+                itrace("static resource %s admitted into the cache", cf.path());
+                cf.isRejected = 0;
+                cf.useFd = 0;
+                if (!reloadCachedFile(it, st)) {
+                    return _lru.end();
+                }
             }
+            // file not modified, no need to reload
+            return it;
+        }
 
-            // if file was recently modified, reload
+        // if file was recently modified, reload
+        if (cf.inFlight > 0) {
+            // chunks of the old contents are still being sent, the old contents are
+            // collected like an evicted file and the file is reloaded into a new entry
+            CachedFile fresh;
+            fresh.path = cf.path.dup();
+            markCachedFileForRemoval(it);
+            it = addCachedFile(rel, std::move(fresh));
+        }
+        else {
+            _totalMemCachedSize -= cf.memSize();
             cf.clear();
-            cf.fd = ::open(cf.path(), O_RDONLY);
-            if (cf.fd < 0) {
-                iwarn("reloading static resource (%s) failed: %s", cf.path(), errno_s);
-                markCachedFileForRemoval(it);
-                return _cachedFiles.end();
-            }
+        }
 
-            cf.lastAccessed = time_t(st.st_atim.tv_sec);
-            cf.lastModified = time_t(st.st_mtim.tv_sec);
-            cf.len          = size_t(st.st_size);
+        auto& rcf = *it;
+        rcf.fd = ::open(rcf.path(), O_RDONLY);
+        if (rcf.fd < 0) {
+            iwarn("reloading static resource (%s) failed: %s", rcf.path(), errno_s);
+            markCachedFileForRemoval(it);
+            return _lru.end();
+        }
 
-            if (_config.enableSendFile and mt.allowSendFile) {
-                // Only enable sending if allowed for current file mime type
-                it->second.useFd  = 1;
-            }
-            else if (!reloadCachedFile(it, st)) {
-                itrace("reloading static resource %s failed: %s", cf.path(), errno_s);
-                ::close(cf.fd);
-                return _cachedFiles.end();
-            }
+        rcf.lastAccessed = time_t(st.st_atim.tv_sec);
+        rcf.lastModified = time_t(st.st_mtim.tv_sec);
+        rcf.len          = size_t(st.st_size);
 
-            return it;
+        if (_config.enableSendFile and mt.allowSendFile) {
+            // Only enable sending if allowed for current file mime type
+            rcf.useFd  = 1;
+        }
+        else if (!admit(rel, rcf.len, &rcf)) {
+            itrace("reloaded static resource %s not admitted into the cache", rcf.path());
+            rcf.useFd = 1;
+            rcf.isRejected = 1;
+            _stats.rejections++;
         }
+        else if (!reloadCachedFile(it, st)) {
+            itrace("reloading static resource %s failed: %s", rcf.path(), errno_s);
+            return _lru.end();
+        }
+
+        return it;
     }
 
     void FileServer::buildRangeResponse(
@@ -617,65 +859,89 @@ namespace suil::http::server {
 #undef  CRLF
     }
 
-    FileServer::CachedFileIt FileServer::addCachedFile(CachedFile&& cf)
+    FileServer::CachedFileIt FileServer::addCachedFile(const String& key, CachedFile&& cf)
     {
-        auto rel = relativePath(cf);
-        if (cf.useFd) {
-            // cached file is not really loaded in memory, just add to cache and move on
-            return _cachedFiles.emplace(std::move(rel), std::move(cf)).first;
+        if (_cachedFiles.size() >= _config.maxCachedFiles) {
+            // make room for the new file
+            evict(0, _cachedFiles.size() + 1 - _config.maxCachedFiles, nullptr);
         }
 
-        auto newSize = _totalMemCachedSize + cf.len;
-        if (newSize < _config.maxCacheSize) {
-            // still within bounds, update and move on
-            _totalMemCachedSize = newSize;
-            return _cachedFiles.emplace(std::move(rel), std::move(cf)).first;
+        cf.key = key.dup();
+        _lru.push_front(std::move(cf));
+        auto it = _lru.begin();
+        _cachedFiles.emplace(it->key.peek(), it);
+        return it;
+    }
+
+    bool FileServer::admit(const String& key, size_t len, const CachedFile* keep)
+    {
+        if (int64(len) > _config.maxCacheSize) {
+            // would never fit
+            return false;
         }
 
-        // this function will ensure that at the end, first iterator is the least recently used
-        auto leastRecentlyUsed = [](const CachedFileIt& a, const CachedFileIt& b) {
-            auto& aa = a->second;
-            auto& bb = b->second;
-            return std::make_tuple(aa.lastAccessed, aa.inFlight) <
-                   std::make_tuple(bb.lastAccessed, bb.inFlight);
-        };
+        if (int64(_totalMemCachedSize + len) > _config.maxCacheSize) {
+            // the file is only admitted if it is more popular than the least
+            // recently used file it would evict
+            auto victim = std::find_if(_lru.rbegin(), _lru.rend(), [keep](const CachedFile& cf) {
+                return (&cf != keep) and !cf.isReloading and (cf.memSize() != 0);
+            });
 
-        std::set<CachedFileIt, decltype(leastRecentlyUsed)> cachedIts{leastRecentlyUsed};
-        for (auto it = _cachedFiles.begin(); it != _cachedFiles.end(); it++) {
-            cachedIts.emplace(it);
-        }
+            if (victim == _lru.rend() or
+                _sketch.frequency(key) <= _sketch.frequency(victim->key))
+            {
+                return false;
+            }
 
-        auto it = cachedIts.begin();
-        while (newSize > _config.maxCacheSize and it != cachedIts.end()) {
-            if ((*it)->second.useFd == 0) {
-                // remove as much as we can, skip those that use file descriptor
-                newSize -= (*it)->second.len;
-                markCachedFileForRemoval(*it);
+            evict(len, 0, keep);
+            if (int64(_totalMemCachedSize + len) > _config.maxCacheSize) {
+                return false;
             }
-            it++;
         }
 
-        _totalMemCachedSize = newSize;
-        return _cachedFiles.emplace(std::move(rel), std::move(cf)).first;
+        _totalMemCachedSize += len;
+        return true;
     }
 
-    void FileServer::markCachedFileForRemoval(CachedFileIt it)
+    void FileServer::evict(size_t len, size_t count, const CachedFile* keep)
     {
-        auto cf = std::move(it->second);
-        _cachedFiles.erase(it);
-        if (cf.useFd == 0) {
-            _totalMemCachedSize -= cf.len;
+        // evict least recently used files until there is room for len bytes and
+        // at least count files were evicted
+        auto it = _lru.end();
+        while (it != _lru.begin() and
+               ((count > 0) or (int64(_totalMemCachedSize + len) > _config.maxCacheSize)))
+        {
+            auto victim = std::prev(it);
+            if ((&*victim == keep) or victim->isReloading or ((count == 0) and (victim->memSize() == 0))) {
+                // file cannot be evicted or doesn't free memory
+                it = victim;
+                continue;
+            }
+
+            itrace("evicting static resource %s from cache", victim->path());
+            markCachedFileForRemoval(victim);
+            _stats.evictions++;
+            if (count > 0) {
+                count--;
+            }
         }
+    }
+
+    void FileServer::markCachedFileForRemoval(CachedFileIt it)
+    {
+        _cachedFiles.erase(it->key);
+        _totalMemCachedSize -= it->memSize();
 
-        if (cf.inFlight == 0) {
+        if (it->inFlight == 0) {
             // if the file is not in flight remove immediately
-            cf.clear();
+            _lru.erase(it);
             return;
         }
 
-        // Put file in garbage so that it will be collected by garbage collector
-        cf.isGarbage = true;
-        _garbageCache.push_back(std::move(cf));
+        // Put file in garbage so that it will be collected by garbage collector, the
+        // file is not moved as chunks in flight reference it
+        it->isGarbage = true;
+        _garbageCache.splice(_garbageCache.end(), _lru, it);
         if (_isCollectingGarbage) {
             // might be waiting for garbage
             _gcCond.notify();
@@ -687,6 +953,86 @@ namespace suil::http::server {
         }
     }
 
+    FileServerStats FileServer::stats() const
+    {
+        auto stats = _stats;
+        stats.pid = spid;
+        stats.entries = _cachedFiles.size();
+        for (auto& cf: _lru) {
+            if (cf.data != nullptr) {
+                if (cf.isMapped) {
+                    stats.mappedBytes += cf.len;
+                }
+                else {
+                    stats.heapBytes += cf.len;
+                }
+            }
+            stats.heapBytes += cf.encodedSize();
+        }
+        return stats;
+    }
+
+    void FileServer::Sketch::resize(size_t entries)
+    {
+        // 4 bit counters, 16 per word and about 4 counters per entry
+        size_t words{1};
+        while ((words * 16) < (entries * 4)) {
+            words <<= 1;
+        }
+        _table.assign(words, 0);
+        _mask = (words * 16) - 1;
+        // counters are halved after this many increments
+        _sampleSize = std::max(entries * 10, size_t(16));
+        _additions = 0;
+    }
+
+    size_t FileServer::Sketch::index(size_t hash, int i) const
+    {
+        auto h2 = (hash >> 32) | 1;
+        return (hash + (i * h2)) & _mask;
+    }
+
+    void FileServer::Sketch::increment(const String& key)
+    {
+        if (_table.empty()) {
+            return;
+        }
+
+        auto hash = std::hash<std::string_view>{}({key.data(), key.size()});
+        for (int i = 0; i < 4; i++) {
+            auto idx = index(hash, i);
+            auto shift = (idx & 15) << 2;
+            auto& word = _table[idx >> 4];
+            if (((word >> shift) & 0xF) < 0xF) {
+                word += (uint64(1) << shift);
+            }
+        }
+
+        if (++_additions >= _sampleSize) {
+            // age the popularity of all files
+            for (auto& word: _table) {
+                word = (word >> 1) & 0x7777777777777777ull;
+            }
+            _additions /= 2;
+        }
+    }
+
+    uint8 FileServer::Sketch::frequency(const String& key) const
+    {
+        if (_table.empty()) {
+            return 0;
+        }
+
+        auto hash = std::hash<std::string_view>{}({key.data(), key.size()});
+        uint8 freq{0xF};
+        for (int i = 0; i < 4; i++) {
+            auto idx = index(hash, i);
+            auto shift = (idx & 15) << 2;
+            freq = std::min(freq, uint8((_table[idx >> 4] >> shift) & 0xF));
+        }
+        return freq;
+    }
+
     void FileServer::derefCachedFileChunk(CachedFile& cf)
     {
         // this function will be invoked after a chunk is used up
@@ -700,7 +1046,9 @@ namespace suil::http::server {
     void FileServer::addCachedFileChunk(Response& resp, CachedFile& cf, size_t size, off_t from)
     {
         cf.inFlight++;
-        if (_config.enableSendFile and cf.useFd) {
+        if (cf.useFd) {
+            // files rejected by the cache are not loaded into memory and are sent
+            // from the descriptor even when sendfile is not enabled
             resp.chunk(net::Chunk{cf.fd, size, off_t(from), [this, cfp = &cf](int) {
                 derefCachedFileChunk(*cfp);
             }});
@@ -736,7 +1084,200 @@ namespace suil::http::server {
             }
         } while (!S._garbageCache.empty());
 
-        S._isCollectingGarbage = true;
+        S._isCollectingGarbage = false;
         ltrace(&S, "garbage collector done");
     }
-}
\ No newline at end of file
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/http/server/endpoint.hpp>
+
+#include <utime.h>
+
+using suil::http::server::FileServer;
+using suil::http::server::Endpoint;
+
+namespace {
+
+    void writeStatic(const suil::String& path, const std::string& content, time_t mtime)
+    {
+        if (suil::fs::exists(path())) {
+            suil::fs::remove(path());
+        }
+        suil::fs::append(path(), content.data(), content.size(), false);
+        struct utimbuf times{mtime, mtime};
+        ::utime(path(), &times);
+    }
+}
+
+TEST_CASE("FileServer frequency sketch", "[http][fileserver]")
+{
+    FileServer::Sketch sketch;
+    sketch.resize(64);
+    REQUIRE(sketch.frequency("/index.html") == 0);
+
+    for (int i = 0; i < 5; i++) {
+        sketch.increment("/index.html");
+    }
+    sketch.increment("/about.html");
+    REQUIRE(sketch.frequency("/index.html") >= 5);
+    REQUIRE(sketch.frequency("/about.html") >= 1);
+    REQUIRE(sketch.frequency("/index.html") > sketch.frequency("/about.html"));
+
+    // counters saturate and are halved periodically
+    for (int i = 0; i < 1000; i++) {
+        sketch.increment("/index.html");
+    }
+    REQUIRE(sketch.frequency("/index.html") <= 15);
+    REQUIRE(sketch.frequency("/about.html") == 0);
+}
+
+TEST_CASE("FileServer cache", "[http][fileserver]")
+{
+    using suil::String;
+    const String dir{"/tmp/suil-fserver-test"};
+    suil::fs::remove(dir(), true);
+    suil::fs::mkdir(dir());
+    auto path = [&](const char *name) { return suil::catstr(dir, "/", name); };
+    const time_t then{::time(nullptr) - 60};
+    const std::string text(4096, 'a');
+    writeStatic(path("a.txt"), text, then);
+    writeStatic(path("b.txt"), text, then);
+    writeStatic(path("c.txt"), text, then);
+
+    Endpoint<> ep{"/api"};
+    FileServer fs(ep,
+                  opt(root, dir.peek()),
+                  opt(enableSendFile, false),
+                  opt(maxCachedFiles, 2));
+    const auto& mt = fs._mimeTypes.find(String{".txt"})->second;
+
+    SECTION("Least recently used files are evicted") {
+        REQUIRE(fs.loadFile("a.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("b.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("a.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("c.txt", mt) != fs._lru.end());
+        REQUIRE(fs._cachedFiles.size() == 2);
+        REQUIRE(fs._cachedFiles.find(String{"a.txt"}) != fs._cachedFiles.end());
+        REQUIRE(fs._cachedFiles.find(String{"b.txt"}) == fs._cachedFiles.end());
+        REQUIRE(fs._stats.evictions == 1);
+        REQUIRE(fs._totalMemCachedSize == 2*text.size());
+    }
+
+    SECTION("Modified files are reloaded") {
+        auto it = fs.loadFile("a.txt", mt);
+        REQUIRE(it != fs._lru.end());
+        auto cfp = &*it;
+
+        // not in flight, reloaded in place
+        writeStatic(path("a.txt"), "Hello World", then + 1);
+        it = fs.loadFile("a.txt", mt);
+        REQUIRE(&*it == cfp);
+        REQUIRE(it->len == 11);
+        REQUIRE(strncmp((const char *) it->data, "Hello World", 11) == 0);
+        REQUIRE(fs._totalMemCachedSize == 11);
+
+        // in flight, the old contents are kept until released
+        cfp->inFlight++;
+        writeStatic(path("a.txt"), text, then + 2);
+        it = fs.loadFile("a.txt", mt);
+        REQUIRE(&*it != cfp);
+        REQUIRE(it->len == text.size());
+        REQUIRE(cfp->isGarbage);
+        REQUIRE(strncmp((const char *) cfp->data, "Hello World", 11) == 0);
+        REQUIRE(fs._garbageCache.size() == 1);
+        REQUIRE(fs._cachedFiles.size() == 1);
+        REQUIRE(fs._totalMemCachedSize == text.size());
+        REQUIRE(fs._isCollectingGarbage);
+
+        // releasing the old contents lets the garbage collector finish
+        fs.derefCachedFileChunk(*cfp);
+        for (int i = 0; i < 10 and fs._isCollectingGarbage; i++) {
+            yield();
+        }
+        REQUIRE(fs._garbageCache.empty());
+        REQUIRE_FALSE(fs._isCollectingGarbage);
+
+        // and the collector is restarted for new garbage
+        it->inFlight++;
+        cfp = &*it;
+        fs.markCachedFileForRemoval(it);
+        REQUIRE(fs._isCollectingGarbage);
+        fs.derefCachedFileChunk(*cfp);
+        for (int i = 0; i < 10 and fs._isCollectingGarbage; i++) {
+            yield();
+        }
+        REQUIRE(fs._garbageCache.empty());
+        REQUIRE_FALSE(fs._isCollectingGarbage);
+    }
+
+    SECTION("Rejected files are sent from the descriptor") {
+        fs._config.maxCacheSize = int64(2*text.size());
+        fs._sketch.resize(1024);
+        REQUIRE(fs.loadFile("a.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("b.txt", mt) != fs._lru.end());
+        // not more popular than the least recently used file
+        auto it = fs.loadFile("c.txt", mt);
+        REQUIRE(it != fs._lru.end());
+        REQUIRE(it->isRejected);
+        REQUIRE(it->useFd);
+        REQUIRE(it->data == nullptr);
+        REQUIRE(fs._stats.rejections == 1);
+        REQUIRE(fs._totalMemCachedSize == 2*text.size());
+
+        {
+            suil::http::server::Response resp;
+            fs.addCachedFileChunk(resp, *it, it->len, 0);
+            REQUIRE(resp._chunks.size() == 1);
+            REQUIRE(resp._chunks[0].usesFd());
+            REQUIRE(resp._chunks[0].fd() == it->fd);
+            REQUIRE(resp._chunks[0].size() == text.size());
+            REQUIRE(it->inFlight == 1);
+        }
+        REQUIRE(it->inFlight == 0);
+    }
+
+    SECTION("Popular files evict others from the cache budget") {
+        fs._config.maxCacheSize = int64(2*text.size());
+        fs._sketch.resize(1024);
+        REQUIRE(fs.loadFile("a.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("b.txt", mt) != fs._lru.end());
+        REQUIRE(fs.loadFile("c.txt", mt)->isRejected);
+        REQUIRE(fs._stats.evictions == 0);
+
+        // requested again, more popular than the least recently used file
+        auto it = fs.loadFile("c.txt", mt);
+        REQUIRE(it != fs._lru.end());
+        REQUIRE_FALSE(it->isRejected);
+        REQUIRE_FALSE(it->useFd);
+        REQUIRE(it->data != nullptr);
+        REQUIRE(fs._stats.evictions == 1);
+        REQUIRE(fs._cachedFiles.find(String{"a.txt"}) == fs._cachedFiles.end());
+        REQUIRE(fs._cachedFiles.find(String{"b.txt"}) != fs._cachedFiles.end());
+        REQUIRE(fs._totalMemCachedSize == 2*text.size());
+    }
+
+    SECTION("Compressed copies are served to subsequent requests") {
+        auto it = fs.loadFile("a.txt", mt);
+        REQUIRE(it != fs._lru.end());
+        auto& enc = it->encoded[FileServer::encodedIndex(suil::Codec::Gzip)];
+        REQUIRE_FALSE(fs.loadEncoded(*it, enc, mt, suil::Codec::Gzip));
+        REQUIRE(enc.compressing);
+        REQUIRE(it->inFlight == 1);
+        // not compressed twice
+        REQUIRE_FALSE(fs.loadEncoded(*it, enc, mt, suil::Codec::Gzip));
+
+        for (int i = 0; i < 10 and enc.compressing; i++) {
+            yield();
+        }
+        REQUIRE_FALSE(enc.compressing);
+        REQUIRE(it->inFlight == 0);
+        REQUIRE(enc.data != nullptr);
+        REQUIRE(enc.len < text.size());
+        REQUIRE(fs._totalMemCachedSize == text.size() + enc.len);
+    }
+
+    suil::fs::remove(dir(), true);
+}
+#endif
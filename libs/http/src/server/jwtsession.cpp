@@ -23,40 +23,48 @@ namespace suil::http::server {
         _token = jwt.encode(jwtSession->_refreshTokenKey);
 
         scoped(conn, redisContext->conn(jwtSession->_sessionDb));
-        if (!conn.set(jwt.aud(), _token)) {
+        bool saved{false};
+        if (jwtSession->_refreshTokenExpiry > 0) {
+            // when token expires, it should be removed from database
+            saved = conn("SET", jwt.aud(), _token, "EX", jwtSession->_refreshTokenExpiry).status();
+        }
+        else {
+            saved = conn.set(jwt.aud(), _token);
+        }
+
+        if (!saved) {
             // saving jwt authentication failed
             jwtAuth->authenticate("Creating session failed");
             return false;
         }
 
-        if (jwtSession->_refreshTokenExpiry > 0) {
-            // when token expires, it should be removed from database
-            conn.expire(jwt.aud(), jwtSession->_refreshTokenExpiry);
-        }
-
         return true;
     }
 
     void JwtSession::Context::revoke(db::RedisClient& conn, const String& user)
     {
         // remove stored token and any keys associated with the user
-        conn.del(user);
         auto keys = conn.keys(suil::catstr("*", user));
+        auto pipeline = conn.pipeline();
+        pipeline("DEL", user);
         for (auto& key : keys) {
-            conn.del(key);
+            if (key != user) {
+                pipeline("DEL", key);
+            }
         }
+        pipeline.exec();
         _token.clear();
         jwtAuth->revoke();
     }
 
     bool JwtSession::Context::authorize(db::RedisClient& conn, const String& user)
     {
-        if (!conn.exists(user)) {
+        auto token = conn.get<String>(user, String{});
+        if (token.empty()) {
             // session does not exist
             return false;
         }
 
-        auto token = conn.get<String>(user);
         Jwt tok;
         if (!Jwt::decode(tok, token, jwtSession->_refreshTokenKey)) {
             Ego.revoke(conn, user);
@@ -227,42 +227,62 @@ inline char *qs_scanvalue(const char *key, const char *qs, char *val, size_t val
 namespace suil::http::server {
 
     QueryString::QueryString(const String& sv)
-        : _url{sv.empty()? nullptr : strndup(sv.data(), sv.size())}
     {
-        if (sv.empty()) return;
-
-        char *params[MaxArguments] = {nullptr};
-        auto count = qs_parse(_url, params, MaxArguments);
-        if (count > 0) {
-            _params.reserve(count);
-            for (int i = 0; i < count; i++) {
-                _params.emplace_back(params[i]);
-            }
-        }
+        Ego.parse(sv);
     }
 
     QueryString::QueryString(QueryString&& other)
         : _url{other._url},
+          _own{other._own},
           _params{std::move(other._params)}
     {
         other._url = nullptr;
+        other._own = false;
     }
 
     QueryString& QueryString::operator=(QueryString&& other)
     {
+        if (this == &other) {
+            return Ego;
+        }
+
+        Ego.clear();
         _url = other._url;
+        _own = other._own;
         _params = std::move(other._params);
         other._url = nullptr;
+        other._own = false;
         return Ego;
     }
 
+    void QueryString::parse(const String& sv, Arena* arena)
+    {
+        Ego.clear();
+        if (sv.empty()) return;
+
+        if (arena) {
+            _url = arena->dup(sv).data();
+        }
+        else {
+            _url = strndup(sv.data(), sv.size());
+            _own = true;
+        }
+
+        char *params[MaxArguments] = {nullptr};
+        auto count = qs_parse(_url, params, MaxArguments);
+        if (count > 0) {
+            _params.assign(params, params + count);
+        }
+    }
+
     void QueryString::clear()
     {
         _params.clear();
-        if (_url) {
+        if (_url and _own) {
             ::free(_url);
-            _url = nullptr;
         }
+        _url = nullptr;
+        _own = false;
     }
 
     String QueryString::get(const String& name) const
@@ -6,14 +6,23 @@
 
 #include <suil/base/url.hpp>
 
+#ifndef HTTP_RX_MIN_READ
+#define HTTP_RX_MIN_READ 512
+#endif
+
 namespace suil::http::server {
 
     uint64 Request::sOffloadIndex{0};
 
     Request::Request(net::Socket& sock, HttpServerConfig& config)
-        : _sock{sock},
+        : _pool{config.requestArena},
+          _sock{sock},
           _config{config}
-    {}
+    {
+        Ego._pipelined = 1;
+        Ego._viewHeaders = 1;
+        Ego._arena = &Ego._pool;
+    }
 
     const char* Request::ip() const
     {
@@ -40,7 +49,7 @@ namespace suil::http::server {
 
     const String & Request::cookie(const String& name) const {
         auto it = Ego._cookies.find(name);
-        if (it == Ego._headers.end()) {
+        if (it == Ego._cookies.end()) {
             static String Invalid{};
             return Invalid;
         }
@@ -88,14 +97,19 @@ namespace suil::http::server {
         Ego._bodyOffset = 0;
         memset(&Ego._flags, 0, sizeof(Ego._flags));
         Ego._params.clear();
+        if (!internal) {
+            // request done, everything allocated from the arena can be released
+            Ego._pool.reset();
+        }
     }
 
     int Request::onUrl(String&& url)
     {
         auto pos = url.find('?');
         if (pos != -1) {
-            Ego._qps = QueryString{url.substr(pos)};
-            Ego._url = url.substr(0, pos, false);
+            Ego._qps.parse(url.substr(pos), &Ego._pool);
+            // url is only a view if it references the receive buffer
+            Ego._url = url.owns()? Ego._pool.dup(url.substr(0, pos)) : url.substr(0, pos);
         }
         else {
             Ego._url = std::move(url);
@@ -117,9 +131,17 @@ namespace suil::http::server {
             // no cookies to parse
             return false;
         }
-        // this will modify the cookie string
-        auto parts = it->second.split(";");
-        for (auto& part: parts) {
+        // cookies are views into the header value
+        const auto& cookies = it->second;
+        const char *ptr = cookies.data(), *end = ptr + cookies.size();
+        while (ptr < end) {
+            auto sep = static_cast<const char *>(memchr(ptr, ';', end - ptr));
+            if (sep == nullptr) {
+                sep = end;
+            }
+            String part{ptr, size_t(sep - ptr), false};
+            ptr = sep + 1;
+
             size_t i{0};
             while (i < part.size() and isspace(part[i])) i++;
             if (i == part.size()) {
@@ -133,7 +155,7 @@ namespace suil::http::server {
             }
             else {
                 // cookie has value
-                Ego._cookies.emplace(part.substr(i, pos), part.substr(pos+1));
+                Ego._cookies.emplace(part.substr(i, pos - i), part.substr(pos+1));
             }
         }
 
@@ -440,7 +462,7 @@ namespace suil::http::server {
                     name = part.peek();
                 }
 
-                Ego._form.add(std::move(name), URL::decode(value));
+                Ego._form.add(std::move(name), URL::decode(value, Ego._pool));
             }
             return true;
         }
@@ -448,13 +470,58 @@ namespace suil::http::server {
         return false;
     }
 
+    bool Request::receiveSome(HttpServerStats& stats)
+    {
+        // responses to pipelined requests are not flushed until the receive
+        // buffer is drained, flush them before blocking on the socket
+        if (!sock().flush(Ego._config.connectionTimeout)) {
+            return false;
+        }
+
+        // the url and headers of a request being parsed are views into the buffer
+        bool hasViews = !Ego._url.empty() or !Ego._headers.empty() or
+                        !Ego._mark.empty() or !Ego._follow.empty();
+        if (!hasViews or (Ego._rx.capacity() < HTTP_RX_MIN_READ)) {
+            if (hasViews) {
+                // buffer is about to be overwritten
+                Ego.intern();
+            }
+            // everything in the buffer has been parsed, reuse it
+            Ego._rx.reset(Ego._config.receiveBuffer, true);
+            Ego._rxOffset = 0;
+        }
+
+        auto len = Ego._rx.capacity();
+        if (!sock().read(&Ego._rx.data()[Ego._rx.size()], len, Ego._config.connectionTimeout)) {
+            return false;
+        }
+        Ego._rx.seek(len);
+        stats.rxBytes += len;
+        return true;
+    }
+
+    void Request::intern()
+    {
+        HttpParser::intern();
+        auto rx = reinterpret_cast<const char *>(Ego._rx.data());
+        if ((Ego._url.data() >= rx) and (Ego._url.data() < (rx + Ego._rx.size()))) {
+            // url references the receive buffer
+            Ego._url = Ego._pool.dup(Ego._url);
+        }
+    }
+
+    bool Request::parseSome()
+    {
+        auto ok = Ego.feed(&Ego._rx.data()[Ego._rxOffset], Ego._rx.size() - Ego._rxOffset);
+        Ego._rxOffset += Ego._parsed;
+        return ok;
+    }
+
     Status Request::receiveHeaders(HttpServerStats& stats)
     {
         Ego._status = http::Ok;
-        char stage[2048];
         do {
-            auto len = sizeof(stage);
-            if (!sock().read(stage, len, Ego._config.connectionTimeout)) {
+            if (!Ego.isPipelined() and !Ego.receiveSome(stats)) {
                 if (errno) {
                     idebug("Request::receiveHeaders(%s) receiving headers failed: %s",
                            sock().id(), errno_s);
@@ -462,9 +529,8 @@ namespace suil::http::server {
                 Ego._status = (errno == ETIMEDOUT) ? http::RequestTimeout : http::InternalError;
                 break;
             }
-            stats.rxBytes += len;
 
-            if (!Ego.feed(stage, len)) {
+            if (!Ego.parseSome()) {
                 if (Ego._status == http::Ok)
                     Ego._status = http::BadRequest;
                 break;
@@ -480,27 +546,21 @@ namespace suil::http::server {
             return Ego._status;
         }
 
-        char stage[8192];
-        size_t len = 0, left = content_length;
         do {
-            len = std::min(sizeof(stage), left);
-            if (!sock().receive(stage, len, Ego._config.connectionTimeout)) {
+            if (!Ego.isPipelined() and !Ego.receiveSome(stats)) {
                 itrace("Request::receiveBody(%s) receive body failed: %s",
                        sock().id(), errno_s);
                 Ego._status = (errno == ETIMEDOUT)? http::RequestTimeout : http::InternalError;
                 Ego._flags.bodyError = 1;
                 break;
             }
-            stats.rxBytes += len;
 
-            if (!feed(stage, len)) {
+            if (!Ego.parseSome()) {
                 if (Ego._status == http::Ok)
                     Ego._status = http::BadRequest;
                 Ego._flags.bodyError = 1;
                 break;
             }
-
-            left -= len;
         } while (Ego._bodyComplete == 0);
 
         if ((Ego._status == http::Ok) and (Ego._bodyComplete == 0)) {
@@ -618,4 +678,58 @@ namespace suil::http::server {
 
         return HPE_OK;
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/net/tcp.hpp>
+
+namespace hs = suil::http::server;
+
+TEST_CASE("Server request pipelining", "[http][server][request]")
+{
+    auto addr = iplocal("127.0.0.1", 9308, 0);
+    suil::net::TcpServerSock server;
+    REQUIRE(server.listen(addr, 2));
+    suil::net::TcpSock client;
+    REQUIRE(client.connect(addr, 2000));
+    auto sock = server.accept(2000);
+    REQUIRE(sock != nullptr);
+
+    hs::HttpServerConfig config;
+    hs::HttpServerStats stats;
+    hs::Request req{*sock, config};
+
+    SECTION("Requests received with a single read are parsed one at a time") {
+        const std::string requests{
+            "GET /first HTTP/1.1\r\nHost: localhost\r\n\r\n"
+            "POST /second HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n\r\nhello"
+        };
+        REQUIRE(client.send(requests.data(), requests.size(), 2000) == requests.size());
+        REQUIRE(client.flush(2000));
+
+        REQUIRE(req.receiveHeaders(stats) == suil::http::Ok);
+        REQUIRE(req.receiveBody(stats) == suil::http::Ok);
+        REQUIRE(stats.rxBytes == requests.size());
+        REQUIRE(req.getMethod() == suil::http::Method::Get);
+        REQUIRE(req.url() == "/first");
+        // the second request is still in the receive buffer
+        REQUIRE(req.isPipelined());
+        req.clear();
+
+        REQUIRE(req.receiveHeaders(stats) == suil::http::Ok);
+        REQUIRE(req.receiveBody(stats) == suil::http::Ok);
+        // parsed from the receive buffer without reading the socket
+        REQUIRE(stats.rxBytes == requests.size());
+        REQUIRE(req.getMethod() == suil::http::Method::Post);
+        REQUIRE(req.url() == "/second");
+        REQUIRE(req.header("Content-Length") == "5");
+        REQUIRE(req.body() == "hello");
+        REQUIRE_FALSE(req.isPipelined());
+        req.clear();
+    }
+
+    sock->close();
+    client.close();
+    server.close();
+}
+#endif
@@ -154,7 +154,9 @@ namespace suil::http::server {
     void Response::clearContent()
     {
         Ego._chunks.clear();
-        Ego._body.clear();
+        Ego._chunksSize = 0;
+        // keep the memory, the response might be reused
+        Ego._body.reset(0, true);
         Ego._headers.erase("Content-Type");
     }
 
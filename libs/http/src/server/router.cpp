@@ -64,26 +64,25 @@ namespace suil::http::server {
             url = "/" SUIL_FILE_SERVER_ROUTE;
         }
 
-        auto params = Ego._trie.find(url);
-        if (params.first == 0) {
+        auto index = Ego._trie.match(url, req._params.decoded);
+        if (index == 0) {
             // route does not exist
             throw HttpError(http::NotFound);
         }
 
-        if (params.first >= Ego._rules.size()) {
+        if (index >= Ego._rules.size()) {
             throw HttpError(
                     http::InternalError,
                     "System error, contact system administrator");
         }
 
-        auto& rule = *Ego._rules[params.first];
+        auto& rule = *Ego._rules[index];
         if (!rule._attrs.Enabled) {
             throw HttpError(http::NotFound);
         }
 
         // update request with parameters
-        req._params.index = params.first;
-        req._params.decoded = std::move(params.second);
+        req._params.index = index;
         req._params.attrs = &rule._attrs;
         req._params.methods =  rule.getMethods();
         req._params.routeId = rule.id();
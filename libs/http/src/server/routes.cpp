@@ -26,6 +26,7 @@ namespace suil::http::server {
     void RequestParams::clear()
     {
         Ego.attrs = nullptr;
-        Ego.decoded.clear();
+        // keep the memory, it's reused when decoding the next request's parameters
+        Ego.decoded.reset();
     }
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include "suil/http/server/trie.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <climits>
 #include <iostream>
 
 namespace suil::http::server {
@@ -106,6 +109,7 @@ namespace suil::http::server {
         tmp.front()._index = Ego._nodes.front()._index;
         tmp.front()._paramChildren = Ego._nodes.front()._paramChildren;
         Ego._nodes = std::move(tmp);
+        compile();
     }
 
     void RoutesTrie::gather(std::vector<Node>& dst, Node& node)
@@ -130,6 +134,369 @@ namespace suil::http::server {
         dst[at]._paramChildren = node._paramChildren;
     }
 
+    unsigned RoutesTrie::compileBound(unsigned node, unsigned& params)
+    {
+        // computes the number of match alternatives that can be pending on the stack while
+        // matching below the given node, along with the smallest route index reachable
+        // from the node (used to prune the search)
+        auto& flat = Ego._flat[node];
+        unsigned alts{0}, bound{0}, maxParams{0};
+        auto minIndex = flat._index? flat._index : UINT_MAX;
+        for (auto child: flat._params) {
+            if (child == 0) continue;
+            unsigned p{0};
+            alts++;
+            bound = std::max(bound, compileBound(child, p));
+            maxParams = std::max(maxParams, p + 1);
+            minIndex = std::min(minIndex, Ego._flat[child]._minIndex);
+        }
+        if (flat._nedges) {
+            // static fragments of a node start with distinct bytes, a single one can match
+            alts++;
+        }
+        for (unsigned i = 0; i < flat._nedges; i++) {
+            unsigned p{0};
+            auto child = Ego._edges[flat._edges + i]._child;
+            bound = std::max(bound, compileBound(child, p));
+            maxParams = std::max(maxParams, p);
+            minIndex = std::min(minIndex, Ego._flat[child]._minIndex);
+        }
+        Ego._flat[node]._minIndex = minIndex;
+        params = maxParams;
+        return alts? std::max(alts, alts - 1 + bound) : 0;
+    }
+
+    void RoutesTrie::compileEdges(unsigned node, const std::vector<std::pair<String, unsigned>>& items)
+    {
+        // fragments sharing the first byte are split on their common prefix, so that
+        // each node dispatches on the first byte to a single edge
+        std::vector<std::pair<String, unsigned>> edges;
+        std::vector<std::pair<unsigned, std::vector<std::pair<String, unsigned>>>> splits;
+        size_t i{0};
+        while (i < items.size()) {
+            auto j = i + 1;
+            while (j < items.size() and items[j].first[0] == items[i].first[0]) {
+                j++;
+            }
+            if ((j - i) == 1) {
+                edges.emplace_back(items[i].first.peek(), items[i].second);
+            }
+            else {
+                // items are sorted, the common prefix of the range is that of its ends
+                auto& x = items[i].first;
+                auto& y = items[j-1].first;
+                size_t lcp{0};
+                while (lcp < x.size() and lcp < y.size() and x[lcp] == y[lcp]) {
+                    lcp++;
+                }
+                auto split = unsigned(Ego._flat.size());
+                Ego._flat.emplace_back();
+                edges.emplace_back(String{x.data(), lcp, false}, split);
+                std::vector<std::pair<String, unsigned>> rest;
+                for (auto k = i; k < j; k++) {
+                    auto& frag = items[k].first;
+                    rest.emplace_back(String{frag.data() + lcp, frag.size() - lcp, false}, items[k].second);
+                }
+                splits.emplace_back(split, std::move(rest));
+            }
+            i = j;
+        }
+
+        auto& flat = Ego._flat[node];
+        flat._edges = unsigned(Ego._edges.size());
+        flat._nedges = uint16_t(edges.size());
+        for (auto& [frag, child]: edges) {
+            Edge edge;
+            edge._fragment = unsigned(Ego._fragments.size());
+            edge._len = unsigned(frag.size());
+            edge._child = child;
+            edge._first = uint8_t(frag[0]);
+            Ego._fragments.insert(Ego._fragments.end(), frag.data(), frag.data() + frag.size());
+            Ego._edges.push_back(edge);
+        }
+
+        if (flat._nedges >= SUIL_ROUTER_DISPATCH_MIN) {
+            // wide nodes get a table mapping the first byte to the edge
+            flat._dispatch = unsigned(Ego._dispatch.size()) + 1;
+            Ego._dispatch.resize(Ego._dispatch.size() + 256, 0);
+            for (uint16_t e = 0; e < flat._nedges; e++) {
+                Ego._dispatch[flat._dispatch - 1 + Ego._edges[flat._edges + e]._first] = e + 1;
+            }
+        }
+
+        for (auto& [split, rest]: splits) {
+            compileEdges(split, rest);
+        }
+    }
+
+    void RoutesTrie::compile()
+    {
+        Ego._flat.clear();
+        Ego._edges.clear();
+        Ego._dispatch.clear();
+        Ego._fragments.clear();
+
+        // nodes are already gathered in depth first order, the compiled nodes use the
+        // same indices and nodes introduced when splitting fragments are appended
+        Ego._flat.resize(Ego._nodes.size());
+        std::vector<std::pair<String, unsigned>> items;
+        for (unsigned i = 0; i < Ego._nodes.size(); i++) {
+            auto& node = Ego._nodes[i];
+            Ego._flat[i]._index = node._index;
+            Ego._flat[i]._params = node._paramChildren;
+            for (int t = 0; t < int(crow::detail::ParamType::MAX); t++) {
+                if (node._paramChildren[t]) {
+                    Ego._flat[i]._paramMask |= uint8_t(1u << t);
+                }
+            }
+
+            items.clear();
+            for (auto& [k, v]: node._children) {
+                items.emplace_back(k.peek(), v);
+            }
+            std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+                auto cmp = memcmp(a.first.data(), b.first.data(), std::min(a.first.size(), b.first.size()));
+                return cmp < 0 or (cmp == 0 and a.first.size() < b.first.size());
+            });
+            compileEdges(i, items);
+        }
+
+        unsigned params{0};
+        auto bound = compileBound(0, params);
+        if (bound > SUIL_ROUTER_MATCH_STACK or params > SUIL_ROUTER_MAX_PARAMS) {
+            swarn("router routes need %u match slots and %u parameters, not compiling routes",
+                  bound, params);
+            Ego._flat.clear();
+            Ego._edges.clear();
+            Ego._dispatch.clear();
+            Ego._fragments.clear();
+        }
+    }
+
+    namespace {
+
+        struct Capture {
+            crow::detail::ParamType type;
+            union {
+                int64_t  i;
+                uint64_t u;
+                double   d;
+                struct {
+                    unsigned off;
+                    unsigned len;
+                } s;
+            };
+        };
+
+        struct Pending {
+            unsigned node;
+            unsigned pos;
+            unsigned depth;
+            bool     captured;
+            Capture  capture;
+        };
+
+        template <typename T>
+        bool parseInteger(const char* p, const char* end, T& out, const char*& eptr)
+        {
+            bool neg{false};
+            if (p != end and (*p == '+' or *p == '-')) {
+                neg = *p == '-';
+                p++;
+            }
+            uint64_t value{0};
+            auto start = p;
+            for (; p != end and *p >= '0' and *p <= '9'; p++) {
+                auto digit = uint64_t(*p - '0');
+                if (value > (UINT64_MAX - digit) / 10) {
+                    return false;
+                }
+                value = value * 10 + digit;
+            }
+            if (p == start) {
+                return false;
+            }
+            if constexpr (std::is_signed_v<T>) {
+                if (neg) {
+                    if (value > uint64_t(INT64_MAX) + 1) return false;
+                    out = T(-int64_t(value - 1) - 1);
+                }
+                else {
+                    if (value > uint64_t(INT64_MAX)) return false;
+                    out = T(value);
+                }
+            }
+            else {
+                if (neg) return false;
+                out = value;
+            }
+            eptr = p;
+            return true;
+        }
+
+        bool parseDouble(const char* p, const char* end, double& out, const char*& eptr)
+        {
+            // from_chars never reads past the url, but unlike strtod doesn't skip a leading '+'
+            auto start = (p != end and *p == '+')? p + 1 : p;
+            auto res = std::from_chars(start, end, out);
+            if (res.ec != std::errc{} or res.ptr == start) {
+                return false;
+            }
+            eptr = res.ptr;
+            return true;
+        }
+    }
+
+    unsigned RoutesTrie::match(const String& reqUrl, crow::detail::routing_params& params) const
+    {
+        using crow::detail::ParamType;
+        params.reset();
+        if (!Ego.compiled()) {
+            auto ret = const_cast<RoutesTrie&>(Ego).find(reqUrl, head(), 0, nullptr);
+            params = std::move(ret.second);
+            return ret.first;
+        }
+
+        const char* url = reqUrl.data();
+        const auto size = unsigned(reqUrl.size());
+        const char* end = url + size;
+
+        Pending stack[SUIL_ROUTER_MATCH_STACK];
+        Capture captures[SUIL_ROUTER_MAX_PARAMS];
+        Capture matched[SUIL_ROUTER_MAX_PARAMS];
+        unsigned top{0}, found{0}, nmatched{0};
+
+        stack[top++] = Pending{0, 0, 0, false, {}};
+        while (top > 0) {
+            auto pending = stack[--top];
+            auto at = pending.node;
+            auto pos = pending.pos;
+            auto depth = pending.depth;
+            if (pending.captured) {
+                captures[depth++] = pending.capture;
+            }
+
+            // static fragments are followed in place while parameters are pushed as alternatives
+            // to explore later, a route is reachable through a single path so the order in which
+            // the alternatives are explored does not change the route that is matched
+            while (true) {
+                auto& node = Ego._flat[at];
+                if (found and node._minIndex >= found) {
+                    // nothing better can be found down this path
+                    break;
+                }
+
+                if (pos == size) {
+                    if (node._index and (!found or node._index < found)) {
+                        found = node._index;
+                        nmatched = depth;
+                        memcpy(matched, captures, sizeof(Capture) * nmatched);
+                    }
+                    break;
+                }
+
+                if (node._paramMask) {
+                    auto push = [&](ParamType type, unsigned epos, Capture& capture) {
+                        capture.type = type;
+                        stack[top++] = Pending{node._params[int(type)], epos, depth, true, capture};
+                    };
+
+                    if (node._params[int(ParamType::PATH)]) {
+                        Capture cap{};
+                        cap.s = {pos, size - pos};
+                        push(ParamType::PATH, size, cap);
+                    }
+
+                    if (node._params[int(ParamType::STRING)]) {
+                        auto epos = pos;
+                        while (epos < size and url[epos] != '/') epos++;
+                        if (epos != pos) {
+                            Capture cap{};
+                            cap.s = {pos, epos - pos};
+                            push(ParamType::STRING, epos, cap);
+                        }
+                    }
+
+                    const char* eptr{nullptr};
+                    char c = url[pos];
+                    if (node._params[int(ParamType::DOUBLE)]) {
+                        Capture cap{};
+                        if (((c >= '0' and c <= '9') or c == '+' or c == '-' or c == '.') and
+                            parseDouble(&url[pos], end, cap.d, eptr))
+                        {
+                            push(ParamType::DOUBLE, unsigned(eptr - url), cap);
+                        }
+                    }
+
+                    if (node._params[int(ParamType::UINT)]) {
+                        Capture cap{};
+                        if (((c >= '0' and c <= '9') or c == '+') and
+                            parseInteger(&url[pos], end, cap.u, eptr))
+                        {
+                            push(ParamType::UINT, unsigned(eptr - url), cap);
+                        }
+                    }
+
+                    if (node._params[int(ParamType::INT)]) {
+                        Capture cap{};
+                        if (((c >= '0' and c <= '9') or c == '+' or c == '-') and
+                            parseInteger(&url[pos], end, cap.i, eptr))
+                        {
+                            push(ParamType::INT, unsigned(eptr - url), cap);
+                        }
+                    }
+                }
+
+                if (node._nedges == 0) {
+                    break;
+                }
+
+                auto first = uint8_t(url[pos]);
+                const Edge* edge{nullptr};
+                if (node._dispatch) {
+                    auto idx = Ego._dispatch[node._dispatch - 1 + first];
+                    if (idx) {
+                        edge = &Ego._edges[node._edges + idx - 1];
+                    }
+                }
+                else {
+                    for (unsigned i = 0; i < node._nedges; i++) {
+                        if (Ego._edges[node._edges + i]._first == first) {
+                            edge = &Ego._edges[node._edges + i];
+                            break;
+                        }
+                    }
+                }
+                if (edge == nullptr or edge->_len > (size - pos) or
+                    memcmp(&Ego._fragments[edge->_fragment], &url[pos], edge->_len) != 0)
+                {
+                    break;
+                }
+                at = edge->_child;
+                pos += edge->_len;
+            }
+        }
+
+        for (unsigned i = 0; i < nmatched; i++) {
+            auto& cap = matched[i];
+            switch (cap.type) {
+                case ParamType::INT:
+                    params.push(cap.i);
+                    break;
+                case ParamType::UINT:
+                    params.push(cap.u);
+                    break;
+                case ParamType::DOUBLE:
+                    params.push(cap.d);
+                    break;
+                default:
+                    params.push(reqUrl.substr(cap.s.off, cap.s.len));
+                    break;
+            }
+        }
+        return found;
+    }
+
     RouterParams RoutesTrie::find(
             const String& reqUrl,
             const Node* node,
@@ -279,6 +646,8 @@ namespace suil::http::server {
     void RoutesTrie::add(const String& url, unsigned int index)
     {
         unsigned idx{0};
+        // the compiled routes are stale once a route is added
+        Ego._flat.clear();
 
         for(unsigned i = 0; i < url.size(); i ++)
         {
@@ -442,5 +811,55 @@ TEST_CASE("RoutesTrie API's", "[http][http-server][routes-trie]")
         REQUIRE(params.second.string_params[0].str == "home");
         REQUIRE(params.second.string_params[1].str == "/home/carter");
     }
+
+    WHEN("Matching routes with the compiled matcher") {
+        unsigned index{1};
+        RoutesTrie trie;
+        trie.add("/", index++);
+        trie.add("/values/{int}", index++);
+        trie.add("/values/{double}", index++);
+        trie.add("/values/{string}", index++);
+        trie.add("/values/{uint}/add", index++);
+        trie.add("/files/{path}", index++);
+        trie.add("/files/list", index++);
+        trie.add("/users/{string}/roles/{int}", index++);
+        for (int i = 0; i < 40; i++) {
+            // enough siblings to use a dispatch table
+            trie.add(suil::catstr("/r", char('a' + (i % 26)), i, "/get"), index++);
+        }
+        trie.validate();
+        REQUIRE(trie.compiled());
+
+        const char* urls[] = {
+            "/", "/values/10", "/values/-10", "/values/1.5", "/values/abc", "/values/10/add",
+            "/values/+7/add", "/files/list", "/files/a/b/c", "/users/carter/roles/3",
+            "/users/carter/roles/x", "/ra0/get", "/rn13/get", "/rz25/get", "/ra1/get", "/unknown",
+            "/values/", "/values/99999999999999999999"
+        };
+        crow::detail::routing_params params;
+        for (auto url: urls) {
+            auto expected = trie.find(url, trie.head(), 0, nullptr);
+            auto found = trie.match(url, params);
+            REQUIRE(found == expected.first);
+            REQUIRE(params.int_params.back == expected.second.int_params.back);
+            REQUIRE(params.uint_params.back == expected.second.uint_params.back);
+            REQUIRE(params.double_params.back == expected.second.double_params.back);
+            REQUIRE(params.string_params.back == expected.second.string_params.back);
+            for (unsigned i = 0; i < params.string_params.back; i++) {
+                REQUIRE(params.string_params[i].str == expected.second.string_params[i].str);
+            }
+        }
+
+        REQUIRE(trie.match("/users/carter/roles/3", params) == 8);
+        REQUIRE(params.string_params[0].str == "carter");
+        REQUIRE(params.int_params[0] == 3);
+        auto mem = params.int_params.params;
+        REQUIRE(trie.match("/values/-10", params) == 2);
+        REQUIRE(params.int_params.back == 1);
+        REQUIRE(params.int_params[0] == -10);
+        REQUIRE(params.string_params.back == 0);
+        // memory is reused between lookups
+        REQUIRE(params.int_params.params == mem);
+    }
 }
 #endif
\ No newline at end of file
@@ -6,8 +6,10 @@
 
 #include <suil/base/base64.hpp>
 #include <suil/base/hash.hpp>
+#include <suil/base/ipc.hpp>
 #include <suil/base/uuid.hpp>
 
+#include <algorithm>
 #include <climits>
 
 #define WS_FRAME_HDR		2
@@ -17,23 +19,179 @@
 #define WS_PAYLOAD_EXTEND_1	126
 #define WS_PAYLOAD_EXTEND_2	127
 #define WS_OPCODE_MASK		0x0f
+// the number of queued frames written with a single system call
+#define WS_DRAIN_BATCH      16
 
 namespace {
     uint8_t sApiIndex{0};
     std::unordered_map<uint8_t, suil::http::WebSockApi&> sApis{};
     const suil::strview WsServerResponse{"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"};
+
+    /**
+     * The permessage-deflate parameters agreed on with a client
+     */
+    struct DeflateParams {
+        bool serverNoContextTakeover{false};
+        bool clientNoContextTakeover{false};
+        int  serverMaxWindowBits{15};
+        int  clientMaxWindowBits{15};
+    };
+
+    std::string_view trim(std::string_view sv)
+    {
+        while (!sv.empty() and isspace(sv.front())) sv.remove_prefix(1);
+        while (!sv.empty() and isspace(sv.back())) sv.remove_suffix(1);
+        return sv;
+    }
+
+    bool windowBits(std::string_view value, int& bits)
+    {
+        value = trim(value);
+        if (value.size() > 1 and value.front() == '"' and value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (value.empty() or value.size() > 2) {
+            return false;
+        }
+
+        int n{0};
+        for (auto c: value) {
+            if (!isdigit(c)) {
+                return false;
+            }
+            n = (n * 10) + (c - '0');
+        }
+        if (n < 8 or n > 15) {
+            return false;
+        }
+        bits = n;
+        return true;
+    }
+
+    /**
+     * Accepts the first permessage-deflate offer in the Sec-WebSocket-Extensions
+     * header that can be honoured with the given configuration (RFC 7692 section 7)
+     * @param offers the value of the Sec-WebSocket-Extensions header
+     * @param config the server side configuration
+     * @param params the accepted parameters
+     * @param response the extension negotiation response
+     * @return true if an offer was accepted
+     */
+    bool negotiateDeflate(
+            const suil::String& offers,
+            const suil::http::server::WebSockDeflate& config,
+            DeflateParams& params,
+            suil::Buffer& response)
+    {
+        std::string_view all{offers.data(), offers.size()};
+        while (!all.empty()) {
+            auto pos = all.find(',');
+            auto offer = all.substr(0, pos);
+            all = (pos == std::string_view::npos)? std::string_view{} : all.substr(pos + 1);
+
+            pos = offer.find(';');
+            if (trim(offer.substr(0, pos)) != "permessage-deflate") {
+                continue;
+            }
+            offer = (pos == std::string_view::npos)? std::string_view{} : offer.substr(pos + 1);
+
+            DeflateParams p{
+                config.serverNoContextTakeover,
+                config.clientNoContextTakeover,
+                std::clamp(int(config.serverMaxWindowBits), 9, 15),
+                15
+            };
+            bool valid{true}, serverBits{false}, clientBits{false};
+            uint8_t seen{0};
+            while (valid and !offer.empty()) {
+                pos = offer.find(';');
+                auto param = offer.substr(0, pos);
+                offer = (pos == std::string_view::npos)? std::string_view{} : offer.substr(pos + 1);
+
+                auto eq = param.find('=');
+                auto name = trim(param.substr(0, eq));
+                auto value = (eq == std::string_view::npos)? std::string_view{} : param.substr(eq + 1);
+                uint8_t id{0};
+                if (name == "server_no_context_takeover" and eq == std::string_view::npos) {
+                    id = 0x01;
+                    p.serverNoContextTakeover = true;
+                }
+                else if (name == "client_no_context_takeover" and eq == std::string_view::npos) {
+                    id = 0x02;
+                    p.clientNoContextTakeover = true;
+                }
+                else if (name == "server_max_window_bits") {
+                    id = 0x04;
+                    int bits{15};
+                    // zlib cannot produce raw deflate streams with a window of 8 bits
+                    valid = windowBits(value, bits) and bits > 8;
+                    p.serverMaxWindowBits = std::min(p.serverMaxWindowBits, bits);
+                    serverBits = true;
+                }
+                else if (name == "client_max_window_bits") {
+                    id = 0x08;
+                    int bits{15};
+                    valid = (eq == std::string_view::npos) or windowBits(value, bits);
+                    p.clientMaxWindowBits = bits;
+                    clientBits = true;
+                }
+                else {
+                    valid = false;
+                }
+
+                // parameters cannot be repeated
+                valid = valid and !(seen & id);
+                seen |= id;
+            }
+
+            if (!valid) {
+                continue;
+            }
+
+            response << "permessage-deflate";
+            if (p.serverNoContextTakeover) {
+                response << "; server_no_context_takeover";
+            }
+            if (p.clientNoContextTakeover) {
+                response << "; client_no_context_takeover";
+            }
+            if (serverBits or p.serverMaxWindowBits < 15) {
+                response << "; server_max_window_bits=" << p.serverMaxWindowBits;
+            }
+            if (clientBits and config.clientMaxWindowBits < 15) {
+                // the client only accepts a smaller window if it offered the parameter
+                p.clientMaxWindowBits = std::clamp(int(config.clientMaxWindowBits), 8, p.clientMaxWindowBits);
+                response << "; client_max_window_bits=" << p.clientMaxWindowBits;
+            }
+            else {
+                // the client can use any window size
+                p.clientMaxWindowBits = 15;
+            }
+            params = p;
+            return true;
+        }
+
+        return false;
+    }
 }
 
 namespace suil::http {
 
-    WebSockApi::WebSockApi(int64 timeout, bool blockingBroadcast)
+    WebSockApi::WebSockApi(int64 timeout, bool blockingBroadcast, size_t maxQueued, SlowConsumer slowConsumer)
         : _timeout{timeout},
-          _blockingBroadcast{blockingBroadcast}
+          _blockingBroadcast{blockingBroadcast},
+          _maxQueued{maxQueued},
+          _slowConsumer{slowConsumer}
     {
         Ego._id = sApiIndex++;
         sApis.emplace(Ego._id, *this);
     }
 
+    void WebSockApi::perMessageDeflate(server::WebSockDeflate config)
+    {
+        Ego._deflate = std::move(config);
+    }
+
     std::shared_ptr<WebSock> WebSockApi::find(const String& uuid)
     {
         auto it = Ego._webSocks.find(uuid);
@@ -50,28 +208,56 @@ namespace suil::http {
             chs(ch, bool, result);
     }
 
-    void WebSockApi::broadcast(WebSock* src, const void* data, size_t size)
+    void WebSockApi::broadcast(WebSock* src, const WsFrame& frame)
     {
-        strace("WebSockApi::broadcast src %p, data %p, size %lu",
-               src, data, size);
+        strace("WebSockApi::broadcast src %p, frame %p, size %lu",
+               src, frame.get(), frame->size());
 
-        auto msg = reinterpret_cast<const WsockBcastMsg *>(data);
+        // starting a drain coroutine switches to it, use a snapshot as sockets
+        // might be disconnected while visiting them
+        size_t dropped{0};
         auto snap = Ego.snapshot();
         for (auto& weak : snap) {
             auto ws = weak.lock();
-            if (ws == nullptr) {
+            if (ws == nullptr or ws.get() == src) {
                 continue;
             }
 
-            if (ws.get() != src) {
-                auto& wsock = *ws;
-                if (!wsock.broadcastSend(msg->payload, msg->len)) {
-                    ltrace(&wsock, "sending web socket message failed");
-                }
+            if (!ws->enqueue(frame)) {
+                dropped++;
             }
         }
 
-        strace("web socket broadcast completed %ld", mnow());
+        if (dropped) {
+            strace("web socket broadcast not queued on %zu slow web sockets", dropped);
+        }
+        strace("web socket broadcast queued %ld", mnow());
+    }
+
+    void WebSockApi::registerIpc()
+    {
+        static bool registered{false};
+        if (registered) {
+            return;
+        }
+        registered = true;
+
+        // receive broadcasts from the web sockets connected to other workers
+        ipc::registerHandler(IPC_WSOCK_BCAST, [](uint8 src, uint8 *data, size_t len, bool) {
+            auto msg = reinterpret_cast<const WsockBcastMsg *>(data);
+            if (len < sizeof(WsockBcastMsg) or (sizeof(WsockBcastMsg) + msg->len) > len) {
+                swarn("received an invalid web socket broadcast message from %hhu", src);
+                return false;
+            }
+
+            auto it = sApis.find(msg->api_id);
+            if (it != sApis.end() and it->second._totalSocks > 0) {
+                Buffer b{msg->len};
+                b.append(msg->payload, msg->len);
+                it->second.broadcast(nullptr, std::make_shared<const Buffer>(std::move(b)));
+            }
+            return false;
+        });
     }
 
     WebSockApi::WebSockSnapshot WebSockApi::snapshot()
@@ -138,14 +324,37 @@ namespace suil::http {
         resp.header("Connection", "Upgrade");
         resp.header("Sec-WebSocket-Accept", std::move(encoded));
 
+        DeflateParams params{};
+        bool deflate{false};
+        if (api._deflate.enabled) {
+            Buffer ext{64};
+            deflate = negotiateDeflate(req.header("Sec-WebSocket-Extensions"), api._deflate, params, ext);
+            if (deflate) {
+                resp.header("Sec-WebSocket-Extensions", String{ext});
+            }
+        }
+
         // end the Response by the handler
         resp.end(
-        [&api, size, created = std::move(onSockCreated)](server::Request &rq, server::Response &rs) {
+        [&api, size, deflate, params, created = std::move(onSockCreated)](server::Request &rq, server::Response &rs) {
             // clear the Request to free resources
             rq.clear();
 
             // Create a web socket
             std::shared_ptr<WebSock> ws{new WebSock(rq.sock(), api, size)};
+            if (deflate) {
+                auto& config = api._deflate;
+                ws->_deflater = std::make_unique<Deflater>(
+                        params.serverMaxWindowBits,
+                        !params.serverNoContextTakeover,
+                        config.level,
+                        config.memLevel);
+                ws->_inflater = std::make_unique<Inflater>(
+                        // zlib needs at least 9 bits, a larger window inflates smaller windows
+                        std::max(params.clientMaxWindowBits, 9),
+                        !params.clientNoContextTakeover,
+                        config.maxMessageSize);
+            }
             // notify API that websocket has been created
             if (created)
                 created(*ws);
@@ -175,7 +384,10 @@ namespace suil::http {
             return false;
         }
 
-        if (h.rsv1 || h.rsv2 || h.rsv3) {
+        // the first frame of a compressed message has the RSV1 bit set
+        bool compressed = h.rsv1 and Ego._inflater and
+                          (h.opcode == WsOp::Text or h.opcode == WsOp::Binary);
+        if ((h.rsv1 and !compressed) || h.rsv2 || h.rsv3) {
             idebug("%s - receive has RSV bits set %d:%d:%d",
                    Ego._sock.id(), h.rsv1, h.rsv2, h.rsv3);
             return false;
@@ -232,6 +444,10 @@ namespace suil::http {
             len = (uint8) h.len;
         }
         h.payloadSize = len;
+        if (compressed and Ego._api._deflate.maxMessageSize and len > Ego._api._deflate.maxMessageSize) {
+            idebug("%s - compressed frame of %zu bytes too large", Ego._sock.id(), len);
+            return false;
+        }
         // receive the mask
         nbytes = WS_MASK_LEN;
         if (!Ego._sock.receive(h.v_mask, nbytes, Ego._api._timeout)) {
@@ -276,6 +492,9 @@ namespace suil::http {
             }
         }
 
+        // broadcasts from other workers are only received by workers with web sockets
+        WebSockApi::registerIpc();
+
         Ego._uuid = suil::uuidstr();
         {
             mill::Lock lk{Ego._api._mutex};
@@ -306,7 +525,20 @@ namespace suil::http {
 
                     case WsOp::Text:
                     case WsOp::Binary:
-                            if (Ego._api.onMessage) {
+                            if (h.rsv1) {
+                                // permessage-deflate compressed message
+                                Ego._inflated.clear();
+                                if (!Ego._inflater->inflate(Ego._inflated, b.data(), b.size())) {
+                                    idebug("%s - inflating web socket message failed", Ego._sock.id());
+                                    Ego._endSession = true;
+                                    break;
+                                }
+                                if (Ego._api.onMessage) {
+                                    (char*) Ego._inflated;
+                                    Ego._api.onMessage(*this, Ego._inflated, (WsOp) h.opcode);
+                                }
+                            }
+                            else if (Ego._api.onMessage) {
                                 // one way of appending null at end of string
                                 (char*) b;
                                 Ego._api.onMessage(*this, b, (WsOp) h.opcode);
@@ -343,18 +575,11 @@ namespace suil::http {
         }
     }
 
-    bool WebSock::send(const void* data, size_t size, WsOp op)
+    uint8 WebSock::encodeHeader(uint8 (&hbuf)[14], size_t size, uint8 op, bool rsv1)
     {
         uint8 payload_1;
-        uint8 hbuf[14] = {0};
         uint8 hlen = WS_FRAME_HDR;
 
-        if (Ego._endSession) {
-            itrace("%s - sending while Session is closing is not allow",
-                   Ego._sock.id());
-            return false;
-        }
-
         if (size > WS_PAYLOAD_SINGLE) {
             payload_1 = uint8((size < USHRT_MAX)?
                                    WS_PAYLOAD_EXTEND_1 : WS_PAYLOAD_EXTEND_2);
@@ -366,6 +591,7 @@ namespace suil::http {
         h.u16All  = 0;
         h.opcode  = (op & WS_OPCODE_MASK);
         h.fin     = 1;
+        h.rsv1    = rsv1;
         h.len     = (payload_1 & uint8(~(1<<7)));
 
         if (payload_1 > WS_PAYLOAD_SINGLE) {
@@ -380,11 +606,39 @@ namespace suil::http {
             }
         }
 
+        return hlen;
+    }
+
+    bool WebSock::send(const void* data, size_t size, WsOp op)
+    {
+        uint8 hbuf[14] = {0};
+
+        if (Ego._endSession) {
+            itrace("%s - sending while Session is closing is not allow",
+                   Ego._sock.id());
+            return false;
+        }
+
         Ego._mutex.acquire();
         defer({
             Ego._mutex.release();
         });
 
+        Buffer compressed{0};
+        bool rsv1{false};
+        if (Ego._deflater and (op == WsOp::Text or op == WsOp::Binary) and
+            size >= Ego._api._deflate.minSize)
+        {
+            // compressed within the lock as the context is shared by consecutive messages
+            if (Ego._deflater->deflate(compressed, data, size)) {
+                data = compressed.data();
+                size = compressed.size();
+                rsv1 = true;
+            }
+        }
+
+        auto hlen = encodeHeader(hbuf, size, op, rsv1);
+
         // send header
         if (Ego._sock.send(hbuf, hlen, Ego._api._timeout) != hlen) {
             itrace("%s - sending header of length %hhu failed: %s",
@@ -402,89 +656,290 @@ namespace suil::http {
         return Ego._sock.flush(Ego._api._timeout);
     }
 
-    bool WebSock::broadcastSend(const void* data, size_t len)
+    WsFrame WebSock::frame(const void* data, size_t sz, WsOp op)
+    {
+        uint8 hbuf[14] = {0};
+        auto hlen = encodeHeader(hbuf, sz, op);
+        Buffer b{hlen + sz};
+        b.append(hbuf, hlen);
+        b.append(data, sz);
+        return std::make_shared<const Buffer>(std::move(b));
+    }
+
+    bool WebSock::enqueue(const WsFrame& frame)
+    {
+        if (Ego._endSession or !Ego._sock.isOpen()) {
+            return false;
+        }
+
+        if (Ego._queue.size() >= Ego._api._maxQueued) {
+            if (Ego._api._slowConsumer == WebSockApi::Disconnect) {
+                // the web socket cannot keep up, end the session
+                idebug("%s - disconnecting slow web socket, %zu frames queued",
+                       Ego._uuid(), Ego._queue.size());
+                Ego._queue.clear();
+                Ego._endSession = true;
+                // wakes up the coroutines blocked on the socket, the connection
+                // closes it once the session loop exits
+                Ego._sock.shutdown();
+            }
+            else {
+                itrace("%s - dropping frame, %zu frames queued", Ego._uuid(), Ego._queue.size());
+            }
+            return false;
+        }
+
+        Ego._queue.push_back(frame);
+        if (!Ego._draining) {
+            Ego._draining = true;
+            go(drain(shared_from_this()));
+        }
+        return true;
+    }
+
+    bool WebSock::broadcastSend()
     {
         if (!Ego._sock.isOpen()) {
             iwarn("attempting to send to a closed websocket");
             return false;
         }
 
-        size_t totalSent = 0;
         Ego._mutex.acquire();
         defer({
            Ego._mutex.release();
         });
 
-        do {
-            auto sent = Ego._sock.send(data, len, Ego._api._timeout);
-            if (!sent) {
+        while (!Ego._queue.empty() and !Ego._endSession) {
+            // write as many queued frames as possible with a single call
+            WsFrame frames[WS_DRAIN_BATCH];
+            struct iovec iov[WS_DRAIN_BATCH];
+            int count{0};
+            size_t total{0};
+            while (count < WS_DRAIN_BATCH and !Ego._queue.empty()) {
+                frames[count] = std::move(Ego._queue.front());
+                Ego._queue.pop_front();
+                iov[count].iov_base = frames[count]->data();
+                iov[count].iov_len  = frames[count]->size();
+                total += iov[count].iov_len;
+                count++;
+            }
+
+            if (Ego._sock.sendv(iov, count, Ego._api._timeout) != total) {
                 itrace("sending websocket data failed: %s", errno_s);
                 return false;
             }
+        }
 
-            totalSent += sent;
-        } while (totalSent < len);
+        return true;
+    }
 
-        return Ego._sock.flush(Ego._api._timeout);
+    void WebSock::drain(std::shared_ptr<WebSock> ws)
+    {
+        auto& S = *ws;
+        if (!S.broadcastSend()) {
+            // could not send to web socket, end session
+            S._queue.clear();
+            S._endSession = true;
+        }
+        S._draining = false;
     }
 
     void WebSock::broadcast(const void* data, size_t sz, WsOp op)
     {
         itrace("WebSock::broadcast data %p, sz %lu, op 0x%02X", data, sz, op);
 
-        // only broadcast when there are other web socket clients
-        if (Ego._api._totalSocks > 0) {
+        // the frame is encoded once and shared by all recipients
+        auto frm = WebSock::frame(data, sz, op);
+        if (Ego._api._totalSocks > 1) {
             itrace("broadcasting %lu web sockets", Ego._api._totalSocks);
-            auto copy = (uint8 *) malloc(
-                    sizeof(WsockBcastMsg) + sz + 16);
-            auto msg = reinterpret_cast<WsockBcastMsg *>(copy);
+            Ego._api.broadcast(this, frm);
+        }
 
-            uint8 payload_1;
-            uint8 hlen = WS_FRAME_HDR;
+        // forward to the web sockets connected to other workers
+        Buffer msg{sizeof(WsockBcastMsg) + frm->size()};
+        WsockBcastMsg hdr{Ego._api._id, frm->size()};
+        msg.append(&hdr, sizeof(hdr));
+        msg.append(frm->data(), frm->size());
+        ipc::broadcast(IPC_WSOCK_BCAST, msg);
+    }
+}
 
-            if (sz > WS_PAYLOAD_SINGLE) {
-                payload_1 = uint8((sz < USHRT_MAX)?
-                                       WS_PAYLOAD_EXTEND_1 : WS_PAYLOAD_EXTEND_2);
-            }
-            else {
-                payload_1 = uint8(sz);
-            }
-            auto h = (header &) msg->payload;
-            h.u16All  = 0;
-            h.opcode  = (op & WS_OPCODE_MASK);
-            h.fin     = 1;
-            h.len     = (payload_1 & uint8(~(1<<7)));
-
-            if (payload_1 > WS_PAYLOAD_SINGLE) {
-                uint8_t *p = ((uint8_t *) msg->payload) + hlen;
-                if (payload_1 == WS_PAYLOAD_EXTEND_1) {
-                    suil::wr<uint16>(p, uint16(sz));
-                    hlen += sizeof(uint16);
-                }
-                else {
-                    suil::wr<uint64>(p, uint64(sz));
-                    hlen += sizeof(uint64);
-                }
-            }
-            uint8 *tmp = &msg->payload[hlen];
-            memcpy(tmp, data, sz);
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/net/tcp.hpp>
 
-            msg->len = sz + hlen;
-            msg->api_id = Ego._api._id;
-            // the copied buffer now belongs to the go-routine
-            // being scheduled
-            size_t len = sizeof(WsockBcastMsg)+msg->len;
-            go(broadcast(shared_from_this(), Ego._api, copy, len));
-        }
+namespace {
+
+    coroutine void wsBlockedReceive(suil::net::Socket& sock, suil::Channel<int>& done)
+    {
+        char c{0};
+        size_t len{1};
+        done << int(sock.receive(&c, len, 5000));
     }
+}
 
-    void WebSock::broadcast(std::shared_ptr<WebSock> ws, WebSockApi& api, void* data, size_t size)
+namespace {
+
+    bool wsNegotiate(
+            const char* offers,
+            const suil::http::server::WebSockDeflate& config,
+            DeflateParams& params,
+            std::string& response)
     {
-        strace("WebSock::broadcast data %p size %lu", data, size);
-        // use the api to broadcast to all connected web sockets
-        api.broadcast(ws.get(), data, size);
-        // free the allocated memory
-        strace("done broadcasting message %p", data);
-        free(data);
+        suil::Buffer ext{64};
+        auto accepted = negotiateDeflate(suil::String{offers}, config, params, ext);
+        response = std::string{static_cast<const char *>(ext.data()), ext.size()};
+        return accepted;
+    }
+}
+
+TEST_CASE("WebSock permessage-deflate negotiation", "[http][websock]")
+{
+    suil::http::server::WebSockDeflate config;
+    config.enabled = true;
+    DeflateParams params{};
+    std::string response;
+
+    SECTION("Offers without parameters use the configuration") {
+        REQUIRE(wsNegotiate("permessage-deflate", config, params, response));
+        REQUIRE(response == "permessage-deflate");
+        REQUIRE_FALSE(params.serverNoContextTakeover);
+        REQUIRE_FALSE(params.clientNoContextTakeover);
+        REQUIRE(params.serverMaxWindowBits == 15);
+        REQUIRE(params.clientMaxWindowBits == 15);
+
+        config.serverNoContextTakeover = true;
+        config.serverMaxWindowBits = 10;
+        REQUIRE(wsNegotiate("permessage-deflate", config, params, response));
+        REQUIRE(response == "permessage-deflate; server_no_context_takeover; server_max_window_bits=10");
+        REQUIRE(params.serverNoContextTakeover);
+        REQUIRE(params.serverMaxWindowBits == 10);
+    }
+
+    SECTION("Offered parameters are accepted") {
+        REQUIRE(wsNegotiate("permessage-deflate; server_no_context_takeover", config, params, response));
+        REQUIRE(response == "permessage-deflate; server_no_context_takeover");
+        REQUIRE(params.serverNoContextTakeover);
+        REQUIRE_FALSE(params.clientNoContextTakeover);
+
+        REQUIRE(wsNegotiate("permessage-deflate;client_no_context_takeover", config, params, response));
+        REQUIRE(response == "permessage-deflate; client_no_context_takeover");
+        REQUIRE_FALSE(params.serverNoContextTakeover);
+        REQUIRE(params.clientNoContextTakeover);
+
+        REQUIRE(wsNegotiate("permessage-deflate; server_max_window_bits=\"10\"", config, params, response));
+        REQUIRE(response == "permessage-deflate; server_max_window_bits=10");
+        REQUIRE(params.serverMaxWindowBits == 10);
+
+        // the client window is only limited when the client offers the parameter
+        config.clientMaxWindowBits = 10;
+        REQUIRE(wsNegotiate("permessage-deflate", config, params, response));
+        REQUIRE(response == "permessage-deflate");
+        REQUIRE(params.clientMaxWindowBits == 15);
+        REQUIRE(wsNegotiate("permessage-deflate; client_max_window_bits", config, params, response));
+        REQUIRE(response == "permessage-deflate; client_max_window_bits=10");
+        REQUIRE(params.clientMaxWindowBits == 10);
+        REQUIRE(wsNegotiate("permessage-deflate; client_max_window_bits=9", config, params, response));
+        REQUIRE(response == "permessage-deflate; client_max_window_bits=9");
+        REQUIRE(params.clientMaxWindowBits == 9);
+    }
+
+    SECTION("Invalid offers are rejected") {
+        const char* offers[] = {
+            "",
+            "x-webkit-deflate-frame",
+            "permessage-deflate; unknown_parameter",
+            "permessage-deflate; server_no_context_takeover=1",
+            "permessage-deflate; server_no_context_takeover; server_no_context_takeover",
+            // zlib cannot produce raw deflate streams with a window of 8 bits
+            "permessage-deflate; server_max_window_bits=8",
+            "permessage-deflate; server_max_window_bits=16",
+            "permessage-deflate; server_max_window_bits",
+            "permessage-deflate; client_max_window_bits=7",
+            "permessage-deflate; client_max_window_bits=abc"
+        };
+        for (auto offer: offers) {
+            suil::Buffer ext{64};
+            REQUIRE_FALSE(negotiateDeflate(suil::String{offer}, config, params, ext));
+            REQUIRE(ext.empty());
+        }
+    }
+
+    SECTION("The first acceptable offer is accepted") {
+        REQUIRE(wsNegotiate(
+                "x-webkit-deflate-frame, permessage-deflate; server_max_window_bits=8, "
+                "permessage-deflate; server_no_context_takeover, permessage-deflate",
+                config, params, response));
+        REQUIRE(response == "permessage-deflate; server_no_context_takeover");
+        REQUIRE(params.serverNoContextTakeover);
     }
 }
+
+TEST_CASE("WebSock send queue", "[http][websock]")
+{
+    using suil::http::WebSock;
+    using suil::http::WebSockApi;
+
+    suil::net::TcpServerSock server;
+    auto addr = iplocal("127.0.0.1", 9305, 0);
+    REQUIRE(server.listen(addr, 2));
+    suil::net::TcpSock client;
+    REQUIRE(client.connect(addr, 2000));
+    auto sock = server.accept(2000);
+    REQUIRE(sock != nullptr);
+
+    auto frame = WebSock::frame("hello", 5, WebSock::Text);
+    WHEN("The slow consumer policy is Drop") {
+        WebSockApi api{1000, true, 2, WebSockApi::Drop};
+        std::shared_ptr<WebSock> ws{new WebSock(*sock, api)};
+        // keep frames queued as if the web socket could not keep up
+        ws->_draining = true;
+        REQUIRE(ws->enqueue(frame));
+        REQUIRE(ws->enqueue(frame));
+        REQUIRE_FALSE(ws->enqueue(frame));
+        REQUIRE(ws->_queue.size() == 2);
+        REQUIRE_FALSE(ws->_endSession);
+        REQUIRE(sock->isOpen());
+
+        // queued frames are written in order once drained
+        ws->_draining = false;
+        REQUIRE(ws->broadcastSend());
+        REQUIRE(ws->_queue.empty());
+        char buf[16];
+        size_t len{frame->size() * 2};
+        REQUIRE(client.receive(buf, len, 2000));
+        REQUIRE(len == frame->size() * 2);
+        REQUIRE(memcmp(buf, frame->data(), frame->size()) == 0);
+        REQUIRE(memcmp(&buf[frame->size()], frame->data(), frame->size()) == 0);
+    }
+
+    WHEN("The slow consumer policy is Disconnect") {
+        WebSockApi api{1000, true, 2, WebSockApi::Disconnect};
+        std::shared_ptr<WebSock> ws{new WebSock(*sock, api)};
+        ws->_draining = true;
+        suil::Channel<int> done{-1};
+        // the session loop is blocked receiving from the web socket
+        go(wsBlockedReceive(*sock, done));
+
+        REQUIRE(ws->enqueue(frame));
+        REQUIRE(ws->enqueue(frame));
+        REQUIRE_FALSE(ws->enqueue(frame));
+        REQUIRE(ws->_queue.empty());
+        REQUIRE(ws->_endSession);
+        // the blocked reader wakes up and the peer sees the connection end
+        int received{-1};
+        done >> received;
+        REQUIRE(received == 0);
+        char c{0};
+        size_t len{1};
+        REQUIRE_FALSE(client.receive(&c, len, 2000));
+        // sessions that are ending do not queue frames
+        REQUIRE_FALSE(ws->enqueue(frame));
+        ws->_draining = false;
+    }
+
+    sock->close();
+    client.close();
+    server.close();
+}
+#endif
@@ -68,7 +68,9 @@ int main(int argc, char *argv[])
             suil::env("POSTGRES_CONN", DEFAULT_POSTGRES_CONN),
             opt(ASYNC,   true),   // connections are async
             opt(TIMEOUT, 10_sec),  // timeout on db transactions
-            opt(EXPIRES, 30_sec)  // connections are cached for 30 seconds
+            opt(EXPIRES, 30_sec),  // connections are cached for 30 seconds
+            opt(PREPARED, true),  // statements are prepared once per connection
+            opt(BINARY,  true)    // results are received in binary format
     );
 
 #if SUIL_BENCH_DEV == 1
@@ -112,12 +114,16 @@ int main(int argc, char *argv[])
         int count = std::max(1, std::min(*queries, 500));
 
         scoped(conn, ep.context<PgSqlMiddleware>(req).conn());
-        std::vector<World> objects(count);
-        WorldOrm orm("World", conn);
-        for (auto& obj: objects) {
-            orm.find(opt(id, randnum()), obj);
+        std::vector<int> ids(count);
+        for (auto& i: ids) {
+            i = randnum();
         }
 
+        std::vector<World> objects;
+        WorldOrm orm("World", conn);
+        // queries are pipelined, all sent before waiting for results
+        orm.findMany(var(id), ids, objects);
+
         resp.append(objects);
         resp.end();
     });
@@ -130,12 +136,15 @@ int main(int argc, char *argv[])
         int count = std::max(1, std::min(*queries, 500));
 
         scoped(conn, ep.context<PgSqlMiddleware>(req).conn());
-        std::vector<World> objects(count);
+        std::vector<int> ids(count);
+        for (auto& i: ids) {
+            i = randnum();
+        }
 
+        std::vector<World> objects;
         WorldOrm orm("World", conn);
-
+        orm.findMany(var(id), ids, objects);
         for (auto& obj: objects) {
-            orm.find(opt(id, randnum()), obj);
             obj.randomNumber = randnum();
         }
 
@@ -146,9 +155,7 @@ int main(int argc, char *argv[])
             // Sorting transactions to avoid postgres deadlock
             std::sort(objects.begin(), objects.end(),
                       [](const World& a, const World& b) { return a.id < b.id; });
-            for (auto& obj: objects) {
-                orm.update(obj);
-            }
+            orm.updateMany(objects);
 
             txn.commit();
         }
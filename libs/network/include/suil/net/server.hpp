@@ -19,7 +19,7 @@ namespace suil::net {
     ServerSocket::UPtr createAdaptor(const SocketConfig& config);
     bool adaptorListen(ServerSocket& adaptor, const SocketConfig& config, int backlog);
     String getAddress(const SocketConfig& config);
-    using Postfork = std::function<void(uint32)>;
+    bool canReusePort(const SocketConfig& config);
 
     template <typename Handler, class Context = void>
     class Server: LOGGER(SERVER) {
@@ -38,6 +38,7 @@ namespace suil::net {
             if (Adaptor == nullptr) {
                 // create socket adaptor
                 Adaptor = createAdaptor(mConfig.socketConfig);
+                Adaptor->reusePort(mReusePort);
             }
             auto addr = getAddress(mConfig.socketConfig);
 
@@ -55,71 +56,21 @@ namespace suil::net {
             return true;
         }
 
-        // template <typename... Opts>
-        // int start(Opts... opts) {
-        //     struct {
-        //         uint32 nprocs{0};
-        //         Postfork postfork{nullptr};
-        //     } config;
-
-        //     if ((Adaptor == nullptr) || !Adaptor->isRunning()) {
-        //         // create socket adaptor
-        //         if (!listen()) {
-        //             return errno;
-        //         }
-        //     }
-        //     applyConfig(config, std::forward<Opts>(opts)...);
-
-        //     if (config.nprocs == 0) {
-        //         // By default the server will use all the available CPU threads
-        //         config.nprocs = sysconf(_SC_NPROCESSORS_ONLN);
-        //     }
-
-        //     if (config.nprocs == 1) {
-        //         int status = accept();
-        //         idebug("Server exiting {status=%d}", status);
-        //         return status;
-        //     }
-
-        //     idebug("Server starting %u workers", config.nprocs);
-
-        //     for (uint32 i = 0; i < config.nprocs; i++) {
-        //         auto pid = mfork();
-        //         if (pid > 0) {
-        //             idebug("Server worker-%u started {pid=%d}", i, pid);
-        //             continue;
-        //         }
-
-        //         prctl(PR_SET_PDEATHSIG, SIGHUP);
-
-        //         if (config.postfork) {
-        //             config.postfork(i);
-        //         }
-
-        //         int status = accept();
-        //         idebug("Server worker-%u exiting {status=%d}", i, status);
-        //         return status;
-        //     }
-
-        //     // Wait for all workers to exit
-        //     int ret = EXIT_SUCCESS;
-        //     while (true) {
-        //         int status = EXIT_SUCCESS;
-        //         auto pid = wait(&status);
-        //         if (pid <= 0) {
-        //             idebug("What the hell happened? %d", pid);
-        //             break;
-        //         }
-        //         ret = status == EXIT_SUCCESS? ret : status;
-        //         idebug("Server worker exited {pid=%d, status=%d}", pid, status);
-        //     }
-
-        //     return ret;
-        // }
-
+        /**
+         * Start accepting connections on the server. The server runs on all the workers
+         * of the IPC group (see ipc::init). When \a ServerConfig::reusePort is enabled,
+         * each worker binds it's own SO_REUSEPORT listener, otherwise workers share the
+         * listener created by the parent process
+         * @return the exit status of the server
+         */
         template <typename... Opts>
         int start(Opts... opts) {
-            if ((Adaptor == nullptr) || !Adaptor->isRunning()) {
+            mReusePort = mConfig.reusePort && canReusePort(mConfig.socketConfig);
+            if (mConfig.reusePort && !mReusePort) {
+                iwarn("SO_REUSEPORT not supported by socket type, workers will share listener");
+            }
+
+            if (!mReusePort && ((Adaptor == nullptr) || !Adaptor->isRunning())) {
                 // create socket adaptor
                 if (!listen()) {
                     return errno;
@@ -127,14 +78,22 @@ namespace suil::net {
             }
 
             return ipc::spawn([&]() {
+                if ((Adaptor == nullptr) || !Adaptor->isRunning()) {
+                    // each worker binds it's own listener
+                    if (!listen()) {
+                        return errno;
+                    }
+                }
+
+                int status = accept();
+                idebug("Server exiting {status=%d}", status);
+                return status;
+            }, [&](uint8) {
                 // stop the server on exit signal
                 ipc::registerCleaner([&] {
                     Ego.stop();
                 });
-                
-                int status = accept();
-                idebug("Server exiting {status=%d}", status);
-                return status;
+                return 0;
             });
         }
 
@@ -199,6 +158,7 @@ namespace suil::net {
         ServerConfig& mConfig;
         ContextPtr    mContext;
         bool          mExiting{false};
+        bool          mReusePort{false};
         ServerSocket::UPtr Adaptor{nullptr};
     };
 }
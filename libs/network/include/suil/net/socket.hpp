@@ -10,6 +10,8 @@
 
 #include <libmill/libmill.h>
 
+#include <sys/uio.h>
+
 namespace suil::net {
 
     define_log_tag(SOCK_ADAPTOR);
@@ -37,6 +39,18 @@ namespace suil::net {
 
         virtual std::size_t sendv(const Deadline& dd, const char* fmt, va_list args);
 
+        /**
+         * scatter/gather send, sends all the given buffers in order
+         * @param iov the buffers to send
+         * @param iovcnt the number of buffers in \a iov
+         * @param dd the send deadline
+         * @return the number of bytes sent, check errno for errors
+         */
+        virtual std::size_t sendv(
+                const struct iovec* iov,
+                int iovcnt,
+                const Deadline& dd = Deadline::infinite());
+
         virtual std::size_t sendfile(
                 int fd,
                 off_t offset,
@@ -66,6 +80,13 @@ namespace suil::net {
 
         virtual void close() = 0;
 
+        /**
+         * Shuts down the connection without releasing the socket, coroutines
+         * blocked on the socket wake up and the owner of the socket closes it.
+         * Implemented by TCP and SSL sockets
+         */
+        virtual void shutdown() {}
+
         virtual void setBuffering(bool on, const Deadline& dd = Deadline::infinite()) {}
 
         const char *id();
@@ -85,9 +106,11 @@ namespace suil::net {
         virtual void close() = 0;
         virtual void shutdown() = 0;
         bool isRunning() const { return mRunning; }
+        void reusePort(bool on) { mReusePort = on; }
         virtual ~ServerSocket() = default;
     protected:
         bool mRunning{false};
+        bool mReusePort{false};
     };
 }
 #endif //SUILNETWORK_SOCKET_HPP
@@ -58,6 +58,7 @@ namespace suil::net {
 
         bool isOpen() const override;
         void close() override;
+        void shutdown() override;
     private:
         sslsock sock{nullptr};
     };
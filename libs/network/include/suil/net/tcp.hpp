@@ -15,9 +15,15 @@ namespace suil::net {
     class TcpSock : public virtual  Socket, LOGGER(TCP_SOCK) {
     public:
         using LOGGER(TCP_SOCK)::log;
+        using Socket::sendv;
 
         TcpSock() = default;
-        TcpSock(tcpsock sock);
+
+        /**
+         * Takes ownership of a connected non-blocking socket descriptor
+         * @param fd the descriptor of the connection
+         */
+        explicit TcpSock(int fd);
 
         DISABLE_COPY(TcpSock);
 
@@ -35,6 +41,10 @@ namespace suil::net {
                 const void *buf,
                 std::size_t len,
                 const Deadline &dd = Deadline::infinite()) override;
+        std::size_t sendv(
+                const struct iovec* iov,
+                int iovcnt,
+                const Deadline& dd = Deadline::infinite()) override;
         std::size_t sendfile(
                 int fd,
                 off_t offset,
@@ -59,8 +69,11 @@ namespace suil::net {
 
         bool isOpen() const override;
         void close() override;
+        void shutdown() override;
     private:
+        void attach(int fd);
         tcpsock sock{nullptr};
+        int     mFd{-1};
     };
 
     class TcpServerSock : public virtual ServerSocket, LOGGER(TCP_SOCK) {
@@ -79,6 +92,7 @@ namespace suil::net {
         virtual ~TcpServerSock();
     private:
         tcpsock sock{nullptr};
+        int     mFd{-1};
     };
 }
 
@@ -54,4 +54,10 @@ namespace suil::net {
             return unixConfig.bindAddr.peek();
         }
     }
-}
\ No newline at end of file
+
+    bool canReusePort(const SocketConfig& config)
+    {
+        // only plain TCP listeners can be created with SO_REUSEPORT
+        return config.has<TcpSocketConfig>();
+    }
+}
@@ -54,6 +54,20 @@ std::size_t Socket::sendv(const Deadline& dd, const char *fmt, va_list args)
     return send(buf, sz, dd);
 }
 
+std::size_t Socket::sendv(const struct iovec* iov, int iovcnt, const Deadline& dd)
+{
+    // sockets that cannot do vectored I/O send each buffer separately
+    std::size_t total{0};
+    for (int i = 0; i < iovcnt; i++) {
+        auto ns = send(iov[i].iov_base, iov[i].iov_len, dd);
+        total += ns;
+        if (ns != iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
 std::size_t Socket::sendf(const Deadline& dd, const char *fmt, ...)
 {
     va_list args;
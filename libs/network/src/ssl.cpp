@@ -4,10 +4,63 @@
 
 #include "suil/net/ssl.hpp"
 
+#include <dirent.h>
+#include <netinet/in.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 
 namespace suil::net {
 
+    static bool samePeer(const ipaddr& a, const ipaddr& b)
+    {
+        auto sa = (const struct sockaddr *) &a, sb = (const struct sockaddr *) &b;
+        if (sa->sa_family != sb->sa_family) {
+            return false;
+        }
+        if (sa->sa_family == AF_INET) {
+            auto ia = (const struct sockaddr_in *) sa, ib = (const struct sockaddr_in *) sb;
+            return ia->sin_port == ib->sin_port and ia->sin_addr.s_addr == ib->sin_addr.s_addr;
+        }
+        if (sa->sa_family == AF_INET6) {
+            auto ia = (const struct sockaddr_in6 *) sa, ib = (const struct sockaddr_in6 *) sb;
+            return ia->sin6_port == ib->sin6_port and
+                   memcmp(&ia->sin6_addr, &ib->sin6_addr, sizeof(ia->sin6_addr)) == 0;
+        }
+        return false;
+    }
+
+    /**
+     * libmill does not expose the descriptor of SSL connections, the descriptor
+     * is found among the process' descriptors by the address of the peer
+     * @param peer the address of the peer of the connection
+     * @return the descriptor of the connection or -1 if not found
+     */
+    static int connectionFd(const ipaddr& peer)
+    {
+        auto dir = opendir("/proc/self/fd");
+        if (dir == nullptr) {
+            return -1;
+        }
+
+        int found{-1};
+        while (auto ent = readdir(dir)) {
+            char *end{nullptr};
+            auto fd = int(strtol(ent->d_name, &end, 10));
+            if (end == ent->d_name or *end != '\0' or fd == dirfd(dir)) {
+                continue;
+            }
+
+            ipaddr addr{};
+            socklen_t len{sizeof(addr)};
+            if (getpeername(fd, (struct sockaddr *) &addr, &len) == 0 and samePeer(addr, peer)) {
+                found = fd;
+                break;
+            }
+        }
+        closedir(dir);
+        return found;
+    }
+
     SslSock::SslSock(sslsock sock)
         : sock{sock}
     {}
@@ -194,6 +247,21 @@ namespace suil::net {
         }
     }
 
+    void SslSock::shutdown()
+    {
+        if (!isOpen()) {
+            return;
+        }
+
+        int fd = connectionFd(addr());
+        if (fd == -1) {
+            iwarn("%s - descriptor of SSL connection not found: %s", id(), errno_s);
+            return;
+        }
+        // closing is left to the owner as other coroutines might be waiting on the socket
+        ::shutdown(fd, SHUT_RDWR);
+    }
+
     SslSock::~SslSock() noexcept
     {
         close();
@@ -269,4 +337,40 @@ namespace suil::net {
             mRunning = false;
         }
     }
-}
\ No newline at end of file
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+#include <suil/net/tcp.hpp>
+
+TEST_CASE("SSL connection descriptors", "[net][ssl]")
+{
+    // SSL connections are found by the address of their peer, plain TCP
+    // connections are used as they are found the same way
+    auto addr = iplocal("127.0.0.1", 8892, 0);
+    suil::net::TcpServerSock server;
+    REQUIRE(server.listen(addr, 2));
+    suil::net::TcpSock client;
+    REQUIRE(client.connect(addr, 500));
+    auto sock = server.accept(500);
+    REQUIRE(sock != nullptr);
+
+    REQUIRE(suil::net::samePeer(client.addr(), addr));
+    REQUIRE_FALSE(suil::net::samePeer(sock->addr(), addr));
+    auto fd = suil::net::connectionFd(client.addr());
+    REQUIRE(fd != -1);
+    // the other end of the connection has a different peer
+    REQUIRE(suil::net::connectionFd(sock->addr()) != fd);
+    REQUIRE(suil::net::connectionFd(iplocal("127.0.0.1", 8893, 0)) == -1);
+
+    // shutting the descriptor down wakes up the peer
+    ::shutdown(fd, SHUT_RDWR);
+    char c{0};
+    size_t len{1};
+    REQUIRE_FALSE(sock->receive(&c, len, 500));
+
+    sock->close();
+    client.close();
+    server.close();
+}
+#endif
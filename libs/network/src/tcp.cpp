@@ -4,41 +4,107 @@
 
 #include "suil/net/tcp.hpp"
 
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#ifndef TCP_SOCK_MAX_IOV
+#define TCP_SOCK_MAX_IOV 64
+#endif
+
 namespace suil::net {
 
-    TcpSock::TcpSock(tcpsock sock)
-            : sock{sock}
-    {}
+    static socklen_t addrlen(const struct sockaddr *sa)
+    {
+        return sa->sa_family == AF_INET? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+    }
+
+    static int listenSocket(ipaddr addr, int backlog, bool reusePort)
+    {
+        auto sa = (struct sockaddr *) &addr;
+        int fd = ::socket(sa->sa_family, SOCK_STREAM, 0);
+        if (fd == -1) {
+            return -1;
+        }
+
+        int opt = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == -1 ||
+            (reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) ||
+            ::bind(fd, sa, addrlen(sa)) == -1 ||
+            ::listen(fd, backlog) == -1)
+        {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            return -1;
+        }
+
+        nonblocking(fd);
+        return fd;
+    }
+
+    TcpSock::TcpSock(int fd)
+    {
+        attach(fd);
+    }
 
     TcpSock::TcpSock(TcpSock&& other)
-            : sock(other.sock)
+            : sock(other.sock),
+              mFd(other.mFd)
     {
         other.sock = nullptr;
+        other.mFd = -1;
     }
 
     TcpSock & TcpSock::operator=(TcpSock&& other)
     {
         if (this != &other) {
             Ego.sock = other.sock;
+            Ego.mFd = other.mFd;
             other.sock = nullptr;
+            other.mFd = -1;
         }
         return Ego;
     }
 
+    void TcpSock::attach(int fd)
+    {
+        // libmill does not expose the descriptor of a connection, connections are
+        // created here and attached to libmill so the descriptor is known for
+        // vectored sends
+        sock = tcpattach(fd, 0);
+        if (sock == nullptr) {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            return;
+        }
+        mFd = fd;
+    }
+
     int TcpSock::port() const
     {
-        if (sock) {
-            return tcpport(sock);
+        auto sa = addr();
+        switch (((const struct sockaddr *) &sa)->sa_family) {
+            case AF_INET:
+                return ntohs(((const struct sockaddr_in *) &sa)->sin_port);
+            case AF_INET6:
+                return ntohs(((const struct sockaddr_in6 *) &sa)->sin6_port);
+            default:
+                return -1;
         }
-        return -1;
     }
 
     const ipaddr TcpSock::addr() const
     {
+        // the address of connections attached to libmill is not known to libmill
+        ipaddr addr{};
         if (sock) {
-            return tcpaddr(sock);
+            socklen_t len{sizeof(addr)};
+            if (getpeername(mFd, (struct sockaddr *) &addr, &len) == -1) {
+                return ipaddr{};
+            }
         }
-        return ipaddr{};
+        return addr;
     }
 
     bool TcpSock::connect(ipaddr addr, const Deadline& dd)
@@ -49,14 +115,40 @@ namespace suil::net {
             return false;
         }
 
-        sock = tcpconnect(addr, dd);
-        if (sock == nullptr) {
-            itrace("connection to address: %s failed: %s",
-                   Socket::ipstr(addr), errno_s);
+        auto sa = (struct sockaddr *) &addr;
+        int fd = ::socket(sa->sa_family, SOCK_STREAM, 0);
+        if (fd == -1) {
+            itrace("creating socket failed: %s", errno_s);
             return false;
         }
+        nonblocking(fd);
+
+        if (::connect(fd, sa, addrlen(sa)) != 0) {
+            int err{errno};
+            if (err == EINPROGRESS) {
+                // wait for the connection to be established
+                int ev = fdwait(fd, FDW_OUT, dd);
+                socklen_t len{sizeof(err)};
+                if (ev == 0) {
+                    err = ETIMEDOUT;
+                }
+                else if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1) {
+                    err = errno;
+                }
+            }
 
-        return true;
+            if (err != 0) {
+                fdclean(fd);
+                ::close(fd);
+                errno = err;
+                itrace("connection to address: %s failed: %s",
+                       Socket::ipstr(addr), errno_s);
+                return false;
+            }
+        }
+
+        attach(fd);
+        return isOpen();
     }
 
     std::size_t TcpSock::send(const void *buf, std::size_t len, const Deadline& dd)
@@ -78,6 +170,67 @@ namespace suil::net {
         return ns;
     }
 
+    std::size_t TcpSock::sendv(const struct iovec* iov, int iovcnt, const Deadline& dd)
+    {
+        if (!isOpen()) {
+            iwarn("writing to a closed socket is not supported");
+            errno = ENOTSUP;
+            return 0;
+        }
+
+        // data buffered by libmill goes out first
+        if (!flush(dd)) {
+            return 0;
+        }
+
+        std::size_t total{0};
+        struct iovec vec[TCP_SOCK_MAX_IOV];
+        for (int idx = 0; idx < iovcnt;) {
+            // copy the next batch since the vector is updated on partial writes
+            int left = std::min(iovcnt - idx, TCP_SOCK_MAX_IOV);
+            memcpy(vec, &iov[idx], sizeof(struct iovec) * left);
+            idx += left;
+
+            auto it = vec;
+            while (left > 0) {
+                auto nw = ::writev(mFd, it, left);
+                if (nw == -1) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        int ev = fdwait(mFd, FDW_OUT, dd);
+                        if (ev & FDW_OUT) {
+                            continue;
+                        }
+                        errno = (ev == 0)? ETIMEDOUT : ECONNRESET;
+                    }
+                    itrace("sendv error: %s", errno_s);
+                    if (errno == ECONNRESET || errno == EPIPE) {
+                        close();
+                    }
+                    return total;
+                }
+
+                total += nw;
+                // skip the buffers that were completely written
+                while (left > 0 && size_t(nw) >= it->iov_len) {
+                    nw -= it->iov_len;
+                    it++;
+                    left--;
+                }
+
+                if (left > 0) {
+                    it->iov_base = static_cast<char *>(it->iov_base) + nw;
+                    it->iov_len -= nw;
+                }
+            }
+        }
+
+        errno = 0;
+        return total;
+    }
+
     std::size_t TcpSock::sendfile(int fd, off_t offset, std::size_t len, const Deadline& dd)
     {
         if (!isOpen()) {
@@ -201,6 +354,15 @@ namespace suil::net {
             flush(500);
             tcpclose(sock);
             sock = nullptr;
+            mFd = -1;
+        }
+    }
+
+    void TcpSock::shutdown()
+    {
+        if (isOpen()) {
+            // closing is left to the owner as other coroutines might be waiting on the socket
+            ::shutdown(mFd, SHUT_RDWR);
         }
     }
 
@@ -217,9 +379,11 @@ namespace suil::net {
     }
 
     TcpServerSock::TcpServerSock(TcpServerSock& other)
-            : sock{other.sock}
+            : sock{other.sock},
+              mFd{other.mFd}
     {
         other.sock = nullptr;
+        other.mFd = -1;
         other.mRunning = false;
     }
 
@@ -227,7 +391,9 @@ namespace suil::net {
     {
         if (this != &other) {
             Ego.sock = other.sock;
+            Ego.mFd = other.mFd;
             other.sock = nullptr;
+            other.mFd = -1;
             other.mRunning = false;
         }
         return Ego;
@@ -241,11 +407,22 @@ namespace suil::net {
             return false;
         }
 
-        sock = tcplisten(addr, backlog);
+        // with SO_REUSEPORT each process gets it's own listening socket and the
+        // kernel load balances incoming connections between them
+        int fd = listenSocket(addr, backlog, mReusePort);
+        if (fd != -1) {
+            sock = tcpattach(fd, 1);
+            if (sock == nullptr) {
+                int err = errno;
+                ::close(fd);
+                errno = err;
+            }
+        }
         if (sock == nullptr) {
             ierror("listening failed: %s", errno_s);
             return false;
         }
+        mFd = fd;
         mRunning  = true;
         return true;
     }
@@ -258,12 +435,34 @@ namespace suil::net {
             return nullptr;
         }
 
-        auto client = tcpaccept(sock, dd);
-        if (client == nullptr) {
-            itrace("accept connection failed: %s", errno_s);
-            return nullptr;
+        while (true) {
+            int fd = ::accept(mFd, nullptr, nullptr);
+            if (fd != -1) {
+                nonblocking(fd);
+                auto client = std::make_unique<TcpSock>(fd);
+                if (!client->isOpen()) {
+                    itrace("attaching accepted connection failed: %s", errno_s);
+                    return nullptr;
+                }
+                return client;
+            }
+
+            if (errno == EINTR or errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN and errno != EWOULDBLOCK) {
+                itrace("accept connection failed: %s", errno_s);
+                return nullptr;
+            }
+
+            // wait for a connection
+            int ev = fdwait(mFd, FDW_IN, dd);
+            if (ev == 0 or (ev & FDW_ERR)) {
+                errno = (ev == 0)? ETIMEDOUT : ECONNABORTED;
+                itrace("accept connection failed: %s", errno_s);
+                return nullptr;
+            }
         }
-        return std::make_unique<TcpSock>(client);
     }
 
     void TcpServerSock::close()
@@ -271,6 +470,7 @@ namespace suil::net {
         if (sock != nullptr) {
             tcpclose(sock);
             sock = nullptr;
+            mFd = -1;
             mRunning = false;
         }
     }
@@ -312,6 +512,55 @@ static coroutine void accept(TcpServerSock::Ptr& server)
     }
 }
 
+TEST_CASE("TCP connection descriptors", "[net][tcp]")
+{
+    auto addr = iplocal("127.0.0.1", 8890, 0);
+    TcpServerSock server;
+    REQUIRE(server.listen(addr, 2));
+    TcpSock client;
+    REQUIRE(client.connect(addr, 500));
+    REQUIRE(client.port() == 8890);
+    auto sock = server.accept(500);
+    REQUIRE(sock != nullptr);
+    REQUIRE(sock->port() > 0);
+
+    SECTION("Connecting to a closed port fails") {
+        TcpSock other;
+        REQUIRE_FALSE(other.connect(iplocal("127.0.0.1", 8891, 0), 500));
+        REQUIRE_FALSE(other.isOpen());
+    }
+
+    SECTION("Accepting times out without connections") {
+        REQUIRE(server.accept(10) == nullptr);
+        REQUIRE(errno == ETIMEDOUT);
+    }
+
+    SECTION("Vectored sends are written to the connection") {
+        // buffered data is sent before the vector
+        REQUIRE(client.send("one ", 4, 500) == 4);
+        struct iovec iov[2] = {
+            {(void *) "two ", 4},
+            {(void *) "three", 5}
+        };
+        REQUIRE(client.sendv(iov, 2, 500) == 9);
+        char buf[16] = {0};
+        size_t len{13};
+        REQUIRE(sock->receive(buf, len, 500));
+        REQUIRE(len == 13);
+        REQUIRE(strcmp(buf, "one two three") == 0);
+
+        // shutting down wakes up the peer without closing the socket
+        client.shutdown();
+        REQUIRE(client.isOpen());
+        len = 1;
+        REQUIRE_FALSE(sock->receive(buf, len, 500));
+    }
+
+    sock->close();
+    client.close();
+    server.close();
+}
+
 TEST_CASE("Using TCP Client/Server", "[net][tcp]")
 {
     auto addr = iplocal("127.0.0.1", 8889, 0);
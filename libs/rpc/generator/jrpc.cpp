@@ -9,8 +9,45 @@
 #include <scc/visitor.hpp>
 #include <scc/includes.hpp>
 
+#include <set>
+
 namespace suil::rpc {
 
+    // must be kept in sync with suil::rpc::jrpc::methodHash
+    static uint32_t methodHash(const std::string& name, uint32_t seed)
+    {
+        uint32_t hash{2166136261u ^ seed};
+        for (auto c: name) {
+            hash ^= uint8_t(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * Find a seed and table size for which every method name hashes
+     * to a different slot
+     * @return the seed and the size of the table
+     */
+    static std::pair<uint32_t, uint32_t> perfectHash(const Methods& methods)
+    {
+        auto size = uint32_t(std::max(methods.size(), size_t(1)));
+        while (true) {
+            for (uint32_t seed = 0; seed < 4096; seed++) {
+                std::set<uint32_t> slots;
+                for (const scc::Method& method: methods) {
+                    if (!slots.insert(methodHash(method.Name.Content, seed) % size).second) {
+                        break;
+                    }
+                }
+                if (slots.size() == methods.size()) {
+                    return {seed, size};
+                }
+            }
+            size++;
+        }
+    }
+
     void JsonRpcHppGenerator::includes(scc::Formatter fmt, scc::IncludeBag& incs)
     {
         incs.write(fmt, "suil/rpc/json/client.hpp");
@@ -145,8 +182,8 @@ namespace suil::rpc {
         });
         Line(--fmt) << "protected:";
         // add function that will be used to handle incoming messages
-        Line(++fmt) << "suil::rpc::jrpc::ResultCode operator()("
-                      "const suil::String& method, const suil::json::Object& params, int id) override;";
+        Line(++fmt) << "int invoke(iod::encode_stream& out, suil::String& err, "
+                      "const suil::String& method, const suil::String& params, int id) override;";
         --fmt;
 
         Line(--fmt) << "private:";
@@ -178,6 +215,8 @@ namespace suil::rpc {
             throw scc::Exception("suil/rpc/json generator can only be used on class types");
         }
         const auto& klass = ct.as<scc::Class>();
+        // symbols are global, the parameters of each method are decoded into an iod object
+        generateSymbols(fmt, klass);
         UsingNamespace(getNamespace(), fmt);
         {
             generateClient(fmt, klass);
@@ -185,6 +224,25 @@ namespace suil::rpc {
         }
     }
 
+    void JsonRpcCppGenerator::generateSymbols(scc::Formatter& fmt, const scc::Class& ct)
+    {
+        std::set<std::string> symbols;
+        auto rpcMethods = getRpcMethods(ct, "json");
+        for (const scc::Method& method: rpcMethods) {
+            for (auto& param: method.Params) {
+                symbols.insert(param.Name.Content);
+            }
+        }
+
+        for (auto& sym: symbols) {
+            Line(fmt) << "#ifndef IOD_SYMBOL_" << sym;
+            Line(fmt) << "#define IOD_SYMBOL_" << sym;
+            Line(fmt) << "    iod_define_symbol(" << sym << ")";
+            Line(fmt) << "#endif";
+        }
+        Line(fmt);
+    }
+
     void JsonRpcCppGenerator::generateClient(scc::Formatter& fmt, const scc::Class& ct)
     {
         scc::Visitor<scc::Class>(ct).visit<scc::Node>([&](const scc::Node& tp) {
@@ -234,71 +292,72 @@ namespace suil::rpc {
 
     void JsonRpcCppGenerator::generateServer(scc::Formatter& fmt, const scc::Class& ct)
     {
-        Line(fmt) << "suil::rpc::jrpc::ResultCode " << ct.Name
-                  << "JrpcContext::operator()("
-                  << "const suil::String& method, const suil::json::Object& params, int id) {";
-        Line(++fmt) << "static suil::UnorderedMap<int> scMappings = {";
+        Line(fmt) << "int " << ct.Name
+                  << "JrpcContext::invoke(iod::encode_stream& out, suil::String& err, "
+                  << "const suil::String& method, const suil::String& params, int id) {";
         ++fmt;
-
-        auto rpcMethods = getRpcMethods(ct, "json");
-        int index{0};
-        for (const scc::Method& method: rpcMethods) {
-            if (index != 0) {
-                fmt << ",";
-            }
-            Line(fmt) << R"({")" << method.Name << R"(", )" << index++ << "}";
-        }
-        Line(--fmt)<< "};";
-        Line(fmt);
         Line(fmt) << "if (m" << ct.Name << " == nullptr) {";
-        Line(++fmt) << "return {suil::rpc::jrpc::ResultCode::InternalError,"
-                      "suil::String{\"Service currently unavailbale\"}};";
+        Line(++fmt) << "err = suil::String{\"Service currently unavailable\"};";
+        Line(fmt) << "return suil::rpc::jrpc::ResultCode::InternalError;";
         Line(--fmt)<< "}";
         Line(fmt);
 
-        Line(fmt) << "auto it = scMappings.find(method);";
-        Line(fmt) << "if (it == scMappings.end()) {";
-        Line(++fmt) << "return {suil::rpc::jrpc::ResultCode::MethodNotFound,"
-                               "suil::String{\"request method not implemented\"}};";
-        Line(--fmt)<< "}";
-        Line(fmt);
-        Line(fmt) << "switch(it->second) {";
+        // methods are found with a perfect hash of their name, only the name in
+        // the slot needs to be compared
+        auto rpcMethods = getRpcMethods(ct, "json");
+        auto [seed, size] = perfectHash(rpcMethods);
+        Line(fmt) << "switch(suil::rpc::jrpc::methodHash(method.data(), method.size(), "
+                  << seed << "u) % " << size << "u) {";
         ++fmt;
-        index = 0;
         for (const scc::Method& method: rpcMethods) {
-            Line(fmt) << "case " << index++ << ": {";
+            Line(fmt) << "case " << methodHash(method.Name.Content, seed) % size << ": {";
             ++fmt;
-            for (auto& param: method.Params) {
-                Line(fmt) << "auto " << param.Name << " = ("
-                          << param.Type << ") params[\""
-                          << param.Name
-                          << "\"];";
+            Line(fmt) << "if (method.compare(\"" << method.Name << "\") != 0) {";
+            Line(++fmt) << "break;";
+            Line(--fmt)<< "}";
+            if (!method.Params.empty()) {
+                // decode the parameters straight into their types
+                Line(fmt) << "decltype(iod::D(";
+                for (auto& param: method.Params) {
+                    if (&param != &method.Params.front()) {
+                        fmt << ", ";
+                    }
+                    fmt << "s::_" << param.Name << " = " << param.Type << "()";
+                }
+                fmt << ")) args;";
+                Line(fmt) << "if (!suil::json::trydecode(params, args)) {";
+                Line(++fmt) << "err = suil::String{\"invalid parameters for method '"
+                            << method.Name << "'\"};";
+                Line(fmt) << "return suil::rpc::jrpc::ResultCode::InvalidParams;";
+                Line(--fmt)<< "}";
             }
-            // invoke the method
+
+            // invoke the method and write the result
             Line(fmt);
             if (!method.ReturnType.Type.isVoid()) {
-                Line(fmt) << "json::Object obj{Ego.m" << ct.Name
-                          << "->" << method.Name << '(';
-                writeParameterCall(fmt, method);
-                fmt << ")};";
-                Line(fmt) << "return {0, jrpc::Result{std::move(obj)}};";
+                Line(fmt) << "auto res = Ego.m" << ct.Name << "->" << method.Name << '(';
+                writeParameterCall(fmt, method, "args.");
+                fmt << ");";
+                Line(fmt) << "out << \"\\\"result\\\":\";";
+                Line(fmt) << "iod::json_internals::json_encode_(res, out);";
             }
             else {
-                Line(fmt) << "Ego.m" << ct.Name
-                          << "->"
-                          << method.Name << '(';
-                writeParameterCall(fmt, method);
+                Line(fmt) << "Ego.m" << ct.Name << "->" << method.Name << '(';
+                writeParameterCall(fmt, method, "args.");
                 fmt << ");";
-                Line(fmt) << "return {0, jrpc::Result{suil::json::Object(nullptr)}};";
+                Line(fmt) << "out << \"\\\"result\\\":null\";";
             }
+            Line(fmt) << "return 0;";
             Line(--fmt)<< "}";
         }
-        Line(fmt) << "default: {";
-        Line(++fmt) << "return {suil::rpc::jrpc::ResultCode::MethodNotFound, "
-                        "suil::String(\"requested method does not exist\")};";
-        Line(--fmt)<< "}";   // close default case
+        Line(fmt) << "default:";
+        Line(++fmt) << "break;";
+        --fmt;
         Line(--fmt)<< "}";   // close switch
+        Line(fmt);
+        Line(fmt) << "err = suil::String{\"requested method does not exist\"};";
+        Line(fmt) << "return suil::rpc::jrpc::ResultCode::MethodNotFound;";
         Line(--fmt)<< "}";   // close method
         Line(fmt);
-    };
+    }
 }
\ No newline at end of file
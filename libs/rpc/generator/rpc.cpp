@@ -34,7 +34,7 @@ namespace suil::rpc {
         return std::move(rpcMethods);
     }
 
-    void writeParameterCall(scc::Formatter& fmt, const scc::Method& method)
+    void writeParameterCall(scc::Formatter& fmt, const scc::Method& method, const std::string& prefix)
     {
         for (auto& param: method.Params) {
             if (&param != &method.Params.front()) {
@@ -42,17 +42,18 @@ namespace suil::rpc {
             }
 
             if (param.Kind.empty() or param.Kind == "&&") {
-                fmt << "std::move(";
+                fmt << "std::move(" << prefix;
                 param.Name.toString(fmt);
                 fmt << ')';
             }
             else if (param.Kind == "*") {
                 // this really shouldn't be supported
-                fmt << "&";
+                fmt << "&" << prefix;
                 param.Name.toString(fmt);
             }
             else {
                 // reference used
+                fmt << prefix;
                 param.Name.toString(fmt);
             }
         }
@@ -16,7 +16,7 @@ namespace suil::rpc {
 
     using Methods = std::vector<std::reference_wrapper<const scc::Method>>;
     Methods getRpcMethods(const scc::Class& ct, const std::string& gen);
-    void writeParameterCall(scc::Formatter& fmt, const scc::Method& method);
+    void writeParameterCall(scc::Formatter& fmt, const scc::Method& method, const std::string& prefix = "");
 
     class JsonRpcHppGenerator: public scc::HppGenerator {
     public:
@@ -39,6 +39,7 @@ namespace suil::rpc {
         void generateClientMethod(scc::Formatter& fmt, const std::string& klass, const scc::Method &method);
         void generateServer(scc::Formatter& fmt, const scc::Class &ct);
         void generateServerMethod(scc::Formatter& fmt, const std::string& klass, const scc::Method &method);
+        void generateSymbols(scc::Formatter& fmt, const scc::Class &ct);
     };
 
     class SuilRpcHppGenerator: public scc::HppGenerator {
@@ -26,6 +26,9 @@ namespace suil::rpc {
             } else if (opts.has(var(unixConfig))) {
                 Ego.config.socketConfig = opts.get(var(unixConfig), net::UnixSocketConfig{});
             }
+            Ego.config.multiplex = opts.get(var(multiplex), Ego.config.multiplex);
+            Ego.config.framed = opts.get(var(framed), Ego.config.framed);
+            Ego.config.streamBatches = opts.get(var(streamBatches), Ego.config.streamBatches);
         }
 
         DISABLE_COPY(RpcClient);
@@ -8,8 +8,14 @@
 #include <suil/rpc/common.scc.hpp>
 
 #include <suil/net/socket.hpp>
+#include <suil/net/tcp.hpp>
 
 #include <cinttypes>
+#include <sys/uio.h>
+
+#ifndef SUIL_RPC_RX_CHUNK
+#define SUIL_RPC_RX_CHUNK 16384
+#endif
 
 namespace suil::rpc {
 
@@ -19,6 +25,13 @@ namespace suil::rpc {
     DECLARE_EXCEPTION(RpcTransportError);
     DECLARE_EXCEPTION(RpcApiError);
 
+    /**
+     * Sends and receives RPC messages. Messages are delimited by the receive timeout
+     * unless \a protoUseSize is enabled, in which case each message is prefixed with
+     * it's size (64-bit little endian). Framed messages are sent with a single vectored
+     * send and received through a buffer that is reused across messages, a single read
+     * from a TCP socket can receive many messages
+     */
     template <typename Config>
         requires (std::is_same_v<Config, RpcClientConfig> or
                   std::is_same_v<Config, RpcServerConfig>)
@@ -35,7 +48,7 @@ namespace suil::rpc {
             }
 
             if (protoUseSize) {
-                return sizedReceive(sock, rxb, initialWait);
+                return framedReceive(sock, rxb, initialWait);
             }
             else {
                 return bestEffortReceive(sock, rxb, initialWait);
@@ -45,56 +58,112 @@ namespace suil::rpc {
         virtual bool transmit(net::Socket& sock, const suil::Data& resp)
         {
             if (Ego.protoUseSize) {
-                // Send the size first
-                auto size = htole64(resp.size());
-                if (sock.send(&size, sizeof(size), getConfig().sendTimeout) != sizeof(size)) {
-                    // failed to send
-                    iwarn("RPC IO - sending response size failed: %s", errno_s);
+                // send the size and the data together
+                uint64_t size = htole64(resp.size());
+                struct iovec iov[2] = {
+                    {&size, sizeof(size)},
+                    {const_cast<uint8_t *>(resp.cdata()), resp.size()}
+                };
+                if (sock.sendv(iov, 2, getConfig().sendTimeout) != (sizeof(size) + resp.size())) {
+                    // sending failed
+                    iwarn("RPC IO - sending response of size %zu failed: %s", resp.size(), errno_s);
                     return false;
                 }
             }
-
-            // send the data
-            if (sock.send(resp.data(), resp.size(), getConfig().sendTimeout) != resp.size()) {
+            else if (sock.send(resp.data(), resp.size(), getConfig().sendTimeout) != resp.size()) {
                 // sending failed
-                iwarn("RPC IO - sending response of size " PRId64 " failed: %s", resp.size(), errno_s);
+                iwarn("RPC IO - sending response of size %zu failed: %s", resp.size(), errno_s);
                 return false;
             }
 
             return sock.flush(getConfig().sendTimeout);
         }
 
-    protected:
+    protected suil_ut:
         virtual const Config& getConfig() const = 0;
         bool protoUseSize{false};
 
-    private:
-        bool sizedReceive(net::Socket& sock, Buffer& rxb, int64_t initialWait)
+    private suil_ut:
+        bool framedReceive(net::Socket& sock, Buffer& rxb, int64_t initialWait)
         {
-            size_t size{0};
-            size_t _{sizeof(size)};
-            if (!sock.receive(&size, _, initialWait)) {
+            uint64_t size{0};
+            if (!fill(sock, sizeof(size), initialWait)) {
                 // failed to receive the size
-                itrace("RPC IO - failed to receive protoUseSize: %s", errno_s);
+                itrace("RPC IO - failed to receive message size: %s", errno_s);
                 return false;
             }
 
-            auto nread = le64toh(size);
-            itrace("RPC IO - received protoUseSize {size =" PRId64 "}", nread);
-            size = nread;
+            memcpy(&size, &rxring.data()[rxpos], sizeof(size));
+            size = le64toh(size);
+            rxpos += sizeof(size);
+            itrace("RPC IO - received message size {size = %" PRIu64 "}", size);
+
             rxb.reserve(size);
-            if (sock.receive(&rxb[0], nread, getConfig().receiveTimeout)) {
-                ierror("RPC IO - failed to receive " PRId64 " bytes from client: %s", size, errno_s);
-                return false;
+            auto buffered = std::min(rxring.size() - rxpos, size);
+            memcpy(&rxb.data()[rxb.size()], &rxring.data()[rxpos], buffered);
+            rxb.seek(off_t(buffered));
+            rxpos += buffered;
+
+            if (buffered < size) {
+                // large messages are received in place
+                auto left = size - buffered;
+                if (!sock.receive(&rxb.data()[rxb.size()], left, getConfig().receiveTimeout)) {
+                    ierror("RPC IO - failed to receive %" PRIu64 " bytes from client: %s", size, errno_s);
+                    return false;
+                }
+                rxb.seek(off_t(left));
+            }
+            return true;
+        }
+
+        bool fill(net::Socket& sock, size_t needed, int64_t timeout)
+        {
+            if (rxpos == rxring.size()) {
+                // everything that was received has been consumed
+                rxring.bseek(0);
+                rxpos = 0;
+            }
+
+            while (rxring.size() - rxpos < needed) {
+                if (rxpos > 0) {
+                    // discard the messages that were already consumed
+                    auto left = rxring.size() - rxpos;
+                    memmove(rxring.data(), &rxring.data()[rxpos], left);
+                    rxring.bseek(off_t(left));
+                    rxpos = 0;
+                }
+
+                size_t len = needed - rxring.size();
+                if (dynamic_cast<net::TcpSock *>(&sock) != nullptr) {
+                    // read whatever is available, which could be several messages
+                    rxring.reserve(std::max(len, size_t(SUIL_RPC_RX_CHUNK)));
+                    len = rxring.capacity();
+                    if (!sock.read(&rxring.data()[rxring.size()], len, timeout)) {
+                        return false;
+                    }
+                }
+                else {
+                    // other sockets wait for the requested number of bytes
+                    rxring.reserve(len);
+                    if (!sock.receive(&rxring.data()[rxring.size()], len, timeout)) {
+                        return false;
+                    }
+                }
+
+                if (len == 0) {
+                    // connection closed
+                    errno = ECONNRESET;
+                    return false;
+                }
+                rxring.seek(off_t(len));
             }
-            rxb.seek(nread);
             return true;
         }
 
         bool bestEffortReceive(net::Socket& sock, Buffer& rxb, int64_t initialWait)
         {
             size_t nread{0}, tread{0};
-            rxb.reserve(1024);
+            rxb.reserve(SUIL_RPC_RX_CHUNK);
             nread = 1;
             // wait for at least 1 byte to be received
             if (!sock.receive(&rxb[0], nread, initialWait)) {
@@ -125,7 +194,7 @@ namespace suil::rpc {
                 if (rxb.capacity() == 0) {
                     // conservative, the idea is that we assume we ran out of buffers
                     // while reading and try again with a smaller timeout
-                    rxb.reserve(1024);
+                    rxb.reserve(SUIL_RPC_RX_CHUNK);
                     timeout = 100_ms;
                 }
                 else {
@@ -136,6 +205,10 @@ namespace suil::rpc {
 
             return true;
         }
+
+        // received data that is yet to be consumed starts at rxpos
+        Buffer rxring{};
+        size_t rxpos{0};
     };
 }
 #endif //SUIL_IO_HPP
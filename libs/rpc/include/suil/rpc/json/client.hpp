@@ -12,10 +12,25 @@ namespace suil::rpc::jrpc {
 
     define_log_tag(JRPC_CLIENT);
 
+    /**
+     * A JSON RPC client. When created with `opt(streamBatches, true)` and the server
+     * supports it, the responses of a batch are received as soon as they are ready
+     * and can be handled before the whole batch completes. With `opt(framed, true)`
+     * messages are prefixed with their size, which streaming batches imply
+     *
+     * @code
+     *   client.batch([&](size_t index, jrpc::Result res) {
+     *       // index is the position of the request in the batch
+     *   }, "get", json::Object(json::Obj, "key", "a"), "get", json::Object(json::Obj, "key", "b"));
+     * @endcode
+     */
     class Client: public rpc::RpcClient, public LOGGER(JRPC_CLIENT) {
     public:
         using LOGGER(JRPC_CLIENT)::log;
         using rpc::RpcClient::RpcClient;
+        using Handler = std::function<void(size_t, jrpc::Result)>;
+
+        bool connect() override;
 
         String rpcVersion() override;
 
@@ -39,6 +54,26 @@ namespace suil::rpc::jrpc {
             return Ego.call(package);
         }
 
+        /**
+         * Execute a batch of requests, passing each result to the given handler as
+         * soon as it's received
+         * @param handler invoked with the index of the request in the batch and it's
+         * result, in the order the results are received
+         */
+        template <typename ...Args>
+        void batch(const Handler& handler, const String& method, const json::Object& params, Args&&... args) {
+            std::vector<jrpc::Request> package;
+            Ego.pack(package, method, params, std::forward<Args>(args)...);
+            Ego.call(package, handler);
+        }
+
+        /**
+         * @return true if the responses of a batch are received as they complete
+         */
+        inline bool isStreaming() const {
+            return Ego.streaming;
+        }
+
     private:
         template <typename ...Args>
         void pack(std::vector<jrpc::Request>& package,
@@ -61,7 +96,11 @@ namespace suil::rpc::jrpc {
 
         jrpc::Result doCall(const String& method, const json::Object& params = nullptr);
         std::vector<jrpc::Result> call(std::vector<jrpc::Request>& package);
-        std::vector<jrpc::Result> transform(std::vector<jrpc::Response>&& resps);
+        void call(std::vector<jrpc::Request>& package, const Handler& handler);
+        size_t indexOf(const std::vector<jrpc::Request>& package, const jrpc::Response& resp);
+        jrpc::Result transform(jrpc::Response&& resp);
+
+        bool streaming{false};
     };
 }
 
@@ -35,5 +35,34 @@ namespace suil::rpc::jrpc {
         Result result;
     };
 
+    /**
+     * A request whose members refer to the received bytes, the parameters are
+     * still encoded and are decoded by the method handling the request
+     */
+    struct RawRequest {
+        String jsonrpc{};
+        String method{};
+        // the parameters (JSON object), empty when the request has no parameters
+        String params{};
+        int    id{0};
+        bool   hasId{false};
+    };
+
+    /**
+     * The hash used by generated contexts to find the method of a request
+     * @param seed the seed chosen by the generator, for which all the methods
+     * of a service have a different hash
+     */
+    inline uint32_t methodHash(const char *name, size_t len, uint32_t seed)
+    {
+        // FNV-1a
+        uint32_t hash{2166136261u ^ seed};
+        for (size_t i = 0; i < len; i++) {
+            hash ^= uint8_t(name[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
 }
 #endif //SUIL_RPC_JSON_COMMON_HPP
@@ -8,10 +8,21 @@
 #include <suil/rpc/json/common.hpp>
 #include <suil/rpc/io.hpp>
 
+#include <suil/base/channel.hpp>
+#include <libmill/libmill.hpp>
+
 namespace suil::rpc::jrpc {
 
     class Context;
 
+    /**
+     * Serves the requests of a JSON RPC client. The entries of a batch request are
+     * executed concurrently, each in it's own coroutine (at most \a batchConcurrency
+     * at a time), and their responses are sent in the order of the requests. A client
+     * that enabled streaming receives each response as soon as it is ready instead.
+     * Clients can also enable framing (rpc_framed), which prefixes every message with
+     * it's size so that the end of a request is known without waiting for a timeout
+     */
     class Connection: public RpcIO<RpcServerConfig>, public LOGGER(JSON_RPC) {
     public:
         using LOGGER(JSON_RPC)::log;
@@ -22,16 +33,31 @@ namespace suil::rpc::jrpc {
     protected:
         const RpcServerConfig& getConfig() const override;
 
-    private:
-        String parseRequest(std::vector<rpc::jrpc::Request>& req, const Buffer& rxb);
-        std::string handleRequest(const Buffer& req);
+    private suil_ut:
+        String parseRequest(std::vector<RawRequest>& reqs, const Buffer& rxb);
+        bool handleRequest(net::Socket& sock, const Buffer& req);
+        void handleOne(iod::encode_stream& out, const RawRequest& req);
+        bool reply(net::Socket& sock, const std::string& resp);
+        bool replyError(net::Socket& sock, const RpcError& err);
+        void drain();
+        static coroutine void execute(Connection& conn, net::Socket& sock, const RawRequest& req, std::string& resp);
         rpc::jrpc::Response handleExtension(const String& method, const json::Object& req, int id = 0);
-        rpc::jrpc::Response handleWithContext(Context& ctx, const String& method, const json::Object& req, int id = 0);
+        void handleWithContext(iod::encode_stream& out, Context& ctx, const RawRequest& req);
+        static void writeHeader(iod::encode_stream& out, const RawRequest* req);
+        static void writeError(iod::encode_stream& out, const RawRequest* req, const RpcError& err);
 
-    private:
+    private suil_ut:
         using ExtensionMethod = std::function<rpc::jrpc::ResultCode(const json::Object&)>;
         std::shared_ptr<Context> context{nullptr};
         UnorderedMap<ExtensionMethod> extensionMethods;
+        // batch entries being executed
+        Conditional completed{};
+        mill::Mutex writer{};
+        uint32 inflight{0};
+        bool   streaming{false};
+        bool   streamRequested{false};
+        bool   framedRequested{false};
+        bool   broken{false};
     };
 }
 #endif //SUIL_RPC_JSON_CONNECTION_HPP
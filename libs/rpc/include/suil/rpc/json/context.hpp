@@ -25,6 +25,22 @@ namespace suil::rpc::jrpc {
             return {ResultCode::MethodNotFound, String{"method not implemented"}};
         }
 
+        /**
+         * Invoke a method with parameters that are still encoded. Generated contexts
+         * decode the parameters straight into the types of the method's parameters,
+         * the default implementation decodes them into a json::Object and invokes
+         * the method with \a operator()
+         * @param out the stream to write the result to, as the `"result":<value>` member
+         * of the response
+         * @param err the error message when the method fails
+         * @return 0 if the result was written, otherwise an error code
+         */
+        virtual int invoke(iod::encode_stream& out,
+                           String& err,
+                           const String& method,
+                           const String& params,
+                           int id);
+
         RpcServerConfig& config();
 
         protected:
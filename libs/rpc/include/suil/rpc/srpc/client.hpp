@@ -8,15 +8,27 @@
 #include <suil/rpc/wire.scc.hpp>
 #include <suil/rpc/client.hpp>
 
+#include <suil/base/channel.hpp>
+#include <libmill/libmill.hpp>
+
+#include <unordered_map>
+
 namespace suil::rpc::srpc {
 
     define_log_tag(SRPC_CLIENT);
 
+    /**
+     * An SRPC client. When created with `opt(multiplex, true)` and the server supports
+     * it, many coroutines can call the server concurrently on the same connection, the
+     * responses are matched to the calls by request id in the order they are received
+     */
     class Client: public RpcClient, LOGGER(SRPC_CLIENT) {
     public:
         using LOGGER(SRPC_CLIENT)::log;
         using rpc::RpcClient::RpcClient;
 
+        bool connect() override;
+
         String rpcVersion() override;
 
         template <typename R, typename ...Params>
@@ -26,12 +38,13 @@ namespace suil::rpc::srpc {
 
             auto size = (Wire::maxByteSize(idGenerator)<<1) + paramsWireSize(params...);
             suil::HeapBoard hb{size + 16};
-            hb << (idGenerator++) << getMethodId(method);
+            auto id = idGenerator++;
+            hb << id << getMethodId(method);
             if constexpr (sizeof...(params) > 0) {
                 (hb << ... << params);
             }
 
-            Ego.doCall(res, hb.release());
+            Ego.doCall(res, id, hb.release());
             if constexpr (std::is_same_v<suil::Data, R>) {
                 return std::move(res);
             }
@@ -42,6 +55,13 @@ namespace suil::rpc::srpc {
 
         const Metadata& getMetadata();
 
+        /**
+         * @return true if calls are multiplexed on the connection
+         */
+        inline bool isMultiplexed() const {
+            return Ego.multiplexed;
+        }
+
     private:
         inline size_t paramsWireSize() { return 0; };
 
@@ -66,13 +86,42 @@ namespace suil::rpc::srpc {
             }
         }
 
-        void doCall(suil::HeapBoard& resp, const suil::Data& req);
+    private suil_ut:
+        // a call waiting for it's response on a multiplexed connection
+        struct Pending {
+            explicit Pending(int id)
+                : id{id}
+            {}
+
+            int    id{0};
+            Buffer rxb{};
+            String error{};
+            bool   ready{false};
+            // reading was handed over to this call
+            bool   lead{false};
+            Channel<uint8_t, 1> done{uint8_t(0)};
+        };
+
+        static constexpr uint8_t Resolved{1};
+        static constexpr uint8_t Lead{2};
+
+        void doCall(suil::HeapBoard& resp, int id, const suil::Data& req);
+        void multiplexCall(Buffer& rxb, int id, const suil::Data& req);
+        void demux(Pending& self);
+        void handover();
+        void decode(suil::HeapBoard& resp, Buffer& rxb);
         std::vector<suil::Data> transform(std::vector<srpc::Response>&& resps);
         int getMethodId(const String& method);
 
-    private:
+    private suil_ut:
         UnorderedMap<int> methodIds;
         Metadata rpcMetadata;
+        // calls waiting for their responses, one of the waiting calls reads the
+        // responses of all the calls
+        std::unordered_map<int, Pending*> inflight;
+        mill::Mutex writer{};
+        bool reading{false};
+        bool multiplexed{false};
     };
 }
 
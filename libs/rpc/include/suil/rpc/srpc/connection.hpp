@@ -8,10 +8,19 @@
 #include <suil/rpc/srpc/common.hpp>
 #include <suil/rpc/io.hpp>
 
+#include <suil/base/channel.hpp>
+#include <libmill/libmill.hpp>
+
 namespace suil::rpc::srpc {
 
     class Context;
 
+    /**
+     * Serves the requests of an SRPC client. Requests are handled one at a time
+     * until the client enables multiplexing, after which each request is handled
+     * in it's own coroutine (at most \a maxConcurrentRequests at a time) and the
+     * responses are sent as soon as they are ready, possibly out of order
+     */
     class Connection: public RpcIO<RpcServerConfig>, public LOGGER(SUIL_RPC) {
     public:
         using LOGGER(SUIL_RPC)::log;
@@ -28,6 +37,9 @@ namespace suil::rpc::srpc {
 
         void handleRequest(suil::HeapBoard& resp, const suil::Data& data);
         void processRequest(suil::HeapBoard& resp, suil::HeapBoard& req, int id, int method);
+        void dispatch(net::Socket& sock, Buffer& req);
+        void drain();
+        static coroutine void process(Connection& conn, net::Socket& sock, Buffer req);
         template <typename T>
         suil::Data transform(const T& t) {
             suil::HeapBoard hb(Wire::maxByteSize(t)+8);
@@ -36,6 +48,11 @@ namespace suil::rpc::srpc {
         }
 
         std::shared_ptr<Context> context{nullptr};
+        // requests being processed on a multiplexed connection
+        Conditional completed{};
+        mill::Mutex writer{};
+        uint32 inflight{0};
+        bool   multiplexed{false};
     };
 }
 #endif //SUIL_RPC_SRPC_CONNECTION_HPP
@@ -65,6 +65,7 @@ namespace suil::rpc::srpc {
         static constexpr int rpcMetaRequest{0};
         static constexpr int rpcVersion{-1};
         static constexpr int rpcUseProto{-2};
+        static constexpr int rpcMultiplex{-3};
 
         RpcServerConfig serverConfig;
         srpc::Metadata rpcMeta;
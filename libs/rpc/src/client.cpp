@@ -106,4 +106,94 @@ namespace suil::rpc {
     {
         return config;
     }
-}
\ No newline at end of file
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+using suil::net::Socket;
+using suil::net::TcpServerSock;
+using suil::net::TcpSock;
+
+namespace {
+
+    struct TestIO: suil::rpc::RpcIO<suil::rpc::RpcClientConfig> {
+        const suil::rpc::RpcClientConfig& getConfig() const override {
+            return config;
+        }
+        suil::rpc::RpcClientConfig config;
+    };
+
+    void frame(suil::Buffer& out, const std::string& msg)
+    {
+        uint64_t size = htole64(msg.size());
+        out.append(&size, sizeof(size));
+        out.append(msg.data(), msg.size());
+    }
+}
+
+static coroutine void framedSender(TcpServerSock::Ptr& server, const std::vector<std::string>& msgs)
+{
+    // all the messages are sent with a single send
+    auto s = server;
+    auto sock = s->accept();
+    if (sock == nullptr) {
+        return;
+    }
+
+    suil::Buffer out{1024};
+    for (auto& msg: msgs) {
+        frame(out, msg);
+    }
+    sock->send(out.data(), out.size(), 2000);
+    sock->flush(2000);
+    sock->close();
+}
+
+TEST_CASE("RpcIO framed receive", "[rpc][io]")
+{
+    auto addr = iplocal("127.0.0.1", 9302, 0);
+    TcpServerSock::Ptr server{new TcpServerSock};
+    REQUIRE(server->listen(addr, 4));
+
+    const std::vector<std::string> msgs{
+        "first",
+        "second",
+        std::string(SUIL_RPC_RX_CHUNK * 2 + 3, 'x'),
+        "last"
+    };
+    go(framedSender(server, msgs));
+
+    TestIO io;
+    io.protoUseSize = true;
+    TcpSock sock;
+    REQUIRE(sock.connect(addr, 2000));
+
+    suil::Buffer rxb{};
+    REQUIRE(io.receive(sock, rxb));
+    REQUIRE(std::string{rxb.data(), rxb.size()} == msgs[0]);
+    // the next messages were received with the first read
+    REQUIRE(io.rxpos < io.rxring.size());
+
+    suil::Buffer rxb2{};
+    REQUIRE(io.receive(sock, rxb2));
+    REQUIRE(std::string{rxb2.data(), rxb2.size()} == msgs[1]);
+
+    // larger than the ring, the rest is received in place
+    suil::Buffer large{};
+    REQUIRE(io.receive(sock, large));
+    REQUIRE(large.size() == msgs[2].size());
+    REQUIRE(std::string{large.data(), large.size()} == msgs[2]);
+
+    suil::Buffer last{};
+    REQUIRE(io.receive(sock, last));
+    REQUIRE(std::string{last.data(), last.size()} == msgs[3]);
+    REQUIRE(io.rxpos == io.rxring.size());
+
+    // the sender closed the connection
+    suil::Buffer none{};
+    REQUIRE_FALSE(io.receive(sock, none));
+
+    sock.close();
+    server->close();
+}
+#endif
@@ -6,6 +6,41 @@
 
 namespace suil::rpc::jrpc {
 
+    bool Client::connect()
+    {
+        if (!RpcClient::connect()) {
+            return false;
+        }
+
+        if (Ego.getConfig().streamBatches and !Ego.streaming) {
+            try {
+                auto res = Ego.call("rpc_streamBatches");
+                Ego.streaming = !res.has<String>();
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                iwarn("JSON RPC server does not support streaming batches: %s", ex.what());
+            }
+        }
+
+        if (Ego.getConfig().framed and !Ego.streaming and !Ego.protoUseSize) {
+            try {
+                auto res = Ego.call("rpc_framed");
+                Ego.protoUseSize = !res.has<String>();
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                iwarn("JSON RPC server does not support framing: %s", ex.what());
+            }
+        }
+
+        if (Ego.streaming) {
+            // each response is received in it's own size prefixed message
+            Ego.protoUseSize = true;
+        }
+        return true;
+    }
+
     String Client::rpcVersion()
     {
         auto res = Ego.call("rpc_Version");
@@ -33,66 +68,97 @@ namespace suil::rpc::jrpc {
 
     std::vector<jrpc::Result> Client::call(std::vector<jrpc::Request>& package)
     {
-        std::vector<jrpc::Response> resps;
+        std::vector<jrpc::Result> res(package.size());
+        Ego.call(package, [&](size_t index, jrpc::Result result) {
+            res[index] = std::move(result);
+        });
+        return res;
+    }
+
+    void Client::call(std::vector<jrpc::Request>& package, const Handler& handler)
+    {
         auto raw = json::encode(package);
         if (!Ego.transmit(sock(), Data{raw.data(), raw.size(), false})) {
             // sending failed
             throw RpcTransportError("Sending requests to JSON RPC server failed: ", errno_s);
         }
 
-        Buffer rxb{};
-        if (!Ego.receive(sock(), rxb)) {
-            // receiving response failed
-            throw RpcTransportError("Receiving JSON RPC response from server failed: ", errno_s);
-        }
+        // a streaming server sends a message per response, in the order they complete
+        size_t messages = Ego.streaming? package.size() : 1;
+        for (size_t i = 0; i < messages; i++) {
+            Buffer rxb{};
+            if (!Ego.receive(sock(), rxb)) {
+                // receiving response failed
+                throw RpcTransportError("Receiving JSON RPC response from server failed: ", errno_s);
+            }
+
+            std::vector<jrpc::Response> resps;
+            try {
+                if (Ego.streaming) {
+                    json::decode(rxb, resps.emplace_back());
+                }
+                else {
+                    json::decode(rxb, resps);
+                }
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                throw RpcInternalError("Failed to decode JSON RPC response: ", ex.what());
+            }
 
-        try {
-            json::decode(rxb, resps);
+            for (auto& resp: resps) {
+                auto index = Ego.indexOf(package, resp);
+                handler(index, Ego.transform(std::move(resp)));
+            }
         }
-        catch (...) {
-            auto ex = Exception::fromCurrent();
-            throw RpcInternalError("Failed to decode JSON RPC response: ", ex.what());
+    }
+
+    size_t Client::indexOf(const std::vector<jrpc::Request>& package, const jrpc::Response& resp)
+    {
+        if (!resp.id) {
+            // only sent when the server could not parse the request
+            if (resp.error) {
+                auto& err = *resp.error;
+                throw RpcInternalError("Internal server error ", err.message, "-", err.code, " ", err.data);
+            }
+            throw RpcInternalError("Received a JSON RPC response without an id");
         }
 
-        return Ego.transform(std::move(resps));
+        // requests are numbered consecutively
+        auto index = size_t(*resp.id - *package.front().id);
+        if (index >= package.size()) {
+            throw RpcInternalError("Received a response {id=", *resp.id, "} to an unknown request");
+        }
+        return index;
     }
 
-    std::vector<jrpc::Result> Client::transform(std::vector<jrpc::Response>&& resps)
+    jrpc::Result Client::transform(jrpc::Response&& resp)
     {
-        std::vector<jrpc::Result> res;
-        while (!resps.empty()) {
-            auto resp = std::move(resps.back());
-            resps.pop_back();
-            if (resp.error and resp.result) {
-                // response can either be an error or a result
-                throw RpcInternalError(
-                        "Response {id=", *resp.id, "} is valid because it payload has a result and an error");
-            }
+        if (resp.error and resp.result) {
+            // response can either be an error or a result
+            throw RpcInternalError(
+                    "Response {id=", *resp.id, "} is valid because it payload has a result and an error");
+        }
 
-            if (resp.error) {
-                // transform the error
-                auto& err = *resp.error;
-                if (err.code >= -32099 and err.code <= ResultCode::ApiError) {
-                    // this an API error
-                    jrpc::Result result{suil::catstr("ApiError-", err.code, " ", err.data)};
-                    res.push_back(std::move(result));
-                }
-                else {
-                    /* System error */
-                    throw RpcInternalError(
-                            "Internal server error ",err.message, "-", err.code, " ", err.data);
-                }
+        if (resp.error) {
+            // transform the error
+            auto& err = *resp.error;
+            if (err.code >= -32099 and err.code <= ResultCode::ApiError) {
+                // this an API error
+                return jrpc::Result{suil::catstr("ApiError-", err.code, " ", err.data)};
             }
             else {
-                // push back result
-                jrpc::Result jres{json::Object()};
-                if (resp.result)
-                    jres = std::move(*resp.result);
-                res.emplace_back(std::move(jres));
+                /* System error */
+                throw RpcInternalError(
+                        "Internal server error ",err.message, "-", err.code, " ", err.data);
             }
         }
 
-        return std::move(res);
+        // push back result
+        jrpc::Result jres{json::Object()};
+        if (resp.result)
+            jres = std::move(*resp.result);
+        return jres;
     }
 
 }
\ No newline at end of file
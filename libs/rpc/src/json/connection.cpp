@@ -14,6 +14,20 @@ namespace suil::rpc::jrpc {
             Result res = json::Object{""};
             return {0, std::move(res)};
         });
+
+        extensionMethods.emplace("rpc_framed", [&](const json::Object&) -> ResultCode {
+            // enabled once the response to this request is sent
+            Ego.framedRequested = true;
+            Result res = json::Object{true};
+            return {0, std::move(res)};
+        });
+
+        extensionMethods.emplace("rpc_streamBatches", [&](const json::Object&) -> ResultCode {
+            // enabled once the response to this request is sent
+            Ego.streamRequested = true;
+            Result res = json::Object{true};
+            return {0, std::move(res)};
+        });
     }
 
     const RpcServerConfig& Connection::getConfig() const
@@ -37,74 +51,368 @@ namespace suil::rpc::jrpc {
                 if (!Ego.receive(sock, ob))
                     break;
 
-                auto resp = handleRequest(ob);
-                if (!Ego.transmit(sock, Data{resp.data(), resp.size(), false}))
+                if (!handleRequest(sock, ob))
                     break;
 
+                if (Ego.streamRequested and !Ego.streaming) {
+                    // each response is sent as soon as it's ready, in it's own message
+                    Ego.streaming = true;
+                }
+                // messages are prefixed with their size
+                Ego.protoUseSize = Ego.framedRequested or Ego.streaming;
             } while (sock.isOpen());
         }
         catch (...) {
             auto ex = Exception::fromCurrent();
             ierror("un-handled JSON RPC server error: %s", ex.what());
         }
+
+        // the batch entries being executed reference this connection
+        Ego.drain();
     }
 
-    String Connection::parseRequest(std::vector<jrpc::Request>& req, const Buffer& rxb)
+    static size_t skipWs(const char *data, size_t pos, size_t len)
     {
-        try {
-            json::decode(rxb, req);
-            return {};
+        while (pos < len and isspace(data[pos])) {
+            pos++;
         }
-        catch (...) {
-            auto ex = Exception::fromCurrent();
-            return String{ex.what()}.dup();
+        return pos;
+    }
+
+    static bool skipString(const char *data, size_t& pos, size_t len)
+    {
+        // pos is at the opening quote
+        for (pos++; pos < len; pos++) {
+            if (data[pos] == '\\') {
+                pos++;
+            }
+            else if (data[pos] == '"') {
+                pos++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool skipValue(const char *data, size_t& pos, size_t len)
+    {
+        if (pos >= len) {
+            return false;
+        }
+
+        if (data[pos] == '"') {
+            return skipString(data, pos, len);
+        }
+
+        if (data[pos] == '{' or data[pos] == '[') {
+            // skip nested objects and arrays, strings can contain brackets
+            int depth{0};
+            while (pos < len) {
+                switch (data[pos]) {
+                    case '"':
+                        if (!skipString(data, pos, len)) {
+                            return false;
+                        }
+                        continue;
+                    case '{': case '[':
+                        depth++;
+                        break;
+                    case '}': case ']':
+                        if (--depth == 0) {
+                            pos++;
+                            return true;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                pos++;
+            }
+            return false;
+        }
+
+        // literals and numbers
+        auto start = pos;
+        while (pos < len and !isspace(data[pos]) and
+               data[pos] != ',' and data[pos] != '}' and data[pos] != ']')
+        {
+            pos++;
+        }
+        return pos != start;
+    }
+
+    static bool scanId(int& id, const String& value)
+    {
+        size_t i = (value[0] == '-')? 1 : 0;
+        if (i == value.size()) {
+            return false;
+        }
+
+        int64 num{0};
+        for (; i < value.size(); i++) {
+            if (!isdigit(value[i]) or num > INT32_MAX) {
+                return false;
+            }
+            num = (num * 10) + (value[i] - '0');
+        }
+        id = int((value[0] == '-')? -num : num);
+        return true;
+    }
+
+    static String scanRequest(RawRequest& req, const char *data, size_t& pos, size_t len)
+    {
+        pos = skipWs(data, pos, len);
+        if (pos >= len or data[pos] != '{') {
+            return String{"request must be a JSON object"};
+        }
+
+        pos = skipWs(data, pos + 1, len);
+        while (pos < len and data[pos] != '}') {
+            // "key" : value
+            auto key = pos;
+            if (data[pos] != '"' or !skipString(data, pos, len)) {
+                return String{"invalid request member name"};
+            }
+            String name{&data[key + 1], pos - key - 2, false};
+
+            pos = skipWs(data, pos, len);
+            if (pos >= len or data[pos] != ':') {
+                return String{"expecting ':' after request member name"};
+            }
+            pos = skipWs(data, pos + 1, len);
+            auto start = pos;
+            if (!skipValue(data, pos, len)) {
+                return suil::catstr("invalid value for request member '", name, "'");
+            }
+
+            String value{&data[start], pos - start, false};
+            if (name == "jsonrpc" or name == "method") {
+                if (value.size() < 2 or value[0] != '"') {
+                    return suil::catstr("request member '", name, "' must be a string");
+                }
+                auto& dst = (name == "method")? req.method : req.jsonrpc;
+                dst = String{&data[start + 1], value.size() - 2, false};
+            }
+            else if (name == "id") {
+                req.hasId = !(value == "null");
+                if (req.hasId and !scanId(req.id, value)) {
+                    return String{"request id must be an integer"};
+                }
+            }
+            else if (name == "params") {
+                req.params = (value == "null")? String{} : std::move(value);
+            }
+
+            pos = skipWs(data, pos, len);
+            if (pos < len and data[pos] == ',') {
+                pos = skipWs(data, pos + 1, len);
+                if (pos < len and data[pos] == '}') {
+                    return String{"expecting a request member after ','"};
+                }
+            }
+            else if (pos < len and data[pos] != '}') {
+                return String{"expecting ',' or '}' after request member"};
+            }
+        }
+
+        if (pos >= len) {
+            return String{"incomplete request object"};
         }
+        pos++;
+        return {};
     }
 
-    std::string Connection::handleRequest(const Buffer& rxb)
+    String Connection::parseRequest(std::vector<RawRequest>& reqs, const Buffer& rxb)
     {
-        std::vector<jrpc::Response> resps;
-        std::vector<jrpc::Request> reqs;
+        // only the envelope of each request is scanned, the parameters are decoded by
+        // the context straight into the types of the method's parameters
+        const char *data = rxb.data();
+        size_t len{rxb.size()}, pos = skipWs(data, 0, len);
+        if (pos < len and data[pos] == '[') {
+            // batch request
+            pos = skipWs(data, pos + 1, len);
+            while (pos < len and data[pos] != ']') {
+                if (auto err = scanRequest(reqs.emplace_back(), data, pos, len)) {
+                    return err;
+                }
+                pos = skipWs(data, pos, len);
+                if (pos < len and data[pos] == ',') {
+                    pos = skipWs(data, pos + 1, len);
+                    if (pos < len and data[pos] == ']') {
+                        return String{"expecting a request after ','"};
+                    }
+                }
+                else if (pos < len and data[pos] != ']') {
+                    return String{"expecting ',' or ']' after batch entry"};
+                }
+            }
+            if (pos >= len) {
+                return String{"incomplete batch request"};
+            }
+            pos++;
+        }
+        else if (auto err = scanRequest(reqs.emplace_back(), data, pos, len)) {
+            return err;
+        }
+
+        if (skipWs(data, pos, len) != len) {
+            return String{"unexpected data after request"};
+        }
+        return {};
+    }
+
+    void Connection::writeHeader(iod::encode_stream& out, const RawRequest* req)
+    {
+        out << "{\"jsonrpc\":\"" JSON_RPC_VERSION "\",\"id\":";
+        if (req != nullptr and req->hasId) {
+            iod::json_internals::json_encode_(req->id, out);
+        }
+        else {
+            out << "null";
+        }
+        out << ',';
+    }
+
+    void Connection::writeError(iod::encode_stream& out, const RawRequest* req, const RpcError& err)
+    {
+        writeHeader(out, req);
+        out << "\"error\":";
+        iod::json_internals::json_encode_(err, out);
+        out << '}';
+    }
+
+    bool Connection::handleRequest(net::Socket& sock, const Buffer& rxb)
+    {
+        std::vector<RawRequest> reqs;
         auto status = Ego.parseRequest(reqs, rxb);
         if (status) {
             /* Parsing given request failed */
             ierror("parsing request failed: " PRIs, _PRIs(status));
-            RpcError err(ResultCode::ParseError, "ParseError", std::move(status));
-            jrpc::Response resp;
-            iod::zero(resp);
-            resp.jsonrpc = String{JSON_RPC_VERSION};
-            resp.error = std::move(err);
-            resps.push_back(std::move(resp));
-            return json::encode(resps);
-        }
-
-        for (auto& req: reqs) {
-            // handle all requests
-            if (req.jsonrpc != JSON_RPC_VERSION) {
-                /* Only accept supported JSON RPC version */
-                RpcError err{ResultCode::InvalidRequest, "InvalidRequest",
-                             suil::catstr("Unsupported JSON RPC version '", req.jsonrpc, "'")};
-                jrpc::Response rsp;
-                iod::zero(rsp);
-                rsp.jsonrpc = JSON_RPC_VERSION;
-                rsp.error = std::move(err);
-                resps.push_back(std::move(rsp));
+            return Ego.replyError(sock, RpcError(ResultCode::ParseError, "ParseError", std::move(status)));
+        }
+
+        if (reqs.empty()) {
+            // an empty batch is not a valid request
+            return Ego.replyError(sock, RpcError(ResultCode::InvalidRequest, "InvalidRequest",
+                                                 String{"batch request cannot be empty"}));
+        }
+
+        std::vector<std::string> resps(reqs.size());
+        auto limit = std::max(Ego.getConfig().batchConcurrency, 1u);
+        Ego.broken = false;
+        for (size_t i = 0; i < reqs.size(); i++) {
+            if (limit == 1 or reqs.size() == 1) {
+                // nothing to gain from spawning a coroutine
+                Ego.inflight++;
+                execute(Ego, sock, reqs[i], resps[i]);
                 continue;
             }
 
-            static json::Object _{nullptr};
-            json::Object &obj = not(req.params.has_value())? _ : *req.params;
-            auto str = json::encode(req);
-            auto method = req.method.substr(0, 4);
-            if (method == "rpc_") {
-                resps.push_back(handleExtension(req.method, obj, *req.id));
+            while (Ego.inflight >= limit) {
+                // wait for one of the entries to complete
+                Sync sync;
+                Ego.completed.wait(sync);
             }
-            else {
-                resps.push_back(handleWithContext(*context, req.method, obj, *req.id));
+            Ego.inflight++;
+            go(execute(Ego, sock, reqs[i], resps[i]));
+        }
+        // the requests reference the received buffer
+        Ego.drain();
+
+        if (Ego.streaming) {
+            // responses were sent by the entries
+            return !Ego.broken;
+        }
+
+        size_t size{2};
+        for (auto& resp: resps) {
+            size += resp.size() + 1;
+        }
+
+        std::string out;
+        out.reserve(size);
+        out += '[';
+        for (auto& resp: resps) {
+            if (&resp != &resps.front()) {
+                out += ',';
+            }
+            out += resp;
+        }
+        out += ']';
+        return Ego.reply(sock, out);
+    }
+
+    void Connection::execute(Connection& conn, net::Socket& sock, const RawRequest& req, std::string& resp)
+    {
+        iod::encode_stream out;
+        conn.handleOne(out, req);
+        resp = out.move_str();
+        if (conn.streaming and !conn.broken) {
+            // responses cannot be interleaved
+            mill::Lock lk{conn.writer};
+            if (!conn.reply(sock, resp)) {
+                ldebug(&conn, "sending JSON RPC response {id=%d} failed: %s", req.id, errno_s);
+                conn.broken = true;
             }
         }
 
-        return json::encode(resps);
+        conn.inflight--;
+        conn.completed.notifyOne();
+    }
+
+    void Connection::drain()
+    {
+        while (Ego.inflight > 0) {
+            Sync sync;
+            Ego.completed.wait(sync);
+        }
+    }
+
+    bool Connection::reply(net::Socket& sock, const std::string& resp)
+    {
+        return Ego.transmit(sock, Data{resp.data(), resp.size(), false});
+    }
+
+    bool Connection::replyError(net::Socket& sock, const RpcError& err)
+    {
+        // errors that are not specific to a request
+        iod::encode_stream out;
+        if (!Ego.streaming) {
+            out << '[';
+        }
+        writeError(out, nullptr, err);
+        if (!Ego.streaming) {
+            out << ']';
+        }
+        return Ego.reply(sock, out.move_str());
+    }
+
+    void Connection::handleOne(iod::encode_stream& out, const RawRequest& req)
+    {
+        if (!(req.jsonrpc == JSON_RPC_VERSION)) {
+            /* Only accept supported JSON RPC version */
+            writeError(out, &req, RpcError{ResultCode::InvalidRequest, "InvalidRequest",
+                         suil::catstr("Unsupported JSON RPC version '", req.jsonrpc, "'")});
+            return;
+        }
+
+        if (req.method.substr(0, 4) == "rpc_") {
+            json::Object obj{nullptr};
+            try {
+                if (!req.params.empty()) {
+                    obj = json::Object::decode(req.params);
+                }
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                writeError(out, &req, RpcError{ResultCode::InvalidParams, "InvalidParams", String{ex.what()}.dup()});
+                return;
+            }
+            iod::json_internals::json_encode_(handleExtension(req.method, obj, req.id), out);
+        }
+        else {
+            handleWithContext(out, *context, req);
+        }
     }
 
     jrpc::Response Connection::handleExtension(const String& method, const json::Object& params, int id)
@@ -142,31 +450,353 @@ namespace suil::rpc::jrpc {
         return std::move(resp);
     }
 
-    jrpc::Response Connection::handleWithContext(
-            jrpc::Context& ctx,
-            const String& method,
-            const json::Object& params, int id)
+    void Connection::handleWithContext(iod::encode_stream& out, jrpc::Context& ctx, const RawRequest& req)
     {
-        jrpc::Response resp;
-        iod::zero(resp);
-        resp.jsonrpc = JSON_RPC_VERSION;
-        resp.id = id;
+        writeHeader(out, &req);
 
+        String err{};
+        const char *name{"ServiceHandlerError"};
+        int code{0};
         try {
-            auto str = json::encode(params);
-            auto [code, ret] = ctx(method, params, id);
-            if (code) {
-                resp.error = RpcError(ResultCode::ApiError, "ServiceHandlerError", std::get<String>(ret.Value));
-            }
-            else {
-                resp.result  = std::get<json::Object>(std::move(ret.Value));
-            }
+            code = ctx.invoke(out, err, req.method, req.params, req.id);
         }
         catch (...) {
             auto ex = Exception::fromCurrent();
-            resp.error = RpcError(ResultCode::ApiError, "UnhandledApiError", String{ex.what()}.dup());
+            name = "UnhandledApiError";
+            code = ResultCode::ApiError;
+            err = String{ex.what()}.dup();
         }
 
-        return std::move(resp);
+        if (code) {
+            // nothing is written when a method fails
+            out << "\"error\":";
+            iod::json_internals::json_encode_(RpcError(code, name, std::move(err)), out);
+        }
+        out << '}';
+    }
+}
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace jrpc = suil::rpc::jrpc;
+using suil::net::TcpServerSock;
+using suil::net::TcpSock;
+
+namespace {
+
+    /**
+     * Dispatches like a generated context, the method of a request is found with a
+     * perfect hash of it's name and only the name in that slot is compared
+     */
+    class TestContext: public jrpc::Context {
+    public:
+        TestContext()
+        {
+            // the generator searches for the seed in the same way
+            for (size = 2; ; size++) {
+                for (seed = 0; seed < 4096; seed++) {
+                    addSlot = jrpc::methodHash("add", 3, seed) % size;
+                    sleepSlot = jrpc::methodHash("sleep", 5, seed) % size;
+                    if (addSlot != sleepSlot) {
+                        return;
+                    }
+                }
+            }
+        }
+
+        int invoke(iod::encode_stream& out,
+                   suil::String& err,
+                   const suil::String& method,
+                   const suil::String& params,
+                   int id) override
+        {
+            std::vector<int> args;
+            auto slot = jrpc::methodHash(method.data(), method.size(), seed) % size;
+            if (slot == addSlot and method.compare("add") == 0) {
+                if (!suil::json::trydecode(params, args)) {
+                    err = suil::String{"invalid parameters for method 'add'"};
+                    return jrpc::ResultCode::InvalidParams;
+                }
+                int sum{0};
+                for (auto a: args) {
+                    sum += a;
+                }
+                out << "\"result\":";
+                iod::json_internals::json_encode_(sum, out);
+                return 0;
+            }
+
+            if (slot == sleepSlot and method.compare("sleep") == 0) {
+                if (!suil::json::trydecode(params, args) or args.size() != 1) {
+                    err = suil::String{"invalid parameters for method 'sleep'"};
+                    return jrpc::ResultCode::InvalidParams;
+                }
+                running++;
+                maxRunning = std::max(maxRunning, running);
+                msleep(mnow() + args[0]);
+                running--;
+                out << "\"result\":";
+                iod::json_internals::json_encode_(args[0], out);
+                return 0;
+            }
+
+            err = suil::String{"requested method does not exist"};
+            return jrpc::ResultCode::MethodNotFound;
+        }
+
+        uint32_t seed{0}, size{0}, addSlot{0}, sleepSlot{0};
+        int running{0}, maxRunning{0};
+    };
+
+    suil::String parse(jrpc::Connection& conn, std::vector<jrpc::RawRequest>& reqs, const char *req)
+    {
+        suil::Buffer rxb{};
+        rxb << req;
+        reqs.clear();
+        return conn.parseRequest(reqs, rxb);
+    }
+
+    std::string handle(jrpc::Connection& conn, const char *req)
+    {
+        std::vector<jrpc::RawRequest> reqs;
+        auto err = parse(conn, reqs, req);
+        REQUIRE(err.empty());
+        REQUIRE(reqs.size() == 1);
+        iod::encode_stream out;
+        conn.handleOne(out, reqs[0]);
+        return out.move_str();
+    }
+
+    std::string readAll(TcpSock& sock)
+    {
+        // reads until nothing is received for a while
+        std::string out;
+        char buf[1024];
+        size_t len{sizeof(buf)};
+        while (sock.read(buf, len, 200) and len != 0) {
+            out.append(buf, len);
+            len = sizeof(buf);
+        }
+        return out;
+    }
+}
+
+TEST_CASE("JSON RPC request scanner", "[rpc][jrpc]")
+{
+    jrpc::Connection conn;
+    std::vector<jrpc::RawRequest> reqs;
+
+    SECTION("Envelopes are scanned, the parameters are left encoded") {
+        auto err = parse(conn, reqs,
+                R"( {"jsonrpc" : "2.0", "method":"add", "params": [1, 2], "id": 7} )");
+        REQUIRE(err.empty());
+        REQUIRE(reqs.size() == 1);
+        REQUIRE(reqs[0].jsonrpc == "2.0");
+        REQUIRE(reqs[0].method == "add");
+        REQUIRE(reqs[0].params == "[1, 2]");
+        REQUIRE(reqs[0].hasId);
+        REQUIRE(reqs[0].id == 7);
+
+        err = parse(conn, reqs, R"({"jsonrpc":"2.0","method":"ping","id":null})");
+        REQUIRE(err.empty());
+        REQUIRE_FALSE(reqs[0].hasId);
+        REQUIRE(reqs[0].params.empty());
+
+        err = parse(conn, reqs, R"({"jsonrpc":"2.0","method":"add","params":[-1],"id":-12})");
+        REQUIRE(err.empty());
+        REQUIRE(reqs[0].id == -12);
+    }
+
+    SECTION("Nested and escaped values are skipped") {
+        auto err = parse(conn, reqs,
+                R"({"extra": {"a": [1, {"b": "]}"}]}, "jsonrpc":"2.0", "method":"add",)"
+                R"( "params": {"s": "a \"quoted\" } string", "n": [[1], [2]]}, "id": 1})");
+        REQUIRE(err.empty());
+        REQUIRE(reqs.size() == 1);
+        REQUIRE(reqs[0].method == "add");
+        REQUIRE(reqs[0].params == R"({"s": "a \"quoted\" } string", "n": [[1], [2]]})");
     }
-}
\ No newline at end of file
+
+    SECTION("Batches are scanned") {
+        auto err = parse(conn, reqs,
+                R"([{"jsonrpc":"2.0","method":"add","id":1}, {"jsonrpc":"2.0","method":"sleep","id":2}])");
+        REQUIRE(err.empty());
+        REQUIRE(reqs.size() == 2);
+        REQUIRE(reqs[0].method == "add");
+        REQUIRE(reqs[1].method == "sleep");
+        REQUIRE(reqs[1].id == 2);
+
+        err = parse(conn, reqs, " [ ] ");
+        REQUIRE(err.empty());
+        REQUIRE(reqs.empty());
+    }
+
+    SECTION("Malformed requests are rejected") {
+        const char *malformed[] = {
+            "",
+            "12",
+            R"({"jsonrpc":"2.0","method":"add")",
+            R"({"jsonrpc":"2.0" "method":"add"})",
+            R"({"jsonrpc":"2.0", "method":"add",})",
+            R"({"jsonrpc":"2.0", "method" "add"})",
+            R"({"jsonrpc":"2.0", "method":add})",
+            R"({"jsonrpc":"2.0", method:"add"})",
+            R"({"jsonrpc":"2.0", "method":"add", "id": "one"})",
+            R"({"jsonrpc":"2.0", "method":"add", "id": 1.5})",
+            R"({"jsonrpc":"2.0", "method":"add", "params": [1, 2})",
+            R"({"jsonrpc":"2.0", "method":"add", "params": "unterminated})",
+            R"({"jsonrpc":"2.0", "method":"add"} trailing)",
+            R"([{"jsonrpc":"2.0","method":"add"} {"jsonrpc":"2.0","method":"add"}])",
+            R"([{"jsonrpc":"2.0","method":"add"},])",
+            R"([{"jsonrpc":"2.0","method":"add"})",
+            R"([1])"
+        };
+        for (auto req: malformed) {
+            INFO("request: " << req);
+            REQUIRE_FALSE(parse(conn, reqs, req).empty());
+        }
+    }
+}
+
+TEST_CASE("JSON RPC method dispatch", "[rpc][jrpc]")
+{
+    jrpc::Connection conn;
+    conn.context = std::make_shared<TestContext>();
+
+    SECTION("Methods are found by their perfect hash") {
+        REQUIRE(handle(conn, R"({"jsonrpc":"2.0","method":"add","params":[1,2,3],"id":1})") ==
+                R"({"jsonrpc":"2.0","id":1,"result":6})");
+        REQUIRE(handle(conn, R"({"jsonrpc":"2.0","method":"sleep","params":[0],"id":2})") ==
+                R"({"jsonrpc":"2.0","id":2,"result":0})");
+    }
+
+    SECTION("Unknown methods and invalid parameters fail") {
+        auto resp = handle(conn, R"({"jsonrpc":"2.0","method":"nope","params":[1],"id":3})");
+        REQUIRE(resp.find(R"("id":3)") != std::string::npos);
+        REQUIRE(resp.find(std::to_string(jrpc::ResultCode::MethodNotFound)) != std::string::npos);
+
+        // a name in the slot of a known method is still compared
+        auto& ctx = static_cast<TestContext&>(*conn.context);
+        std::string other{"a"};
+        for (int i = 0; jrpc::methodHash(other.data(), other.size(), ctx.seed) % ctx.size != ctx.addSlot; i++) {
+            other = "a" + std::to_string(i);
+        }
+        auto req = R"({"jsonrpc":"2.0","method":")" + other + R"(","id":4})";
+        resp = handle(conn, req.c_str());
+        REQUIRE(resp.find(std::to_string(jrpc::ResultCode::MethodNotFound)) != std::string::npos);
+
+        resp = handle(conn, R"({"jsonrpc":"2.0","method":"add","params":{"a":1},"id":5})");
+        REQUIRE(resp.find(std::to_string(jrpc::ResultCode::InvalidParams)) != std::string::npos);
+
+        resp = handle(conn, R"({"jsonrpc":"1.0","method":"add","params":[1],"id":6})");
+        REQUIRE(resp.find(std::to_string(jrpc::ResultCode::InvalidRequest)) != std::string::npos);
+    }
+
+    SECTION("An empty batch is an invalid request") {
+        auto addr = iplocal("127.0.0.1", 9303, 0);
+        TcpServerSock server;
+        REQUIRE(server.listen(addr, 4));
+        TcpSock client;
+        REQUIRE(client.connect(addr, 2000));
+        auto sock = server.accept();
+        REQUIRE(sock != nullptr);
+
+        suil::Buffer rxb{};
+        rxb << "[]";
+        REQUIRE(conn.handleRequest(*sock, rxb));
+        auto resp = readAll(client);
+        REQUIRE_FALSE(resp.empty());
+        REQUIRE(resp.front() == '[');
+        REQUIRE(resp.find(R"("id":null)") != std::string::npos);
+        REQUIRE(resp.find(std::to_string(jrpc::ResultCode::InvalidRequest)) != std::string::npos);
+        server.close();
+    }
+}
+
+TEST_CASE("JSON RPC batch execution", "[rpc][jrpc][batch]")
+{
+    auto addr = iplocal("127.0.0.1", 9304, 0);
+    TcpServerSock server;
+    REQUIRE(server.listen(addr, 4));
+    TcpSock client;
+    REQUIRE(client.connect(addr, 2000));
+    auto sock = server.accept();
+    REQUIRE(sock != nullptr);
+
+    auto ctx = std::make_shared<TestContext>();
+    jrpc::Connection conn;
+    conn.context = ctx;
+    auto sleeps = [](std::initializer_list<int> ms) {
+        suil::Buffer rxb{};
+        rxb << '[';
+        int id{1};
+        for (auto m: ms) {
+            if (id != 1) {
+                rxb << ',';
+            }
+            rxb << R"({"jsonrpc":"2.0","method":"sleep","params":[)" << m << R"(],"id":)" << id++ << '}';
+        }
+        rxb << ']';
+        return rxb;
+    };
+
+    SECTION("Responses are sent in the order of the requests") {
+        auto rxb = sleeps({40, 10, 20});
+        REQUIRE(conn.handleRequest(*sock, rxb));
+        // the entries ran concurrently
+        REQUIRE(ctx->maxRunning == 3);
+        REQUIRE(conn.inflight == 0);
+
+        auto resp = readAll(client);
+        REQUIRE(resp == R"([{"jsonrpc":"2.0","id":1,"result":40},)"
+                        R"({"jsonrpc":"2.0","id":2,"result":10},)"
+                        R"({"jsonrpc":"2.0","id":3,"result":20}])");
+    }
+
+    SECTION("At most batchConcurrency entries run at the same time") {
+        ctx->config().batchConcurrency = 2;
+        auto rxb = sleeps({10, 10, 10, 10, 10, 10});
+        REQUIRE(conn.handleRequest(*sock, rxb));
+        REQUIRE(ctx->maxRunning == 2);
+        REQUIRE(conn.inflight == 0);
+
+        auto resp = readAll(client);
+        for (int i = 1; i <= 6; i++) {
+            REQUIRE(resp.find(suil::catstr(R"("id":)", i, ",").data()) != std::string::npos);
+        }
+
+        // entries are executed one after the other
+        ctx->config().batchConcurrency = 1;
+        ctx->maxRunning = 0;
+        rxb = sleeps({5, 5, 5});
+        REQUIRE(conn.handleRequest(*sock, rxb));
+        REQUIRE(ctx->maxRunning == 1);
+        readAll(client);
+    }
+
+    SECTION("Streamed responses are sent as soon as they are ready") {
+        conn.streaming = true;
+        conn.protoUseSize = true;
+        auto rxb = sleeps({40, 10});
+        REQUIRE(conn.handleRequest(*sock, rxb));
+
+        auto resp = readAll(client);
+        std::vector<std::string> msgs;
+        size_t pos{0};
+        while (pos + sizeof(uint64_t) <= resp.size()) {
+            uint64_t size{0};
+            memcpy(&size, &resp[pos], sizeof(size));
+            size = le64toh(size);
+            pos += sizeof(size);
+            msgs.emplace_back(resp.substr(pos, size));
+            pos += size;
+        }
+        REQUIRE(pos == resp.size());
+        REQUIRE(msgs.size() == 2);
+        REQUIRE(msgs[0] == R"({"jsonrpc":"2.0","id":2,"result":10})");
+        REQUIRE(msgs[1] == R"({"jsonrpc":"2.0","id":1,"result":40})");
+    }
+
+    server.close();
+}
+#endif
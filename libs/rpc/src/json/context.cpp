@@ -11,4 +11,26 @@ namespace suil::rpc::jrpc {
         return Ego.serverConfig;
     }
 
+    int Context::invoke(iod::encode_stream& out,
+                        String& err,
+                        const String& method,
+                        const String& params,
+                        int id)
+    {
+        json::Object obj{nullptr};
+        if (!params.empty()) {
+            obj = json::Object::decode(params);
+        }
+
+        auto [code, ret] = Ego(method, obj, id);
+        if (code) {
+            err = std::move(std::get<String>(ret.Value));
+            return code;
+        }
+
+        out << "\"result\":";
+        iod::json_internals::json_encode_(std::get<json::Object>(ret.Value), out);
+        return 0;
+    }
+
 }
\ No newline at end of file
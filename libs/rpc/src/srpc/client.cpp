@@ -6,6 +6,29 @@
 
 namespace suil::rpc::srpc {
 
+    bool Client::connect()
+    {
+        if (!RpcClient::connect()) {
+            return false;
+        }
+
+        if (Ego.getConfig().multiplex and !Ego.multiplexed) {
+            try {
+                Ego.multiplexed = Ego.call<bool>("rpc_multiplex");
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                iwarn("SUIL RPC server does not support multiplexing: %s", ex.what());
+            }
+
+            if (Ego.multiplexed) {
+                // responses can be received out of order, each message is prefixed with it's size
+                Ego.protoUseSize = true;
+            }
+        }
+        return true;
+    }
+
     String Client::rpcVersion()
     {
         return Ego.call<String>("rpc_Version");
@@ -18,7 +41,7 @@ namespace suil::rpc::srpc {
 
         if (!method.empty()) {
             auto& meta = Ego.getMetadata();
-            if (method.substr(0, 4) == "rpc") {
+            if (method.substr(0, 4) == "rpc_") {
                 auto it = std::find_if(meta.extensions.begin(), meta.extensions.end(), [&](const auto& m) {
                     return m.name == method;
                 });
@@ -39,19 +62,131 @@ namespace suil::rpc::srpc {
         return id;
     }
 
-    void Client::doCall(suil::HeapBoard& res, const suil::Data& data)
+    void Client::doCall(suil::HeapBoard& res, int id, const suil::Data& data)
     {
-        if (!Ego.transmit(sock(), data)) {
-            // sending failed
-            throw RpcTransportError("Sending requests to SUIL RPC server failed: ", errno_s);
+        Buffer rxb{};
+        if (Ego.multiplexed) {
+            Ego.multiplexCall(rxb, id, data);
         }
+        else {
+            if (!Ego.transmit(sock(), data)) {
+                // sending failed
+                throw RpcTransportError("Sending requests to SUIL RPC server failed: ", errno_s);
+            }
 
-        Buffer rxb{};
-        if (!Ego.receive(sock(), rxb)) {
-            // receiving response failed
-            throw RpcTransportError("Receiving SUIL RPC response from server failed: ", errno_s);
+            if (!Ego.receive(sock(), rxb)) {
+                // receiving response failed
+                throw RpcTransportError("Receiving SUIL RPC response from server failed: ", errno_s);
+            }
+        }
+
+        Ego.decode(res, rxb);
+    }
+
+    void Client::multiplexCall(Buffer& rxb, int id, const suil::Data& data)
+    {
+        Pending pending{id};
+        Ego.inflight.emplace(id, &pending);
+        bool sent{false};
+        {
+            // requests cannot be interleaved
+            mill::Lock lk{Ego.writer};
+            sent = Ego.transmit(sock(), data);
         }
 
+        if (!sent) {
+            auto err = suil::catstr("Sending requests to SUIL RPC server failed: ", errno_s);
+            Ego.inflight.erase(id);
+            if (pending.lead) {
+                // reading was handed over to this call while it was sending
+                Ego.handover();
+            }
+            throw RpcTransportError(err);
+        }
+
+        if (Ego.reading) {
+            // another call is reading responses, it will either deliver the response
+            // of this call or hand over reading to this call
+            uint8_t status{0};
+            pending.done >> status;
+            if (status == Lead) {
+                Ego.demux(pending);
+            }
+        }
+        else {
+            Ego.demux(pending);
+        }
+
+        if (!pending.error.empty()) {
+            throw RpcTransportError(pending.error);
+        }
+        rxb = std::move(pending.rxb);
+    }
+
+    void Client::demux(Pending& self)
+    {
+        Ego.reading = true;
+        while (!self.ready) {
+            Buffer rxb{};
+            if (!Ego.receive(sock(), rxb)) {
+                // the connection is unusable, fail all the calls waiting for a response
+                auto err = suil::catstr("Receiving SUIL RPC response from server failed: ", errno_s);
+                // the stream is out of sync, calls sent after this must not wait on it
+                sock().close();
+                for (auto& [_, p]: Ego.inflight) {
+                    p->error = err.dup();
+                    p->ready = true;
+                    if (p != &self) {
+                        p->done << Resolved;
+                    }
+                }
+                Ego.inflight.clear();
+                break;
+            }
+
+            int id{0};
+            try {
+                suil::HeapBoard hb(rxb.cdata());
+                hb >> id;
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                iwarn("dropping invalid SUIL RPC response: %s", ex.what());
+                continue;
+            }
+
+            auto it = Ego.inflight.find(id);
+            if (it == Ego.inflight.end()) {
+                iwarn("dropping SUIL RPC response to unknown request %d", id);
+                continue;
+            }
+
+            auto p = it->second;
+            Ego.inflight.erase(it);
+            p->rxb = std::move(rxb);
+            p->ready = true;
+            if (p != &self) {
+                p->done << Resolved;
+            }
+        }
+
+        Ego.handover();
+    }
+
+    void Client::handover()
+    {
+        Ego.reading = false;
+        if (!Ego.inflight.empty()) {
+            // one of the calls still waiting continues reading
+            auto p = Ego.inflight.begin()->second;
+            Ego.reading = true;
+            p->lead = true;
+            p->done << Lead;
+        }
+    }
+
+    void Client::decode(suil::HeapBoard& res, Buffer& rxb)
+    {
         try {
             auto size = rxb.size();
             res = suil::HeapBoard(reinterpret_cast<uint8_t *>(rxb.release()), size, true);
@@ -79,4 +214,153 @@ namespace suil::rpc::srpc {
 
         return Ego.rpcMetadata;
     }
-}
\ No newline at end of file
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+namespace srpc = suil::rpc::srpc;
+using suil::net::Socket;
+using suil::net::TcpServerSock;
+
+static bool fakeSrpcReceive(Socket& sock, suil::Buffer& rxb)
+{
+    uint64_t size{0};
+    size_t len{sizeof(size)};
+    if (!sock.receive(&size, len, 2000) or len != sizeof(size)) {
+        return false;
+    }
+    size = le64toh(size);
+    rxb.bseek(0);
+    rxb.reserve(size);
+    len = size;
+    if (!sock.receive(rxb.data(), len, 2000) or len != size) {
+        return false;
+    }
+    rxb.seek(off_t(size));
+    return true;
+}
+
+static coroutine void fakeSrpcServer(TcpServerSock::Ptr& server, int count, bool reply)
+{
+    // waits for count requests and replies to them in reverse order with twice the
+    // request id, or closes the connection without replying
+    auto s = server;
+    auto sock = s->accept();
+    if (sock == nullptr) {
+        return;
+    }
+
+    std::vector<int> ids;
+    suil::Buffer rxb{64};
+    while (int(ids.size()) < count and fakeSrpcReceive(*sock, rxb)) {
+        int id{0};
+        suil::HeapBoard hb(rxb.cdata());
+        hb >> id;
+        ids.push_back(id);
+    }
+
+    if (reply) {
+        for (auto it = ids.rbegin(); it != ids.rend(); it++) {
+            suil::HeapBoard hb{64};
+            hb << *it << 0 << (*it * 2);
+            auto data = hb.release();
+            uint64_t size = htole64(data.size());
+            sock->send(&size, sizeof(size), 2000);
+            sock->send(data.cdata(), data.size(), 2000);
+        }
+        sock->flush(2000);
+    }
+    sock->close();
+}
+
+static coroutine void srpcCall(srpc::Client& cli, int& out, suil::String& error, suil::Channel<int>& done)
+{
+    try {
+        out = cli.call<int>("");
+    }
+    catch (...) {
+        error = suil::Exception::fromCurrent().what();
+    }
+    done << 1;
+}
+
+TEST_CASE("SRPC multiplexed calls", "[rpc][srpc]")
+{
+    constexpr int count{4};
+    auto addr = iplocal("127.0.0.1", 9301, 0);
+    TcpServerSock::Ptr server{new TcpServerSock};
+    REQUIRE(server->listen(addr, 4));
+
+    suil::net::TcpSocketConfig tcp;
+    tcp.bindAddr.port = 9301;
+    srpc::Client cli(opt(tcpConfig, tcp));
+    std::vector<int> results(count, -1);
+    std::vector<suil::String> errors(count);
+    suil::Channel<int> done{-1};
+
+    SECTION("Responses are matched to the calls") {
+        go(fakeSrpcServer(server, count, true));
+        REQUIRE(cli.RpcClient::connect());
+        cli.multiplexed = cli.protoUseSize = true;
+        for (int i = 0; i < count; i++) {
+            go(srpcCall(cli, results[i], errors[i], done));
+        }
+        for (int i = 0; i < count; i++) {
+            int tmp{0};
+            done >> tmp;
+        }
+
+        std::sort(results.begin(), results.end());
+        for (int i = 0; i < count; i++) {
+            REQUIRE(errors[i].empty());
+            REQUIRE(results[i] == i * 2);
+        }
+        REQUIRE(cli.inflight.empty());
+        REQUIRE_FALSE(cli.reading);
+    }
+
+    SECTION("A failed receive fails all the calls and closes the connection") {
+        go(fakeSrpcServer(server, count, false));
+        REQUIRE(cli.RpcClient::connect());
+        cli.multiplexed = cli.protoUseSize = true;
+        for (int i = 0; i < count; i++) {
+            go(srpcCall(cli, results[i], errors[i], done));
+        }
+        for (int i = 0; i < count; i++) {
+            int tmp{0};
+            done >> tmp;
+        }
+
+        for (int i = 0; i < count; i++) {
+            REQUIRE_FALSE(errors[i].empty());
+        }
+        REQUIRE(cli.inflight.empty());
+        REQUIRE_FALSE(cli.reading);
+        REQUIRE_FALSE(cli.sock().isOpen());
+
+        // calls made after the failure fail right away
+        REQUIRE_THROWS(cli.call<int>(""));
+        REQUIRE_FALSE(cli.reading);
+    }
+
+    SECTION("Reading is handed over to a waiting call") {
+        srpc::Client::Pending waiting{101};
+        cli.inflight.emplace(waiting.id, &waiting);
+        cli.reading = true;
+        cli.handover();
+        REQUIRE(waiting.lead);
+        REQUIRE(cli.reading);
+        uint8_t status{0};
+        waiting.done >> status;
+        REQUIRE(status == srpc::Client::Lead);
+
+        // nobody left waiting
+        cli.inflight.clear();
+        cli.handover();
+        REQUIRE_FALSE(cli.reading);
+    }
+
+    server->close();
+}
+#endif
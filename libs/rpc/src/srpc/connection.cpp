@@ -28,17 +28,65 @@ namespace suil::rpc::srpc {
                 if (!Ego.receive(sock, ob))
                     break;
 
+                if (Ego.multiplexed) {
+                    Ego.dispatch(sock, ob);
+                    continue;
+                }
+
                 suil::HeapBoard resp;
                 handleRequest(resp, ob.cdata());
                 if (!Ego.transmit(sock, resp.release()))
                     break;
 
+                if (Ego.multiplexed) {
+                    // responses can be sent out of order, each message is prefixed with it's size
+                    Ego.protoUseSize = true;
+                }
             } while (sock.isOpen());
         }
         catch (...) {
             auto ex = Exception::fromCurrent();
             ierror("un-handled SUIL RPC server {client=%s} error: %s", sock.id(), ex.what());
         }
+
+        // the requests being processed reference this connection
+        Ego.drain();
+    }
+
+    void Connection::dispatch(net::Socket& sock, Buffer& req)
+    {
+        while (Ego.inflight >= std::max(Ego.getConfig().maxConcurrentRequests, 1u)) {
+            // wait for one of the requests to complete
+            Sync sync;
+            Ego.completed.wait(sync);
+        }
+
+        Ego.inflight++;
+        go(process(Ego, sock, std::move(req)));
+    }
+
+    void Connection::drain()
+    {
+        while (Ego.inflight > 0) {
+            Sync sync;
+            Ego.completed.wait(sync);
+        }
+    }
+
+    void Connection::process(Connection& conn, net::Socket& sock, Buffer req)
+    {
+        suil::HeapBoard resp;
+        conn.handleRequest(resp, req.cdata());
+        {
+            // the size and data of a response cannot be interleaved with other responses
+            mill::Lock lk{conn.writer};
+            if (sock.isOpen() and !conn.transmit(sock, resp.release())) {
+                ldebug(&conn, "sending SUIL RPC {client=%s} response failed: %s", sock.id(), errno_s);
+            }
+        }
+
+        conn.inflight--;
+        conn.completed.notifyOne();
     }
 
     void Connection::handleRequest(suil::HeapBoard& resp, const suil::Data& data)
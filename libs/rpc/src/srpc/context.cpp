@@ -28,6 +28,7 @@ namespace suil::rpc::srpc {
         rpcMeta.version = String{SUIL_RPC_VERSION}.dup();
         Ego.appendMethod("rpc_Version", true);
         Ego.appendMethod("rpc_enableProtoSize", true);
+        Ego.appendMethod("rpc_multiplex", true);
         buildMethodInfo();
     }
 
@@ -76,6 +77,14 @@ namespace suil::rpc::srpc {
                 req >> conn.protoUseSize;
                 break;
             }
+            case rpcMultiplex: {
+                // the connection switches to size framed messages once this
+                // response is sent
+                resp = suil::HeapBoard(payloadSize(true));
+                resp << id << 0 << true;
+                conn.multiplexed = true;
+                break;
+            }
             default: {
                 RpcError err{-1, "UnsupportedExtensionMethod", "Extension method not found"};
                 resp = suil::HeapBoard(payloadSize(err));
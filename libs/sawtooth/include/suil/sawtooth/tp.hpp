@@ -11,8 +11,14 @@
 #include <suil/sawtooth/processor.hpp>
 
 #include <suil/net/zmq/monitor.hpp>
+#include <suil/base/channel.hpp>
 
 #include <csignal>
+#include <deque>
+
+#ifndef SUIL_SAWTOOTH_WORKERS_STOP_TIMEOUT
+#define SUIL_SAWTOOTH_WORKERS_STOP_TIMEOUT 10000
+#endif
 
 namespace suil::saw {
 
@@ -55,10 +61,26 @@ namespace suil::saw {
 
         void setHeaderStyle(TpRequestHeaderStyle headerStyle) { Ego.mHeaderStyle = headerStyle; }
 
-    private:
+        /**
+         * Set the number of transactions processed at the same time. By default
+         * this is the sum of the max occupancy of the registered handlers, i.e the
+         * number of transactions the validator can send to this processor at a time
+         * @param workers the number of worker coroutines, 0 to use the default
+         */
+        void setMaxWorkers(uint32 workers) { Ego.mMaxWorkers = workers; }
+
+    private suil_ut:
+        struct Job {
+            std::string content{};
+            String      cid{};
+        };
+
         void registerAll();
         void unRegisterAll();
-        void handleRequest(const suil::Data& msg, const suil::String& cid);
+        void handleRequest(Stream& stream, const suil::Data& msg, const suil::String& cid);
+        void startWorkers();
+        bool stopWorkers(int64 timeout = SUIL_SAWTOOTH_WORKERS_STOP_TIMEOUT);
+        static coroutine void worker(TransactionProcessor& tp);
         void initConnectionMonitor();
         void handleExitSignal(int, siginfo_t*, void*);
 
@@ -71,6 +93,12 @@ namespace suil::saw {
         bool mRunning{false};
         bool mIsSeverConnected{false};
         TpRequestHeaderStyle mHeaderStyle{HeaderStyleUnset};
+        // requests waiting for a worker
+        std::deque<Job> mJobs{};
+        Conditional mJobsReady{};
+        Conditional mWorkerExit{};
+        uint32 mMaxWorkers{0};
+        uint32 mWorkers{0};
     };
 
 }
\ No newline at end of file
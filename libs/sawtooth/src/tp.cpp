@@ -77,7 +77,7 @@ namespace suil::saw {
         }
     }
 
-    void TransactionProcessor::handleRequest(const suil::Data &msg, const suil::String &cid)
+    void TransactionProcessor::handleRequest(Stream& stream, const suil::Data &msg, const suil::String &cid)
     {
         sp::TpProcessRequest req;
         sp::TpProcessResponse resp;
@@ -122,7 +122,82 @@ namespace suil::saw {
             resp.set_status(sp::TpProcessResponse::INTERNAL_ERROR);
         }
 
-        Ego.mRespStream.sendResponse(sp::Message::TP_PROCESS_RESPONSE, resp, cid);
+        stream.sendResponse(sp::Message::TP_PROCESS_RESPONSE, resp, cid);
+    }
+
+    void TransactionProcessor::startWorkers()
+    {
+        auto workers = Ego.mMaxWorkers;
+        if (workers == 0) {
+            // the validator sends at most max occupancy transactions per handler
+            for (const auto& [_, handler]: Ego.mHandlers) {
+                workers += std::max(handler->getMaxOccupancy(), uint32(1));
+            }
+        }
+        workers = std::max(workers, uint32(1));
+
+        idebug("starting %u transaction processing workers", workers);
+        for (uint32 i = 0; i < workers; i++) {
+            Ego.mWorkers++;
+            go(worker(Ego));
+        }
+    }
+
+    bool TransactionProcessor::stopWorkers(int64 timeout)
+    {
+        // workers exit once there are no more requests to process. Workers reference the
+        // processor and its dispatcher, so this always waits for all of them to exit
+        Ego.mJobsReady.notify();
+        bool inTime{true};
+        auto deadline = mnow() + timeout;
+        while (Ego.mWorkers > 0) {
+            Sync sync;
+            if (!inTime) {
+                Ego.mWorkerExit.wait(sync);
+                continue;
+            }
+
+            auto left = deadline - mnow();
+            if (left <= 0 or !Ego.mWorkerExit.wait(sync, left)) {
+                // the validator resends the transactions that were not processed, workers
+                // exit after the transactions they are processing
+                iwarn("%u transaction processing workers did not stop in time, dropping %zu requests",
+                      Ego.mWorkers, Ego.mJobs.size());
+                Ego.mJobs.clear();
+                inTime = false;
+            }
+        }
+        return inTime;
+    }
+
+    void TransactionProcessor::worker(TransactionProcessor& tp)
+    {
+        // responses are sent on the worker's own stream, while the state of each
+        // transaction is accessed through a stream created for it
+        auto stream = tp.mDispatcher.createStream();
+        while (true) {
+            if (tp.mJobs.empty()) {
+                if (!tp.mRunning) {
+                    break;
+                }
+                Sync sync;
+                tp.mJobsReady.wait(sync);
+                continue;
+            }
+
+            auto job = std::move(tp.mJobs.front());
+            tp.mJobs.pop_front();
+            try {
+                tp.handleRequest(stream, fromStdString(job.content), job.cid);
+            }
+            catch (...) {
+                auto ex = Exception::fromCurrent();
+                lerror(&tp, "sending transaction {cid: %s} response failed: %s", job.cid(), ex.what());
+            }
+        }
+
+        tp.mWorkers--;
+        tp.mWorkerExit.notifyOne();
     }
 
     void TransactionProcessor::initConnectionMonitor()
@@ -163,6 +238,7 @@ namespace suil::saw {
 
             Ego.mRunning = true;
             Ego.initConnectionMonitor();
+            Ego.startWorkers();
 
             while (Ego.mRunning) {
                 net::zmq::Message msg;
@@ -176,7 +252,11 @@ namespace suil::saw {
 
                 switch (validatorMsg.message_type()) {
                     case sp::Message::TP_PROCESS_REQUEST: {
-                        Ego.handleRequest(fromStdString(validatorMsg.content()), String{validatorMsg.correlation_id()});
+                        // processed by the next available worker
+                        Ego.mJobs.push_back(Job{
+                            std::move(*validatorMsg.mutable_content()),
+                            String{validatorMsg.correlation_id()}.dup()});
+                        Ego.mJobsReady.notifyOne();
                         break;
                     }
                     default: {
@@ -191,6 +271,9 @@ namespace suil::saw {
             ierror("Unexpected error while running TP: %s", ex.what());
         }
 
+        Ego.mRunning = false;
+        Ego.stopWorkers();
+
         idebug("TP done, unregistering");
         Ego.unRegisterAll();
         Ego.mDispatcher.exit();
@@ -204,4 +287,63 @@ namespace suil::saw {
         }
     }
 
-}
\ No newline at end of file
+}
+
+#ifdef SUIL_UNITTEST
+#include <catch2/catch.hpp>
+
+using suil::saw::TransactionProcessor;
+
+namespace {
+
+    coroutine void stuckWorker(TransactionProcessor& tp, int64 delay)
+    {
+        // finishes the transaction it is processing after the given delay
+        msleep(mnow() + delay);
+        tp.mWorkers--;
+        tp.mWorkerExit.notifyOne();
+    }
+
+}
+
+TEST_CASE("Transaction processor workers", "[sawtooth][tp]")
+{
+    TransactionProcessor tp{"tcp://127.0.0.1:4004"};
+    tp.mRunning = true;
+
+    SECTION("Workers are started and stopped") {
+        tp.setMaxWorkers(4);
+        tp.startWorkers();
+        REQUIRE(tp.mWorkers == 4);
+        // workers wait for requests
+        yield();
+        REQUIRE(tp.mWorkers == 4);
+
+        tp.mRunning = false;
+        REQUIRE(tp.stopWorkers(1000));
+        REQUIRE(tp.mWorkers == 0);
+    }
+
+    SECTION("At least one worker is started") {
+        tp.startWorkers();
+        REQUIRE(tp.mWorkers == 1);
+        tp.mRunning = false;
+        REQUIRE(tp.stopWorkers(1000));
+        REQUIRE(tp.mWorkers == 0);
+    }
+
+    SECTION("Stopping workers waits for workers stuck past the timeout") {
+        // a worker stuck processing a transaction
+        tp.mWorkers = 1;
+        tp.mJobs.push_back(TransactionProcessor::Job{"", suil::String{"cid"}.dup()});
+        tp.mRunning = false;
+        go(stuckWorker(tp, 100));
+        auto start = mnow();
+        REQUIRE_FALSE(tp.stopWorkers(50));
+        REQUIRE(mnow() - start >= 100);
+        REQUIRE(tp.mWorkers == 0);
+        // requests that were not picked up are dropped
+        REQUIRE(tp.mJobs.empty());
+    }
+}
+#endif